@@ -11,6 +11,7 @@ BUILD_DIR="$WORKDIR/build"
 TESTDATA_DIR="$WORKDIR/testdata"
 TEMP_OUTPUT="/tmp/tiger_regression_output.txt"
 TEMP_REF="/tmp/tiger_regression_ref.txt"
+RUNTIME="$WORKDIR/src/tiger/runtime/runtime.c"
 
 # Colors and counters
 RED='\033[0;31m'; GREEN='\033[0;32m'; YELLOW='\033[1;33m'; BLUE='\033[0;34m'; NC='\033[0m'
@@ -101,6 +102,241 @@ run_test() {
     fi
 }
 
+# Compile a program; if it has an expected execution output, link and run it
+run_compiler_test() {
+    local testcase=$1 ref_output=$2
+    local testcase_name=$(basename "$testcase" .tig)
+
+    TOTAL_TESTS=$((TOTAL_TESTS + 1))
+    if ! ./tiger-compiler "$testcase" > "$TEMP_OUTPUT" 2>&1; then
+        log_error "$testcase_name - compilation failed"
+        FAILED_TESTS=$((FAILED_TESTS + 1)); return 1
+    fi
+    if [[ ! -f "$ref_output" ]]; then
+        log_success "$testcase_name - compilation successful"
+        PASSED_TESTS=$((PASSED_TESTS + 1)); return 0
+    fi
+
+    gcc -Wl,--wrap,getchar -m64 "$testcase.s" "$RUNTIME" -o test.out >/dev/null 2>&1
+    rm -f "$testcase.s"
+    if [[ ! -s test.out ]]; then
+        log_error "$testcase_name - link failed"
+        FAILED_TESTS=$((FAILED_TESTS + 1)); return 1
+    fi
+    ./test.out > "$TEMP_OUTPUT" 2>&1
+    rm -f test.out
+    if diff -w -B "$TEMP_OUTPUT" "$ref_output" > /dev/null; then
+        log_success "$testcase_name - output matches"
+        PASSED_TESTS=$((PASSED_TESTS + 1)); return 0
+    fi
+    log_error "$testcase_name - output mismatch"
+    FAILED_TESTS=$((FAILED_TESTS + 1)); return 1
+}
+
+# Register allocation that runs out of rounds must be a diagnostic, not code
+run_nonconvergence_test() {
+    local testcase="$TESTDATA_DIR/lab5or6/testcases/spill_blocks.tig"
+
+    TOTAL_TESTS=$((TOTAL_TESTS + 1))
+    cd "$BUILD_DIR"
+    rm -f "$testcase.s"
+    if ./tiger-compiler --max-regalloc-rounds 1 "$testcase" > "$TEMP_OUTPUT" 2>&1; then
+        log_error "spill_blocks - compiled although allocation did not converge"
+        rm -f "$testcase.s"
+        FAILED_TESTS=$((FAILED_TESTS + 1)); return 1
+    fi
+    if ! grep -q "internal compiler error: register allocation of .* did not converge" "$TEMP_OUTPUT" ||
+       [[ -f "$testcase.s" ]]; then
+        log_error "spill_blocks - no diagnostic for allocation that did not converge"
+        rm -f "$testcase.s"
+        FAILED_TESTS=$((FAILED_TESTS + 1)); return 1
+    fi
+    log_success "spill_blocks - allocation that did not converge is reported"
+    PASSED_TESTS=$((PASSED_TESTS + 1)); return 0
+}
+
+# The assembly is the same for every -j, one file at a time or several
+run_jobs_test() {
+    local work
+    work=$(mktemp -d /tmp/tiger-jobs.XXXXXX)
+    mkdir "$work/j1" "$work/j8" "$work/all"
+
+    TOTAL_TESTS=$((TOTAL_TESTS + 1))
+    cd "$BUILD_DIR"
+    local testcase testcase_name differ=()
+    for testcase in "$TESTDATA_DIR"/lab5or6/testcases/*.tig; do
+        testcase_name=$(basename "$testcase")
+        cp "$testcase" "$work/j1/"; cp "$testcase" "$work/j8/"; cp "$testcase" "$work/all/"
+        ./tiger-compiler -j 1 "$work/j1/$testcase_name" > /dev/null 2>&1
+        ./tiger-compiler -j 8 "$work/j8/$testcase_name" > /dev/null 2>&1
+        [[ -f "$work/j1/$testcase_name.s" ]] || continue
+        cmp -s "$work/j1/$testcase_name.s" "$work/j8/$testcase_name.s" ||
+            differ+=("$testcase_name (-j 8)")
+    done
+    ./tiger-compiler -j 8 "$work"/all/*.tig > /dev/null 2>&1
+    for testcase in "$work"/j1/*.tig.s; do
+        testcase_name=$(basename "$testcase")
+        cmp -s "$testcase" "$work/all/$testcase_name" ||
+            differ+=("$testcase_name (-j 8, all files)")
+    done
+    rm -rf "$work"
+
+    if [[ ${#differ[@]} -ne 0 ]]; then
+        log_error "jobs - assembly differs from -j 1: ${differ[*]}"
+        FAILED_TESTS=$((FAILED_TESTS + 1)); return 1
+    fi
+    log_success "jobs - same assembly with -j 1, -j 8 and all files at once"
+    PASSED_TESTS=$((PASSED_TESTS + 1)); return 0
+}
+
+# --cache gives the assembly of an uncached build; a second run finds every
+# function, and after an edit to one function only that one is compiled
+run_cache_test() {
+    local work
+    work=$(mktemp -d /tmp/tiger-cache.XXXXXX)
+    mkdir "$work/plain" "$work/cached" "$work/cache"
+    cp "$TESTDATA_DIR"/lab5or6/testcases/*.tig "$work/plain/"
+    cp "$TESTDATA_DIR"/lab5or6/testcases/*.tig "$work/cached/"
+
+    TOTAL_TESTS=$((TOTAL_TESTS + 1))
+    cd "$BUILD_DIR"
+    ./tiger-compiler "$work"/plain/*.tig > /dev/null 2>&1
+    local run stats error=""
+    for run in cold warm; do
+        rm -f "$work"/cached/*.s
+        stats=$(./tiger-compiler --cache "$work/cache" --cache-stats "$work"/cached/*.tig 2>&1 |
+                grep "^cache:")
+        local testcase
+        for testcase in "$work"/plain/*.tig.s; do
+            cmp -s "$testcase" "$work/cached/$(basename "$testcase")" ||
+                error="$run run: $(basename "$testcase") differs from the uncached build"
+        done
+        [[ -n "$error" ]] && break
+        if [[ $run == warm ]] && ! [[ "$stats" =~ ^cache:\ [1-9][0-9]*\ hits,\ 0\ misses$ ]]; then
+            error="warm run: expected only hits, got \"$stats\""
+            break
+        fi
+    done
+
+    # The base case of nfactor is the only function that changes
+    if [[ -z "$error" ]]; then
+        sed -i 's/then 1/then 2/' "$work/cached/tfact.tig"
+        cp "$work/cached/tfact.tig" "$work/plain/tfact.tig"
+        ./tiger-compiler "$work/plain/tfact.tig" > /dev/null 2>&1
+        stats=$(./tiger-compiler --cache "$work/cache" --cache-stats "$work/cached/tfact.tig" 2>&1 |
+                grep "^cache:")
+        if ! [[ "$stats" =~ ^cache:\ [0-9]+\ hits,\ 1\ misses$ ]]; then
+            error="edited tfact: expected one miss, got \"$stats\""
+        elif ! cmp -s "$work/plain/tfact.tig.s" "$work/cached/tfact.tig.s"; then
+            error="edited tfact: differs from the uncached build"
+        fi
+    fi
+    rm -rf "$work"
+
+    if [[ -n "$error" ]]; then
+        log_error "cache - $error"
+        FAILED_TESTS=$((FAILED_TESTS + 1)); return 1
+    fi
+    log_success "cache - same assembly as without, all hits when warm, one miss per edit"
+    PASSED_TESTS=$((PASSED_TESTS + 1)); return 0
+}
+
+# Input that ends in a string or comment: exactly one error, and it stops
+run_unterminated_tests() {
+    local target=$1
+
+    cd "$BUILD_DIR"
+    for testcase in "$TESTDATA_DIR"/lab2/testcases/unterminated_*.tig; do
+        local testcase_name=$(basename "$testcase" .tig)
+        local what=${testcase_name#unterminated_}
+
+        TOTAL_TESTS=$((TOTAL_TESTS + 1))
+        timeout 10 ./"$target" "$testcase" > "$TEMP_OUTPUT" 2>&1
+        local status=$?
+        rm -f "$testcase.s"
+        if [[ $status -eq 124 ]]; then
+            log_error "$testcase_name - $target did not stop"
+            FAILED_TESTS=$((FAILED_TESTS + 1)); continue
+        fi
+        if [[ $(grep -c "^$testcase:" "$TEMP_OUTPUT") -ne 1 ]] ||
+           ! grep -q "^$testcase:.*: unterminated $what$" "$TEMP_OUTPUT"; then
+            log_error "$testcase_name - $target did not report one unterminated $what"
+            FAILED_TESTS=$((FAILED_TESTS + 1)); continue
+        fi
+        log_success "$testcase_name - $target reports one error"
+        PASSED_TESTS=$((PASSED_TESTS + 1))
+    done
+}
+
+# The server answers bad programs and requests that take too long with an
+# error, and goes on serving
+run_server_test() {
+    local socket
+    socket=$(mktemp -u /tmp/tiger-serve.XXXXXX)
+
+    TOTAL_TESTS=$((TOTAL_TESTS + 1))
+    cd "$BUILD_DIR"
+    ./tiger-compiler --request-timeout 2 --serve "$socket" 2>/dev/null &
+    local server=$!
+    timeout 60 python3 - "$socket" "$TESTDATA_DIR" > "$TEMP_OUTPUT" 2>&1 << 'EOF'
+import os, socket, sys, time
+
+path, testdata = sys.argv[1], sys.argv[2]
+for _ in range(100):
+    if os.path.exists(path):
+        break
+    time.sleep(0.1)
+
+def request(source, finish=True):
+    """Status and diagnostic lines of the reply to source"""
+    conn = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    conn.connect(path)
+    conn.sendall(source.encode())
+    if finish:
+        conn.shutdown(socket.SHUT_WR)
+    reply = b""
+    while data := conn.recv(65536):
+        reply += data
+    conn.close()
+    header, _, body = reply.decode().partition("\n\n")
+    fields = dict(line.split(" ", 1) for line in header.splitlines())
+    return fields.get("status"), body[:int(fields.get("diagnostics", 0))].splitlines()
+
+def check(what, reply, status, diagnostic=None):
+    if reply[0] != status or (diagnostic is not None and
+            (len(reply[1]) != 1 or diagnostic not in reply[1][0])):
+        sys.exit(f"{what}: got {reply}")
+
+for what in ("string", "comment"):
+    with open(f"{testdata}/lab2/testcases/unterminated_{what}.tig") as f:
+        check(what, request(f.read()), "error", f"unterminated {what}")
+check("timeout", request("let", finish=False), "error", "took longer than 2 seconds")
+with open(f"{testdata}/lab5or6/testcases/tfact.tig") as f:
+    check("request after a timeout", request(f.read()), "ok")
+EOF
+    local status=$?
+    kill "$server" 2>/dev/null; wait "$server" 2>/dev/null
+    if [[ $status -ne 0 ]]; then
+        log_error "server - $(tail -1 "$TEMP_OUTPUT")"
+        FAILED_TESTS=$((FAILED_TESTS + 1)); return 1
+    fi
+    log_success "server - bad programs and timeouts are answered with errors"
+    PASSED_TESTS=$((PASSED_TESTS + 1)); return 0
+}
+
+# libtiger through driver::Compiler: errors come back as diagnostics
+run_driver_test() {
+    build_target "test_driver"
+    TOTAL_TESTS=$((TOTAL_TESTS + 1))
+    cd "$BUILD_DIR"
+    if timeout 60 ./test_driver > "$TEMP_OUTPUT" 2>&1; then
+        log_success "driver - $(tail -1 "$TEMP_OUTPUT")"
+        PASSED_TESTS=$((PASSED_TESTS + 1)); return 0
+    fi
+    log_error "driver - $(grep -m1 FAIL "$TEMP_OUTPUT" || echo "did not finish")"
+    FAILED_TESTS=$((FAILED_TESTS + 1)); return 1
+}
+
 # Generic test function
 run_lab_tests() {
     local lab=$1 target=$2 description=$3
@@ -118,14 +354,7 @@ run_lab_tests() {
         local ref_output="$ref_dir/${testcase_name}.out"
         
         if [[ "$target" == "tiger-compiler" ]]; then
-            TOTAL_TESTS=$((TOTAL_TESTS + 1))
-            if ./"$target" "$testcase" > "$TEMP_OUTPUT" 2>&1; then
-                log_success "$testcase_name - compilation successful"
-                PASSED_TESTS=$((PASSED_TESTS + 1))
-            else
-                log_error "$testcase_name - compilation failed"
-                FAILED_TESTS=$((FAILED_TESTS + 1))
-            fi
+            run_compiler_test "$testcase" "$TESTDATA_DIR/$lab/refs/${testcase_name}.out"
         else
             run_test "$target" "$testcase" "$ref_output"
         fi
@@ -133,11 +362,22 @@ run_lab_tests() {
 }
 
 # Test lab functions
-test_lex() { run_lab_tests "lab2" "test_lex" "Lab 2 - Lexical Analysis"; }
+test_lex() {
+    run_lab_tests "lab2" "test_lex" "Lab 2 - Lexical Analysis"
+    run_unterminated_tests "test_lex"
+}
 test_parse() { run_lab_tests "lab3" "test_parse" "Lab 3 - Parsing"; }
 test_semant() { run_lab_tests "lab4" "test_semant" "Lab 4 - Semantic Analysis"; }
 test_translate() { run_lab_tests "lab5or6" "test_translate" "Lab 5 Part 1 - Translation"; }
-test_compiler() { run_lab_tests "lab5or6" "tiger-compiler" "Lab 6 - Final Compiler"; }
+test_compiler() {
+    run_lab_tests "lab5or6" "tiger-compiler" "Lab 6 - Final Compiler"
+    run_nonconvergence_test
+    run_jobs_test
+    run_cache_test
+    run_unterminated_tests "tiger-compiler"
+    run_server_test
+    run_driver_test
+}
 
 # Print summary and exit
 print_summary() {
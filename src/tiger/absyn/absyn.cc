@@ -402,7 +402,7 @@ type::TyList *FieldList::MakeFormalTyList(env::TEnvPtr tenv,
 
     if (!ty) {
       errormsg->Error(param->pos_, "undefined type %s",
-                      param->typ_->Name().c_str());
+                      param->typ_->Name().data());
     }
     formal_tylist->Append(ty);
   }
@@ -422,7 +422,7 @@ type::FieldList *FieldList::MakeFieldList(env::TEnvPtr tenv,
     type::Ty *ty = tenv->Look(a_field->typ_);
     if (ty == nullptr) {
       errormsg->Error(a_field->pos_, "undefined type %s",
-                      a_field->typ_->Name().c_str());
+                      a_field->typ_->Name().data());
     }
     ty_field_list->Append(new type::Field(a_field->name_, ty));
   }
@@ -17,6 +17,13 @@
  * - Traverse(): Escape analysis traversal
  * 
  * All AST nodes store position information (pos_) for error reporting.
+ *
+ * SemAnalyze() leaves annotations on the nodes that name something: the
+ * env::VarEntry or env::FunEntry a name resolved to, the type a record or
+ * array expression creates.  Along the way it also sets the escape flags,
+ * as Traverse() would.  Translate(), given null environments, takes names
+ * from those annotations instead of looking them up, and leaves out the
+ * checks semantic analysis has already made.
  */
 
 #ifndef TIGER_ABSYN_ABSYN_H_
@@ -32,6 +39,7 @@
 //#include "tiger/frame/frame.h"
 #include "tiger/semant/types.h"
 #include "tiger/symbol/symbol.h"
+#include "tiger/util/alloc_profile.h"
 
 /**
  * @brief Forward declarations for translation module
@@ -120,13 +128,13 @@ private:
  * Variables represent l-values (locations that can be assigned to).
  * All variable nodes support semantic analysis, translation, and escape analysis.
  */
-class Var {
+class Var : public util::AllocTracked<Var> {
 public:
   int pos_;
   virtual ~Var() = default;
   virtual void Print(FILE *out, int d) const = 0;
   virtual type::Ty *SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
-                               int labelcount,
+                               int labelcount, int depth,
                                err::ErrorMsg *errormsg) const = 0;
   virtual tr::ExpAndTy *Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
                                   tr::Level *level, temp::Label *label,
@@ -146,12 +154,13 @@ protected:
 class SimpleVar : public Var {
 public:
   sym::Symbol *sym_;  ///< Variable name symbol
+  mutable env::VarEntry *entry_ = nullptr; ///< Resolved by semantic analysis
   SimpleVar(int pos, sym::Symbol *sym) : Var(pos), sym_(sym) {}
   ~SimpleVar() override;
 
   void Print(FILE *out, int d) const override;
   type::Ty *SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
-                       err::ErrorMsg *errormsg) const override;
+                       int depth, err::ErrorMsg *errormsg) const override;
   tr::ExpAndTy *Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
                           tr::Level *level, temp::Label *label,
                           err::ErrorMsg *errormsg) const override;
@@ -175,7 +184,7 @@ public:
 
   void Print(FILE *out, int d) const override;
   type::Ty *SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
-                       err::ErrorMsg *errormsg) const override;
+                       int depth, err::ErrorMsg *errormsg) const override;
   tr::ExpAndTy *Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
                           tr::Level *level, temp::Label *label,
                           err::ErrorMsg *errormsg) const override;
@@ -199,7 +208,7 @@ public:
 
   void Print(FILE *out, int d) const override;
   type::Ty *SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
-                       err::ErrorMsg *errormsg) const override;
+                       int depth, err::ErrorMsg *errormsg) const override;
   tr::ExpAndTy *Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
                           tr::Level *level, temp::Label *label,
                           err::ErrorMsg *errormsg) const override;
@@ -223,13 +232,13 @@ public:
  * - Translate(): Conversion to IR tree representation
  * - Traverse(): Escape analysis for nested functions
  */
-class Exp {
+class Exp : public util::AllocTracked<Exp> {
 public:
   int pos_;
   virtual ~Exp() = default;
   virtual void Print(FILE *out, int d) const = 0;
   virtual type::Ty *SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
-                               int labelcount,
+                               int labelcount, int depth,
                                err::ErrorMsg *errormsg) const = 0;
   virtual tr::ExpAndTy *Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
                                   tr::Level *level, temp::Label *label,
@@ -255,7 +264,7 @@ public:
 
   void Print(FILE *out, int d) const override;
   type::Ty *SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
-                       err::ErrorMsg *errormsg) const override;
+                       int depth, err::ErrorMsg *errormsg) const override;
   tr::ExpAndTy *Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
                           tr::Level *level, temp::Label *label,
                           err::ErrorMsg *errormsg) const override;
@@ -276,7 +285,7 @@ public:
 
   void Print(FILE *out, int d) const override;
   type::Ty *SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
-                       err::ErrorMsg *errormsg) const override;
+                       int depth, err::ErrorMsg *errormsg) const override;
   tr::ExpAndTy *Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
                           tr::Level *level, temp::Label *label,
                           err::ErrorMsg *errormsg) const override;
@@ -298,7 +307,7 @@ public:
 
   void Print(FILE *out, int d) const override;
   type::Ty *SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
-                       err::ErrorMsg *errormsg) const override;
+                       int depth, err::ErrorMsg *errormsg) const override;
   tr::ExpAndTy *Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
                           tr::Level *level, temp::Label *label,
                           err::ErrorMsg *errormsg) const override;
@@ -320,7 +329,7 @@ public:
 
   void Print(FILE *out, int d) const override;
   type::Ty *SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
-                       err::ErrorMsg *errormsg) const override;
+                       int depth, err::ErrorMsg *errormsg) const override;
   tr::ExpAndTy *Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
                           tr::Level *level, temp::Label *label,
                           err::ErrorMsg *errormsg) const override;
@@ -338,6 +347,7 @@ class CallExp : public Exp {
 public:
   sym::Symbol *func_;  ///< Function name
   ExpList *args_;      ///< Argument expressions
+  mutable env::FunEntry *entry_ = nullptr; ///< Resolved by semantic analysis
 
   CallExp(int pos, sym::Symbol *func, ExpList *args)
       : Exp(pos), func_(func), args_(args) {
@@ -347,7 +357,7 @@ public:
 
   void Print(FILE *out, int d) const override;
   type::Ty *SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
-                       err::ErrorMsg *errormsg) const override;
+                       int depth, err::ErrorMsg *errormsg) const override;
   tr::ExpAndTy *Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
                           tr::Level *level, temp::Label *label,
                           err::ErrorMsg *errormsg) const override;
@@ -372,7 +382,7 @@ public:
 
   void Print(FILE *out, int d) const override;
   type::Ty *SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
-                       err::ErrorMsg *errormsg) const override;
+                       int depth, err::ErrorMsg *errormsg) const override;
   tr::ExpAndTy *Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
                           tr::Level *level, temp::Label *label,
                           err::ErrorMsg *errormsg) const override;
@@ -390,6 +400,7 @@ class RecordExp : public Exp {
 public:
   sym::Symbol *typ_;     ///< Record type name
   EFieldList *fields_;   ///< Field initializers
+  mutable type::Ty *ty_ = nullptr; ///< typ_, resolved by semantic analysis
 
   RecordExp(int pos, sym::Symbol *typ, EFieldList *fields)
       : Exp(pos), typ_(typ), fields_(fields) {}
@@ -397,7 +408,7 @@ public:
 
   void Print(FILE *out, int d) const override;
   type::Ty *SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
-                       err::ErrorMsg *errormsg) const override;
+                       int depth, err::ErrorMsg *errormsg) const override;
   tr::ExpAndTy *Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
                           tr::Level *level, temp::Label *label,
                           err::ErrorMsg *errormsg) const override;
@@ -420,7 +431,7 @@ public:
 
   void Print(FILE *out, int d) const override;
   type::Ty *SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
-                       err::ErrorMsg *errormsg) const override;
+                       int depth, err::ErrorMsg *errormsg) const override;
   tr::ExpAndTy *Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
                           tr::Level *level, temp::Label *label,
                           err::ErrorMsg *errormsg) const override;
@@ -444,7 +455,7 @@ public:
 
   void Print(FILE *out, int d) const override;
   type::Ty *SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
-                       err::ErrorMsg *errormsg) const override;
+                       int depth, err::ErrorMsg *errormsg) const override;
   tr::ExpAndTy *Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
                           tr::Level *level, temp::Label *label,
                           err::ErrorMsg *errormsg) const override;
@@ -470,7 +481,7 @@ public:
 
   void Print(FILE *out, int d) const override;
   type::Ty *SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
-                       err::ErrorMsg *errormsg) const override;
+                       int depth, err::ErrorMsg *errormsg) const override;
   tr::ExpAndTy *Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
                           tr::Level *level, temp::Label *label,
                           err::ErrorMsg *errormsg) const override;
@@ -495,7 +506,7 @@ public:
 
   void Print(FILE *out, int d) const override;
   type::Ty *SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
-                       err::ErrorMsg *errormsg) const override;
+                       int depth, err::ErrorMsg *errormsg) const override;
   tr::ExpAndTy *Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
                           tr::Level *level, temp::Label *label,
                           err::ErrorMsg *errormsg) const override;
@@ -515,7 +526,8 @@ public:
   sym::Symbol *var_;  ///< Loop variable name
   Exp *lo_, *hi_;     ///< Lower and upper bounds (inclusive)
   Exp *body_;         ///< Loop body
-  bool escape_;       ///< Escape flag (set by escape analysis)
+  mutable bool escape_; ///< Escape flag (set by escape or semantic analysis)
+  mutable env::VarEntry *entry_ = nullptr; ///< Of var_, by semantic analysis
 
   ForExp(int pos, sym::Symbol *var, Exp *lo, Exp *hi, Exp *body)
       : Exp(pos), var_(var), lo_(lo), hi_(hi), body_(body), escape_(true) {}
@@ -523,7 +535,7 @@ public:
 
   void Print(FILE *out, int d) const override;
   type::Ty *SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
-                       err::ErrorMsg *errormsg) const override;
+                       int depth, err::ErrorMsg *errormsg) const override;
   tr::ExpAndTy *Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
                           tr::Level *level, temp::Label *label,
                           err::ErrorMsg *errormsg) const override;
@@ -544,7 +556,7 @@ public:
 
   void Print(FILE *out, int d) const override;
   type::Ty *SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
-                       err::ErrorMsg *errormsg) const override;
+                       int depth, err::ErrorMsg *errormsg) const override;
   tr::ExpAndTy *Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
                           tr::Level *level, temp::Label *label,
                           err::ErrorMsg *errormsg) const override;
@@ -570,7 +582,7 @@ public:
 
   void Print(FILE *out, int d) const override;
   type::Ty *SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
-                       err::ErrorMsg *errormsg) const override;
+                       int depth, err::ErrorMsg *errormsg) const override;
   tr::ExpAndTy *Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
                           tr::Level *level, temp::Label *label,
                           err::ErrorMsg *errormsg) const override;
@@ -589,6 +601,7 @@ public:
   sym::Symbol *typ_;  ///< Array type name
   Exp *size_;         ///< Array size expression
   Exp *init_;         ///< Initial value expression
+  mutable type::Ty *ty_ = nullptr; ///< typ_, resolved by semantic analysis
 
   ArrayExp(int pos, sym::Symbol *typ, Exp *size, Exp *init)
       : Exp(pos), typ_(typ), size_(size), init_(init) {}
@@ -596,7 +609,7 @@ public:
 
   void Print(FILE *out, int d) const override;
   type::Ty *SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
-                       err::ErrorMsg *errormsg) const override;
+                       int depth, err::ErrorMsg *errormsg) const override;
   tr::ExpAndTy *Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
                           tr::Level *level, temp::Label *label,
                           err::ErrorMsg *errormsg) const override;
@@ -616,7 +629,7 @@ public:
 
   void Print(FILE *out, int d) const override;
   type::Ty *SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
-                       err::ErrorMsg *errormsg) const override;
+                       int depth, err::ErrorMsg *errormsg) const override;
   tr::ExpAndTy *Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
                           tr::Level *level, temp::Label *label,
                           err::ErrorMsg *errormsg) const override;
@@ -638,13 +651,13 @@ public:
  * All declarations support semantic analysis and translation.
  * Declarations update the symbol tables (venv and tenv).
  */
-class Dec {
+class Dec : public util::AllocTracked<Dec> {
 public:
   int pos_;
   virtual ~Dec() = default;
   virtual void Print(FILE *out, int d) const = 0;
   virtual void SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
-                          err::ErrorMsg *errormsg) const = 0;
+                          int depth, err::ErrorMsg *errormsg) const = 0;
   virtual tr::Exp *Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
                              tr::Level *level, temp::Label *label,
                              err::ErrorMsg *errormsg) const = 0;
@@ -671,7 +684,7 @@ public:
 
   void Print(FILE *out, int d) const override;
   void SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
-                  err::ErrorMsg *errormsg) const override;
+                  int depth, err::ErrorMsg *errormsg) const override;
   tr::Exp *Translate(env::VEnvPtr venv, env::TEnvPtr tenv, tr::Level *level,
                      temp::Label *label, 
                      err::ErrorMsg *errormsg) const override;
@@ -690,7 +703,8 @@ public:
   sym::Symbol *var_;  ///< Variable name
   sym::Symbol *typ_;  ///< Type name (may be nullptr if type omitted)
   Exp *init_;         ///< Initial value expression
-  bool escape_;       ///< Escape flag (set by escape analysis)
+  mutable bool escape_; ///< Escape flag (set by escape or semantic analysis)
+  mutable env::VarEntry *entry_ = nullptr; ///< Of var_, by semantic analysis
 
   VarDec(int pos, sym::Symbol *var, sym::Symbol *typ, Exp *init)
       : Dec(pos), var_(var), typ_(typ), init_(init), escape_(true) {}
@@ -698,7 +712,7 @@ public:
 
   void Print(FILE *out, int d) const override;
   void SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
-                  err::ErrorMsg *errormsg) const override;
+                  int depth, err::ErrorMsg *errormsg) const override;
   tr::Exp *Translate(env::VEnvPtr venv, env::TEnvPtr tenv, tr::Level *level,
                      temp::Label *label, 
                      err::ErrorMsg *errormsg) const override;
@@ -721,7 +735,7 @@ public:
 
   void Print(FILE *out, int d) const override;
   void SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
-                  err::ErrorMsg *errormsg) const override;
+                  int depth, err::ErrorMsg *errormsg) const override;
   tr::Exp *Translate(env::VEnvPtr venv, env::TEnvPtr tenv, tr::Level *level,
                      temp::Label *label, 
                      err::ErrorMsg *errormsg) const override;
@@ -743,7 +757,7 @@ public:
  * Type definitions are analyzed during semantic analysis to create
  * type objects in the type environment.
  */
-class Ty {
+class Ty : public util::AllocTracked<Ty> {
 public:
   int pos_;
   virtual ~Ty() = default;
@@ -838,7 +852,8 @@ class Field {
 public:
   int pos_;              ///< Source position
   sym::Symbol *name_, *typ_;  ///< Field name and type
-  bool escape_;          ///< Escape flag (set by escape analysis)
+  bool escape_;          ///< Escape flag (set by escape or semantic analysis)
+  env::VarEntry *entry_ = nullptr; ///< Of a parameter, by semantic analysis
 
   Field(int pos, sym::Symbol *name, sym::Symbol *typ)
       : pos_(pos), name_(name), typ_(typ), escape_(true) {}
@@ -891,6 +906,7 @@ public:
   FieldList *params_;
   sym::Symbol *result_;
   Exp *body_;
+  env::FunEntry *entry_ = nullptr; ///< Entered by semantic analysis
 
   FunDec(int pos, sym::Symbol *name, FieldList *params, sym::Symbol *result,
          Exp *body)
@@ -0,0 +1,202 @@
+/**
+ * @file generator.h
+ * @brief Seeded generator of large Tiger programs for the benchmarks
+ *
+ * The test cases are too small to show how the compiler scales, so the
+ * benchmarks compile programs made by GenerateProgram().  Each aspect of a
+ * program that some pass is sensitive to is a separate knob of
+ * GenOptions: the number of functions, how deeply functions nest (and so
+ * how many static links a variable access follows), how deeply loops
+ * nest, how many temps are live at once, and how many records, arrays and
+ * string literals each function uses.  The same options and seed always
+ * give the same program.
+ *
+ * Every program is well typed and terminates: loops run a fixed number of
+ * times, no function calls another top-level function, and every update of
+ * a variable halves it, so nothing overflows.  The program prints one
+ * checksum, which depends on every function.
+ */
+
+#ifndef TIGER_BENCH_GENERATOR_H_
+#define TIGER_BENCH_GENERATOR_H_
+
+#include <random>
+#include <string>
+
+namespace bench {
+
+/**
+ * @brief The shape of a generated program
+ */
+struct GenOptions {
+  unsigned seed_ = 1;
+  int functions_ = 100;                 ///< Top-level functions
+  int depth_ = 2;                       ///< Functions nested one in another in each
+  int loops_ = 2;                       ///< Loops nested in each function body
+  int temps_ = 8;                       ///< Integer locals of each function, all live in its loops
+  int records_ = 1;                     ///< Record variables of each function
+  int arrays_ = 1;                      ///< Array variables of each function
+  int strings_ = 2;                     ///< String literals of each function
+  int trip_ = 4;                        ///< Iterations of each loop
+};
+
+namespace detail {
+
+/// Writes one program for GenerateProgram()
+class Generator {
+public:
+  explicit Generator(const GenOptions &options)
+      : options_(options), random_(options.seed_) {}
+
+  std::string Program() {
+    out_ += "/* Generated: seed " + std::to_string(options_.seed_) + " */\n";
+    out_ += "let\n";
+    if (options_.records_ > 0)
+      out_ += "  type rec = {a: int, b: int}\n";
+    if (options_.arrays_ > 0)
+      out_ += "  type arr = array of int\n";
+    for (int k = 0; k < options_.functions_; ++k)
+      Function(k);
+    out_ += "  var checksum := 0\n";
+    out_ += "in\n";
+    for (int k = 0; k < options_.functions_; ++k)
+      out_ += "  checksum := (checksum + f" + std::to_string(k) + "(" +
+              std::to_string(k % 17) + ", " + std::to_string(Pick(100)) +
+              ")) / 2;\n";
+    out_ += "  printi(checksum);\n";
+    out_ += "  print(\"\\n\")\n";
+    out_ += "end\n";
+    return std::move(out_);
+  }
+
+private:
+  const GenOptions &options_;
+  std::mt19937 random_;
+  std::string out_;
+
+  /// A number in [0, n)
+  int Pick(int n) {
+    return n <= 1 ? 0 : static_cast<int>(random_() % static_cast<unsigned>(n));
+  }
+
+  static std::string Temp(int i) { return "v" + std::to_string(i); }
+
+  /// Innermost loop variable, or 0 outside loops
+  std::string Index() const {
+    return options_.loops_ > 0 ? "i" + std::to_string(options_.loops_ - 1)
+                               : std::string("0");
+  }
+
+  /// Top-level function fk(x, y)
+  void Function(int k) {
+    std::string f = "f" + std::to_string(k);
+    int temps = options_.temps_ > 0 ? options_.temps_ : 1;
+    out_ += "  function " + f + "(x: int, y: int): int =\n";
+    out_ += "    let\n";
+    for (int t = 0; t < temps; ++t)
+      out_ += "      var " + Temp(t) + " := " + (Pick(2) ? "x" : "y") + " + " +
+              std::to_string(Pick(50)) + "\n";
+    for (int r = 0; r < options_.records_; ++r)
+      out_ += "      var r" + std::to_string(r) + " := rec{a = x, b = " +
+              std::to_string(Pick(50)) + "}\n";
+    for (int a = 0; a < options_.arrays_; ++a)
+      out_ += "      var a" + std::to_string(a) + " := arr[" +
+              std::to_string(options_.trip_) + "] of " +
+              std::to_string(Pick(50)) + "\n";
+    for (int s = 0; s < options_.strings_; ++s)
+      out_ += "      var s" + std::to_string(s) + " := \"" + f + " string " +
+              std::to_string(s) + std::string(Pick(24), '.') + "\"\n";
+    if (options_.depth_ > 0)
+      Nested(f, 1, "      ");
+    out_ += "    in\n";
+
+    // The loops, innermost updating every variable
+    std::string indent = "      ";
+    for (int l = 0; l < options_.loops_; ++l) {
+      out_ += indent + "for i" + std::to_string(l) + " := 0 to " +
+              std::to_string(options_.trip_ - 1) + " do\n";
+      indent += "  ";
+    }
+    out_ += indent + "(";
+    std::string sep;
+    for (int t = 0; t < temps; ++t) {
+      out_ += sep + Update(t, temps);
+      sep = ";\n" + indent + " ";
+      if (t % 4 == 3) {
+        int a = Pick(temps), b = Pick(temps);
+        out_ += sep + "if " + Temp(a) + " > " + Temp(b) + " then " + Temp(a) +
+                " := " + Temp(a) + " - 1 else " + Temp(b) + " := " + Temp(b) +
+                " + 1";
+      }
+    }
+    for (int r = 0; r < options_.records_; ++r)
+      out_ += sep + "r" + std::to_string(r) + ".a := (r" + std::to_string(r) +
+              ".a + " + Temp(Pick(temps)) + ") / 2";
+    for (int a = 0; a < options_.arrays_; ++a) {
+      std::string elem = "a" + std::to_string(a) + "[" + Index() + "]";
+      out_ += sep + elem + " := (" + elem + " + " + Temp(Pick(temps)) + ") / 2";
+    }
+    out_ += ");\n";
+
+    // The result depends on everything
+    out_ += "      ";
+    sep.clear();
+    for (int t = 0; t < temps; ++t) {
+      out_ += sep + Temp(t);
+      sep = " + ";
+    }
+    for (int r = 0; r < options_.records_; ++r)
+      out_ += " + r" + std::to_string(r) + ".a + r" + std::to_string(r) + ".b";
+    for (int a = 0; a < options_.arrays_; ++a)
+      out_ += " + a" + std::to_string(a) + "[0]";
+    for (int s = 0; s < options_.strings_; ++s)
+      out_ += " + size(s" + std::to_string(s) + ")";
+    if (options_.depth_ > 0)
+      out_ += " + " + f + "_1(" + Temp(Pick(temps)) + ")";
+    out_ += "\n    end\n";
+  }
+
+  /// vt := some contracting combination of vt, another temp and the index
+  std::string Update(int t, int temps) {
+    std::string v = Temp(t), w = Temp(Pick(temps));
+    switch (Pick(3)) {
+    case 0:
+      return v + " := (" + v + " + " + w + " + " + Index() + ") / 2";
+    case 1:
+      return v + " := (" + v + " * 3 + " + w + ") / 4";
+    default:
+      return v + " := (" + w + " - " + v + " + " + std::to_string(Pick(20)) +
+             ") / 2";
+    }
+  }
+
+  /**
+   * @brief fk_d(z), which calls fk_(d+1) nested in it, and the deepest of
+   *        which reads x and v0 of fk through all the static links
+   */
+  void Nested(const std::string &f, int d, const std::string &indent) {
+    std::string g = f + "_" + std::to_string(d);
+    out_ += indent + "function " + g + "(z: int): int =\n";
+    if (d == options_.depth_) {
+      out_ += indent + "  (z + x + v0) / 2\n";
+      return;
+    }
+    out_ += indent + "  let\n";
+    Nested(f, d + 1, indent + "    ");
+    out_ += indent + "  in\n";
+    out_ += indent + "    (" + f + "_" + std::to_string(d + 1) + "(z + " +
+            std::to_string(Pick(10)) + ") + x) / 2\n";
+    out_ += indent + "  end\n";
+  }
+};
+
+} // namespace detail
+
+/** @brief The Tiger program of @p options */
+inline std::string GenerateProgram(const GenOptions &options) {
+  return detail::Generator(options).Program();
+}
+
+} // namespace bench
+
+#endif // TIGER_BENCH_GENERATOR_H_
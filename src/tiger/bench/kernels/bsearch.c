@@ -0,0 +1,32 @@
+/* C equivalent of testdata/lab5or6/testcases/bsearch.tig */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define N 16
+
+static long *list;
+
+static void nop(void) { fputs("", stdout); }
+
+static void init(void) {
+  for (long i = 0; i <= N - 1; i++) {
+    list[i] = i * 2 + 1;
+    nop();
+  }
+}
+
+static long bsearch_(long left, long right, long c) {
+  if (left == right)
+    return left;
+  long mid = (left + right) / 2;
+  return list[mid] < c ? bsearch_(mid + 1, right, c) : bsearch_(left, mid, c);
+}
+
+int main(void) {
+  list = calloc(N, sizeof(long));
+  init();
+  printf("%d", (int)bsearch_(0, N - 1, 7));
+  fputs("\n", stdout);
+  return 0;
+}
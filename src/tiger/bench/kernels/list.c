@@ -0,0 +1,43 @@
+/* C equivalent of list.tig */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define N 10000
+
+struct node {
+  long value;
+  struct node *next;
+};
+
+static struct node *build(void) {
+  struct node *head = NULL;
+  for (long i = 0; i <= N - 1; i++) {
+    struct node *n = malloc(sizeof(*n));
+    n->value = i * 7 - i * 7 / 1000 * 1000;
+    n->next = head;
+    head = n;
+  }
+  return head;
+}
+
+static long walk(struct node *head, long passes) {
+  long sum = 0;
+  struct node *p = head;
+  for (long pass = 1; pass <= passes; pass++) {
+    p = head;
+    while (p != NULL) {
+      sum = sum + p->value;
+      if (sum >= 1000003)
+        sum = sum - 1000003;
+      p = p->next;
+    }
+  }
+  return sum;
+}
+
+int main(void) {
+  printf("%d", (int)walk(build(), 100));
+  fputs("\n", stdout);
+  return 0;
+}
@@ -0,0 +1,46 @@
+/* C equivalent of matmul.tig */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define N 64
+
+static long *a, *b, *c;
+
+static long mod(long x, long m) { return x - x / m * m; }
+
+static void init(void) {
+  for (long i = 0; i <= N - 1; i++)
+    for (long j = 0; j <= N - 1; j++) {
+      a[i * N + j] = mod(i + 2 * j, 7);
+      b[i * N + j] = mod(3 * i + j, 5);
+    }
+}
+
+static void multiply(void) {
+  for (long i = 0; i <= N - 1; i++)
+    for (long j = 0; j <= N - 1; j++) {
+      long sum = 0;
+      for (long k = 0; k <= N - 1; k++)
+        sum = sum + a[i * N + k] * b[k * N + j];
+      c[i * N + j] = sum;
+    }
+}
+
+static long checksum(void) {
+  long sum = 0;
+  for (long i = 0; i <= N * N - 1; i++)
+    sum = mod(sum + c[i] * mod(i, 13), 1000003);
+  return sum;
+}
+
+int main(void) {
+  a = calloc(N * N, sizeof(long));
+  b = calloc(N * N, sizeof(long));
+  c = calloc(N * N, sizeof(long));
+  init();
+  multiply();
+  printf("%d", (int)checksum());
+  fputs("\n", stdout);
+  return 0;
+}
@@ -0,0 +1,85 @@
+/* C equivalent of testdata/lab5or6/testcases/merge.tig */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+struct list {
+  long first;
+  struct list *rest;
+};
+
+static int buffer;
+
+static int isdigit_(void) { return buffer >= '0' && buffer <= '9'; }
+
+static long readint(long *any) {
+  long i = 0;
+  while (buffer == ' ' || buffer == '\n')
+    buffer = getchar();
+  *any = isdigit_();
+  while (isdigit_()) {
+    i = i * 10 + buffer - '0';
+    buffer = getchar();
+  }
+  return i;
+}
+
+static struct list *readlist(void) {
+  long any;
+  long i = readint(&any);
+  if (!any)
+    return NULL;
+  struct list *l = malloc(sizeof(*l));
+  l->first = i;
+  l->rest = readlist();
+  return l;
+}
+
+static struct list *cons(long first, struct list *rest) {
+  struct list *l = malloc(sizeof(*l));
+  l->first = first;
+  l->rest = rest;
+  return l;
+}
+
+static struct list *merge(struct list *a, struct list *b) {
+  if (!a)
+    return b;
+  if (!b)
+    return a;
+  if (a->first < b->first)
+    return cons(a->first, merge(a->rest, b));
+  return cons(b->first, merge(a, b->rest));
+}
+
+static void printint(long i) {
+  char digits[24];
+  int n = 0;
+  if (i < 0) {
+    fputs("-", stdout);
+    i = -i;
+  }
+  if (i == 0)
+    fputs("0", stdout);
+  for (; i > 0; i /= 10)
+    digits[n++] = (char)('0' + i % 10);
+  while (n > 0)
+    putchar(digits[--n]);
+}
+
+static void printlist(struct list *l) {
+  for (; l; l = l->rest) {
+    printint(l->first);
+    fputs(" ", stdout);
+  }
+  fputs("\n", stdout);
+}
+
+int main(void) {
+  buffer = getchar();
+  struct list *list1 = readlist();
+  buffer = getchar();
+  struct list *list2 = readlist();
+  printlist(merge(list1, list2));
+  return 0;
+}
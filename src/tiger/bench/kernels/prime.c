@@ -0,0 +1,23 @@
+/* C equivalent of testdata/lab5or6/testcases/prime.tig */
+
+#include <stdio.h>
+
+static long check(long num) {
+  long flag = 1;
+  for (long i = 2; i <= num / 2; i++)
+    if (num / i * i == num) {
+      flag = 0;
+      break;
+    }
+  return flag;
+}
+
+int main(void) {
+  static const long numbers[] = {56,  23,  71,  72,  173, 181,
+                                 281, 659, 729, 947, 945};
+  for (unsigned k = 0; k < sizeof(numbers) / sizeof(numbers[0]); k++) {
+    printf("%d", (int)check(numbers[k]));
+    fputs("\n", stdout);
+  }
+  return 0;
+}
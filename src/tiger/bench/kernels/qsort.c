@@ -0,0 +1,46 @@
+/* C equivalent of testdata/lab5or6/testcases/qsort.tig */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define N 16
+
+static long *list;
+
+static void nop(void) { fputs("", stdout); }
+
+static void init(void) {
+  for (long i = 0; i <= N - 1; i++) {
+    list[i] = N - i;
+    nop();
+  }
+}
+
+static void quicksort(long left, long right) {
+  long i = left, j = right, key = list[left];
+  if (left < right) {
+    while (i < j) {
+      while (i < j && key <= list[j])
+        j = j - 1;
+      list[i] = list[j];
+      while (i < j && key >= list[i])
+        i = i + 1;
+      list[j] = list[i];
+    }
+    list[i] = key;
+    quicksort(left, i - 1);
+    quicksort(i + 1, right);
+  }
+}
+
+int main(void) {
+  list = calloc(N, sizeof(long));
+  init();
+  quicksort(0, N - 1);
+  for (long i = 0; i <= N - 1; i++) {
+    printf("%d", (int)list[i]);
+    fputs(" ", stdout);
+  }
+  fputs("\n", stdout);
+  return 0;
+}
@@ -0,0 +1,38 @@
+/* C equivalent of testdata/lab5or6/testcases/queens.tig */
+
+#include <stdio.h>
+
+#define N 8
+
+static long row[N], col[N], diag1[N + N - 1], diag2[N + N - 1];
+
+static void printboard(void) {
+  for (long i = 0; i <= N - 1; i++) {
+    for (long j = 0; j <= N - 1; j++)
+      fputs(col[i] == j ? " O" : " .", stdout);
+    fputs("\n", stdout);
+  }
+  fputs("\n", stdout);
+}
+
+static void try(long c) {
+  if (c == N)
+    printboard();
+  else
+    for (long r = 0; r <= N - 1; r++)
+      if (row[r] == 0 && diag1[r + c] == 0 && diag2[r + 7 - c] == 0) {
+        row[r] = 1;
+        diag1[r + c] = 1;
+        diag2[r + 7 - c] = 1;
+        col[c] = r;
+        try(c + 1);
+        row[r] = 0;
+        diag1[r + c] = 0;
+        diag2[r + 7 - c] = 0;
+      }
+}
+
+int main(void) {
+  try(0);
+  return 0;
+}
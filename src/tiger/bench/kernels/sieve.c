@@ -0,0 +1,29 @@
+/* C equivalent of sieve.tig */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define N 100000
+
+static long *composite;
+
+static long sieve(void) {
+  long count = 0, j = 0;
+  for (long i = 2; i <= N; i++)
+    if (composite[i] == 0) {
+      count = count + 1;
+      j = i * i;
+      while (j <= N) {
+        composite[j] = 1;
+        j = j + i;
+      }
+    }
+  return count;
+}
+
+int main(void) {
+  composite = calloc(N + 1, sizeof(long));
+  printf("%d", (int)sieve());
+  fputs("\n", stdout);
+  return 0;
+}
@@ -0,0 +1,71 @@
+/*
+ * C equivalent of strbuild.tig, with strings made the way the Tiger
+ * runtime makes them: every concatenation and substring is a new copy, and
+ * none is freed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define N 2000
+
+struct string {
+  int length;
+  char chars[1];
+};
+
+static struct string *letters[26];
+
+static struct string *letter(long i) { return letters[i - i / 26 * 26]; }
+
+static struct string *concat(struct string *a, struct string *b) {
+  if (a->length == 0)
+    return b;
+  if (b->length == 0)
+    return a;
+  struct string *t = malloc(sizeof(int) + a->length + b->length);
+  t->length = a->length + b->length;
+  memcpy(t->chars, a->chars, a->length);
+  memcpy(t->chars + a->length, b->chars, b->length);
+  return t;
+}
+
+static struct string *substring(struct string *s, long first, long n) {
+  struct string *t = malloc(sizeof(int) + n);
+  t->length = (int)n;
+  memcpy(t->chars, s->chars + first, n);
+  return t;
+}
+
+static int equal(struct string *s, struct string *t) {
+  return s == t ||
+         (s->length == t->length && memcmp(s->chars, t->chars, s->length) == 0);
+}
+
+static struct string *build(void) {
+  static struct string empty = {0, ""};
+  struct string *s = &empty;
+  for (long i = 0; i <= N - 1; i++)
+    s = concat(s, letter(i));
+  return s;
+}
+
+static long checksum(struct string *s) {
+  long sum = s->length;
+  for (long i = 0; i <= s->length - 1; i++)
+    if (equal(substring(s, i, 1), letter(i * 7)))
+      sum = sum + (unsigned char)substring(s, i, 1)->chars[0];
+  return sum;
+}
+
+int main(void) {
+  for (int i = 0; i < 26; i++) {
+    letters[i] = malloc(sizeof(struct string));
+    letters[i]->length = 1;
+    letters[i]->chars[0] = (char)('a' + i);
+  }
+  printf("%d", (int)checksum(build()));
+  fputs("\n", stdout);
+  return 0;
+}
@@ -32,7 +32,7 @@ Stm *Stm::Seq(tree::Stm *x, tree::Stm *y) {
     return y;
   if (y->IsNop())
     return x;
-  return new tree::SeqStm(x, y);
+  return util::New<tree::SeqStm>(x, y);
 }
 
 bool Stm::Commute(tree::Stm *x, tree::Exp *y) {
@@ -68,7 +68,7 @@ struct ExpRefList {
 
   tree::Stm *Reorder() {
     if (refs.empty()) {
-      return new tree::ExpStm(new tree::ConstExp(0)); // nop
+      return util::New<tree::ExpStm>(util::New<tree::ConstExp>(0)); // nop
     } else {
       tree::Exp *&ref = refs.front().get();
       if (typeid(*ref) == typeid(tree::CallExp)) {
@@ -76,8 +76,8 @@ struct ExpRefList {
         // force the call result into a fresh TEMP so later reordering can treat
         // the call like an ordinary side-effect-free operand.
         temp::Temp *t = temp::TempFactory::NewTemp();
-        ref = new tree::EseqExp(new tree::MoveStm(new tree::TempExp(t), ref),
-                                new tree::TempExp(t));
+        ref = util::New<tree::EseqExp>(util::New<tree::MoveStm>(util::New<tree::TempExp>(t), ref),
+                                util::New<tree::TempExp>(t));
         return Reorder();
       } else {
         canon::StmAndExp hd = ref->Canon();
@@ -93,10 +93,10 @@ struct ExpRefList {
           // Unsafe case: preserve evaluation order by saving hd.e_ into a TEMP
           // before executing the reordered tail.
           temp::Temp *t = temp::TempFactory::NewTemp();
-          ref = new tree::TempExp(t);
+          ref = util::New<tree::TempExp>(t);
           return tree::Stm::Seq(
               hd.s_, tree::Stm::Seq(
-                         new tree::MoveStm(new tree::TempExp(t), hd.e_), s));
+                         util::New<tree::MoveStm>(util::New<tree::TempExp>(t), hd.e_), s));
         }
       }
     }
@@ -107,7 +107,7 @@ ExpRefList *GetCallRlist(tree::Exp *exp) {
   auto callexp = dynamic_cast<tree::CallExp *>(exp);
   assert(callexp);
   tree::ExpList *args = callexp->args_;
-  auto *rlist = new ExpRefList(callexp->fun_, args->GetNonConstList().begin(),
+  auto *rlist = util::New<ExpRefList>(callexp->fun_, args->GetNonConstList().begin(),
                                args->GetNonConstList().end());
   return rlist;
 }
@@ -158,7 +158,7 @@ void Canon::Trace(std::list<tree::Stm *> &stms) {
       // If only the true successor is available, negate the relation so that
       // the available block becomes the false fall-through edge instead.
       stms.pop_back();
-      stms.push_back(new tree::CjumpStm(
+      stms.push_back(util::New<tree::CjumpStm>(
           tree::NotRel(cjumpstm->op_), cjumpstm->left_, cjumpstm->right_,
           cjumpstm->false_label_, cjumpstm->true_label_));
 
@@ -172,12 +172,12 @@ void Canon::Trace(std::list<tree::Stm *> &stms) {
       temp::Label *falselabel = temp::LabelFactory::NewLabel();
       stms.pop_back();
       std::list<tree::Stm *> tmp_stm_list = {
-          new tree::CjumpStm(cjumpstm->op_, cjumpstm->left_, cjumpstm->right_,
+          util::New<tree::CjumpStm>(cjumpstm->op_, cjumpstm->left_, cjumpstm->right_,
                              cjumpstm->true_label_, falselabel),
-          new tree::LabelStm(falselabel),
-          new tree::JumpStm(
-              new tree::NameExp(cjumpstm->false_label_),
-              new std::vector<temp::Label *>({cjumpstm->false_label_}))};
+          util::New<tree::LabelStm>(falselabel),
+          util::New<tree::JumpStm>(
+              util::New<tree::NameExp>(cjumpstm->false_label_),
+              util::New<std::vector<temp::Label *>>({cjumpstm->false_label_}))};
       stms.insert(stms.end(), tmp_stm_list.begin(), tmp_stm_list.end());
       auto insert = GetNext()->stm_list_;
       stms.insert(stms.end(), insert.begin(), insert.end());
@@ -191,13 +191,14 @@ tree::StmList *Canon::GetNext() {
     // Trace scheduling always ends with a final synthetic label so the last
     // block still has a concrete successor anchor.
     auto *last_stm_list = new tree::StmList();
-    last_stm_list->stm_list_.push_back(new tree::LabelStm(block_.label_));
+    last_stm_list->stm_list_.push_back(util::New<tree::LabelStm>(block_.label_));
     return last_stm_list;
   } else {
     tree::StmList *s = block_.stm_lists_->stmlist_list_.front();
     auto lab = dynamic_cast<tree::LabelStm *>(s->stm_list_.front());
     assert(lab);
     if (block_env_->Look(lab->label_)) { // label_ exists in the table
+      ++trace_count_;
       Trace(s->stm_list_);
       return s;
     } else {
@@ -229,7 +230,7 @@ canon::StmListList *Canon::BasicBlocks() {
         // Every basic block must have a unique entry label, even if the
         // linearized statement stream did not begin with one.
         cur_list->stm_list_.push_front(
-            new tree::LabelStm(temp::LabelFactory::NewLabel()));
+            util::New<tree::LabelStm>(temp::LabelFactory::NewLabel()));
       }
     }
     if (typeid(*stm) == typeid(tree::JumpStm) ||
@@ -250,8 +251,8 @@ canon::StmListList *Canon::BasicBlocks() {
       cur_list->stm_list_.insert(cur_list->stm_list_.end(), left, right);
       left = right;
       auto label = static_cast<tree::LabelStm *>(stm)->label_;
-      cur_list->stm_list_.push_back(new tree::JumpStm(
-          new tree::NameExp(label), new std::vector<temp::Label *>({label})));
+      cur_list->stm_list_.push_back(util::New<tree::JumpStm>(
+          util::New<tree::NameExp>(label), util::New<std::vector<temp::Label *>>({label})));
       stm_lists->Append(cur_list);
       cur_list = new tree::StmList();
     }
@@ -259,8 +260,8 @@ canon::StmListList *Canon::BasicBlocks() {
     start = false;
   }
   cur_list->stm_list_.insert(cur_list->stm_list_.end(), left, right);
-  cur_list->stm_list_.push_back(new tree::JumpStm(
-      new tree::NameExp(done), new std::vector<temp::Label *>({done})));
+  cur_list->stm_list_.push_back(util::New<tree::JumpStm>(
+      util::New<tree::NameExp>(done), util::New<std::vector<temp::Label *>>({done})));
   stm_lists->Append(cur_list);
   block_ = Block(done, stm_lists);
   return block_.stm_lists_;
@@ -286,7 +287,7 @@ Traces::~Traces() { delete stm_list_; }
 
 namespace tree {
 
-#define NOP (new tree::ExpStm(new tree::ConstExp(0)))
+#define NOP (util::New<tree::ExpStm>(util::New<tree::ConstExp>(0)))
 
 Stm *SeqStm::Canon() { return tree::Stm::Seq(left_->Canon(), right_->Canon()); }
 
@@ -306,7 +307,7 @@ Stm *MoveStm::Canon() {
     // permits, so we only need to reorder the call's function/arguments.
     return tree::Stm::Seq(GetCallRlist(src_)->Reorder(), this);
   } else if (typeid(*(dst_)) == typeid(TempExp)) {
-    return tree::Stm::Seq((new ExpRefList(src_))->Reorder(), this);
+    return tree::Stm::Seq((util::New<ExpRefList>(src_))->Reorder(), this);
   } else if (typeid(*(dst_)) == typeid(MemExp)) {
     // Stores constrain both the address and the stored value, so they must be
     // reordered together to preserve memory side-effect order.
@@ -318,7 +319,7 @@ Stm *MoveStm::Canon() {
     auto eseqexp = static_cast<EseqExp *>(dst_);
     Stm *s = eseqexp->stm_;
     dst_ = eseqexp->exp_;
-    return (new SeqStm(s, this))->Canon();
+    return (util::New<SeqStm>(s, this))->Canon();
   }
   assert(0); // dst_ should be temp or mem only
 }
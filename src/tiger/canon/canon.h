@@ -265,6 +265,9 @@ public:
    */
   tree::StmList *TraceSchedule();
 
+  /** @brief Number of traces TraceSchedule() laid out */
+  [[nodiscard]] int TraceCount() const { return trace_count_; }
+
   /**
    * @brief Transfer ownership of the trace result to the caller
    * @return Unique pointer to the Traces object
@@ -277,6 +280,7 @@ private:
   Block block_;                            ///< Current block descriptor (for TraceSchedule)
   sym::Table<tree::StmList> *block_env_;   ///< Maps labels to basic blocks (for trace lookup)
   std::unique_ptr<Traces> traces_;         ///< Result of TraceSchedule()
+  int trace_count_ = 0;                    ///< Traces started by GetNext()
 
   /**
    * @brief Get the next untraced block from the block list
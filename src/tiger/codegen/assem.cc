@@ -13,68 +13,75 @@ Temp *TempList::NthTemp(int i) const {
 } // namespace temp
 
 namespace assem {
-/**
- * First param is string created by this function by reading 'assem' string
- * and replacing `d `s and `j stuff.
- * Last param is function to use to determine what to do with each temp.
- * @param assem assembly string
- * @param dst dst_ temp
- * @param src src temp
- * @param jumps jump labels_
- * @param m temp map
- * @return formatted assembly string
- */
-static std::string Format(std::string_view assem, temp::TempList *dst,
-                          temp::TempList *src, Targets *jumps, temp::Map *m) {
-  std::string result;
-  for (std::string::size_type i = 0; i < assem.size(); i++) {
-    char ch = assem.at(i);
-    if (ch == '`') {
-      i++;
-      switch (assem.at(i)) {
-      case 's': {
-        i++;
-        int n = assem.at(i) - '0';
-        std::string *s = m->Look(src->NthTemp(n));
-        result += *s;
-      } break;
-      case 'd': {
-        i++;
-        int n = assem.at(i) - '0';
-        std::string *s = m->Look(dst->NthTemp(n));
-        result += *s;
-      } break;
-      case 'j': {
-        i++;
-        assert(jumps);
-        std::string::size_type n = assem.at(i) - '0';
-        std::string s = temp::LabelFactory::LabelString(jumps->labels_->at(n));
-        result += s;
-      } break;
-      case '`': {
-        result += '`';
-      } break;
-      default:
-        assert(0);
-      }
-    } else {
-      result += ch;
+
+Template::Template(std::string_view assem) {
+  uint32_t run = 0;  // start of the literal run being scanned
+  auto close_run = [&](uint32_t end) {
+    if (end > run)
+      segments_.push_back({Segment::TEXT, 0, run, end - run});
+  };
+  for (uint32_t i = 0; i < assem.size(); i++) {
+    if (assem[i] != '`')
+      continue;
+    close_run(i);
+    assert(i + 1 < assem.size());
+    switch (assem[i + 1]) {
+    case 's':
+    case 'd':
+    case 'j': {
+      assert(i + 2 < assem.size());
+      Segment::Kind kind = assem[i + 1] == 's'   ? Segment::SRC
+                           : assem[i + 1] == 'd' ? Segment::DST
+                                                 : Segment::JUMP;
+      segments_.push_back(
+          {kind, static_cast<uint8_t>(assem[i + 2] - '0'), 0, 0});
+      i += 2;
+      run = i + 1;
+    } break;
+    case '`':
+      // "``" is a literal backtick: start the next run at the second one
+      i += 1;
+      run = i;
+      break;
+    default:
+      assert(0);
+    }
+  }
+  close_run(static_cast<uint32_t>(assem.size()));
+}
+
+void Template::Emit(util::Writer &out, std::string_view assem,
+                    temp::TempList *dst, temp::TempList *src, Targets *jumps,
+                    temp::Map *m) const {
+  for (const Segment &seg : segments_) {
+    switch (seg.kind_) {
+    case Segment::TEXT:
+      out << assem.substr(seg.begin_, seg.length_);
+      break;
+    case Segment::SRC:
+      m->Write(out, src->NthTemp(seg.index_));
+      break;
+    case Segment::DST:
+      m->Write(out, dst->NthTemp(seg.index_));
+      break;
+    case Segment::JUMP:
+      assert(jumps);
+      out << jumps->labels_->at(seg.index_)->Name();
+      break;
     }
   }
-  return result;
 }
 
-void OperInstr::Print(FILE *out, temp::Map *m) const {
-  std::string result = Format(assem_, dst_, src_, jumps_, m);
-  fprintf(out, "%s\n", result.data());
+void OperInstr::Print(util::Writer &out, temp::Map *m) const {
+  format_.Emit(out, assem_, dst_, src_, jumps_, m);
+  out << '\n';
 }
 
-void LabelInstr::Print(FILE *out, temp::Map *m) const {
-  std::string result = Format(assem_, nullptr, nullptr, nullptr, m);
-  fprintf(out, "%s:\n", result.data());
+void LabelInstr::Print(util::Writer &out, temp::Map *m) const {
+  out << assem_ << ":\n";
 }
 
-void MoveInstr::Print(FILE *out, temp::Map *m) const {
+void MoveInstr::Print(util::Writer &out, temp::Map *m) const {
   if (!dst_ && !src_) {
     std::size_t srcpos = assem_.find_first_of('%');
     if (srcpos != std::string::npos) {
@@ -87,14 +94,14 @@ void MoveInstr::Print(FILE *out, temp::Map *m) const {
       }
     }
   }
-  std::string result = Format(assem_, dst_, src_, nullptr, m);
-  fprintf(out, "%s\n", result.data());
+  format_.Emit(out, assem_, dst_, src_, nullptr, m);
+  out << '\n';
 }
 
-void InstrList::Print(FILE *out, temp::Map *m) const {
+void InstrList::Print(util::Writer &out, temp::Map *m) const {
   for (auto instr : instr_list_)
     instr->Print(out, m);
-  fprintf(out, "\n");
+  out << '\n';
 }
 
 } // namespace assem
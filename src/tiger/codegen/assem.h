@@ -32,6 +32,10 @@
  * When printing, each placeholder is replaced by the register name from
  * the provided temp::Map (e.g., "`s0" → "%rax").
  *
+ * The string is split into literal runs and placeholders once, when the
+ * instruction is created (see Template), so printing only copies the runs
+ * and looks up the operands.
+ *
  * ─────────────────────────────────────────────────────────────────────────
  * InstrList
  * ─────────────────────────────────────────────────────────────────────────
@@ -44,16 +48,23 @@
  * ─────────────────────────────────────────────────────────────────────────
  * Wraps a function's instruction list with its prologue and epilogue
  * strings (generated by ProcEntryExit3).
+ *
+ * Instructions, their temp lists and targets are created with util::New()
+ * in the arena of the function being compiled.  The InstrList itself stays
+ * on the heap because its owners delete it.
  */
 
 #ifndef TIGER_CODEGEN_ASSEM_H_
 #define TIGER_CODEGEN_ASSEM_H_
 
+#include <cstdint>
 #include <cstdio>
 #include <string>
 #include <vector>
 
 #include "tiger/frame/temp.h"
+#include "tiger/util/arena.h"
+#include "tiger/util/writer.h"
 
 namespace assem {
 
@@ -70,6 +81,43 @@ public:
   explicit Targets(std::vector<temp::Label *> *labels) : labels_(labels) {}
 };
 
+/**
+ * @brief An assembly string pre-split into literal runs and placeholders
+ *
+ * Built once from the instruction's assembly string; Emit() then writes the
+ * instruction by copying each literal run and looking up each `s, `d or `j
+ * operand, without scanning the string again.  Literal runs are stored as
+ * offsets into the assembly string, which the instruction keeps.
+ */
+class Template {
+public:
+  explicit Template(std::string_view assem);
+
+  /**
+   * @brief Write the instruction text with operands substituted
+   * @param out   Output buffer
+   * @param assem The assembly string this template was built from
+   * @param dst   Destination temps (`d operands)
+   * @param src   Source temps (`s operands)
+   * @param jumps Jump targets (`j operands)
+   * @param m     Temp-to-register-name map
+   */
+  void Emit(util::Writer &out, std::string_view assem, temp::TempList *dst,
+            temp::TempList *src, Targets *jumps, temp::Map *m) const;
+
+private:
+  /// A literal run of the assembly string, or one placeholder
+  struct Segment {
+    enum Kind : uint8_t { TEXT, SRC, DST, JUMP };
+    Kind kind_;
+    uint8_t index_;   ///< Operand number (placeholders)
+    uint32_t begin_;  ///< Offset of the run in the assembly string (TEXT)
+    uint32_t length_; ///< Length of the run (TEXT)
+  };
+
+  std::vector<Segment> segments_;
+};
+
 /**
  * @brief Abstract base class for assembly instructions
  *
@@ -87,10 +135,10 @@ public:
 
   /**
    * @brief Print the instruction with register names from @p m
-   * @param out Output file
+   * @param out Output buffer
    * @param m   Temp-to-register-name map (from register allocation)
    */
-  virtual void Print(FILE *out, temp::Map *m) const = 0;
+  virtual void Print(util::Writer &out, temp::Map *m) const = 0;
 
   /**
    * @brief Get the temporaries defined (written) by this instruction
@@ -124,12 +172,14 @@ public:
   temp::TempList *dst_;     ///< Defined (destination) temporaries
   temp::TempList *src_;     ///< Used (source) temporaries
   Targets *jumps_;          ///< Jump targets (nullptr for non-branch instructions)
+  Template format_;         ///< assem_ split into runs and placeholders
 
   OperInstr(std::string assem, temp::TempList *dst, temp::TempList *src,
             Targets *jumps)
-      : assem_(std::move(assem)), dst_(dst), src_(src), jumps_(jumps) {}
+      : assem_(std::move(assem)), dst_(dst), src_(src), jumps_(jumps),
+        format_(assem_) {}
 
-  void Print(FILE *out, temp::Map *m) const override;
+  void Print(util::Writer &out, temp::Map *m) const override;
   [[nodiscard]] temp::TempList *Def() const override;
   [[nodiscard]] temp::TempList *Use() const override;
 };
@@ -151,7 +201,7 @@ public:
   LabelInstr(std::string assem, temp::Label *label)
       : assem_(std::move(assem)), label_(label) {}
 
-  void Print(FILE *out, temp::Map *m) const override;
+  void Print(util::Writer &out, temp::Map *m) const override;
   [[nodiscard]] temp::TempList *Def() const override;
   [[nodiscard]] temp::TempList *Use() const override;
 };
@@ -170,11 +220,12 @@ public:
   std::string assem_;    ///< Assembly template (usually "movq `s0, `d0")
   temp::TempList *dst_;  ///< Destination temporary (exactly one)
   temp::TempList *src_;  ///< Source temporary (exactly one)
+  Template format_;      ///< assem_ split into runs and placeholders
 
   MoveInstr(std::string assem, temp::TempList *dst, temp::TempList *src)
-      : assem_(std::move(assem)), dst_(dst), src_(src) {}
+      : assem_(std::move(assem)), dst_(dst), src_(src), format_(assem_) {}
 
-  void Print(FILE *out, temp::Map *m) const override;
+  void Print(util::Writer &out, temp::Map *m) const override;
   [[nodiscard]] temp::TempList *Def() const override;
   [[nodiscard]] temp::TempList *Use() const override;
 };
@@ -191,7 +242,7 @@ public:
   InstrList() = default;
 
   /** @brief Print all instructions with register names from @p m */
-  void Print(FILE *out, temp::Map *m) const;
+  void Print(util::Writer &out, temp::Map *m) const;
 
   /** @brief Append an instruction to the end of the list */
   void Append(assem::Instr *instr) { instr_list_.push_back(instr); }
@@ -202,9 +253,13 @@ public:
   /** @brief Erase the instruction at position @p pos */
   void Erase(std::list<Instr *>::const_iterator pos) { instr_list_.erase(pos); }
 
-  /** @brief Insert @p instr before position @p pos */
-  void Insert(std::list<Instr *>::const_iterator pos, assem::Instr *instr) {
-    instr_list_.insert(pos, instr);
+  /**
+   * @brief Insert @p instr before position @p pos
+   * @return The position of the inserted instruction
+   */
+  std::list<Instr *>::const_iterator Insert(std::list<Instr *>::const_iterator pos,
+                                            assem::Instr *instr) {
+    return instr_list_.insert(pos, instr);
   }
 
   /**
@@ -258,7 +313,7 @@ public:
   std::string fetch_;    ///< Assembly operand string (e.g., "8(`s1)")
   temp::TempList *regs_; ///< Base/index registers used in the address
 
-  MemFetch() { regs_ = new temp::TempList(); }
+  MemFetch() { regs_ = util::New<temp::TempList>(); }
   MemFetch(std::string fetch, temp::TempList *regs)
     : fetch_(fetch), regs_(regs) {}
 };
@@ -3,7 +3,7 @@
 #include <cstdint>
 #include <sstream>
 
-extern frame::RegManager *reg_manager;
+#include "tiger/frame/compilation.h"
 
 namespace {
 
@@ -33,8 +33,8 @@ void EmitArm64LoadImmediate(assem::InstrList &instr_list, temp::Temp *dst,
       instr_ss << "movz `d0, #" << chunk;
       if (shift != 0)
         instr_ss << ", lsl #" << shift;
-      instr_list.Append(new assem::OperInstr(
-          instr_ss.str(), new temp::TempList(dst), nullptr, nullptr));
+      instr_list.Append(util::New<assem::OperInstr>(
+          instr_ss.str(), util::New<temp::TempList>(dst), nullptr, nullptr));
       emitted = true;
       continue;
     }
@@ -45,23 +45,23 @@ void EmitArm64LoadImmediate(assem::InstrList &instr_list, temp::Temp *dst,
     instr_ss << "movk `d0, #" << chunk;
     if (shift != 0)
       instr_ss << ", lsl #" << shift;
-    instr_list.Append(new assem::OperInstr(
-        instr_ss.str(), new temp::TempList(dst), new temp::TempList(dst),
+    instr_list.Append(util::New<assem::OperInstr>(
+        instr_ss.str(), util::New<temp::TempList>(dst), util::New<temp::TempList>(dst),
         nullptr));
   }
 
   if (!emitted) {
-    instr_list.Append(new assem::OperInstr("movz `d0, #0",
-                                           new temp::TempList(dst), nullptr,
+    instr_list.Append(util::New<assem::OperInstr>("movz `d0, #0",
+                                           util::New<temp::TempList>(dst), nullptr,
                                            nullptr));
   }
 }
 
 void EmitArm64MoveReg(assem::InstrList &instr_list, temp::Temp *dst,
                       temp::Temp *src) {
-  instr_list.Append(new assem::MoveInstr("mov `d0, `s0",
-                                         new temp::TempList(dst),
-                                         new temp::TempList(src)));
+  instr_list.Append(util::New<assem::MoveInstr>("mov `d0, `s0",
+                                         util::New<temp::TempList>(dst),
+                                         util::New<temp::TempList>(src)));
 }
 
 struct Arm64MemFetch {
@@ -75,45 +75,45 @@ Arm64MemFetch *BuildArm64MemFetch(temp::Temp *base_reg, int offset, int ordinal,
   std::stringstream mem_ss;
   if (offset == 0) {
     mem_ss << "[`s" << ordinal << "]";
-    return new Arm64MemFetch{mem_ss.str(), new temp::TempList(base_reg), false};
+    return util::New<Arm64MemFetch>(Arm64MemFetch{mem_ss.str(), util::New<temp::TempList>(base_reg), false});
   }
 
   if (FitsArm64ScaledMemOffset(offset)) {
     mem_ss << "[`s" << ordinal << ", #" << offset << "]";
-    return new Arm64MemFetch{mem_ss.str(), new temp::TempList(base_reg), false};
+    return util::New<Arm64MemFetch>(Arm64MemFetch{mem_ss.str(), util::New<temp::TempList>(base_reg), false});
   }
 
   if (FitsArm64Signed9(offset)) {
     mem_ss << "[`s" << ordinal << ", #" << offset << "]";
-    return new Arm64MemFetch{mem_ss.str(), new temp::TempList(base_reg), true};
+    return util::New<Arm64MemFetch>(Arm64MemFetch{mem_ss.str(), util::New<temp::TempList>(base_reg), true});
   }
 
   temp::Temp *addr_reg = temp::TempFactory::NewTemp();
   if (offset > 0 && FitsArm64AddSubImm(offset)) {
     std::stringstream instr_ss;
     instr_ss << "add `d0, `s0, #" << offset;
-    instr_list.Append(new assem::OperInstr(
-        instr_ss.str(), new temp::TempList(addr_reg),
-        new temp::TempList(base_reg), nullptr));
+    instr_list.Append(util::New<assem::OperInstr>(
+        instr_ss.str(), util::New<temp::TempList>(addr_reg),
+        util::New<temp::TempList>(base_reg), nullptr));
   } else if (offset < 0 && FitsArm64AddSubImm(-offset)) {
     std::stringstream instr_ss;
     instr_ss << "sub `d0, `s0, #" << -offset;
-    instr_list.Append(new assem::OperInstr(
-        instr_ss.str(), new temp::TempList(addr_reg),
-        new temp::TempList(base_reg), nullptr));
+    instr_list.Append(util::New<assem::OperInstr>(
+        instr_ss.str(), util::New<temp::TempList>(addr_reg),
+        util::New<temp::TempList>(base_reg), nullptr));
   } else {
     temp::Temp *offset_reg = temp::TempFactory::NewTemp();
     EmitArm64LoadImmediate(instr_list, offset_reg,
                            offset >= 0 ? offset : -offset);
     std::stringstream instr_ss;
     instr_ss << (offset >= 0 ? "add" : "sub") << " `d0, `s0, `s1";
-    instr_list.Append(new assem::OperInstr(
-        instr_ss.str(), new temp::TempList(addr_reg),
-        new temp::TempList({base_reg, offset_reg}), nullptr));
+    instr_list.Append(util::New<assem::OperInstr>(
+        instr_ss.str(), util::New<temp::TempList>(addr_reg),
+        util::New<temp::TempList>({base_reg, offset_reg}), nullptr));
   }
 
   mem_ss << "[`s" << ordinal << "]";
-  return new Arm64MemFetch{mem_ss.str(), new temp::TempList(addr_reg), false};
+  return util::New<Arm64MemFetch>(Arm64MemFetch{mem_ss.str(), util::New<temp::TempList>(addr_reg), false});
 }
 
 assem::MemFetch *MunchMemX64(tree::Exp *mem_exp, int ordinal,
@@ -131,7 +131,7 @@ assem::MemFetch *MunchMemX64(tree::Exp *mem_exp, int ordinal,
         mem_ss << "(`s" << ordinal << ")";
       else
         mem_ss << offset_exp->consti_ << "(`s" << ordinal << ")";
-      return new assem::MemFetch(mem_ss.str(), new temp::TempList(base_reg));
+      return util::New<assem::MemFetch>(mem_ss.str(), util::New<temp::TempList>(base_reg));
     }
 
     if (typeid(*bin_exp->left_) == typeid(tree::ConstExp)) {
@@ -141,13 +141,13 @@ assem::MemFetch *MunchMemX64(tree::Exp *mem_exp, int ordinal,
         mem_ss << "(`s" << ordinal << ")";
       else
         mem_ss << offset_exp->consti_ << "(`s" << ordinal << ")";
-      return new assem::MemFetch(mem_ss.str(), new temp::TempList(base_reg));
+      return util::New<assem::MemFetch>(mem_ss.str(), util::New<temp::TempList>(base_reg));
     }
   }
 
   temp::Temp *mem_reg = exp->Munch(instr_list, fs);
   mem_ss << "(`s" << ordinal << ")";
-  return new assem::MemFetch(mem_ss.str(), new temp::TempList(mem_reg));
+  return util::New<assem::MemFetch>(mem_ss.str(), util::New<temp::TempList>(mem_reg));
 }
 
 Arm64MemFetch *MunchMemArm64(tree::Exp *mem_exp, int ordinal,
@@ -181,7 +181,7 @@ Arm64MemFetch *MunchMemArm64(tree::Exp *mem_exp, int ordinal,
   temp::Temp *addr_reg = exp->Munch(instr_list, fs);
   std::stringstream mem_ss;
   mem_ss << "[`s" << ordinal << "]";
-  return new Arm64MemFetch{mem_ss.str(), new temp::TempList(addr_reg), false};
+  return util::New<Arm64MemFetch>(Arm64MemFetch{mem_ss.str(), util::New<temp::TempList>(addr_reg), false});
 }
 
 void EmitArm64CompareBranch(tree::Exp *left, tree::Exp *right, tree::RelOp op,
@@ -194,21 +194,21 @@ void EmitArm64CompareBranch(tree::Exp *left, tree::Exp *right, tree::RelOp op,
     if (value >= 0 && value <= 4095) {
       std::stringstream instr_ss;
       instr_ss << "cmp `s0, #" << value;
-      instr_list.Append(new assem::OperInstr(instr_ss.str(), nullptr,
-                                             new temp::TempList(left_reg),
+      instr_list.Append(util::New<assem::OperInstr>(instr_ss.str(), nullptr,
+                                             util::New<temp::TempList>(left_reg),
                                              nullptr));
     } else {
       temp::Temp *right_reg = temp::TempFactory::NewTemp();
       EmitArm64LoadImmediate(instr_list, right_reg, value);
-      instr_list.Append(new assem::OperInstr(
-          "cmp `s0, `s1", nullptr, new temp::TempList({left_reg, right_reg}),
+      instr_list.Append(util::New<assem::OperInstr>(
+          "cmp `s0, `s1", nullptr, util::New<temp::TempList>({left_reg, right_reg}),
           nullptr));
     }
   } else {
     temp::Temp *left_reg = left->Munch(instr_list, fs);
     temp::Temp *right_reg = right->Munch(instr_list, fs);
-    instr_list.Append(new assem::OperInstr(
-        "cmp `s0, `s1", nullptr, new temp::TempList({left_reg, right_reg}),
+    instr_list.Append(util::New<assem::OperInstr>(
+        "cmp `s0, `s1", nullptr, util::New<temp::TempList>({left_reg, right_reg}),
         nullptr));
   }
 
@@ -248,9 +248,9 @@ void EmitArm64CompareBranch(tree::Exp *left, tree::Exp *right, tree::RelOp op,
     return;
   }
   branch_ss << true_label->Name();
-  instr_list.Append(new assem::OperInstr(
+  instr_list.Append(util::New<assem::OperInstr>(
       branch_ss.str(), nullptr, nullptr,
-      new assem::Targets(new std::vector<temp::Label *>{true_label})));
+      util::New<assem::Targets>(util::New<std::vector<temp::Label *>>({true_label}))));
 }
 
 } // namespace
@@ -268,10 +268,10 @@ void CodeGen::Codegen() {
   assem_instr_ = std::make_unique<AssemInstr>(instr_list);
 }
 
-void AssemInstr::Print(FILE *out, temp::Map *map) const {
+void AssemInstr::Print(util::Writer &out, temp::Map *map) const {
   for (auto instr : instr_list_->GetList())
     instr->Print(out, map);
-  fprintf(out, "\n");
+  out << '\n';
 }
 
 } // namespace cg
@@ -284,14 +284,14 @@ void SeqStm::Munch(assem::InstrList &instr_list, std::string_view fs) {
 }
 
 void LabelStm::Munch(assem::InstrList &instr_list, std::string_view fs) {
-  instr_list.Append(new assem::LabelInstr(label_->Name(), label_));
+  instr_list.Append(util::New<assem::LabelInstr>(std::string(label_->Name()), label_));
 }
 
 void JumpStm::Munch(assem::InstrList &instr_list, std::string_view fs) {
-  std::string instr_str =
-      IsArm64Target() ? "b " + exp_->name_->Name() : "jmp " + exp_->name_->Name();
-  instr_list.Append(new assem::OperInstr(
-      instr_str, nullptr, nullptr, new assem::Targets(jumps_)));
+  std::string instr_str(IsArm64Target() ? "b " : "jmp ");
+  instr_str += exp_->name_->Name();
+  instr_list.Append(util::New<assem::OperInstr>(
+      instr_str, nullptr, nullptr, util::New<assem::Targets>(jumps_)));
 }
 
 void CjumpStm::Munch(assem::InstrList &instr_list, std::string_view fs) {
@@ -305,15 +305,15 @@ void CjumpStm::Munch(assem::InstrList &instr_list, std::string_view fs) {
     auto *right_const = static_cast<tree::ConstExp *>(right_);
     temp::Temp *left_reg = left_->Munch(instr_list, fs);
     instr_ss << "cmpq $" << right_const->consti_ << ", `s0";
-    instr_list.Append(new assem::OperInstr(instr_ss.str(), nullptr,
-                                           new temp::TempList(left_reg),
+    instr_list.Append(util::New<assem::OperInstr>(instr_ss.str(), nullptr,
+                                           util::New<temp::TempList>(left_reg),
                                            nullptr));
   } else {
     temp::Temp *left_reg = left_->Munch(instr_list, fs);
     temp::Temp *right_reg = right_->Munch(instr_list, fs);
-    instr_list.Append(new assem::OperInstr(
+    instr_list.Append(util::New<assem::OperInstr>(
         "cmpq `s0, `s1", nullptr,
-        new temp::TempList({right_reg, left_reg}), nullptr));
+        util::New<temp::TempList>({right_reg, left_reg}), nullptr));
   }
 
   instr_ss.str("");
@@ -340,9 +340,9 @@ void CjumpStm::Munch(assem::InstrList &instr_list, std::string_view fs) {
     return;
   }
   instr_ss << true_label_->Name();
-  instr_list.Append(new assem::OperInstr(
+  instr_list.Append(util::New<assem::OperInstr>(
       instr_ss.str(), nullptr, nullptr,
-      new assem::Targets(new std::vector<temp::Label *>{true_label_})));
+      util::New<assem::Targets>(util::New<std::vector<temp::Label *>>({true_label_}))));
 }
 
 void MoveStm::Munch(assem::InstrList &instr_list, std::string_view fs) {
@@ -353,9 +353,9 @@ void MoveStm::Munch(assem::InstrList &instr_list, std::string_view fs) {
       std::stringstream instr_ss;
       instr_ss << (fetch->unscaled_ ? "stur " : "str ") << "`s0, "
                << fetch->fetch_;
-      temp::TempList *src_regs = new temp::TempList(src_reg);
+      temp::TempList *src_regs = util::New<temp::TempList>(src_reg);
       src_regs->CatList(fetch->regs_);
-      instr_list.Append(new assem::OperInstr(instr_ss.str(), nullptr, src_regs,
+      instr_list.Append(util::New<assem::OperInstr>(instr_ss.str(), nullptr, src_regs,
                                              nullptr));
       return;
     }
@@ -366,8 +366,8 @@ void MoveStm::Munch(assem::InstrList &instr_list, std::string_view fs) {
       std::stringstream instr_ss;
       instr_ss << (fetch->unscaled_ ? "ldur " : "ldr ") << "`d0, "
                << fetch->fetch_;
-      instr_list.Append(new assem::OperInstr(
-          instr_ss.str(), new temp::TempList(dst_reg), fetch->regs_, nullptr));
+      instr_list.Append(util::New<assem::OperInstr>(
+          instr_ss.str(), util::New<temp::TempList>(dst_reg), fetch->regs_, nullptr));
       return;
     }
 
@@ -389,10 +389,10 @@ void MoveStm::Munch(assem::InstrList &instr_list, std::string_view fs) {
     temp::Temp *src_reg = src_->Munch(instr_list, fs);
     assem::MemFetch *fetch = MunchMemX64(dst_, 1, instr_list, fs);
     instr_ss << "movq `s0, " << fetch->fetch_;
-    temp::TempList *src_regs = new temp::TempList(src_reg);
+    temp::TempList *src_regs = util::New<temp::TempList>(src_reg);
     src_regs->CatList(fetch->regs_);
     instr_list.Append(
-        new assem::OperInstr(instr_ss.str(), nullptr, src_regs, nullptr));
+        util::New<assem::OperInstr>(instr_ss.str(), nullptr, src_regs, nullptr));
     return;
   }
 
@@ -400,8 +400,8 @@ void MoveStm::Munch(assem::InstrList &instr_list, std::string_view fs) {
     assem::MemFetch *fetch = MunchMemX64(src_, 0, instr_list, fs);
     temp::Temp *dst_reg = dst_->Munch(instr_list, fs);
     instr_ss << "movq " << fetch->fetch_ << ", `d0";
-    instr_list.Append(new assem::OperInstr(instr_ss.str(),
-                                           new temp::TempList(dst_reg),
+    instr_list.Append(util::New<assem::OperInstr>(instr_ss.str(),
+                                           util::New<temp::TempList>(dst_reg),
                                            fetch->regs_, nullptr));
     return;
   }
@@ -410,17 +410,17 @@ void MoveStm::Munch(assem::InstrList &instr_list, std::string_view fs) {
     temp::Temp *dst_reg = dst_->Munch(instr_list, fs);
     instr_ss << "movq $" << static_cast<tree::ConstExp *>(src_)->consti_
              << ", `d0";
-    instr_list.Append(new assem::OperInstr(instr_ss.str(),
-                                           new temp::TempList(dst_reg),
+    instr_list.Append(util::New<assem::OperInstr>(instr_ss.str(),
+                                           util::New<temp::TempList>(dst_reg),
                                            nullptr, nullptr));
     return;
   }
 
   temp::Temp *src_reg = src_->Munch(instr_list, fs);
   temp::Temp *dst_reg = dst_->Munch(instr_list, fs);
-  instr_list.Append(new assem::MoveInstr("movq `s0, `d0",
-                                         new temp::TempList(dst_reg),
-                                         new temp::TempList(src_reg)));
+  instr_list.Append(util::New<assem::MoveInstr>("movq `s0, `d0",
+                                         util::New<temp::TempList>(dst_reg),
+                                         util::New<temp::TempList>(src_reg)));
 }
 
 void ExpStm::Munch(assem::InstrList &instr_list, std::string_view fs) {
@@ -440,9 +440,9 @@ temp::Temp *BinopExp::Munch(assem::InstrList &instr_list, std::string_view fs) {
           std::stringstream instr_ss;
           instr_ss << (op_ == PLUS_OP ? "add " : "sub ") << "`d0, `s0, #"
                    << value;
-          instr_list.Append(new assem::OperInstr(
-              instr_ss.str(), new temp::TempList(res_reg),
-              new temp::TempList(res_reg), nullptr));
+          instr_list.Append(util::New<assem::OperInstr>(
+              instr_ss.str(), util::New<temp::TempList>(res_reg),
+              util::New<temp::TempList>(res_reg), nullptr));
           return res_reg;
         }
       }
@@ -450,9 +450,9 @@ temp::Temp *BinopExp::Munch(assem::InstrList &instr_list, std::string_view fs) {
       temp::Temp *right_reg = right_->Munch(instr_list, fs);
       std::stringstream instr_ss;
       instr_ss << (op_ == PLUS_OP ? "add " : "sub ") << "`d0, `s0, `s1";
-      instr_list.Append(new assem::OperInstr(
-          instr_ss.str(), new temp::TempList(res_reg),
-          new temp::TempList({res_reg, right_reg}), nullptr));
+      instr_list.Append(util::New<assem::OperInstr>(
+          instr_ss.str(), util::New<temp::TempList>(res_reg),
+          util::New<temp::TempList>({res_reg, right_reg}), nullptr));
       return res_reg;
     }
 
@@ -462,9 +462,9 @@ temp::Temp *BinopExp::Munch(assem::InstrList &instr_list, std::string_view fs) {
       temp::Temp *res_reg = temp::TempFactory::NewTemp();
       std::stringstream instr_ss;
       instr_ss << (op_ == MUL_OP ? "mul " : "sdiv ") << "`d0, `s0, `s1";
-      instr_list.Append(new assem::OperInstr(
-          instr_ss.str(), new temp::TempList(res_reg),
-          new temp::TempList({left_reg, right_reg}), nullptr));
+      instr_list.Append(util::New<assem::OperInstr>(
+          instr_ss.str(), util::New<temp::TempList>(res_reg),
+          util::New<temp::TempList>({left_reg, right_reg}), nullptr));
       return res_reg;
     }
 
@@ -478,9 +478,9 @@ temp::Temp *BinopExp::Munch(assem::InstrList &instr_list, std::string_view fs) {
     temp::Temp *left_reg = left_->Munch(instr_list, fs);
     temp::Temp *res_reg = temp::TempFactory::NewTemp();
     instr_ss << "leaq " << fs << "(`s0), `d0";
-    instr_list.Append(new assem::OperInstr(instr_ss.str(),
-                                           new temp::TempList(res_reg),
-                                           new temp::TempList(left_reg),
+    instr_list.Append(util::New<assem::OperInstr>(instr_ss.str(),
+                                           util::New<temp::TempList>(res_reg),
+                                           util::New<temp::TempList>(left_reg),
                                            nullptr));
     return res_reg;
   }
@@ -489,24 +489,24 @@ temp::Temp *BinopExp::Munch(assem::InstrList &instr_list, std::string_view fs) {
     assem_instr = op_ == PLUS_OP ? "addq" : "subq";
     temp::Temp *left_reg = left_->Munch(instr_list, fs);
     temp::Temp *res_reg = temp::TempFactory::NewTemp();
-    instr_list.Append(new assem::MoveInstr("movq `s0, `d0",
-                                           new temp::TempList(res_reg),
-                                           new temp::TempList(left_reg)));
+    instr_list.Append(util::New<assem::MoveInstr>("movq `s0, `d0",
+                                           util::New<temp::TempList>(res_reg),
+                                           util::New<temp::TempList>(left_reg)));
 
     if (typeid(*right_) == typeid(tree::ConstExp)) {
       auto *right_const = static_cast<tree::ConstExp *>(right_);
       instr_ss << assem_instr << " $" << right_const->consti_ << ", `d0";
-      instr_list.Append(new assem::OperInstr(
-          instr_ss.str(), new temp::TempList({res_reg}),
-          new temp::TempList(res_reg), nullptr));
+      instr_list.Append(util::New<assem::OperInstr>(
+          instr_ss.str(), util::New<temp::TempList>({res_reg}),
+          util::New<temp::TempList>(res_reg), nullptr));
       return res_reg;
     }
 
     temp::Temp *right_reg = right_->Munch(instr_list, fs);
     instr_ss << assem_instr << " `s1, `d0";
-    instr_list.Append(new assem::OperInstr(
-        instr_ss.str(), new temp::TempList({res_reg}),
-        new temp::TempList({res_reg, right_reg}), nullptr));
+    instr_list.Append(util::New<assem::OperInstr>(
+        instr_ss.str(), util::New<temp::TempList>({res_reg}),
+        util::New<temp::TempList>({res_reg, right_reg}), nullptr));
     return res_reg;
   }
 
@@ -517,56 +517,59 @@ temp::Temp *BinopExp::Munch(assem::InstrList &instr_list, std::string_view fs) {
     temp::Temp *rax_saver = temp::TempFactory::NewTemp();
     temp::Temp *rdx_saver = temp::TempFactory::NewTemp();
 
-    instr_list.Append(new assem::MoveInstr("movq `s0, `d0",
-                                           new temp::TempList(rax_saver),
-                                           new temp::TempList(rax)));
-    instr_list.Append(new assem::MoveInstr("movq `s0, `d0",
-                                           new temp::TempList(rdx_saver),
-                                           new temp::TempList(rdx)));
+    instr_list.Append(util::New<assem::MoveInstr>("movq `s0, `d0",
+                                           util::New<temp::TempList>(rax_saver),
+                                           util::New<temp::TempList>(rax)));
+    instr_list.Append(util::New<assem::MoveInstr>("movq `s0, `d0",
+                                           util::New<temp::TempList>(rdx_saver),
+                                           util::New<temp::TempList>(rdx)));
 
     if (typeid(*left_) == typeid(tree::ConstExp)) {
       auto *left_const = static_cast<tree::ConstExp *>(left_);
       instr_ss << "movq $" << left_const->consti_ << ", `d0";
-      instr_list.Append(new assem::OperInstr(instr_ss.str(),
-                                             new temp::TempList(rax), nullptr,
+      instr_list.Append(util::New<assem::OperInstr>(instr_ss.str(),
+                                             util::New<temp::TempList>(rax), nullptr,
                                              nullptr));
     } else if (typeid(*left_) == typeid(tree::MemExp)) {
       assem::MemFetch *fetch = MunchMemX64(left_, 0, instr_list, fs);
       instr_ss << "movq " << fetch->fetch_ << ", `d0";
-      instr_list.Append(new assem::OperInstr(instr_ss.str(),
-                                             new temp::TempList(rax),
+      instr_list.Append(util::New<assem::OperInstr>(instr_ss.str(),
+                                             util::New<temp::TempList>(rax),
                                              fetch->regs_, nullptr));
     } else {
       temp::Temp *left_reg = left_->Munch(instr_list, fs);
       instr_ss << "movq `s0, `d0";
-      instr_list.Append(new assem::MoveInstr(instr_ss.str(),
-                                             new temp::TempList(rax),
-                                             new temp::TempList(left_reg)));
+      instr_list.Append(util::New<assem::MoveInstr>(instr_ss.str(),
+                                             util::New<temp::TempList>(rax),
+                                             util::New<temp::TempList>(left_reg)));
     }
 
     instr_ss.str("");
+    // The savers are live across these, not defined by them: were they
+    // defs, the saving moves would be dead and the allocator free to give
+    // their registers to the operands
     if (op_ == DIV_OP) {
-      instr_list.Append(new assem::OperInstr(
-          "cqto", new temp::TempList({rdx, rax, rax_saver, rdx_saver}),
-          new temp::TempList(rax), nullptr));
+      instr_list.Append(util::New<assem::OperInstr>(
+          "cqto", util::New<temp::TempList>({rdx, rax}),
+          util::New<temp::TempList>(rax), nullptr));
     }
 
     temp::Temp *right_reg = right_->Munch(instr_list, fs);
     instr_ss << assem_instr << " `s2";
-    instr_list.Append(new assem::OperInstr(
-        instr_ss.str(), new temp::TempList({rdx, rax, rax_saver, rdx_saver}),
-        new temp::TempList({rdx, rax, right_reg}), nullptr));
+    instr_list.Append(util::New<assem::OperInstr>(
+        instr_ss.str(), util::New<temp::TempList>({rdx, rax}),
+        util::New<temp::TempList>({rdx, rax, right_reg}), nullptr));
 
     temp::Temp *res_reg = temp::TempFactory::NewTemp();
-    instr_list.Append(new assem::MoveInstr("movq `s0, `d0",
-                                           new temp::TempList(res_reg),
-                                           new temp::TempList(rax)));
-    instr_list.Append(new assem::MoveInstr("movq `s0, `d0",
-                                           new temp::TempList(rax),
-                                           new temp::TempList(rax_saver)));
-    instr_list.Append(new assem::MoveInstr("movq `s0, `d0",
-                                           new temp::TempList(rdx),
-                                           new temp::TempList(rdx_saver)));
+    instr_list.Append(util::New<assem::MoveInstr>("movq `s0, `d0",
+                                           util::New<temp::TempList>(res_reg),
+                                           util::New<temp::TempList>(rax)));
+    instr_list.Append(util::New<assem::MoveInstr>("movq `s0, `d0",
+                                           util::New<temp::TempList>(rax),
+                                           util::New<temp::TempList>(rax_saver)));
+    instr_list.Append(util::New<assem::MoveInstr>("movq `s0, `d0",
+                                           util::New<temp::TempList>(rdx),
+                                           util::New<temp::TempList>(rdx_saver)));
     return res_reg;
   }
 
@@ -580,8 +583,8 @@ temp::Temp *MemExp::Munch(assem::InstrList &instr_list, std::string_view fs) {
     std::stringstream instr_ss;
     instr_ss << (fetch->unscaled_ ? "ldur " : "ldr ") << "`d0, "
              << fetch->fetch_;
-    instr_list.Append(new assem::OperInstr(instr_ss.str(),
-                                           new temp::TempList(reg),
+    instr_list.Append(util::New<assem::OperInstr>(instr_ss.str(),
+                                           util::New<temp::TempList>(reg),
                                            fetch->regs_, nullptr));
     return reg;
   }
@@ -589,7 +592,7 @@ temp::Temp *MemExp::Munch(assem::InstrList &instr_list, std::string_view fs) {
   assem::MemFetch *fetch = MunchMemX64(this, 0, instr_list, fs);
   std::stringstream instr_ss;
   instr_ss << "movq " << fetch->fetch_ << ", `d0";
-  instr_list.Append(new assem::OperInstr(instr_ss.str(), new temp::TempList(reg),
+  instr_list.Append(util::New<assem::OperInstr>(instr_ss.str(), util::New<temp::TempList>(reg),
                                          fetch->regs_, nullptr));
   return reg;
 }
@@ -608,20 +611,20 @@ temp::Temp *NameExp::Munch(assem::InstrList &instr_list, std::string_view fs) {
   if (IsArm64Target()) {
     std::stringstream instr_ss;
     instr_ss << "adrp `d0, " << name_->Name() << "@PAGE";
-    instr_list.Append(new assem::OperInstr(instr_ss.str(),
-                                           new temp::TempList(reg), nullptr,
+    instr_list.Append(util::New<assem::OperInstr>(instr_ss.str(),
+                                           util::New<temp::TempList>(reg), nullptr,
                                            nullptr));
     instr_ss.str("");
     instr_ss << "add `d0, `s0, " << name_->Name() << "@PAGEOFF";
-    instr_list.Append(new assem::OperInstr(instr_ss.str(),
-                                           new temp::TempList(reg),
-                                           new temp::TempList(reg), nullptr));
+    instr_list.Append(util::New<assem::OperInstr>(instr_ss.str(),
+                                           util::New<temp::TempList>(reg),
+                                           util::New<temp::TempList>(reg), nullptr));
     return reg;
   }
 
   std::stringstream instr_ss;
   instr_ss << "leaq " << name_->Name() << "(%rip), `d0";
-  instr_list.Append(new assem::OperInstr(instr_ss.str(), new temp::TempList(reg),
+  instr_list.Append(util::New<assem::OperInstr>(instr_ss.str(), util::New<temp::TempList>(reg),
                                          nullptr, nullptr));
   return reg;
 }
@@ -635,7 +638,7 @@ temp::Temp *ConstExp::Munch(assem::InstrList &instr_list, std::string_view fs) {
 
   std::stringstream instr_ss;
   instr_ss << "movq $" << consti_ << ", `d0";
-  instr_list.Append(new assem::OperInstr(instr_ss.str(), new temp::TempList(reg),
+  instr_list.Append(util::New<assem::OperInstr>(instr_ss.str(), util::New<temp::TempList>(reg),
                                          nullptr, nullptr));
   return reg;
 }
@@ -653,13 +656,13 @@ temp::Temp *CallExp::Munch(assem::InstrList &instr_list, std::string_view fs) {
   instr_ss << (IsArm64Target() ? "bl " : "callq ")
            << static_cast<tree::NameExp *>(fun_)->name_->Name();
   instr_list.Append(
-      new assem::OperInstr(instr_ss.str(), calldefs, arg_list, nullptr));
+      util::New<assem::OperInstr>(instr_ss.str(), calldefs, arg_list, nullptr));
   return ret;
 }
 
 temp::TempList *ExpList::MunchArgs(assem::InstrList &instr_list,
                                    std::string_view fs) {
-  temp::TempList *arg_list = new temp::TempList();
+  temp::TempList *arg_list = util::New<temp::TempList>();
   std::stringstream instr_ss;
   int arg_reg_count = reg_manager->ArgRegs()->GetList().size();
   int i = 0;
@@ -673,17 +676,17 @@ temp::TempList *ExpList::MunchArgs(assem::InstrList &instr_list,
           EmitArm64LoadImmediate(instr_list, dst_reg, value);
         } else {
           instr_ss << "movq $" << value << ", `d0";
-          instr_list.Append(new assem::OperInstr(
-              instr_ss.str(), new temp::TempList(dst_reg), nullptr, nullptr));
+          instr_list.Append(util::New<assem::OperInstr>(
+              instr_ss.str(), util::New<temp::TempList>(dst_reg), nullptr, nullptr));
         }
       } else {
         temp::Temp *src_reg = arg->Munch(instr_list, fs);
         if (IsArm64Target())
           EmitArm64MoveReg(instr_list, dst_reg, src_reg);
         else
-          instr_list.Append(new assem::MoveInstr(
-              "movq `s0, `d0", new temp::TempList(dst_reg),
-              new temp::TempList(src_reg)));
+          instr_list.Append(util::New<assem::MoveInstr>(
+              "movq `s0, `d0", util::New<temp::TempList>(dst_reg),
+              util::New<temp::TempList>(src_reg)));
       }
       arg_list->Append(dst_reg);
       instr_ss.str("");
@@ -706,9 +709,9 @@ temp::TempList *ExpList::MunchArgs(assem::InstrList &instr_list,
       if (stack_offset != 0)
         store_ss << ", #" << stack_offset;
       store_ss << "]";
-      instr_list.Append(new assem::OperInstr(
+      instr_list.Append(util::New<assem::OperInstr>(
           store_ss.str(), nullptr,
-          new temp::TempList({src_reg, reg_manager->StackPointer()}), nullptr));
+          util::New<temp::TempList>({src_reg, reg_manager->StackPointer()}), nullptr));
     } else {
       if (typeid(*arg) == typeid(tree::ConstExp)) {
         instr_ss << "movq $" << static_cast<tree::ConstExp *>(arg)->consti_
@@ -718,9 +721,9 @@ temp::TempList *ExpList::MunchArgs(assem::InstrList &instr_list,
         instr_ss << "("
                  << *reg_manager->temp_map_->Look(reg_manager->StackPointer())
                  << ")";
-        instr_list.Append(new assem::OperInstr(
+        instr_list.Append(util::New<assem::OperInstr>(
             instr_ss.str(), nullptr,
-            new temp::TempList(reg_manager->StackPointer()), nullptr));
+            util::New<temp::TempList>(reg_manager->StackPointer()), nullptr));
       } else {
         temp::Temp *src_reg = arg->Munch(instr_list, fs);
         instr_ss << "movq `s0, ";
@@ -729,9 +732,9 @@ temp::TempList *ExpList::MunchArgs(assem::InstrList &instr_list,
         instr_ss << "("
                  << *reg_manager->temp_map_->Look(reg_manager->StackPointer())
                  << ")";
-        instr_list.Append(new assem::OperInstr(
+        instr_list.Append(util::New<assem::OperInstr>(
             instr_ss.str(), nullptr,
-            new temp::TempList({src_reg, reg_manager->StackPointer()}),
+            util::New<temp::TempList>({src_reg, reg_manager->StackPointer()}),
             nullptr));
       }
     }
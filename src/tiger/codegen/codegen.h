@@ -90,10 +90,10 @@ public:
 
   /**
    * @brief Print all instructions with register names from @p map
-   * @param out Output file
+   * @param out Output buffer
    * @param map Temp-to-register-name map
    */
-  void Print(FILE *out, temp::Map *map) const;
+  void Print(util::Writer &out, temp::Map *map) const;
 
   /** @brief Get the underlying instruction list */
   [[nodiscard]] assem::InstrList *GetInstrList() const { return instr_list_; }
@@ -0,0 +1,343 @@
+#include "tiger/driver/driver.h"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <map>
+#include <memory>
+
+#include "tiger/absyn/absyn.h"
+#include "tiger/escape/escape.h"
+#include "tiger/output/logger.h"
+#include "tiger/output/output.h"
+#include "tiger/parse/parser.h"
+#include "tiger/semant/semant.h"
+#include "tiger/translate/translate.h"
+
+namespace driver {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+long long MicrosSince(Clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() -
+                                                               start)
+      .count();
+}
+
+/// Write @p s to @p out as a JSON string
+void PutJsonString(FILE *out, std::string_view s) {
+  fputc('"', out);
+  for (char c : s) {
+    if (c == '"' || c == '\\')
+      fprintf(out, "\\%c", c);
+    else if (static_cast<unsigned char>(c) < 0x20)
+      fprintf(out, "\\u%04x", c);
+    else
+      fputc(c, out);
+  }
+  fputc('"', out);
+}
+
+/// Sums of the counters of @p functions
+util::FunctionStats SumStats(const std::vector<util::FunctionStats> &functions) {
+  util::FunctionStats total;
+  total.name_ = "total";
+  for (const util::FunctionStats &function : functions)
+    for (const util::StatsCounter &counter : util::STATS_COUNTERS)
+      total.*counter.member_ += function.*counter.member_;
+  return total;
+}
+
+} // namespace
+
+Compiler::Compiler(const Options &options)
+    : options_(options), compilation_(options.target_) {
+  compilation_.SetPassTimer(options_.pass_timer_);
+  compilation_.SetMaxAllocRounds(options_.max_regalloc_rounds_);
+  if (options_.stats_)
+    compilation_.SetStats(&stats_);
+  if (!options_.cache_dir_.empty()) {
+    cache_ = std::make_unique<output::FunctionCache>(options_.cache_dir_);
+    compilation_.SetFunctionCache(cache_.get());
+  }
+}
+
+Result Compiler::Compile(std::string_view source, std::string *assembly,
+                         std::string_view name) {
+  size_t size = assembly->size();
+  Result result = Run(source, name, assembly, nullptr);
+  if (!result.ok_)
+    assembly->resize(size);
+  TakeStats(name, &result);
+  return result;
+}
+
+Result Compiler::Compile(std::string_view source, const Sink &sink,
+                         std::string_view name) {
+  Result result = Run(source, name, nullptr, &sink);
+  TakeStats(name, &result);
+  return result;
+}
+
+void Compiler::TakeStats(std::string_view name, Result *result) {
+  if (!options_.stats_)
+    return;
+  result->functions_ = stats_.TakeFunctions();
+  for (util::FunctionStats &function : result->functions_)
+    function.file_ = name;
+}
+
+Result Compiler::Run(std::string_view source, std::string_view name,
+                     std::string *assembly, const Sink *sink) {
+  Result result;
+  output::FunctionCache::Stats cache_before;
+  if (cache_)
+    cache_before = cache_->GetStats();
+  auto errormsg = std::make_unique<err::ErrorMsg>(name, &result.diagnostics_);
+  std::unique_ptr<absyn::AbsynTree> absyn_tree;
+
+  // Nothing of the previous program survives but the register manager
+  compilation_.Reset();
+  frame::Compilation::Scope scope(&compilation_);
+
+  try {
+    {
+      // Lab 3: parsing
+      // TigerLog("-------====Parse=====-----\n");
+      util::PassTimer::Scope pass("parse", name);
+      Clock::time_point start = Clock::now();
+      absyn_tree = ParseBuffer(source, errormsg.get());
+      result.times_.parse_ = MicrosSince(start);
+      if (!absyn_tree)
+        return result; // Syntax errors have been reported
+    }
+
+    {
+      // Lab 4: semantic analysis
+      TigerLog("-------====Semantic analysis=====-----\n");
+      util::PassTimer::Scope pass("semant", name);
+      Clock::time_point start = Clock::now();
+      sem::ProgSem prog_sem(std::move(absyn_tree), std::move(errormsg));
+      prog_sem.SemAnalyze();
+      absyn_tree = prog_sem.TransferAbsynTree();
+      errormsg = prog_sem.TransferErrormsg();
+      result.times_.semant_ = MicrosSince(start);
+    }
+
+    if (errormsg->AnyErrors())
+      return result; // Don't continue if error occurrs
+
+    if (!options_.annotate_) {
+      // Lab 5: escape analysis
+      TigerLog("-------====Escape analysis=====-----\n");
+      util::PassTimer::Scope pass("escape", name);
+      Clock::time_point start = Clock::now();
+      esc::EscFinder esc_finder(std::move(absyn_tree));
+      esc_finder.FindEscape();
+      absyn_tree = esc_finder.TransferAbsynTree();
+      result.times_.escape_ = MicrosSince(start);
+    }
+
+    {
+      // Lab 5: translate IR tree, and output assembly for each function
+      // as soon as it is translated
+      TigerLog("-------====Translate=====-----\n");
+      util::PassTimer::Scope pass("translate", name);
+      Clock::time_point start = Clock::now();
+      std::unique_ptr<output::AssemGen> assem_gen =
+          assembly ? std::make_unique<output::AssemGen>(assembly)
+                   : std::make_unique<output::AssemGen>(*sink);
+      assem_gen->Begin(true, options_.jobs_);
+      frags->SetProcConsumer([&assem_gen](std::unique_ptr<frame::ProcFrag> frag) {
+        assem_gen->Emit(std::move(frag));
+      });
+      tr::ProgTr prog_tr(std::move(absyn_tree), std::move(errormsg),
+                         options_.annotate_);
+      prog_tr.Translate();
+      errormsg = prog_tr.TransferErrormsg();
+      frags->SetProcConsumer(nullptr);
+      assem_gen->End();
+      assem_gen.reset();
+      result.times_.translate_ = MicrosSince(start);
+    }
+
+    if (cache_) {
+      output::FunctionCache::Stats cache_after = cache_->GetStats();
+      result.cache_.hits_ = cache_after.hits_ - cache_before.hits_;
+      result.cache_.misses_ = cache_after.misses_ - cache_before.misses_;
+    }
+  } catch (const std::exception &e) {
+    result.diagnostics_.push_back(
+        {0, 0, std::string("internal compiler error: ") + e.what()});
+    return result;
+  }
+
+  result.ok_ = !errormsg->AnyErrors();
+  return result;
+}
+
+std::string Format(std::string_view name, const err::Diagnostic &diagnostic) {
+  std::string text(name);
+  text += ':';
+  text += std::to_string(diagnostic.line_);
+  text += '.';
+  text += std::to_string(diagnostic.column_);
+  text += ": ";
+  text += diagnostic.message_;
+  return text;
+}
+
+void PrintPassTimes(FILE *out, const util::PassTimer &timer) {
+  struct Row {
+    const char *pass_;
+    long long calls_ = 0;
+    long long self_ns_ = 0;
+    long long cycles_ = 0;
+    long long instructions_ = 0;
+    long long cpu_ns_ = 0;
+  };
+  // Passes are named by string literals, but the same literal may have
+  // several addresses
+  std::map<std::string_view, Row> by_pass;
+  Row total{"total"};
+  for (const util::PassTimer::Event &event : timer.Events()) {
+    for (Row *row : {&by_pass.try_emplace(event.pass_, Row{event.pass_})
+                          .first->second,
+                     &total}) {
+      ++row->calls_;
+      row->self_ns_ += event.self_ns_;
+      row->cycles_ += event.cycles_;
+      row->instructions_ += event.instructions_;
+      row->cpu_ns_ += event.cpu_ns_;
+    }
+  }
+  std::vector<Row> rows;
+  for (const auto &[pass, row] : by_pass)
+    rows.push_back(row);
+  std::stable_sort(rows.begin(), rows.end(), [](const Row &a, const Row &b) {
+    return a.self_ns_ > b.self_ns_;
+  });
+  rows.push_back(total);
+
+  util::PassTimer::Counters counters = timer.GetCounters();
+  fprintf(out, "%-16s %8s %11s %6s", "pass", "calls", "wall ms", "%");
+  if (counters == util::PassTimer::Counters::HARDWARE)
+    fprintf(out, " %14s %14s %5s", "cycles", "instructions", "IPC");
+  else if (counters == util::PassTimer::Counters::RUSAGE)
+    fprintf(out, " %11s", "cpu ms");
+  fputc('\n', out);
+  for (const Row &row : rows) {
+    fprintf(out, "%-16s %8lld %11.3f %6.1f", row.pass_, row.calls_,
+            row.self_ns_ / 1e6,
+            total.self_ns_ ? 100.0 * row.self_ns_ / total.self_ns_ : 0.0);
+    if (counters == util::PassTimer::Counters::HARDWARE)
+      fprintf(out, " %14lld %14lld %5.2f", row.cycles_, row.instructions_,
+              row.cycles_ ? static_cast<double>(row.instructions_) / row.cycles_
+                          : 0.0);
+    else if (counters == util::PassTimer::Counters::RUSAGE)
+      fprintf(out, " %11.3f", row.cpu_ns_ / 1e6);
+    fputc('\n', out);
+  }
+  if (counters == util::PassTimer::Counters::RUSAGE)
+    fprintf(out, "(hardware counters not available; CPU time from getrusage)\n");
+}
+
+bool WritePassTrace(const std::string &path, const util::PassTimer &timer) {
+  FILE *out = fopen(path.c_str(), "w");
+  if (!out)
+    return false;
+
+  // Complete events ("ph":"X"), with times in microseconds
+  util::PassTimer::Counters counters = timer.GetCounters();
+  fputs("{\"traceEvents\":[", out);
+  bool first = true;
+  for (const util::PassTimer::Event &event : timer.Events()) {
+    fputs(first ? "\n" : ",\n", out);
+    first = false;
+    fputs("{\"name\":", out);
+    PutJsonString(out, event.pass_);
+    fprintf(out,
+            ",\"cat\":\"pass\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+            "\"pid\":1,\"tid\":%d,\"args\":{\"name\":",
+            event.start_ns_ / 1e3, event.wall_ns_ / 1e3, event.thread_);
+    PutJsonString(out, event.detail_);
+    fprintf(out, ",\"self_us\":%.3f", event.self_ns_ / 1e3);
+    if (counters == util::PassTimer::Counters::HARDWARE)
+      fprintf(out, ",\"cycles\":%lld,\"instructions\":%lld", event.cycles_,
+              event.instructions_);
+    else if (counters == util::PassTimer::Counters::RUSAGE)
+      fprintf(out, ",\"cpu_us\":%.3f", event.cpu_ns_ / 1e3);
+    fputs("}}", out);
+  }
+  fputs("\n],\"displayTimeUnit\":\"ms\"}\n", out);
+  bool ok = !ferror(out);
+  return fclose(out) == 0 && ok;
+}
+
+void PrintStats(FILE *out, const std::vector<util::FunctionStats> &functions) {
+  // Name functions by file as well once there are several files
+  bool files = false;
+  for (const util::FunctionStats &function : functions)
+    files = files || function.file_ != functions.front().file_;
+  auto name_of = [files](const util::FunctionStats &function) {
+    return files && !function.file_.empty()
+               ? function.file_ + ": " + function.name_
+               : function.name_;
+  };
+
+  int width = 8;
+  for (const util::FunctionStats &function : functions)
+    width = std::max(width, static_cast<int>(name_of(function).size()));
+  fprintf(out, "%-*s", width, "function");
+  for (const util::StatsCounter &counter : util::STATS_COUNTERS)
+    fprintf(out, " %8s", counter.header_);
+  fputc('\n', out);
+
+  util::FunctionStats total = SumStats(functions);
+  auto print_row = [out, width](const std::string &name,
+                                const util::FunctionStats &function) {
+    fprintf(out, "%-*s", width, name.c_str());
+    for (const util::StatsCounter &counter : util::STATS_COUNTERS)
+      fprintf(out, " %8lld", function.*counter.member_);
+    fputc('\n', out);
+  };
+  for (const util::FunctionStats &function : functions)
+    print_row(name_of(function), function);
+  print_row(total.name_, total);
+}
+
+bool WriteStats(const std::string &path,
+                const std::vector<util::FunctionStats> &functions) {
+  FILE *out = fopen(path.c_str(), "w");
+  if (!out)
+    return false;
+  auto put_counters = [out](const util::FunctionStats &function) {
+    for (const util::StatsCounter &counter : util::STATS_COUNTERS)
+      fprintf(out, ",\"%s\":%lld", counter.key_, function.*counter.member_);
+  };
+
+  fputs("{\"functions\":[", out);
+  bool first = true;
+  for (const util::FunctionStats &function : functions) {
+    fputs(first ? "\n" : ",\n", out);
+    first = false;
+    fputs("{\"file\":", out);
+    PutJsonString(out, function.file_);
+    fputs(",\"name\":", out);
+    PutJsonString(out, function.name_);
+    fputs(",\"label\":", out);
+    PutJsonString(out, function.label_);
+    put_counters(function);
+    fputc('}', out);
+  }
+  fputs("\n],\"total\":{\"functions\":", out);
+  fprintf(out, "%zu", functions.size());
+  put_counters(SumStats(functions));
+  fputs("}}\n", out);
+  bool ok = !ferror(out);
+  return fclose(out) == 0 && ok;
+}
+
+} // namespace driver
@@ -0,0 +1,175 @@
+/**
+ * @file driver.h
+ * @brief The Tiger compiler as a library
+ *
+ * A driver::Compiler turns the text of a Tiger program into target
+ * assembly without going through the file system: the source is passed
+ * as a buffer, the assembly is appended to a string or handed to a sink in
+ * pieces, and the errors come back as err::Diagnostic records.  It runs
+ * the whole pipeline of the tiger-compiler command, which is built on it:
+ *
+ *   1. Parse            – lex + parse the source into an AST
+ *   2. Semantic analysis – type-check and scope-check the AST
+ *   3. Escape analysis   – determine which variables must live in the frame
+ *   4. IR translation    – translate the AST to IR tree fragments
+ *   5. Assembly output   – canonicalize, select instructions, allocate
+ *                          registers, and write the assembly
+ *
+ * Steps 4 and 5 are interleaved: each function is handed to the back end
+ * as soon as its translation is complete.  By default step 3 is part of
+ * step 2, which annotates the AST for step 4 to translate from (see
+ * Options::annotate_).
+ *
+ * A Compiler keeps one frame::Compilation, and with it the target's
+ * register manager, for every program it compiles, and resets it in
+ * between; a program compiles to the same assembly as it would on a new
+ * Compiler.  A Compiler must be used by one thread at a time, but any
+ * number of them can run on different threads.
+ *
+ * Given a cache directory, a Compiler takes the assembly of functions it
+ * or any other Compiler has compiled before from there (see cache.h).
+ *
+ * Given a util::PassTimer, a Compiler records the time spent in each pass;
+ * PrintPassTimes() and WritePassTrace() report it.  Asked to, it also
+ * counts what each pass did to each function (see util/stats.h);
+ * PrintStats() and WriteStats() report that.
+ *
+ * The library is built as libtiger.
+ */
+
+#ifndef TIGER_DRIVER_DRIVER_H_
+#define TIGER_DRIVER_DRIVER_H_
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "tiger/errormsg/errormsg.h"
+#include "tiger/frame/compilation.h"
+#include "tiger/frame/target.h"
+#include "tiger/output/cache.h"
+#include "tiger/util/pass_timer.h"
+#include "tiger/util/stats.h"
+#include "tiger/util/writer.h"
+
+namespace driver {
+
+/**
+ * @brief How programs are compiled
+ */
+struct Options {
+  frame::TargetArch target_ = frame::DetectHostTarget(); ///< Target machine
+  int jobs_ = 1;                        ///< Functions compiled at the same time
+  std::string cache_dir_;               ///< Function cache directory, if any
+  util::PassTimer *pass_timer_ = nullptr; ///< Times the passes, if any; not owned
+  bool stats_ = false;                  ///< Count per function, into Result::functions_
+  /// Translate from the annotations of semantic analysis, which finds the
+  /// escapes as well, rather than look up and check every name again
+  bool annotate_ = true;
+  /// Register allocation rounds before a function is an internal error;
+  /// 0 for the allocator's own bound.  For testing that error.
+  int max_regalloc_rounds_ = 0;
+};
+
+/**
+ * @brief Wall time of each phase of one compilation, in microseconds
+ */
+struct PhaseTimes {
+  long long parse_ = 0;
+  long long semant_ = 0;
+  long long escape_ = 0;
+  long long translate_ = 0;             ///< Including the back end
+};
+
+/**
+ * @brief What became of one program
+ */
+struct Result {
+  bool ok_ = false;                     ///< Compiled without errors
+  std::vector<err::Diagnostic> diagnostics_; ///< Errors, in the order found
+  PhaseTimes times_;                    ///< Phases that did not run are 0
+  output::FunctionCache::Stats cache_;  ///< Functions found in the cache or not
+  std::vector<util::FunctionStats> functions_; ///< With Options::stats_, in order of translation
+};
+
+/**
+ * @brief Compiles Tiger programs held in memory
+ */
+class Compiler {
+public:
+  /// Receives the assembly in pieces, in order
+  using Sink = util::Writer::Sink;
+
+  explicit Compiler(const Options &options = Options());
+  Compiler(const Compiler &) = delete;
+  Compiler &operator=(const Compiler &) = delete;
+
+  /**
+   * @brief Compile @p source and append its assembly to @p assembly
+   * @param name Name of the program, as used in diagnostics
+   *
+   * If the program has errors, @p assembly is left as it was.
+   */
+  Result Compile(std::string_view source, std::string *assembly,
+                 std::string_view name = "input.tig");
+
+  /**
+   * @brief Compile @p source and hand its assembly to @p sink
+   * @param name Name of the program, as used in diagnostics
+   *
+   * Nothing reaches @p sink unless the program passes semantic analysis.
+   */
+  Result Compile(std::string_view source, const Sink &sink,
+                 std::string_view name = "input.tig");
+
+private:
+  Options options_;
+  frame::Compilation compilation_;      ///< Reset for every program
+  std::unique_ptr<output::FunctionCache> cache_; ///< If options_ name one
+  util::Stats stats_;                   ///< Emptied into every Result
+
+  Result Run(std::string_view source, std::string_view name,
+             std::string *assembly, const Sink *sink);
+  /** @brief Move the counters of the program @p name into @p result */
+  void TakeStats(std::string_view name, Result *result);
+};
+
+/** @brief @p diagnostic as the command prints it: "name:line.column: message" */
+std::string Format(std::string_view name, const err::Diagnostic &diagnostic);
+
+/**
+ * @brief Print the time spent in each pass recorded by @p timer to @p out
+ *
+ * One row per pass, with the time spent in it summed over all functions,
+ * files and threads, the most expensive first.  The times exclude the
+ * passes nested in a pass, so that the rows add up to the total.
+ */
+void PrintPassTimes(FILE *out, const util::PassTimer &timer);
+
+/**
+ * @brief Write the passes recorded by @p timer to @p path in the Chrome
+ *        trace-event format (chrome://tracing, Perfetto)
+ * @return false if the file could not be written
+ */
+bool WritePassTrace(const std::string &path, const util::PassTimer &timer);
+
+/**
+ * @brief Print the counters of @p functions to @p out, one row per
+ *        function and their sums
+ */
+void PrintStats(FILE *out, const std::vector<util::FunctionStats> &functions);
+
+/**
+ * @brief Write the counters of @p functions and their sums to @p path as
+ *        JSON: {"functions": [{"file", "name", "label", counters…}…],
+ *        "total": {counters…}}
+ * @return false if the file could not be written
+ */
+bool WriteStats(const std::string &path,
+                const std::vector<util::FunctionStats> &functions);
+
+} // namespace driver
+
+#endif // TIGER_DRIVER_DRIVER_H_
@@ -57,6 +57,8 @@ class VarEntry : public EnvEntry {
 public:
   tr::Access *access_;  ///< Frame access (set during IR translation)
   type::Ty *ty_;        ///< Variable type
+  bool *escape_ = nullptr; ///< Escape flag of the declaration, if semantic analysis sets it
+  int depth_ = 0;       ///< Function nesting depth of the declaration
 
   /**
    * @brief Constructor for semantic analysis phase (Lab 4)
@@ -25,7 +25,27 @@ void ErrorMsg::Error(int pos, std::string_view message, ...) {
     num--;
   }
 
-  // Output error message
+  if (diagnostics_ && diagnostics_->size() >= MAX_DIAGNOSTICS) {
+    if (diagnostics_->size() == MAX_DIAGNOSTICS)
+      diagnostics_->push_back({0, 0, "too many errors"});
+    return;
+  }
+  if (diagnostics_) {
+    va_start(ap, message);
+    int size = vsnprintf(nullptr, 0, message.data(), ap);
+    va_end(ap);
+    std::vector<char> text(size + 1);
+    va_start(ap, message);
+    vsnprintf(text.data(), text.size(), message.data(), ap);
+    va_end(ap);
+    diagnostics_->push_back({val != -1 ? num : 0, val != -1 ? pos - val : 0,
+                             std::string(text.data(), size)});
+    return;
+  }
+
+  // Output error message, in one piece even when other files are being
+  // compiled on other threads
+  flockfile(stderr);
   if (!file_name_.empty())
     fprintf(stderr, "%s:", file_name_.data());
   if (val != -1)
@@ -34,6 +54,7 @@ void ErrorMsg::Error(int pos, std::string_view message, ...) {
   vfprintf(stderr, message.data(), ap);
   va_end(ap);
   fprintf(stderr, "\n");
+  funlockfile(stderr);
 }
 
 } // namespace err
@@ -17,6 +17,7 @@
 #include <fstream>
 #include <list>
 #include <string>
+#include <vector>
 
 /**
  * @brief Forward declaration
@@ -25,6 +26,15 @@ class Scanner;
 
 namespace err {
 
+/**
+ * @brief An error in a program, as data rather than as a printed message
+ */
+struct Diagnostic {
+  int line_;             ///< Line of the error, counting from 1
+  int column_;           ///< Column, as in printed messages
+  std::string message_;  ///< What is wrong, without the position
+};
+
 /**
  * @brief Error message handler with position tracking
  * 
@@ -42,6 +52,20 @@ public:
       throw std::invalid_argument("cannot open file");
   }
 
+  /// Errors collected for one program; the ones after it are counted
+  /// but replaced by a single "too many errors" diagnostic
+  static constexpr size_t MAX_DIAGNOSTICS = 100;
+
+  /**
+   * Collect the errors of a program that does not come from a file
+   * @param fname name of the program
+   * @param diagnostics receives each error instead of stderr, up to
+   *        MAX_DIAGNOSTICS of them
+   */
+  ErrorMsg(std::string_view fname, std::vector<Diagnostic> *diagnostics)
+      : line_pos_(std::list<int>{0}), file_name_(fname),
+        diagnostics_(diagnostics) {}
+
   /**
    * Add a new line in parser
    */
@@ -76,6 +100,7 @@ private:
   std::list<int> line_pos_; // current token position of a line
   std::string file_name_;   // name of input file
   std::ifstream infile_;    // instream of the input file
+  std::vector<Diagnostic> *diagnostics_ = nullptr; // collects errors, if set
 };
 } // namespace err
 
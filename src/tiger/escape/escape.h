@@ -32,6 +32,8 @@
  *
  * These flags are later read by the IR translator (translate.cc) to decide
  * whether to allocate the variable in a register or in the frame.
+ * Semantic analysis sets them the same way as it goes, for the translator
+ * to use with its annotations; this pass is for trees translated without.
  *
  * ─────────────────────────────────────────────────────────────────────────
  * Environment
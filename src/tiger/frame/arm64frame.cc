@@ -2,7 +2,7 @@
 
 #include <sstream>
 
-extern frame::RegManager *reg_manager;
+#include "tiger/frame/compilation.h"
 
 namespace frame {
 
@@ -36,20 +36,20 @@ Arm64RegManager::Arm64RegManager() {
 }
 
 temp::TempList *Arm64RegManager::Registers() {
-  temp::TempList *temps = new temp::TempList();
+  temp::TempList *temps = util::New<temp::TempList>();
   for (int reg = 0; reg < REG_COUNT; ++reg)
     temps->Append(regs_.at(reg));
   return temps;
 }
 
 temp::TempList *Arm64RegManager::ArgRegs() {
-  return new temp::TempList({regs_.at(X0), regs_.at(X1), regs_.at(X2),
+  return util::New<temp::TempList>({regs_.at(X0), regs_.at(X1), regs_.at(X2),
                              regs_.at(X3), regs_.at(X4), regs_.at(X5),
                              regs_.at(X6), regs_.at(X7)});
 }
 
 temp::TempList *Arm64RegManager::CallerSaves() {
-  return new temp::TempList({regs_.at(X0), regs_.at(X1), regs_.at(X2),
+  return util::New<temp::TempList>({regs_.at(X0), regs_.at(X1), regs_.at(X2),
                              regs_.at(X3), regs_.at(X4), regs_.at(X5),
                              regs_.at(X6), regs_.at(X7), regs_.at(X9),
                              regs_.at(X10), regs_.at(X11), regs_.at(X12),
@@ -58,7 +58,7 @@ temp::TempList *Arm64RegManager::CallerSaves() {
 }
 
 temp::TempList *Arm64RegManager::CalleeSaves() {
-  return new temp::TempList({regs_.at(X19), regs_.at(X20), regs_.at(X21),
+  return util::New<temp::TempList>({regs_.at(X19), regs_.at(X20), regs_.at(X21),
                              regs_.at(X22), regs_.at(X23), regs_.at(X24),
                              regs_.at(X25), regs_.at(X26), regs_.at(X27),
                              regs_.at(X28), regs_.at(FP)});
@@ -103,7 +103,7 @@ public:
   explicit Arm64InRegAccess(temp::Temp *reg) : reg_(reg) {}
 
   std::string MunchAccess(Frame *frame) override {
-    return *temp::Map::Name()->Look(reg_);
+    return temp::Map::Name()->NameOf(reg_);
   }
 
   temp::Temp *reg_;
@@ -134,24 +134,24 @@ Access *Arm64Frame::AllocLocal(bool escape) {
 }
 
 tree::Exp *Arm64Frame::FrameAddress() const {
-  return new tree::TempExp(reg_manager->FramePointer());
+  return util::New<tree::TempExp>(reg_manager->FramePointer());
 }
 
 int Arm64Frame::WordSize() const { return word_size_; }
 
-std::string Arm64Frame::GetLabel() const { return name_->Name(); }
+std::string Arm64Frame::GetLabel() const { return std::string(name_->Name()); }
 
 tree::Exp *Arm64Frame::StackOffset(int frame_offset) const {
-  return new tree::BinopExp(tree::MINUS_OP, FrameAddress(),
-                            new tree::ConstExp(frame_offset));
+  return util::New<tree::BinopExp>(tree::MINUS_OP, FrameAddress(),
+                            util::New<tree::ConstExp>(frame_offset));
 }
 
 Frame *NewArm64Frame(temp::Label *name, std::vector<bool> formals) {
   Frame *frame = new Arm64Frame(name);
   int frame_offset = kSavedFrameRecordBytes + frame->WordSize();
   frame->frame_size_ =
-      temp::LabelFactory::NamedLabel(name->Name() + "_framesize");
-  frame->view_shift = new tree::ExpStm(new tree::ConstExp(0));
+      temp::LabelFactory::NamedLabel(std::string(name->Name()) + "_framesize");
+  frame->view_shift = util::New<tree::ExpStm>(util::New<tree::ConstExp>(0));
 
   tree::Exp *dst_exp;
   tree::Stm *single_view_shift;
@@ -160,50 +160,50 @@ Frame *NewArm64Frame(temp::Label *name, std::vector<bool> formals) {
   for (int i = 0; i < static_cast<int>(formals.size()); ++i) {
     if (formals.at(i)) {
       frame->formal_access_.push_back(new Arm64InFrameAccess(frame_offset));
-      dst_exp = new tree::MemExp(new tree::BinopExp(
+      dst_exp = util::New<tree::MemExp>(util::New<tree::BinopExp>(
           tree::MINUS_OP, frame->FrameAddress(),
-          new tree::ConstExp(frame_offset)));
+          util::New<tree::ConstExp>(frame_offset)));
       frame_offset += frame->WordSize();
       frame->local_count_++;
     } else {
       temp::Temp *reg = temp::TempFactory::NewTemp();
       frame->formal_access_.push_back(new Arm64InRegAccess(reg));
-      dst_exp = new tree::TempExp(reg);
+      dst_exp = util::New<tree::TempExp>(reg);
     }
 
     if (i < arg_reg_count) {
-      single_view_shift = new tree::MoveStm(
-          dst_exp, new tree::TempExp(reg_manager->ArgRegs()->NthTemp(i)));
+      single_view_shift = util::New<tree::MoveStm>(
+          dst_exp, util::New<tree::TempExp>(reg_manager->ArgRegs()->NthTemp(i)));
     } else {
-      single_view_shift = new tree::MoveStm(
-          dst_exp, new tree::MemExp(new tree::BinopExp(
+      single_view_shift = util::New<tree::MoveStm>(
+          dst_exp, util::New<tree::MemExp>(util::New<tree::BinopExp>(
                        tree::PLUS_OP, frame->FrameAddress(),
-                       new tree::ConstExp((i - arg_reg_count) *
+                       util::New<tree::ConstExp>((i - arg_reg_count) *
                                           frame->WordSize()))));
     }
-    frame->view_shift = new tree::SeqStm(frame->view_shift, single_view_shift);
+    frame->view_shift = util::New<tree::SeqStm>(frame->view_shift, single_view_shift);
   }
 
   temp::TempList *callee_saves = reg_manager->CalleeSaves();
   temp::Temp *store_reg = temp::TempFactory::NewTemp();
-  frame->save_callee_saves = new tree::MoveStm(
-      new tree::TempExp(store_reg),
-      new tree::TempExp(callee_saves->GetList().front()));
-  frame->restore_callee_saves = new tree::MoveStm(
-      new tree::TempExp(callee_saves->GetList().front()),
-      new tree::TempExp(store_reg));
+  frame->save_callee_saves = util::New<tree::MoveStm>(
+      util::New<tree::TempExp>(store_reg),
+      util::New<tree::TempExp>(callee_saves->GetList().front()));
+  frame->restore_callee_saves = util::New<tree::MoveStm>(
+      util::New<tree::TempExp>(callee_saves->GetList().front()),
+      util::New<tree::TempExp>(store_reg));
 
   for (auto reg_it = ++callee_saves->GetList().begin();
        reg_it != callee_saves->GetList().end(); ++reg_it) {
     store_reg = temp::TempFactory::NewTemp();
-    tree::Stm *single_save = new tree::MoveStm(new tree::TempExp(store_reg),
-                                               new tree::TempExp(*reg_it));
+    tree::Stm *single_save = util::New<tree::MoveStm>(util::New<tree::TempExp>(store_reg),
+                                               util::New<tree::TempExp>(*reg_it));
     tree::Stm *single_restore =
-        new tree::MoveStm(new tree::TempExp(*reg_it),
-                          new tree::TempExp(store_reg));
-    frame->save_callee_saves = new tree::SeqStm(single_save,
+        util::New<tree::MoveStm>(util::New<tree::TempExp>(*reg_it),
+                          util::New<tree::TempExp>(store_reg));
+    frame->save_callee_saves = util::New<tree::SeqStm>(single_save,
                                                 frame->save_callee_saves);
-    frame->restore_callee_saves = new tree::SeqStm(
+    frame->restore_callee_saves = util::New<tree::SeqStm>(
         single_restore, frame->restore_callee_saves);
   }
 
@@ -213,30 +213,32 @@ Frame *NewArm64Frame(temp::Label *name, std::vector<bool> formals) {
 tree::Exp *AccessCurrentExpArm64(Access *acc, Frame *frame) {
   if (typeid(*acc) == typeid(Arm64InFrameAccess)) {
     auto *frame_acc = static_cast<Arm64InFrameAccess *>(acc);
-    return new tree::MemExp(new tree::BinopExp(
+    return util::New<tree::MemExp>(util::New<tree::BinopExp>(
         tree::MINUS_OP, frame->FrameAddress(),
-        new tree::ConstExp(frame_acc->offset_)));
+        util::New<tree::ConstExp>(frame_acc->offset_)));
   }
 
   auto *reg_acc = static_cast<Arm64InRegAccess *>(acc);
-  return new tree::TempExp(reg_acc->reg_);
+  return util::New<tree::TempExp>(reg_acc->reg_);
 }
 
 tree::Exp *AccessExpArm64(Access *acc, tree::Exp *fp) {
   if (typeid(*acc) == typeid(Arm64InFrameAccess)) {
     auto *frame_acc = static_cast<Arm64InFrameAccess *>(acc);
-    return new tree::MemExp(new tree::BinopExp(
-        tree::MINUS_OP, fp, new tree::ConstExp(frame_acc->offset_)));
+    return util::New<tree::MemExp>(util::New<tree::BinopExp>(
+        tree::MINUS_OP, fp, util::New<tree::ConstExp>(frame_acc->offset_)));
   }
 
   auto *reg_acc = static_cast<Arm64InRegAccess *>(acc);
-  return new tree::TempExp(reg_acc->reg_);
+  return util::New<tree::TempExp>(reg_acc->reg_);
 }
 
 assem::Proc *ProcEntryExit3Arm64(Frame *frame, assem::InstrList *body) {
   const int local_bytes =
       (frame->local_count_ + frame->max_outgoing_args_) * frame->WordSize();
   const int fs = Align16(local_bytes + 16);
+  if (frame->stats_)
+    frame->stats_->frame_size_ = fs;
 
   std::stringstream prologue_ss;
   std::stringstream epilogue_ss;
@@ -253,7 +255,7 @@ assem::Proc *ProcEntryExit3Arm64(Frame *frame, assem::InstrList *body) {
   epilogue_ss << "add sp, sp, #" << fs << "\n";
   epilogue_ss << "ret\n";
 
-  return new assem::Proc(prologue_ss.str(), body, epilogue_ss.str());
+  return util::New<assem::Proc>(prologue_ss.str(), body, epilogue_ss.str());
 }
 
 } // namespace frame
@@ -0,0 +1,58 @@
+#include "tiger/frame/compilation.h"
+
+thread_local frame::RegManager *reg_manager = nullptr;
+thread_local frame::Frags *frags = nullptr;
+
+namespace frame {
+
+thread_local Compilation *Compilation::current_ = nullptr;
+
+Compilation::Compilation(TargetArch target)
+    : target_(target), reg_manager_(nullptr) {
+  // The machine registers are the first temps of every compilation
+  Scope scope(this);
+  reg_manager_ = NewRegManagerForTarget(target);
+  first_temp_ = temp::TempFactory::Peek();
+}
+
+Compilation::~Compilation() {
+  for (Frag *frag : frags_.GetList())
+    delete frag;
+  delete reg_manager_;
+}
+
+void Compilation::Reset() {
+  for (Frag *frag : frags_.GetList())
+    delete frag;
+  frags_ = Frags();
+  temps_.temp_id_ = first_temp_;
+  labels_.label_id_ = 0;
+  labels_.labels_.Release();
+}
+
+void Compilation::MakeCurrent(Compilation *compilation) {
+  current_ = compilation;
+  if (compilation) {
+    reg_manager = compilation->reg_manager_;
+    frags = &compilation->frags_;
+    temp::TempFactory::current_ = &compilation->temps_;
+    temp::LabelFactory::current_ = &compilation->labels_;
+    util::PassTimer::SetCurrent(compilation->pass_timer_);
+    util::Stats::SetCurrent(compilation->stats_);
+  } else {
+    reg_manager = nullptr;
+    frags = nullptr;
+    temp::TempFactory::current_ = nullptr;
+    temp::LabelFactory::current_ = nullptr;
+    util::PassTimer::SetCurrent(nullptr);
+    util::Stats::SetCurrent(nullptr);
+  }
+}
+
+Compilation::Scope::Scope(Compilation *compilation) : saved_(current_) {
+  MakeCurrent(compilation);
+}
+
+Compilation::Scope::~Scope() { MakeCurrent(saved_); }
+
+} // namespace frame
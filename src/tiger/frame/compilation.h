@@ -0,0 +1,132 @@
+/**
+ * @file compilation.h
+ * @brief State that belongs to one compilation
+ *
+ * Every phase of the compiler reaches for the same few things: the target
+ * and its register manager (reg_manager), the fragments produced so far
+ * (frags), and the counters that number temps and anonymous labels.  A
+ * Compilation owns one set of them.  While a Compilation::Scope is alive,
+ * that compilation is current on the running thread and the usual names
+ * (reg_manager, frags, frame::GetCurrentTarget(),
+ * temp::TempFactory::NewTemp(), temp::LabelFactory::NewLabel()) refer to
+ * it.
+ *
+ * Several programs can therefore be compiled at the same time on different
+ * threads of one process, each producing exactly the output it would
+ * produce alone.  A thread that works on part of a compilation, such as a
+ * back-end worker, enters the compilation's scope for the duration.
+ *
+ * A compilation may also be given an output::FunctionCache, from which
+ * the back end takes the assembly of functions compiled before, and a
+ * util::PassTimer, which is current while the compilation is and records
+ * how long each pass takes, and a util::Stats, in which translation makes
+ * the counters of each function.
+ *
+ * Outside any scope reg_manager and frags are null, and temps and labels
+ * come from counters shared by the whole process.
+ */
+
+#ifndef TIGER_FRAME_COMPILATION_H_
+#define TIGER_FRAME_COMPILATION_H_
+
+#include "tiger/frame/frame.h"
+#include "tiger/frame/target.h"
+#include "tiger/frame/temp.h"
+#include "tiger/util/pass_timer.h"
+#include "tiger/util/stats.h"
+
+namespace output {
+class FunctionCache;
+} // namespace output
+
+namespace frame {
+
+/**
+ * @brief The target, register manager, fragments and temp/label counters
+ *        of one program being compiled
+ */
+class Compilation {
+public:
+  /** @brief Start compiling a program for @p target */
+  explicit Compilation(TargetArch target);
+  Compilation(const Compilation &) = delete;
+  Compilation &operator=(const Compilation &) = delete;
+  ~Compilation();
+
+  [[nodiscard]] TargetArch Target() const { return target_; }
+
+  /**
+   * @brief Forget the program compiled so far, but keep the register manager
+   *
+   * Temps and labels are numbered afresh, so the next program compiles to
+   * the same output as it would in a new compilation.  The anonymous labels
+   * of the program are freed.  The compilation
+   * must not be current on any thread.
+   */
+  void Reset();
+
+  /** @brief Reuse and keep the assembly of functions in @p cache, if set */
+  void SetFunctionCache(output::FunctionCache *cache) { function_cache_ = cache; }
+  [[nodiscard]] output::FunctionCache *GetFunctionCache() const {
+    return function_cache_;
+  }
+
+  /** @brief Record the time of every pass in @p timer, if set */
+  void SetPassTimer(util::PassTimer *timer) { pass_timer_ = timer; }
+
+  /** @brief Count what is done to every function in @p stats, if set */
+  void SetStats(util::Stats *stats) { stats_ = stats; }
+
+  /**
+   * @brief Fail register allocation of a function that still spills after
+   *        @p rounds rounds; 0 keeps ra::RegAllocator::MAX_ROUNDS
+   *
+   * Only tests need another bound.
+   */
+  void SetMaxAllocRounds(int rounds) { max_alloc_rounds_ = rounds; }
+  [[nodiscard]] int MaxAllocRounds() const { return max_alloc_rounds_; }
+
+  /** @brief The compilation current on the running thread, or nullptr */
+  static Compilation *Current() { return current_; }
+
+  /**
+   * @brief Makes a compilation current on the running thread while in scope
+   *
+   * Scopes nest; leaving one makes the enclosing compilation current again.
+   */
+  class Scope {
+  public:
+    explicit Scope(Compilation *compilation);
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+    ~Scope();
+
+  private:
+    Compilation *saved_;                ///< Compilation current before this scope
+  };
+
+private:
+  TargetArch target_;
+  temp::TempFactory temps_;             ///< Numbers this compilation's temps
+  temp::LabelFactory labels_;           ///< Numbers and holds its anonymous labels
+  RegManager *reg_manager_;             ///< Machine registers (temps 100 and up)
+  int first_temp_;                      ///< First temp after the machine registers
+  Frags frags_;                         ///< Fragments translated so far
+  output::FunctionCache *function_cache_ = nullptr; ///< Not owned
+  util::PassTimer *pass_timer_ = nullptr; ///< Not owned
+  util::Stats *stats_ = nullptr;        ///< Not owned
+  int max_alloc_rounds_ = 0;            ///< 0 for the allocator's own bound
+
+  static thread_local Compilation *current_;
+
+  static void MakeCurrent(Compilation *compilation);
+};
+
+} // namespace frame
+
+/** @brief Register manager of the compilation current on this thread */
+extern thread_local frame::RegManager *reg_manager;
+/** @brief Fragments of the compilation current on this thread */
+extern thread_local frame::Frags *frags;
+
+#endif // TIGER_FRAME_COMPILATION_H_
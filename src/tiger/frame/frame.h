@@ -53,13 +53,17 @@
 #ifndef TIGER_FRAME_FRAME_H_
 #define TIGER_FRAME_FRAME_H_
 
+#include <functional>
 #include <list>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "tiger/canon/canon.h"
 #include "tiger/frame/temp.h"
 #include "tiger/translate/tree.h"
 #include "tiger/codegen/assem.h"
+#include "tiger/util/stats.h"
 
 namespace frame {
 
@@ -83,6 +87,7 @@ class Frame;
 class RegManager {
 public:
   RegManager() : temp_map_(temp::Map::Empty()) {}
+  virtual ~RegManager() = default;
 
   /** @brief Get the physical register temp for register index @p regno */
   temp::Temp *GetRegister(int regno) { return regs_[regno]; }
@@ -208,6 +213,8 @@ public:
  * The concrete subclass X64Frame provides the x86-64 implementation.
  */
 class Frame {
+  friend class ProcFrag;                // Owns the frame of its function
+
 protected:
   Frame() = default;
   explicit Frame(temp::Label *name)
@@ -256,6 +263,7 @@ public:
   tree::Stm *save_callee_saves;             ///< IR tree: save callee-saved registers to fresh temps
   tree::Stm *restore_callee_saves;          ///< IR tree: restore callee-saved registers from saved temps
   int max_outgoing_args_;                   ///< Max extra stack args needed for any call in this function
+  util::FunctionStats *stats_ = nullptr;    ///< Counters of this function, if kept
 };
 
 // ═══════════════════════════════════════════════════════════════════════════
@@ -283,11 +291,12 @@ public:
 
   /**
    * @brief Write assembly for this fragment
-   * @param out     Output file
+   * @param out     Output buffer
    * @param phase   Which phase to emit (Proc or String)
    * @param need_ra Whether to perform register allocation before output
    */
-  virtual void OutputAssem(FILE *out, OutputPhase phase, bool need_ra) const = 0;
+  virtual void OutputAssem(util::Writer &out, OutputPhase phase,
+                           bool need_ra) = 0;
 };
 
 /**
@@ -310,7 +319,8 @@ public:
   StringFrag(temp::Label *label, std::string str)
       : label_(label), str_(std::move(str)) {}
 
-  void OutputAssem(FILE *out, OutputPhase phase, bool need_ra) const override;
+  void OutputAssem(util::Writer &out, OutputPhase phase,
+                   bool need_ra) override;
 };
 
 /**
@@ -319,18 +329,40 @@ public:
  * Represents one compiled Tiger function.  Contains:
  *   - body_: the IR tree for the function body (after ProcEntryExit1)
  *   - frame_: the activation record (for frame size, formal accesses, etc.)
+ *   - arena_: the memory holding body_ and everything the back end builds
+ *     from it (canonical trees, instructions, temp lists)
+ *
+ * The fragment owns frame_ and arena_; deleting it frees the function.
  *
  * OutputAssem() drives the back-end pipeline for this function:
  *   canonicalization → code generation → register allocation → assembly output
+ * with arena_ as the current util::Arena, and releases the arena when the
+ * assembly has been written.  body_ is dangling from then on.
+ *
+ * Canonicalization may also be run ahead by Canonicalize().  It is the only
+ * back-end phase that makes labels, so once a function has been
+ * canonicalized, its remaining phases can run on any thread (see
+ * output::AssemGen::Emit()).
  */
 class ProcFrag : public Frag {
 public:
-  tree::Stm *body_;  ///< IR tree for the function body
-  Frame *frame_;     ///< Activation record for this function
-
-  ProcFrag(tree::Stm *body, Frame *frame) : body_(body), frame_(frame) {}
-
-  void OutputAssem(FILE *out, OutputPhase phase, bool need_ra) const override;
+  tree::Stm *body_;                     ///< IR tree for the function body
+  Frame *frame_;                        ///< Activation record for this function; owned
+  std::unique_ptr<util::Arena> arena_;  ///< Backing store of body_ and the back end
+  std::unique_ptr<canon::Traces> traces_; ///< Canonical trees, once Canonicalize() ran
+  int first_temp_ = 0;                  ///< First temp number after canonicalization
+
+  ProcFrag(tree::Stm *body, Frame *frame, std::unique_ptr<util::Arena> arena)
+      : body_(body), frame_(frame), arena_(std::move(arena)) {}
+  ProcFrag(const ProcFrag &) = delete;
+  ProcFrag &operator=(const ProcFrag &) = delete;
+  ~ProcFrag() override { delete frame_; }
+
+  /** @brief Canonicalize body_ into traces_, ahead of OutputAssem() */
+  void Canonicalize();
+
+  void OutputAssem(util::Writer &out, OutputPhase phase,
+                   bool need_ra) override;
 };
 
 /**
@@ -338,15 +370,33 @@ public:
  *
  * Accumulated during IR translation (tr::ProgTr::Translate()).
  * Consumed by output::AssemGen::GenAssem() to produce the final assembly file.
+ *
+ * When a ProcFrag consumer is set, each function is handed to it as soon as
+ * its translation is complete instead of being kept, so the back end can
+ * compile it and free it while the rest of the program is still being
+ * translated.  String fragments are always kept.
  */
 class Frags {
 public:
   Frags() = default;
-  void PushBack(Frag *frag) { frags_.emplace_back(frag); }
+  void PushBack(Frag *frag) {
+    if (proc_consumer_)
+      if (auto *proc = dynamic_cast<ProcFrag *>(frag)) {
+        proc_consumer_(std::unique_ptr<ProcFrag>(proc));
+        return;
+      }
+    frags_.emplace_back(frag);
+  }
   const std::list<Frag*> &GetList() { return frags_; }
 
+  /** @brief Hand ProcFrags pushed from now on to @p consumer (empty: keep them) */
+  void SetProcConsumer(std::function<void(std::unique_ptr<ProcFrag>)> consumer) {
+    proc_consumer_ = std::move(consumer);
+  }
+
 private:
   std::list<Frag*> frags_;
+  std::function<void(std::unique_ptr<ProcFrag>)> proc_consumer_; ///< Takes ProcFrags, if set
 };
 
 } // namespace frame
@@ -3,18 +3,11 @@
 #include <utility>
 
 #include "tiger/frame/arm64frame.h"
+#include "tiger/frame/compilation.h"
 #include "tiger/frame/x64frame.h"
 
-extern frame::RegManager *reg_manager;
-
 namespace frame {
 
-namespace {
-
-TargetArch current_target = DetectHostTarget();
-
-} // namespace
-
 TargetArch DetectHostTarget() {
 #if defined(__APPLE__) && defined(__aarch64__)
   return TargetArch::Arm64Apple;
@@ -46,9 +39,10 @@ std::string TargetName(TargetArch target) {
   return "unknown";
 }
 
-void SetCurrentTarget(TargetArch target) { current_target = target; }
-
-TargetArch GetCurrentTarget() { return current_target; }
+TargetArch GetCurrentTarget() {
+  Compilation *compilation = Compilation::Current();
+  return compilation ? compilation->Target() : DetectHostTarget();
+}
 
 bool IsArm64AppleTarget() {
   return GetCurrentTarget() == TargetArch::Arm64Apple;
@@ -75,9 +69,13 @@ RegManager *NewRegManagerForTarget(TargetArch target) {
 }
 
 Frame *NewFrame(temp::Label *name, std::vector<bool> formals) {
-  if (IsArm64AppleTarget())
-    return NewArm64Frame(name, std::move(formals));
-  return NewX64Frame(name, std::move(formals));
+  // The view shift is part of the function's IR
+  util::FunctionStats *stats = util::Stats::NewFunction(name->Name());
+  util::FunctionStats::Scope counting(stats);
+  Frame *frame = IsArm64AppleTarget() ? NewArm64Frame(name, std::move(formals))
+                                      : NewX64Frame(name, std::move(formals));
+  frame->stats_ = stats;
+  return frame;
 }
 
 tree::Exp *AccessCurrentExp(Access *acc, Frame *frame) {
@@ -93,19 +91,19 @@ tree::Exp *AccessExp(Access *acc, tree::Exp *fp) {
 }
 
 tree::Exp *ExternalCall(std::string s, tree::ExpList *args) {
-  return new tree::CallExp(new tree::NameExp(NamedCodeLabel(s)), args);
+  return util::New<tree::CallExp>(util::New<tree::NameExp>(NamedCodeLabel(s)), args);
 }
 
 tree::Stm *ProcEntryExit1(Frame *frame, tree::Stm *stm) {
-  stm = new tree::SeqStm(frame->save_callee_saves, stm);
-  stm = new tree::SeqStm(frame->view_shift, stm);
-  stm = new tree::SeqStm(stm, frame->restore_callee_saves);
+  stm = util::New<tree::SeqStm>(frame->save_callee_saves, stm);
+  stm = util::New<tree::SeqStm>(frame->view_shift, stm);
+  stm = util::New<tree::SeqStm>(stm, frame->restore_callee_saves);
   return stm;
 }
 
 assem::InstrList *ProcEntryExit2(assem::InstrList *body) {
   assem::Instr *return_sink =
-      new assem::OperInstr("", nullptr, reg_manager->ReturnSink(), nullptr);
+      util::New<assem::OperInstr>("", nullptr, reg_manager->ReturnSink(), nullptr);
   body->Append(return_sink);
   return body;
 }
@@ -20,7 +20,7 @@ TargetArch DetectHostTarget();
 bool ParseTarget(std::string_view name, TargetArch *target);
 std::string TargetName(TargetArch target);
 
-void SetCurrentTarget(TargetArch target);
+/** @brief Target of the current compilation, or the host's outside one */
 TargetArch GetCurrentTarget();
 bool IsArm64AppleTarget();
 
@@ -1,18 +1,25 @@
 #include "tiger/frame/temp.h"
 
+#include <charconv>
 #include <cstdio>
 #include <set>
-#include <sstream>
+
+#include "tiger/util/writer.h"
 
 namespace temp {
 
 LabelFactory LabelFactory::label_factory;
 TempFactory TempFactory::temp_factory;
+thread_local LabelFactory *LabelFactory::current_ = nullptr;
 
 Label *LabelFactory::NewLabel() {
-  char buf[100];
-  snprintf(buf, sizeof(buf), "L%d", label_factory.label_id_++);
-  return NamedLabel(std::string(buf));
+  // Anonymous labels are unique by construction and only compared by
+  // pointer, so they skip the interning table and live in the factory
+  LabelFactory &factory = current_ ? *current_ : label_factory;
+  char buf[16] = {'L'};
+  char *end = std::to_chars(buf + 1, buf + sizeof(buf), factory.label_id_++).ptr;
+  return sym::Symbol::FreshSymbol(std::string_view(buf, end - buf),
+                                  &factory.labels_);
 }
 
 /**
@@ -24,18 +31,27 @@ Label *LabelFactory::NamedLabel(std::string_view s) {
   return sym::Symbol::UniqueSymbol(s);
 }
 
-std::string LabelFactory::LabelString(Label *s) { return s->Name(); }
+std::string LabelFactory::LabelString(Label *s) { return std::string(s->Name()); }
+
+thread_local TempFactory *TempFactory::current_ = nullptr;
 
 Temp *TempFactory::NewTemp() {
-  Temp *p = new Temp(temp_factory.temp_id_++);
-  std::stringstream stream;
-  stream << 't';
-  stream << p->num_;
-  // Name() is the global fallback map used by debug printing and by assembly
-  // pretty-printers before register allocation assigns physical registers.
-  Map::Name()->Enter(p, new std::string(stream.str()));
-
-  return p;
+  // The "tN" name is made by Map::Name() only if the temp is ever printed
+  TempFactory &factory = current_ ? *current_ : temp_factory;
+  return new Temp(factory.temp_id_++);
+}
+
+int TempFactory::Peek() { return (current_ ? *current_ : temp_factory).temp_id_; }
+
+TempFactory::Scope::Scope(int first)
+    : saved_(current_), factory_(new TempFactory()) {
+  factory_->temp_id_ = first;
+  current_ = factory_;
+}
+
+TempFactory::Scope::~Scope() {
+  current_ = saved_;
+  delete factory_;
 }
 
 int Temp::Int() const { return num_; }
@@ -43,11 +59,9 @@ int Temp::Int() const { return num_; }
 Map *Map::Empty() { return new Map(); }
 
 Map *Map::Name() {
-  static Map *m = nullptr;
-  if (!m)
-    // This singleton accumulates names for every Temp ever created.
-    m = Empty();
-  return m;
+  // Binds nothing and is never changed, so one map serves every thread
+  static Map names(std::make_shared<Bindings>(), true, nullptr);
+  return &names;
 }
 
 Map *Map::LayerMap(Map *over, Map *under) {
@@ -55,29 +69,50 @@ Map *Map::LayerMap(Map *over, Map *under) {
     return under;
   else
     // Preserve the full fallback chain of `over` while ending at `under`.
-    return new Map(over->tab_, LayerMap(over->under_, under));
+    return new Map(over->bindings_, over->numbered_,
+                   LayerMap(over->under_, under));
 }
 
 void Map::Enter(Temp *t, std::string *s) {
-  assert(tab_);
-  tab_->Enter(t, s);
+  assert(bindings_);
+  bindings_->Put(t->Int(), s);
 }
 
 std::string *Map::Look(Temp *t) {
-  std::string *s;
-  assert(tab_);
-  s = tab_->Look(t);
-  if (s)
+  assert(bindings_);
+  if (std::string *s = bindings_->Get(t->Int()))
     return s;
-  else if (under_)
+  if (under_)
     return under_->Look(t);
-  else
-    return nullptr;
+  return nullptr;
+}
+
+void Map::Write(util::Writer &out, Temp *t) {
+  for (Map *m = this; m; m = m->under_) {
+    if (std::string *s = m->bindings_->Get(t->Int())) {
+      out << *s;
+      return;
+    }
+    if (m->numbered_) {
+      out << 't' << t->Int();
+      return;
+    }
+  }
+}
+
+std::string Map::NameOf(Temp *t) {
+  for (Map *m = this; m; m = m->under_) {
+    if (std::string *s = m->bindings_->Get(t->Int()))
+      return *s;
+    if (m->numbered_)
+      return "t" + std::to_string(t->Int());
+  }
+  return std::string();
 }
 
 void Map::DumpMap(FILE *out) {
-  tab_->Dump([out](temp::Temp *t, std::string *r) {
-    fprintf(out, "t%d -> %s\n", t->Int(), r->data());
+  bindings_->ForEach([out](int num, std::string *r) {
+    fprintf(out, "t%d -> %s\n", num, r->data());
   });
   if (under_) {
     fprintf(out, "---------\n");
@@ -19,12 +19,28 @@
  *
  * Temps are created by TempFactory::NewTemp() and identified by a unique
  * integer (starting at 100 to avoid confusion with small constants).
+ * Each frame::Compilation has counters of its own for temps and anonymous
+ * labels, used while it is current on the running thread, so programs
+ * compiled side by side number theirs exactly as they would alone.
+ *
+ * The back end of each function may number its temps privately: inside a
+ * TempFactory::Scope, NewTemp() on the running thread counts up from a
+ * given number, usually where the compilation's counter stood when the
+ * function was canonicalized, without moving that counter.  Two functions can then get
+ * the same numbers, which is harmless because no temp is ever used outside
+ * its function, and a function's temps come out numbered the same whether
+ * the functions are compiled one after another or on several threads.
+ * Anonymous labels have no such scope: they are only made by translation
+ * and canonicalization, which run on one thread in fragment order.
  *
  * ─────────────────────────────────────────────────────────────────────────
  * Labels (Label)
  * ─────────────────────────────────────────────────────────────────────────
- * A Label is simply a sym::Symbol used as an assembly label.  Labels are
- * interned (unique per name) so pointer equality can be used.
+ * A Label is simply a sym::Symbol used as an assembly label, compared by
+ * pointer.  Named labels are interned (unique per name); anonymous labels
+ * are fresh symbols that never enter the interning table.  They are held
+ * by the LabelFactory that made them, so the labels of a compilation are
+ * freed when it is reset or destroyed.
  *
  *   LabelFactory::NewLabel()        – create a fresh anonymous label (L0, L1, …)
  *   LabelFactory::NamedLabel(name)  – create/retrieve a named label
@@ -37,7 +53,13 @@
  * layering: Map::LayerMap(over, under) looks up in `over` first, then `under`.
  *
  *   Map::Empty()  – empty map (no bindings)
- *   Map::Name()   – map that returns the temp's numeric name (e.g., "t42")
+ *   Map::Name()   – map that names every temp by its number (e.g., "t42")
+ *
+ * Bindings are stored by temp number in fixed-size pages that are
+ * allocated on first use, so a lookup is two array accesses and a map only
+ * pays for the ranges of temps it actually binds.  Map::Name() binds
+ * nothing: Write() formats the name of a temp straight into the output,
+ * so the one Name() map is never changed and is shared by all threads.
  *
  * The register manager (RegManager) uses a Map to associate pre-colored
  * temps with physical register names (e.g., "%rax").
@@ -56,8 +78,22 @@
 #define TIGER_FRAME_TEMP_H_
 
 #include "tiger/symbol/symbol.h"
+#include "tiger/util/alloc_profile.h"
+#include "tiger/util/arena.h"
 
+#include <array>
 #include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace frame {
+class Compilation;
+} // namespace frame
+
+namespace util {
+class Writer;
+} // namespace util
 
 namespace temp {
 
@@ -72,6 +108,8 @@ using Label = sym::Symbol;
  *   - Named labels: arbitrary strings (for function names, string literals)
  */
 class LabelFactory {
+  friend class frame::Compilation;
+
 public:
   /**
    * @brief Create a fresh anonymous label
@@ -95,7 +133,9 @@ public:
 
 private:
   int label_id_ = 0;                    ///< Counter for anonymous label names
-  static LabelFactory label_factory;    ///< Singleton factory instance
+  util::Arena labels_;                  ///< The anonymous labels made so far
+  static LabelFactory label_factory;    ///< Used outside any compilation
+  static thread_local LabelFactory *current_; ///< Current compilation's, if any
 };
 
 /**
@@ -131,6 +171,8 @@ private:
  * All temps are created through this factory to ensure unique IDs.
  */
 class TempFactory {
+  friend class frame::Compilation;
+
 public:
   /**
    * @brief Create a fresh virtual register
@@ -138,9 +180,30 @@ public:
    */
   static Temp *NewTemp();
 
+  /** @brief Number the next NewTemp() on this thread would give */
+  static int Peek();
+
+  /**
+   * @brief Gives the running thread its own temp counter while in scope
+   *
+   * The counter starts at @p first; scopes nest.
+   */
+  class Scope {
+  public:
+    explicit Scope(int first);
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+    ~Scope();
+
+  private:
+    TempFactory *saved_;                ///< Factory in use before this scope
+    TempFactory *factory_;              ///< This scope's private counter
+  };
+
 private:
   int temp_id_ = 100;                   ///< Counter for temp IDs
-  static TempFactory temp_factory;      ///< Singleton factory instance
+  static TempFactory temp_factory;      ///< Used outside any compilation
+  static thread_local TempFactory *current_; ///< Scope's or compilation's counter, if any
 };
 
 /**
@@ -166,10 +229,20 @@ public:
   /**
    * @brief Look up the register name for a temp
    * @param t The temp to look up
-   * @return Pointer to the name string, or nullptr if not found
+   * @return Pointer to the name string, or nullptr if not bound (temps
+   *         named only by a Name() map have no string to point to)
    */
   std::string *Look(Temp *t);
 
+  /**
+   * @brief Write the name of @p t to @p out: its binding, or "tN" if a
+   *        Name() map is reached first
+   */
+  void Write(util::Writer &out, Temp *t);
+
+  /** @brief The name Write() would write for @p t */
+  std::string NameOf(Temp *t);
+
   /** @brief Print all bindings in this map (for debugging) */
   void DumpMap(FILE *out);
 
@@ -177,10 +250,11 @@ public:
   static Map *Empty();
 
   /**
-   * @brief Create a map that returns each temp's numeric name
+   * @brief The map that names each temp by its number
    *
-   * Returns strings like "t100", "t101", etc.  Used as a fallback
-   * when no physical register has been assigned yet.
+   * Names like "t100", "t101", etc.  Used as a fallback when no physical
+   * register has been assigned yet.  The map binds nothing and is shared
+   * by all threads; it must not be entered into.
    */
   static Map *Name();
 
@@ -193,12 +267,51 @@ public:
   static Map *LayerMap(Map *over, Map *under);
 
 private:
-  tab::Table<Temp, std::string> *tab_; ///< Hash table of bindings
-  Map *under_;                          ///< Fallback map (may be nullptr)
-
-  Map() : tab_(new tab::Table<Temp, std::string>()), under_(nullptr) {}
-  Map(tab::Table<Temp, std::string> *tab, Map *under)
-      : tab_(tab), under_(under) {}
+  /// Temp number → name, in pages of PAGE_SIZE allocated on first use
+  class Bindings {
+  public:
+    static constexpr int PAGE_BITS = 8;
+    static constexpr int PAGE_SIZE = 1 << PAGE_BITS;
+
+    std::string *Get(int num) const {
+      size_t page = static_cast<size_t>(num) >> PAGE_BITS;
+      if (page >= pages_.size() || !pages_[page])
+        return nullptr;
+      return (*pages_[page])[num & (PAGE_SIZE - 1)];
+    }
+
+    void Put(int num, std::string *s) {
+      size_t page = static_cast<size_t>(num) >> PAGE_BITS;
+      if (page >= pages_.size())
+        pages_.resize(page + 1);
+      if (!pages_[page])
+        pages_[page] = std::make_unique<Page>();
+      (*pages_[page])[num & (PAGE_SIZE - 1)] = s;
+    }
+
+    /** @brief Visit every binding in temp-number order */
+    template <typename F> void ForEach(F f) const {
+      for (size_t page = 0; page < pages_.size(); ++page) {
+        if (!pages_[page])
+          continue;
+        for (int i = 0; i < PAGE_SIZE; ++i)
+          if (std::string *s = (*pages_[page])[i])
+            f(static_cast<int>(page << PAGE_BITS) + i, s);
+      }
+    }
+
+  private:
+    using Page = std::array<std::string *, PAGE_SIZE>;
+    std::vector<std::unique_ptr<Page>> pages_;
+  };
+
+  std::shared_ptr<Bindings> bindings_; ///< Own bindings (shared by layered views)
+  bool numbered_;                      ///< Name(): write "tN" for unbound temps
+  Map *under_;                         ///< Fallback map (may be nullptr)
+
+  Map() : bindings_(std::make_shared<Bindings>()), numbered_(false), under_(nullptr) {}
+  Map(std::shared_ptr<Bindings> bindings, bool numbered, Map *under)
+      : bindings_(std::move(bindings)), numbered_(numbered), under_(under) {}
 };
 
 /**
@@ -214,7 +327,7 @@ private:
  * Set operations (Union, Diff, Contain) treat the list as a set
  * (no duplicates in results).
  */
-class TempList {
+class TempList : public util::AllocTracked<TempList> {
 public:
   explicit TempList(Temp *t) : temp_list_({t}) {}
   TempList(std::initializer_list<Temp *> list) : temp_list_(list) {}
@@ -226,8 +339,11 @@ public:
   /** @brief Get the n-th temp (0-indexed) */
   [[nodiscard]] Temp *NthTemp(int i) const;
 
+  /// The cells are charged to TempList in an allocation profile
+  using List = std::list<Temp *, util::TrackedAllocator<Temp *, TempList>>;
+
   /** @brief Get the underlying list */
-  [[nodiscard]] const std::list<Temp *> &GetList() const { return temp_list_; }
+  [[nodiscard]] const List &GetList() const { return temp_list_; }
 
   /** @brief Test whether temp @p t is in this list */
   bool Contain(Temp *t) const;
@@ -259,11 +375,10 @@ public:
    * @param temp The replacement temp
    * @return Iterator pointing to the newly inserted temp
    */
-  std::list<Temp *>::const_iterator Replace(
-    std::list<Temp *>::const_iterator pos, Temp *temp);
+  List::const_iterator Replace(List::const_iterator pos, Temp *temp);
 
 private:
-  std::list<Temp *> temp_list_;
+  List temp_list_;
 };
 
 } // namespace temp
@@ -3,7 +3,7 @@
 #include <iostream>
 #include <sstream>
 
-extern frame::RegManager *reg_manager;
+#include "tiger/frame/compilation.h"
 
 namespace frame {
 std::unordered_map<X64RegManager::Register, std::string> X64RegManager::reg_str = 
@@ -37,7 +37,7 @@ X64RegManager::X64RegManager() {
 }
 
 temp::TempList *X64RegManager::Registers() {
-  temp::TempList *temps = new temp::TempList();
+  temp::TempList *temps = util::New<temp::TempList>();
   for (int reg = 0; reg < REG_COUNT; ++reg) {
       // Keep the enumeration order stable: color indices are interpreted by
       // register allocation using this exact register list.
@@ -47,7 +47,7 @@ temp::TempList *X64RegManager::Registers() {
 }
 
 temp::TempList *X64RegManager::ArgRegs() {
-  temp::TempList *temps = new temp::TempList({
+  temp::TempList *temps = util::New<temp::TempList>({
     regs_.at(RDI),
     regs_.at(RSI),
     regs_.at(RDX),
@@ -59,7 +59,7 @@ temp::TempList *X64RegManager::ArgRegs() {
 }
 
 temp::TempList *X64RegManager::CallerSaves() {
-  temp::TempList *temps = new temp::TempList({
+  temp::TempList *temps = util::New<temp::TempList>({
     regs_.at(RAX),
     regs_.at(RDI),
     regs_.at(RSI),
@@ -74,7 +74,7 @@ temp::TempList *X64RegManager::CallerSaves() {
 }
 
 temp::TempList *X64RegManager::CalleeSaves() {
-  temp::TempList *temps = new temp::TempList({
+  temp::TempList *temps = util::New<temp::TempList>({
     regs_.at(RBX), 
     regs_.at(RBP), 
     regs_.at(R12),
@@ -141,7 +141,7 @@ public:
   explicit InRegAccess(temp::Temp *reg) : reg(reg) {}
 
   std::string MunchAccess(Frame *frame) override {
-    return *temp::Map::Name()->Look(reg);
+    return temp::Map::Name()->NameOf(reg);
   }
 };
 
@@ -176,8 +176,8 @@ Access *X64Frame::AllocLocal(bool escape) {
 }
 
 tree::Exp *X64Frame::FrameAddress() const {
-  return new tree::BinopExp(tree::PLUS_OP, 
-          new tree::TempExp(reg_manager->StackPointer()), new tree::NameExp(frame_size_));
+  return util::New<tree::BinopExp>(tree::PLUS_OP, 
+          util::New<tree::TempExp>(reg_manager->StackPointer()), util::New<tree::NameExp>(frame_size_));
 }
 
 int X64Frame::WordSize() const {
@@ -185,12 +185,12 @@ int X64Frame::WordSize() const {
 }
 
 std::string X64Frame::GetLabel() const {
-  return name_->Name();
+  return std::string(name_->Name());
 }
 
 tree::Exp *X64Frame::StackOffset(int frame_offset) const {
-  return new tree::BinopExp(tree::MINUS_OP, 
-          new tree::NameExp(frame_size_), new tree::ConstExp(frame_offset));
+  return util::New<tree::BinopExp>(tree::MINUS_OP, 
+          util::New<tree::NameExp>(frame_size_), util::New<tree::ConstExp>(frame_offset));
 }
 
 Frame *NewX64Frame(temp::Label *name, std::vector<bool> formals) {
@@ -198,12 +198,12 @@ Frame *NewX64Frame(temp::Label *name, std::vector<bool> formals) {
   int frame_offset = frame->WordSize();
   // The assembler-level frame-size symbol lets both the prologue and every
   // stack-slot reference agree on the final frame size without patching IR.
-  frame->frame_size_ = temp::LabelFactory::NamedLabel(name->Name() + "_framesize");
+  frame->frame_size_ = temp::LabelFactory::NamedLabel(std::string(name->Name()) + "_framesize");
 
-  tree::TempExp *fp_exp = new tree::TempExp(temp::TempFactory::NewTemp());
+  tree::TempExp *fp_exp = util::New<tree::TempExp>(temp::TempFactory::NewTemp());
   // Materialize the "virtual frame pointer" once at function entry so view
   // shift code can address incoming stack arguments consistently.
-  frame->view_shift = new tree::MoveStm(fp_exp, frame->FrameAddress());
+  frame->view_shift = util::New<tree::MoveStm>(fp_exp, frame->FrameAddress());
 
   tree::Exp *dst_exp;
   tree::Stm *single_view_shift;
@@ -213,10 +213,10 @@ Frame *NewX64Frame(temp::Label *name, std::vector<bool> formals) {
   // Formals
 
   if (formals.size() > arg_reg_count) {
-    fp_exp_copy = new tree::TempExp(temp::TempFactory::NewTemp());
+    fp_exp_copy = util::New<tree::TempExp>(temp::TempFactory::NewTemp());
     // Extra formals arrive in caller-allocated stack slots above the return
     // address, so we keep an extra saved FP expression for those loads.
-    frame->view_shift = new tree::SeqStm(frame->view_shift, new tree::MoveStm(fp_exp_copy, frame->FrameAddress()));
+    frame->view_shift = util::New<tree::SeqStm>(frame->view_shift, util::New<tree::MoveStm>(fp_exp_copy, frame->FrameAddress()));
   }
 
   for (int i = 0; i < formals.size(); ++i) {
@@ -224,27 +224,27 @@ Frame *NewX64Frame(temp::Label *name, std::vector<bool> formals) {
       frame->formal_access_.push_back(new InFrameAccess(frame_offset));
       // Escaping formals are copied into this frame's own slots immediately;
       // nested functions will later reach them through static-link traversal.
-      dst_exp = new tree::MemExp(new tree::BinopExp(tree::MINUS_OP, 
-                  fp_exp, new tree::ConstExp((i + 1) * frame->WordSize())));
+      dst_exp = util::New<tree::MemExp>(util::New<tree::BinopExp>(tree::MINUS_OP, 
+                  fp_exp, util::New<tree::ConstExp>((i + 1) * frame->WordSize())));
       frame_offset += frame->WordSize();
       frame->local_count_++;
     } else {
       temp::Temp *reg = temp::TempFactory::NewTemp();
       frame->formal_access_.push_back(new InRegAccess(reg));
-      dst_exp = new tree::TempExp(reg);
+      dst_exp = util::New<tree::TempExp>(reg);
     }
 
     if (i < arg_reg_count) {
       // Register-passed formal: move from ABI argument register to its home.
-      single_view_shift = new tree::MoveStm(dst_exp, new tree::TempExp(reg_manager->ArgRegs()->NthTemp(i)));
+      single_view_shift = util::New<tree::MoveStm>(dst_exp, util::New<tree::TempExp>(reg_manager->ArgRegs()->NthTemp(i)));
     } else {
       // Stack-passed formals start one word above the return address, then
       // continue upward in word-sized slots.
-      single_view_shift = new tree::MoveStm(dst_exp, new tree::MemExp(
-                            new tree::BinopExp(tree::PLUS_OP, fp_exp_copy, 
-                              new tree::ConstExp((i - arg_reg_count + 1) * frame->WordSize()))));
+      single_view_shift = util::New<tree::MoveStm>(dst_exp, util::New<tree::MemExp>(
+                            util::New<tree::BinopExp>(tree::PLUS_OP, fp_exp_copy, 
+                              util::New<tree::ConstExp>((i - arg_reg_count + 1) * frame->WordSize()))));
     }
-    frame->view_shift = new tree::SeqStm(frame->view_shift, single_view_shift);
+    frame->view_shift = util::New<tree::SeqStm>(frame->view_shift, single_view_shift);
   }
 
   // Save and restore callee-save registers in fresh temps. Those temps then
@@ -257,17 +257,17 @@ Frame *NewX64Frame(temp::Label *name, std::vector<bool> formals) {
   tree::Stm *single_restore;
 
   store_reg = temp::TempFactory::NewTemp();
-  frame->save_callee_saves = new tree::MoveStm(new tree::TempExp(store_reg), 
-                              new tree::TempExp(callee_saves->GetList().front()));
-  frame->restore_callee_saves = new tree::MoveStm(new tree::TempExp(callee_saves->GetList().front()),
-                                  new tree::TempExp(store_reg));
+  frame->save_callee_saves = util::New<tree::MoveStm>(util::New<tree::TempExp>(store_reg), 
+                              util::New<tree::TempExp>(callee_saves->GetList().front()));
+  frame->restore_callee_saves = util::New<tree::MoveStm>(util::New<tree::TempExp>(callee_saves->GetList().front()),
+                                  util::New<tree::TempExp>(store_reg));
 
   for (auto reg_it = ++callee_saves->GetList().begin(); reg_it != callee_saves->GetList().end(); ++reg_it) {
     store_reg = temp::TempFactory::NewTemp();
-    single_save = new tree::MoveStm(new tree::TempExp(store_reg), new tree::TempExp(*reg_it));
-    single_restore = new tree::MoveStm(new tree::TempExp(*reg_it), new tree::TempExp(store_reg));
-    frame->save_callee_saves = new tree::SeqStm(single_save, frame->save_callee_saves);
-    frame->restore_callee_saves = new tree::SeqStm(single_restore, frame->restore_callee_saves);
+    single_save = util::New<tree::MoveStm>(util::New<tree::TempExp>(store_reg), util::New<tree::TempExp>(*reg_it));
+    single_restore = util::New<tree::MoveStm>(util::New<tree::TempExp>(*reg_it), util::New<tree::TempExp>(store_reg));
+    frame->save_callee_saves = util::New<tree::SeqStm>(single_save, frame->save_callee_saves);
+    frame->restore_callee_saves = util::New<tree::SeqStm>(single_restore, frame->restore_callee_saves);
   }
 
   return frame;
@@ -280,12 +280,12 @@ tree::Exp *AccessCurrentExpX64(Access *acc, Frame *frame) {
 
     // Recompute the current frame's base address instead of assuming a fixed
     // hardware frame pointer register.
-    return new tree::MemExp(new tree::BinopExp(tree::MINUS_OP, 
-            frame->FrameAddress(), new tree::ConstExp(frame_acc->offset)));
+    return util::New<tree::MemExp>(util::New<tree::BinopExp>(tree::MINUS_OP, 
+            frame->FrameAddress(), util::New<tree::ConstExp>(frame_acc->offset)));
 
   } else {
     InRegAccess *reg_acc = static_cast<InRegAccess *>(acc);
-    return new tree::TempExp(reg_acc->reg);
+    return util::New<tree::TempExp>(reg_acc->reg);
   }
 }
 
@@ -294,11 +294,11 @@ tree::Exp *AccessExpX64(Access *acc, tree::Exp *fp) {
     // `fp` is an explicit frame-pointer expression, usually obtained by
     // following static links through enclosing activation records.
     InFrameAccess *frame_acc = static_cast<InFrameAccess *>(acc);
-    return new tree::MemExp(new tree::BinopExp(tree::MINUS_OP, 
-            fp, new tree::ConstExp(frame_acc->offset)));
+    return util::New<tree::MemExp>(util::New<tree::BinopExp>(tree::MINUS_OP, 
+            fp, util::New<tree::ConstExp>(frame_acc->offset)));
   } else {
     InRegAccess *reg_acc = static_cast<InRegAccess *>(acc);
-    return new tree::TempExp(reg_acc->reg);
+    return util::New<tree::TempExp>(reg_acc->reg);
   }
 }
 
@@ -309,6 +309,8 @@ assem::Proc *ProcEntryExit3X64(Frame *frame, assem::InstrList *body) {
   // Reserve enough space for both escaping locals and the maximum outgoing
   // stack-argument area needed by any call in the function body.
   int fs = (frame->local_count_ + frame->max_outgoing_args_) * frame->WordSize();
+  if (frame->stats_)
+    frame->stats_->frame_size_ = fs;
   prologue_ss << ".set " << frame->frame_size_->Name() << ", " << fs << "\n"; 
 
   // Function label
@@ -329,7 +331,7 @@ assem::Proc *ProcEntryExit3X64(Frame *frame, assem::InstrList *body) {
   // Return instruction
   epilogue_ss << "retq\n";
 
-  return new assem::Proc(prologue_ss.str(), body, epilogue_ss.str());
+  return util::New<assem::Proc>(prologue_ss.str(), body, epilogue_ss.str());
 }
 
 } // namespace frame
@@ -0,0 +1,33 @@
+/**
+ * @file lex_state.h
+ * @brief Tiger-specific state of one scan - Lab 2
+ *
+ * tiger.lex declares LexState as the scanner's extra data, so it is
+ * included both by the scanner itself and, through scanner.h, by the code
+ * that makes scanners.
+ */
+
+#ifndef TIGER_LEX_LEX_STATE_H_
+#define TIGER_LEX_LEX_STATE_H_
+
+#include <string>
+
+// Forward declarations
+namespace err {
+    class ErrorMsg;  /**< Forward declaration for error message handler */
+}
+
+/**
+ * @brief Lexer state of one scan, kept as the scanner's extra data
+ */
+struct LexState {
+    explicit LexState(err::ErrorMsg *errormsg) : errormsg(errormsg) {}
+
+    err::ErrorMsg *errormsg;  /**< Receives token positions and errors */
+    int char_pos = 1;         /**< Position of the next character */
+    int comment_level = 0;    /**< Nesting depth of the current comment */
+    std::string string_buf;   /**< String literal being scanned */
+    bool unterminated = false; /**< Input ended in a string or comment */
+};
+
+#endif // TIGER_LEX_LEX_STATE_H_
@@ -3,38 +3,24 @@
  * @brief Interface for the Tiger lexical analyzer - Lab 2
  *
  * This header file provides the interface for the Flex-generated lexical
- * analyzer. It declares the external functions and variables needed to
- * integrate the lexer with the parser and error handling systems.
+ * analyzer to the parser and the lexer test.
+ *
+ * The scanner is reentrant: everything it keeps between tokens lives in a
+ * yyscan_t made by yylex_init_extra(), together with a LexState for the
+ * Tiger-specific part, so several files can be scanned at the same time.
+ *
+ * Its functions (yylex(), yylex_init_extra(), yylex_destroy(), yyset_in(),
+ * yy_scan_bytes(), ...) are declared by lex.yy.hh, the header flex writes
+ * next to lex.yy.cc in the build tree, so that their declarations always
+ * match the definitions of the flex that built the scanner.  yylex() takes
+ * a YYSTYPE, so parse.tab.hh is included first.
  */
 
 #ifndef TIGER_LEX_SCANNER_H_
 #define TIGER_LEX_SCANNER_H_
 
-#include <string>
-#include <iostream>
-
-// Forward declarations
-namespace err {
-    class ErrorMsg;  /**< Forward declaration for error message handler */
-}
-
-// Forward declaration for flex generated functions
-extern int yylex();           /**< Main lexing function - returns next token */
-extern int yylineno;          /**< Current line number (maintained by flex) */
-extern char *yytext;          /**< Text of the current token */
-extern int yyleng;            /**< Length of the current token */
-extern FILE *yyin;            /**< Input file stream */
-
-/**
- * @brief Initialize the lexical analyzer state
- *
- * Sets up the global state variables for a new lexing session:
- * - Sets the error message handler
- * - Resets character position to 1
- * - Resets comment nesting level to 0
- *
- * @param errormsg Pointer to the error message handler
- */
-void InitLexer(err::ErrorMsg *errormsg);
+#include "tiger/lex/lex_state.h"
+#include "parse.tab.hh"
+#include "lex.yy.hh"
 
 #endif // TIGER_LEX_SCANNER_H_
@@ -0,0 +1,99 @@
+/**
+ * @file dataflow.cc
+ * @brief Basic-block partitioning and ordering for the dataflow framework
+ *
+ * Splits the per-instruction flow graph into basic blocks, links the blocks
+ * by the flow graph edges that cross block boundaries, and computes the
+ * reverse post-order used to seed the dataflow worklist.
+ */
+
+#include "tiger/liveness/dataflow.h"
+
+#include <algorithm>
+
+namespace df {
+
+namespace {
+
+/**
+ * Return true if @p node must start a new block given the node @p prev that
+ * precedes it in instruction order.
+ */
+bool StartsBlock(fg::FNode *prev, fg::FNode *node) {
+  if (prev == nullptr)
+    return true;
+  // Join points and successors of branches begin a block
+  if (node->InDegree() != 1 || prev->OutDegree() != 1)
+    return true;
+  // The single edge into node must be the fall-through from prev
+  return prev->Succ()->GetList().front() != node;
+}
+
+} // namespace
+
+BlockGraph::BlockGraph(fg::FGraphPtr flowgraph)
+    : block_of_(flowgraph->nodecount_, nullptr) {
+  // Pass 1: cut the instruction sequence into blocks
+  fg::FNode *prev = nullptr;
+  for (fg::FNode *node : flowgraph->Nodes()->GetList()) {
+    if (StartsBlock(prev, node)) {
+      Block *b = new Block();
+      b->id_ = static_cast<int>(blocks_.size());
+      b->rpo_ = -1;
+      blocks_.push_back(b);
+    }
+    blocks_.back()->nodes_.push_back(node);
+    block_of_[node->Key()] = blocks_.back();
+    prev = node;
+  }
+
+  // Pass 2: edges leaving the last instruction of a block connect blocks
+  for (Block *b : blocks_) {
+    for (fg::FNode *succ : b->nodes_.back()->Succ()->GetList()) {
+      Block *s = block_of_[succ->Key()];
+      if (std::find(b->succs_.begin(), b->succs_.end(), s) != b->succs_.end())
+        continue;
+      b->succs_.push_back(s);
+      s->preds_.push_back(b);
+    }
+  }
+
+  // Pass 3: reverse post-order by an iterative depth-first search from the
+  // entry block.  Blocks the entry cannot reach are appended afterwards so
+  // every block still gets solved.
+  std::vector<bool> visited(blocks_.size(), false);
+  std::vector<std::pair<Block *, std::size_t>> stack;
+  std::vector<Block *> post_order;
+  for (Block *root : blocks_) {
+    if (visited[root->id_])
+      continue;
+    visited[root->id_] = true;
+    stack.emplace_back(root, 0);
+    post_order.clear();
+    while (!stack.empty()) {
+      Block *b = stack.back().first;
+      std::size_t &next = stack.back().second;
+      if (next < b->succs_.size()) {
+        Block *s = b->succs_[next++];
+        if (!visited[s->id_]) {
+          visited[s->id_] = true;
+          stack.emplace_back(s, 0);
+        }
+      } else {
+        post_order.push_back(b);
+        stack.pop_back();
+      }
+    }
+    rpo_.insert(rpo_.end(), post_order.rbegin(), post_order.rend());
+  }
+
+  for (std::size_t i = 0; i < rpo_.size(); ++i)
+    rpo_[i]->rpo_ = static_cast<int>(i);
+}
+
+BlockGraph::~BlockGraph() {
+  for (Block *b : blocks_)
+    delete b;
+}
+
+} // namespace df
@@ -0,0 +1,409 @@
+/**
+ * @file dataflow.h
+ * @brief Block-level, worklist-driven bit-vector dataflow framework
+ *
+ * This module solves gen/kill dataflow problems over the control flow graph
+ * built by fg::FlowGraphFactory.  Instead of sweeping every instruction
+ * until nothing changes, it works on basic blocks:
+ *
+ *   1. BlockGraph partitions the flow graph into maximal straight-line
+ *      blocks and orders them in reverse post-order (RPO).
+ *   2. Solver summarises each block by a single (gen, kill) pair, the
+ *      composition of the transfer functions of its instructions.
+ *   3. A worklist seeded in RPO (forward problems) or in RPO of the reverse
+ *      graph (backward problems) re-evaluates a block only when one of its
+ *      neighbours changed.
+ *   4. Per-instruction sets are never stored.  Expand() rebuilds them for
+ *      one block on demand, walking the block from its boundary set.
+ *
+ * When a transformation only touches a few blocks, Update() re-solves from
+ * the previous fixed point: only the changed blocks are re-summarised and
+ * the worklist starts with them alone.  If the blocks turn out not to be
+ * the ones solved before, it solves from scratch instead.
+ *
+ * ─────────────────────────────────────────────────────────────────────────
+ * Problem interface
+ * ─────────────────────────────────────────────────────────────────────────
+ * A problem is any class providing:
+ *
+ *   static constexpr df::Direction DIRECTION;  // FORWARD or BACKWARD
+ *   static constexpr df::Meet MEET;            // UNION or INTERSECT
+ *   int Universe() const;                      // number of set elements
+ *   template <typename Fn> void ForEachGen(fg::FNode *n, Fn f) const;
+ *   template <typename Fn> void ForEachKill(fg::FNode *n, Fn f) const;
+ *
+ * The transfer function of an instruction n is
+ *   f_n(x) = gen[n] ∪ (x − kill[n])
+ * and the boundary value (entry for forward, exit for backward) is empty.
+ *
+ * Liveness (live::LivenessProblem) is the first client.
+ */
+
+#ifndef TIGER_LIVENESS_DATAFLOW_H_
+#define TIGER_LIVENESS_DATAFLOW_H_
+
+#include <algorithm>
+#include <cassert>
+#include <deque>
+#include <vector>
+
+#include "tiger/liveness/flowgraph.h"
+#include "tiger/util/bitset.h"
+
+namespace df {
+
+/** @brief Direction in which facts propagate along control flow edges */
+enum class Direction { FORWARD, BACKWARD };
+
+/** @brief Confluence operator applied where control flow edges join */
+enum class Meet { UNION, INTERSECT };
+
+/**
+ * @brief A basic block: a maximal run of flow-graph nodes with a single
+ * entry at the first node and a single exit at the last one
+ */
+struct Block {
+  int id_;                          ///< Index in BlockGraph::Blocks()
+  int rpo_;                         ///< Position in reverse post-order
+  std::vector<fg::FNode *> nodes_;  ///< Instructions, in program order
+  std::vector<Block *> succs_;      ///< Successor blocks
+  std::vector<Block *> preds_;      ///< Predecessor blocks
+};
+
+/**
+ * @brief The flow graph partitioned into basic blocks
+ *
+ * A new block starts at the first instruction, at every instruction that
+ * does not have exactly one predecessor, and after every instruction that
+ * does not have exactly one (fall-through) successor.
+ */
+class BlockGraph {
+public:
+  explicit BlockGraph(fg::FGraphPtr flowgraph);
+
+  /** @brief All blocks, in program order (the entry block first) */
+  [[nodiscard]] const std::vector<Block *> &Blocks() const { return blocks_; }
+
+  /** @brief Blocks in reverse post-order from the entry; unreachable last */
+  [[nodiscard]] const std::vector<Block *> &ReversePostOrder() const {
+    return rpo_;
+  }
+
+  /** @brief The block containing flow-graph node @p n */
+  [[nodiscard]] Block *BlockOf(fg::FNode *n) const {
+    return block_of_[n->Key()];
+  }
+
+  BlockGraph(const BlockGraph &) = delete;
+  BlockGraph &operator=(const BlockGraph &) = delete;
+  ~BlockGraph();
+
+private:
+  std::vector<Block *> blocks_;    ///< Owned blocks, in program order
+  std::vector<Block *> rpo_;       ///< Blocks in reverse post-order
+  std::vector<Block *> block_of_;  ///< FNode key → containing block
+};
+
+/**
+ * @brief Worklist solver for a gen/kill problem over a BlockGraph
+ * @tparam Problem See the problem interface in the file comment
+ */
+template <typename Problem> class Solver {
+public:
+  Solver(const BlockGraph *graph, const Problem *problem)
+      : graph_(graph), problem_(problem), iterations_(0) {}
+
+  /** @brief Compute the fixed point of the block-level equations */
+  void Solve();
+
+  /**
+   * @brief Re-solve after the instructions of some blocks changed
+   *
+   * @p graph should have the same blocks (same ids, same edges) as the
+   * graph solved before; only the instructions inside the blocks of
+   * @p dirty may differ, and the universe may have grown.  Facts in
+   * @p retract are dropped from every set first.  Starting from the
+   * previous solution is only sound for may-problems whose new fixed point
+   * contains the old one less @p retract, e.g. liveness after inserting
+   * uses or renaming temps away.
+   *
+   * Each block must still contain the first and the last instruction it
+   * had before (instructions may have been inserted around them).  If one
+   * does not, or the number of blocks changed, the old solution does not
+   * apply and @p graph is solved from scratch.
+   *
+   * @return The blocks whose per-instruction sets may have changed: the
+   * dirty blocks and every block whose boundary set changed, in id order;
+   * every block after solving from scratch
+   */
+  std::vector<Block *> Update(const BlockGraph *graph, const Problem *problem,
+                              const std::vector<Block *> &dirty,
+                              const util::BitSet &retract);
+
+  /** @brief Facts at the top of block @p b */
+  [[nodiscard]] const util::BitSet &In(Block *b) const { return in_[b->id_]; }
+
+  /** @brief Facts at the bottom of block @p b */
+  [[nodiscard]] const util::BitSet &Out(Block *b) const {
+    return out_[b->id_];
+  }
+
+  /** @brief Number of block evaluations performed by Solve() */
+  [[nodiscard]] int Iterations() const { return iterations_; }
+
+  /**
+   * @brief Rebuild the per-instruction sets of block @p b
+   *
+   * Calls @p f(node, facts) once per instruction, in the direction of the
+   * problem, where facts is the set flowing into the instruction: its out
+   * set for backward problems (visited last-to-first) and its in set for
+   * forward ones (visited first-to-last).  Only one running set is kept,
+   * so @p facts is only valid during the call.
+   */
+  template <typename Fn> void Expand(Block *b, Fn f) const;
+
+private:
+  static constexpr bool BACKWARD = Problem::DIRECTION == Direction::BACKWARD;
+
+  const BlockGraph *graph_;
+  const Problem *problem_;
+  int iterations_;
+  std::vector<util::BitSet> gen_;   ///< Block gen summaries
+  std::vector<util::BitSet> kill_;  ///< Block kill summaries
+  std::vector<util::BitSet> in_;    ///< Facts at block entry
+  std::vector<util::BitSet> out_;   ///< Facts at block exit
+  std::vector<assem::Instr *> heads_; ///< First instruction of each block solved
+  std::vector<assem::Instr *> tails_; ///< Last instruction of each block solved
+
+  /** @brief Record the first and last instruction of every block of graph_ */
+  void RememberBlocks();
+  /** @brief Whether every block of @p graph spans the same old instructions */
+  bool SameBlocks(const BlockGraph *graph) const;
+  /** @brief Fold the transfer function of @p n into a running (gen, kill) */
+  void Compose(fg::FNode *n, util::BitSet *gen, util::BitSet *kill) const;
+  /** @brief Recompute the (gen, kill) summary of block @p b */
+  void Summarise(Block *b);
+  /**
+   * @brief Run the worklist to a fixed point, setting @p changed[id] for
+   * every block whose boundary set (in for forward, out for backward) moved
+   */
+  void Propagate(std::deque<Block *> *worklist, std::vector<bool> *queued,
+                 std::vector<bool> *changed);
+  /** @brief Apply the transfer function of @p n to @p set in place */
+  void Apply(fg::FNode *n, util::BitSet *set) const;
+};
+
+template <typename Problem>
+void Solver<Problem>::Compose(fg::FNode *n, util::BitSet *gen,
+                              util::BitSet *kill) const {
+  // Appending f_n(x) = g ∪ (x − k) after (G, K) gives
+  //   (g ∪ (G − k), K ∪ k)
+  problem_->ForEachKill(n, [gen, kill](int i) {
+    gen->Reset(i);
+    kill->Set(i);
+  });
+  problem_->ForEachGen(n, [gen](int i) { gen->Set(i); });
+}
+
+template <typename Problem>
+void Solver<Problem>::Apply(fg::FNode *n, util::BitSet *set) const {
+  problem_->ForEachKill(n, [set](int i) { set->Reset(i); });
+  problem_->ForEachGen(n, [set](int i) { set->Set(i); });
+}
+
+template <typename Problem> void Solver<Problem>::Summarise(Block *b) {
+  gen_[b->id_].Clear();
+  kill_[b->id_].Clear();
+  if (BACKWARD) {
+    for (auto it = b->nodes_.rbegin(); it != b->nodes_.rend(); ++it)
+      Compose(*it, &gen_[b->id_], &kill_[b->id_]);
+  } else {
+    for (fg::FNode *n : b->nodes_)
+      Compose(n, &gen_[b->id_], &kill_[b->id_]);
+  }
+}
+
+template <typename Problem> void Solver<Problem>::Solve() {
+  const std::vector<Block *> &blocks = graph_->Blocks();
+  int universe = problem_->Universe();
+  std::size_t block_count = blocks.size();
+
+  // Summarise every block by one (gen, kill) pair, composing the transfer
+  // functions in the order facts flow through the block.
+  gen_.assign(block_count, util::BitSet(universe));
+  kill_.assign(block_count, util::BitSet(universe));
+  for (Block *b : blocks)
+    Summarise(b);
+
+  // Start from the top of the lattice: empty for may-problems and the full
+  // universe for must-problems.  Blocks at the boundary meet nothing and
+  // keep the empty boundary value.
+  util::BitSet top(universe);
+  if (Problem::MEET == Meet::INTERSECT)
+    top.SetAll();
+  in_.assign(block_count, top);
+  out_.assign(block_count, top);
+
+  // Seed the worklist in RPO for forward problems and in reverse RPO (an
+  // approximation of RPO on the reversed graph) for backward ones, so most
+  // blocks see up-to-date neighbours the first time they are evaluated.
+  std::deque<Block *> worklist;
+  std::vector<bool> queued(block_count, true);
+  const std::vector<Block *> &rpo = graph_->ReversePostOrder();
+  if (BACKWARD)
+    worklist.assign(rpo.rbegin(), rpo.rend());
+  else
+    worklist.assign(rpo.begin(), rpo.end());
+
+  Propagate(&worklist, &queued, nullptr);
+  RememberBlocks();
+}
+
+template <typename Problem> void Solver<Problem>::RememberBlocks() {
+  heads_.clear();
+  tails_.clear();
+  for (Block *b : graph_->Blocks()) {
+    heads_.push_back(b->nodes_.front()->NodeInfo());
+    tails_.push_back(b->nodes_.back()->NodeInfo());
+  }
+}
+
+template <typename Problem>
+bool Solver<Problem>::SameBlocks(const BlockGraph *graph) const {
+  const std::vector<Block *> &blocks = graph->Blocks();
+  if (blocks.size() != heads_.size())
+    return false;
+  // A block that still runs from its old first to its old last instruction
+  // holds all of its old instructions, and no old instruction of another
+  // block, as long as every other block does too.  Both ends are usually
+  // found at once; only blocks with code inserted at an end are searched.
+  for (Block *b : blocks) {
+    assem::Instr *head = heads_[b->id_];
+    assem::Instr *tail = tails_[b->id_];
+    if (std::none_of(b->nodes_.begin(), b->nodes_.end(),
+                     [head](fg::FNode *n) { return n->NodeInfo() == head; }) ||
+        std::none_of(b->nodes_.rbegin(), b->nodes_.rend(),
+                     [tail](fg::FNode *n) { return n->NodeInfo() == tail; }))
+      return false;
+  }
+  return true;
+}
+
+template <typename Problem>
+std::vector<Block *> Solver<Problem>::Update(const BlockGraph *graph,
+                                             const Problem *problem,
+                                             const std::vector<Block *> &dirty,
+                                             const util::BitSet &retract) {
+  static_assert(Problem::MEET == Meet::UNION,
+                "warm-started solving needs a may-problem");
+  bool same_blocks = SameBlocks(graph);
+  graph_ = graph;
+  problem_ = problem;
+  if (!same_blocks) {
+    // A block boundary moved, so the old sets belong to other blocks
+    Solve();
+    return graph_->Blocks();
+  }
+  int universe = problem_->Universe();
+  std::size_t block_count = in_.size();
+
+  // Carry the old solution over to the (possibly larger) universe
+  for (std::size_t i = 0; i < block_count; ++i) {
+    gen_[i].Grow(universe);
+    kill_[i].Grow(universe);
+    in_[i].Grow(universe);
+    out_[i].Grow(universe);
+    in_[i].DiffWith(retract);
+    out_[i].DiffWith(retract);
+  }
+
+  // Only the dirty blocks have new transfer functions; everything else can
+  // only change through them.
+  std::deque<Block *> worklist;
+  std::vector<bool> queued(block_count, false);
+  std::vector<bool> changed(block_count, false);
+  for (Block *b : dirty) {
+    if (changed[b->id_])
+      continue;
+    changed[b->id_] = true;
+    Summarise(b);
+    queued[b->id_] = true;
+    worklist.push_back(b);
+  }
+
+  Propagate(&worklist, &queued, &changed);
+  RememberBlocks();
+
+  std::vector<Block *> res;
+  for (Block *b : graph_->Blocks()) {
+    if (changed[b->id_])
+      res.push_back(b);
+  }
+  return res;
+}
+
+template <typename Problem>
+void Solver<Problem>::Propagate(std::deque<Block *> *worklist,
+                                std::vector<bool> *queued,
+                                std::vector<bool> *changed) {
+  util::BitSet joined(problem_->Universe());
+  while (!worklist->empty()) {
+    Block *b = worklist->front();
+    worklist->pop_front();
+    (*queued)[b->id_] = false;
+    ++iterations_;
+
+    // Meet over the neighbours facts flow in from
+    const std::vector<Block *> &sources = BACKWARD ? b->succs_ : b->preds_;
+    if (sources.empty()) {
+      joined.Clear();
+    } else {
+      joined = BACKWARD ? in_[sources.front()->id_] : out_[sources.front()->id_];
+      for (std::size_t i = 1; i < sources.size(); ++i) {
+        const util::BitSet &s =
+            BACKWARD ? in_[sources[i]->id_] : out_[sources[i]->id_];
+        if (Problem::MEET == Meet::UNION)
+          joined.UnionWith(s);
+        else
+          joined.IntersectWith(s);
+      }
+    }
+
+    util::BitSet &head = BACKWARD ? out_[b->id_] : in_[b->id_];
+    util::BitSet &tail = BACKWARD ? in_[b->id_] : out_[b->id_];
+    if (changed && head != joined)
+      (*changed)[b->id_] = true;
+    head = joined;
+    if (!tail.AssignTransfer(gen_[b->id_], head, kill_[b->id_]))
+      continue;
+
+    // Only the blocks that read this block's result need another look
+    for (Block *dep : BACKWARD ? b->preds_ : b->succs_) {
+      if (!(*queued)[dep->id_]) {
+        (*queued)[dep->id_] = true;
+        worklist->push_back(dep);
+      }
+    }
+  }
+}
+
+template <typename Problem>
+template <typename Fn>
+void Solver<Problem>::Expand(Block *b, Fn f) const {
+  util::BitSet facts = BACKWARD ? out_[b->id_] : in_[b->id_];
+  if (BACKWARD) {
+    for (auto it = b->nodes_.rbegin(); it != b->nodes_.rend(); ++it) {
+      f(*it, static_cast<const util::BitSet &>(facts));
+      Apply(*it, &facts);
+    }
+  } else {
+    for (fg::FNode *n : b->nodes_) {
+      f(n, static_cast<const util::BitSet &>(facts));
+      Apply(n, &facts);
+    }
+  }
+}
+
+} // namespace df
+
+#endif // TIGER_LIVENESS_DATAFLOW_H_
@@ -73,7 +73,7 @@ namespace assem {
  * @return Empty list (labels don't define temporaries)
  */
 temp::TempList *LabelInstr::Def() const {
-  return new temp::TempList();
+  return util::New<temp::TempList>();
 }
 
 /**
@@ -81,7 +81,7 @@ temp::TempList *LabelInstr::Def() const {
  * @return List of destination temporaries, or empty if none
  */
 temp::TempList *MoveInstr::Def() const {
-  return dst_ == nullptr ? new temp::TempList() : dst_;
+  return dst_ == nullptr ? util::New<temp::TempList>() : dst_;
 }
 
 /**
@@ -89,7 +89,7 @@ temp::TempList *MoveInstr::Def() const {
  * @return List of destination temporaries, or empty if none
  */
 temp::TempList *OperInstr::Def() const {
-  return dst_ == nullptr ? new temp::TempList() : dst_;
+  return dst_ == nullptr ? util::New<temp::TempList>() : dst_;
 }
 
 /**
@@ -97,7 +97,7 @@ temp::TempList *OperInstr::Def() const {
  * @return Empty list (labels don't use temporaries)
  */
 temp::TempList *LabelInstr::Use() const {
-  return new temp::TempList();
+  return util::New<temp::TempList>();
 }
 
 /**
@@ -105,7 +105,7 @@ temp::TempList *LabelInstr::Use() const {
  * @return List of source temporaries, or empty if none
  */
 temp::TempList *MoveInstr::Use() const {
-  return src_ == nullptr ? new temp::TempList() : src_;
+  return src_ == nullptr ? util::New<temp::TempList>() : src_;
 }
 
 /**
@@ -113,6 +113,6 @@ temp::TempList *MoveInstr::Use() const {
  * @return List of source temporaries, or empty if none
  */
 temp::TempList *OperInstr::Use() const {
-  return src_ == nullptr ? new temp::TempList() : src_;
+  return src_ == nullptr ? util::New<temp::TempList>() : src_;
 }
 } // namespace assem
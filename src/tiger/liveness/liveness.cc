@@ -5,6 +5,9 @@
  * Implements the iterative dataflow algorithm for liveness analysis:
  * - Live-in[n] = Use[n] ∪ (Live-out[n] - Def[n])
  * - Live-out[n] = ∪(Live-in[s] for all successors s of n)
+ *
+ * Live sets are packed bit sets over the dense temp indices given by the
+ * interference graph node keys, solved per basic block by df::Solver.
  * 
  * The interference graph is built by adding edges between temporaries that
  * are both live at the same point. Move instructions are tracked separately
@@ -14,9 +17,13 @@
 #include "tiger/liveness/liveness.h"
 
 //#include <iostream>
+#include <algorithm>
 #include <limits>
+#include <optional>
+#include <unordered_set>
 
-extern frame::RegManager *reg_manager;
+#include "tiger/frame/compilation.h"
+#include "tiger/util/pass_timer.h"
 
 namespace graph {
 
@@ -31,13 +38,37 @@ Node<temp::Temp> *IGraph::NewNode(temp::Temp *info) {
   n->preds_ = new NodeList<temp::Temp>();
   n->info_ = info;
 
-  degree_[n] = 0;
+  is_precolored_.push_back(precolored_->Contain(info));
+  adj_list_.emplace_back();
+  degree_.push_back(0);
+
+  // The new node appends one row to the triangular matrix; past the limit
+  // the matrix would grow quadratically, so switch to hashed edges.
+  if (dense_ && nodecount_ > DENSE_LIMIT)
+    MakeSparse();
+  if (dense_)
+    adj_bits_.Grow(static_cast<int>(RowStart(nodecount_)));
 
   return n;
 }
 
+void IGraph::MakeSparse() {
+  int row = 1;
+  adj_bits_.ForEach([this, &row](int bit) {
+    while (RowStart(row + 1) <= bit)
+      ++row;
+    adj_set_.insert(EdgeKey(row, static_cast<int>(bit - RowStart(row))));
+  });
+  adj_bits_ = util::BitSet();
+  dense_ = false;
+}
+
 bool IGraph::IAdj(Node<temp::Temp> *n, Node<temp::Temp> *m) {
-  return adj_set_.find(std::make_pair(n, m)) != adj_set_.end();
+  if (n == m)
+    return false;
+  if (dense_)
+    return adj_bits_.Test(static_cast<int>(BitIndex(n->Key(), m->Key())));
+  return adj_set_.count(EdgeKey(n->Key(), m->Key())) != 0;
 }
 
 void IGraph::AddEdge(Node<temp::Temp> *from, Node<temp::Temp> *to) {
@@ -48,54 +79,127 @@ void IGraph::AddEdge(Node<temp::Temp> *from, Node<temp::Temp> *to) {
 
   if (!IAdj(from, to) && from != to) {
     // Add to adjacent set
-    adj_set_.emplace(from, to);
-    adj_set_.emplace(to, from);
-
-    // The interference graph is conceptually undirected. We still reuse the
-    // generic Graph node representation, so `succs_`/`preds_` act as the two
-    // halves of the undirected adjacency relation. Precolored nodes keep their
-    // conceptual infinite degree and therefore are not added to the mutable
-    // degree-tracked side of these lists.
-    if (!precolored_->Contain(from->NodeInfo())) {
-      live::INodeList *single_to = new live::INodeList(to);
-      from->succs_ = from->succs_->Union(single_to);
+    if (dense_)
+      adj_bits_.Set(static_cast<int>(BitIndex(from->Key(), to->Key())));
+    else
+      adj_set_.insert(EdgeKey(from->Key(), to->Key()));
+
+    // The interference graph is undirected, so each endpoint records the
+    // other in its adjacency vector.  Precolored nodes keep their conceptual
+    // infinite degree and therefore get neither neighbours nor degree.
+    if (!is_precolored_[from->Key()]) {
+      adj_list_[from->Key()].push_back(to);
       from->AddOneIDegree();
     }
-    if (!precolored_->Contain(to->NodeInfo())) {
-      live::INodeList *single_from = new live::INodeList(from);
-      to->preds_ = to->preds_->Union(single_from);
+    if (!is_precolored_[to->Key()]) {
+      adj_list_[to->Key()].push_back(from);
       to->AddOneIDegree();
     }
+    if (logging_)
+      edge_log_.emplace_back(from, to);
   } 
 }
 
+void IGraph::EraseEdge(int i, int j) {
+  if (dense_)
+    adj_bits_.Reset(static_cast<int>(BitIndex(i, j)));
+  else
+    adj_set_.erase(EdgeKey(i, j));
+}
+
+void IGraph::Checkpoint() {
+  logging_ = true;
+  edge_log_.clear();
+}
+
+void IGraph::Rollback() {
+  // Adjacency vectors only ever grow at the back, so undoing the log in
+  // reverse finds each edge at the back of its endpoints' vectors.
+  for (auto it = edge_log_.rbegin(); it != edge_log_.rend(); ++it) {
+    Node<temp::Temp> *from = it->first;
+    Node<temp::Temp> *to = it->second;
+    EraseEdge(from->Key(), to->Key());
+    if (!is_precolored_[from->Key()]) {
+      assert(adj_list_[from->Key()].back() == to);
+      adj_list_[from->Key()].pop_back();
+    }
+    if (!is_precolored_[to->Key()]) {
+      assert(adj_list_[to->Key()].back() == from);
+      adj_list_[to->Key()].pop_back();
+    }
+  }
+  edge_log_.clear();
+  logging_ = false;
+
+  for (int key = 0; key < nodecount_; ++key) {
+    if (!is_precolored_[key])
+      degree_[key] = static_cast<int>(adj_list_[key].size());
+  }
+}
+
+void IGraph::Isolate(Node<temp::Temp> *n) {
+  assert(!is_precolored_[n->Key()]);
+  for (Node<temp::Temp> *m : adj_list_[n->Key()]) {
+    EraseEdge(n->Key(), m->Key());
+    if (is_precolored_[m->Key()])
+      continue;
+    Vector<Node<temp::Temp> *> &adj = adj_list_[m->Key()];
+    *std::find(adj.begin(), adj.end(), n) = adj.back();
+    adj.pop_back();
+    --degree_[m->Key()];
+  }
+  adj_list_[n->Key()].clear();
+  degree_[n->Key()] = 0;
+}
+
+int IGraph::TempCount() const {
+  return static_cast<int>(
+      std::count(is_precolored_.begin(), is_precolored_.end(), false));
+}
+
+long long IGraph::EdgeCount() const {
+  // An edge between two temps is in the adjacency vectors of both
+  long long ends = 0;
+  for (size_t key = 0; key < adj_list_.size(); ++key)
+    for (Node<temp::Temp> *m : adj_list_[key])
+      ends += is_precolored_[m->Key()] ? 2 : 1;
+  return ends / 2;
+}
+
+NodeList<temp::Temp> *IGraph::AdjList(Node<temp::Temp> *n) {
+  auto *res = util::New<NodeList<temp::Temp>>();
+  for (Node<temp::Temp> *m : adj_list_[n->Key()])
+    res->Append(m);
+  return res;
+}
+
 void IGraph::SetDegree(Node<temp::Temp> *n, int d) {
   assert(n->my_graph_ == this);
-  degree_.at(n) = d;
+  degree_[n->Key()] = d;
 }
 
 int IGraph::GetDegree(Node<temp::Temp> *n) {
   assert(n->my_graph_ == this);
-  return degree_.at(n);
+  return degree_[n->Key()];
 }
 
 void IGraph::ClearEdge() {
+  adj_bits_.Clear();
   adj_set_.clear();
   for (Node<temp::Temp> *n : my_nodes_->GetList()) {
-    degree_.at(n) = 0;
-    n->preds_->Clear();
-    n->succs_->Clear();
+    degree_[n->Key()] = 0;
+    adj_list_[n->Key()].clear();
   }
 }
 
 void IGraph::AddOneDegree(Node<temp::Temp> *n) {
   assert(n->my_graph_ == this);
-  degree_.at(n)++;
+  degree_[n->Key()]++;
 }
 
 void IGraph::MinusOneDegree(Node<temp::Temp> *n) {
   assert(n->my_graph_ == this);
-  degree_.at(n)--;
+  degree_[n->Key()]--;
 }
 
 } // namespace graph
@@ -117,7 +221,7 @@ namespace temp {
   }
 
   TempList *TempList::Union(const TempList *tl) const {
-    TempList *res = new TempList();
+    TempList *res = util::New<TempList>();
     res->CatList(this);
     for (auto temp : tl->GetList()) {
       if (!res->Contain(temp))
@@ -127,7 +231,7 @@ namespace temp {
   }
 
   TempList *TempList::Diff(const TempList *tl) const {
-    TempList *res = new TempList();
+    TempList *res = util::New<TempList>();
     for (auto temp : temp_list_) {
       if (!tl->Contain(temp))
         res->Append(temp);
@@ -141,8 +245,8 @@ namespace temp {
     return diff1->GetList().empty() && diff2->GetList().empty();
   }
 
-  std::list<Temp *>::const_iterator TempList::Replace(
-    std::list<Temp *>::const_iterator pos, Temp *temp) {
+  TempList::List::const_iterator TempList::Replace(
+    List::const_iterator pos, Temp *temp) {
     temp_list_.insert(pos, temp);
     pos = temp_list_.erase(pos);
     pos--;  // points to the replaced temp
@@ -153,15 +257,21 @@ namespace temp {
 namespace live {
 
 LiveGraphFactory::LiveGraphFactory() 
-  : live_graph_(new IGraph(reg_manager->Registers()), new MoveList()),
-    in_(std::make_unique<graph::Table<assem::Instr, temp::TempList>>()),
-    out_(std::make_unique<graph::Table<assem::Instr, temp::TempList>>()),
+  : live_graph_(new IGraph(reg_manager->Registers())),
     temp_node_map_(new tab::Table<temp::Temp, INode>()),
     node_instr_map_(std::make_shared<NodeInstrMap>()) {
   // Initialize interference graph with precolored registers (machine registers)
   // These are never spilled and have infinite degree
 }
 
+LiveGraphFactory::~LiveGraphFactory() {
+  for (auto &entry : *node_instr_map_)
+    delete entry.second;
+  delete temp_node_map_;
+  delete live_graph_.moves;
+  delete live_graph_.interf_graph;
+}
+
 bool MoveList::Contain(INodePtr src, INodePtr dst) {
   return std::any_of(move_list_.cbegin(), move_list_.cend(),
                      [src, dst](std::pair<INodePtr, INodePtr> move) {
@@ -209,116 +319,193 @@ MoveList *MoveList::Diff(MoveList *list) {
   return res;
 }
 
-void LiveGraphFactory::LiveMap(fg::FGraphPtr flowgraph) {
-  // Initialize live-in and live-out sets to empty for all nodes
-  for (fg::FNode *fnode : flowgraph->Nodes()->GetList()) {
-    in_.get()->Enter(fnode, new temp::TempList());
-    out_.get()->Enter(fnode, new temp::TempList());
-  }
+int MoveTable::Add(INodePtr src, INodePtr dst) {
+  uint64_t key = (uint64_t(src->Key()) << 32) | uint32_t(dst->Key());
+  auto it = ids_.find(key);
+  if (it != ids_.end())
+    return it->second;
+
+  int id = Count();
+  ids_.emplace(key, id);
+  moves_.emplace_back(src, dst);
+  node_moves_[src->Key()].push_back(id);
+  if (dst != src)
+    node_moves_[dst->Key()].push_back(id);
+  return id;
+}
 
-  // Iterative dataflow analysis: iterate until fixed point
-  int finished = 0;
-  int i = 0;
-
-  while (finished != flowgraph->nodecount_) {
-    finished = 0;
-
-    // Process nodes in reverse order (backward dataflow)
-    for (auto fnode_it = flowgraph->Nodes()->GetList().rbegin();
-         fnode_it != flowgraph->Nodes()->GetList().rend(); fnode_it++) {
-          // Live-out[n] = ∪(Live-in[s] for all successors s)
-          temp::TempList *out_n = new temp::TempList();
-          for (fg::FNode *succ_fnode : (*fnode_it)->Succ()->GetList())
-            out_n = out_n->Union(in_.get()->Look(succ_fnode));
-
-          // Live-in[n] = Use[n] ∪ (Live-out[n] - Def[n])
-          // A temp is live-in if it's used here, or live-out and not redefined here
-          temp::TempList *in_n = (*fnode_it)->NodeInfo()->Use();
-          in_n = in_n->Union(out_n->Diff((*fnode_it)->NodeInfo()->Def()));
-
-          // Check if we've reached fixed point for this node
-          if (out_n->IdentitalTo(out_.get()->Look(*fnode_it)) 
-              && in_n->IdentitalTo(in_.get()->Look(*fnode_it))) {
-            finished++;
-          } else {
-            // Update sets and continue iterating
-            out_.get()->Enter((*fnode_it), out_n);
-            in_.get()->Enter(*fnode_it, in_n);
-          }
-    } 
+void LiveGraphFactory::BuildProblem(fg::FGraphPtr flowgraph) {
+  problem_ = std::make_unique<LivenessProblem>(live_graph_.interf_graph->nodecount_,
+                                               flowgraph->nodecount_);
+  for (fg::FNode *fnode : flowgraph->Nodes()->GetList()) {
+    for (temp::Temp *t : fnode->NodeInfo()->Use()->GetList())
+      problem_->AddUse(fnode, TempIndex(t));
+    for (temp::Temp *t : fnode->NodeInfo()->Def()->GetList())
+      problem_->AddDef(fnode, TempIndex(t));
   }
 }
 
-void LiveGraphFactory::InterfGraph(fg::FGraphPtr flowgraph, MoveList **worklist_moves) {
-  // Build interference graph by processing instructions in forward order
-  for (fg::FNode *fnode : flowgraph->Nodes()->GetList()) {
-    assem::Instr *instr = fnode->NodeInfo();
-    temp::TempList *live = out_.get()->Look(fnode);  // Start with live-out set
+void LiveGraphFactory::LiveMap(fg::FGraphPtr flowgraph) {
+  int temp_count = live_graph_.interf_graph->nodecount_;
 
-    // Special handling for move instructions (for coalescing)
-    if (typeid(*instr) == typeid(assem::MoveInstr)) {  // move instruction
-      assert(instr->Def()->GetList().size() == 1);
-      assert(instr->Use()->GetList().size() == 1);
+  // Every temp already has an interference graph node (BuildIGraph runs
+  // first), whose key doubles as the temp's dense index in the bit sets.
+  index_node_.assign(temp_count, nullptr);
+  for (INode *n : live_graph_.interf_graph->Nodes()->GetList())
+    index_node_[n->Key()] = n;
 
-      // Appel's move rule removes the move source from the live set before
-      // adding interference edges. That preserves the opportunity to color the
-      // move source and destination with the same physical register later.
-      live = live->Diff(instr->Use());
+  // Convert use[n]/def[n] to index lists once so the solver never allocates
+  BuildProblem(flowgraph);
 
-      temp::Temp *def_reg = instr->Def()->GetList().front();
-      temp::Temp *use_reg = instr->Use()->GetList().front();
-      INode *def_n = temp_node_map_->Look(def_reg);
-      INode *use_n = temp_node_map_->Look(use_reg);
-      MoveList *single_move = new MoveList(Move(use_n, def_n));
-
-      // Track this move for both source and destination nodes
-      temp::TempList *defs_and_uses = instr->Def()->Union(instr->Use());
-      for (temp::Temp *reg : defs_and_uses->GetList()) {
-        INode *n = temp_node_map_->Look(reg);
-        MoveList *new_moves = live_graph_.move_list->Look(n)->Union(single_move);;
-        live_graph_.move_list->Set(n, new_moves);
-      }
+  // Solve live-in/live-out at basic-block granularity
+  blocks_ = std::make_unique<df::BlockGraph>(flowgraph);
+  live_ = std::make_unique<df::Solver<LivenessProblem>>(blocks_.get(), problem_.get());
+  live_->Solve();
+}
 
-      // Add to worklist for coalescing
-      *worklist_moves = (*worklist_moves)->Union(single_move);
-    }
+void LiveGraphFactory::CollectMoves() {
+  live_graph_.moves->Reset(live_graph_.interf_graph->nodecount_);
 
-    // Add defined temporaries before creating edges so each definition
-    // interferes with every value live after the instruction. Self-edges are
-    // harmlessly ignored by AddEdge().
-    live = live->Union(instr->Def());
+  // Each block is walked backwards, the order InterfGraph() used to meet
+  // the moves in, so move ids stay stable.
+  for (df::Block *block : blocks_->Blocks()) {
+    for (auto it = block->nodes_.rbegin(); it != block->nodes_.rend(); ++it) {
+      assem::Instr *instr = (*it)->NodeInfo();
+      if (typeid(*instr) != typeid(assem::MoveInstr))
+        continue;
+      assert(instr->Def()->GetList().size() == 1);
+      assert(instr->Use()->GetList().size() == 1);
+      // Record the move for coalescing (and for both of its endpoints)
+      live_graph_.moves->Add(temp_node_map_->Look(instr->Use()->GetList().front()),
+                             temp_node_map_->Look(instr->Def()->GetList().front()));
+    }
+  }
+}
 
-    // Add interference edges: all defined temps interfere with all live temps
-    // (they can't share registers because they're both live at this point)
+void LiveGraphFactory::AddInterference(df::Block *block) {
+  // Expand() walks the block backwards from its live-out set and hands over
+  // the live-out set of every instruction in turn.
+  live_->Expand(block, [this](fg::FNode *fnode, const util::BitSet &live) {
+    assem::Instr *instr = fnode->NodeInfo();
+    INode *skip_n = nullptr;
+
+    // Appel's move rule removes the move source from the live set before
+    // adding interference edges. That preserves the opportunity to color
+    // the move source and destination with the same physical register.
+    if (typeid(*instr) == typeid(assem::MoveInstr))
+      skip_n = temp_node_map_->Look(instr->Use()->GetList().front());
+
+    // Add interference edges: every defined temp interferes with every
+    // temp live after the instruction and with the other temps defined by
+    // it (they can't share registers because they're all live at this
+    // point).  Self-edges are harmlessly ignored by AddEdge().
     temp::TempList *defs = instr->Def();
     for (temp::Temp *def_reg : defs->GetList()) {
       INode *def_n = temp_node_map_->Look(def_reg);
-      for (temp::Temp *live_reg : live->GetList()) {
-        INode *live_n = temp_node_map_->Look(live_reg);
-        live_graph_.interf_graph->AddEdge(live_n, def_n);
-      }
+      live.ForEach([this, def_n, skip_n](int live_idx) {
+        INode *live_n = index_node_[live_idx];
+        if (live_n != skip_n)
+          live_graph_.interf_graph->AddEdge(live_n, def_n);
+      });
+      for (temp::Temp *other_reg : defs->GetList())
+        live_graph_.interf_graph->AddEdge(temp_node_map_->Look(other_reg), def_n);
     }
+  });
+}
 
-    // Update live set: add uses, remove defs (defs kill previous values)
-    live = instr->Use()->Union(live->Diff(instr->Def())); 
-  }
+void LiveGraphFactory::InterfGraph(fg::FGraphPtr flowgraph) {
+  CollectMoves();
+
+  // Build interference graph block by block
+  for (df::Block *block : blocks_->Blocks())
+    AddInterference(block);
 }
 
-void LiveGraphFactory::Liveness(fg::FGraphPtr flowgraph, MoveList **worklist_moves) {
+void LiveGraphFactory::Liveness(fg::FGraphPtr flowgraph) {
   // Step 1: Compute liveness information (live-in and live-out sets)
-  LiveMap(flowgraph);
+  {
+    util::PassTimer::Scope pass("liveness");
+    LiveMap(flowgraph);
+  }
   // Step 2: Build interference graph from liveness information
-  InterfGraph(flowgraph, worklist_moves);
+  util::PassTimer::Scope pass("interference");
+  InterfGraph(flowgraph);
+  // Edges the register allocator adds from here on can be undone by Update()
+  live_graph_.interf_graph->Checkpoint();
+}
+
+void LiveGraphFactory::Update(fg::FGraphPtr flowgraph,
+                              const std::vector<INode *> &spilled,
+                              const std::vector<InstrPos> &rewritten) {
+  IGraph *graph = live_graph_.interf_graph;
+  std::optional<util::PassTimer::Scope> pass;
+  pass.emplace("liveness");
+
+  // Step 1: Return to the edges liveness found and drop the spilled temps.
+  // Their nodes stay in the graph, isolated and unused.
+  graph->Rollback();
+  int old_count = graph->nodecount_;
+  util::BitSet retract(old_count);
+  for (INode *n : spilled) {
+    graph->Isolate(n);
+    node_instr_map_->at(n)->clear();
+    retract.Set(n->Key());
+  }
+
+  // Step 2: Add nodes for the new temps and record their instruction sites.
+  // Rewriting adds no uses or defs of existing temps except the frame base
+  // register, which is precolored and never spilled.
+  std::unordered_set<assem::Instr *> changed;
+  for (InstrPos pos : rewritten) {
+    changed.insert(*pos);
+    for (temp::TempList *temps : {(*pos)->Def(), (*pos)->Use()}) {
+      for (temp::Temp *t : temps->GetList()) {
+        INode *n = temp_node_map_->Look(t);
+        if (n == nullptr) {
+          n = graph->NewNode(t);
+          temp_node_map_->Enter(t, n);
+          node_instr_map_->insert(std::make_pair(n, new std::vector<InstrPos>()));
+          index_node_.push_back(n);
+        }
+        std::vector<InstrPos> *sites = node_instr_map_->at(n);
+        if (n->Key() >= old_count && (sites->empty() || sites->back() != pos))
+          sites->push_back(pos);
+      }
+    }
+  }
+  retract.Grow(graph->nodecount_);
+
+  // Step 3: Re-solve liveness from the old block live sets.  Rewriting only
+  // adds instructions inside blocks, so the blocks keep their ids; should
+  // that ever not hold, the solver starts over and every block is stale.
+  BuildProblem(flowgraph);
+  blocks_ = std::make_unique<df::BlockGraph>(flowgraph);
+  std::vector<df::Block *> dirty;
+  for (fg::FNode *fnode : flowgraph->Nodes()->GetList()) {
+    if (changed.count(fnode->NodeInfo()))
+      dirty.push_back(blocks_->BlockOf(fnode));
+  }
+  std::vector<df::Block *> stale =
+      live_->Update(blocks_.get(), problem_.get(), dirty, retract);
+
+  // Step 4: Moves and the edges of every block whose live sets changed
+  pass.reset();
+  pass.emplace("interference");
+  CollectMoves();
+  for (df::Block *block : stale)
+    AddInterference(block);
+  graph->Checkpoint();
 }
 
 void LiveGraphFactory::BuildIGraph(assem::InstrList *instr_list) {
+  util::PassTimer::Scope pass("interference");
+
   // Step 1: Add precolored registers (machine registers) as nodes
   // Precolored registers are never spilled and have infinite degree
   for (temp::Temp *reg : reg_manager->Registers()->GetList()) {
     if (temp_node_map_->Look(reg) == nullptr) {
       INode *n = live_graph_.interf_graph->NewNode(reg);
       live_graph_.interf_graph->SetDegree(n, std::numeric_limits<int>::max());
-      live_graph_.move_list->Enter(n, new MoveList());
       temp_node_map_->Enter(reg, n);
       node_instr_map_.get()->insert(std::make_pair(n, new std::vector<InstrPos>()));
     }
@@ -335,7 +522,6 @@ void LiveGraphFactory::BuildIGraph(assem::InstrList *instr_list) {
       if ((n = temp_node_map_->Look(reg)) == nullptr) {
         // New temporary: create node
         n = live_graph_.interf_graph->NewNode(reg);
-        live_graph_.move_list->Enter(n, new MoveList());
         temp_node_map_->Enter(reg, n); 
         node_instr_map_.get()->insert(std::make_pair(n, new std::vector<InstrPos>{instr_it}));
       } else {
@@ -15,7 +15,14 @@
  *   live-out[n] = ∪ { live-in[s] | s ∈ succ[n] }
  *
  * The analysis iterates until a fixed point is reached (no set changes).
- * Processing nodes in reverse order (backward) accelerates convergence.
+ * It runs on basic blocks through the worklist framework in dataflow.h:
+ * each block is summarised by one (use, def) pair and is only re-evaluated
+ * when the live-in set of a successor grew.
+ *
+ * Every temporary of the function is identified by the dense key of its
+ * interference-graph node (INode::Key()), so the sets are stored as packed
+ * util::BitSet objects rather than temp::TempLists.  Union, difference and
+ * the fixed-point comparison then cost one word operation per 64 temps.
  *
  * ─────────────────────────────────────────────────────────────────────────
  * Interference graph (IGraph)
@@ -35,11 +42,28 @@
  * degree so they are never simplified or spilled.
  *
  * ─────────────────────────────────────────────────────────────────────────
+ * Updating after spills
+ * ─────────────────────────────────────────────────────────────────────────
+ * Spill rewriting renames every use and def of a spilled temp to a fresh
+ * temp and inserts a load or store next to it.  It adds no control flow
+ * and leaves every other temp's uses and defs alone, so Update() keeps the
+ * graph and the block live sets and only:
+ *   - undoes the edges the allocator added while coalescing,
+ *   - removes the spilled nodes' edges and drops them from the live sets,
+ *   - adds nodes for the new temps,
+ *   - re-solves liveness starting from the blocks containing spill code,
+ *   - re-adds edges in the blocks whose live sets or code changed.
+ * Only the move table is rebuilt in full, which is a linear scan.  The
+ * solver checks that the rebuilt blocks are the old ones; if they are not,
+ * liveness is solved again in full and edges are re-added everywhere.
+ *
+ * ─────────────────────────────────────────────────────────────────────────
  * Move list
  * ─────────────────────────────────────────────────────────────────────────
- * Move instructions are tracked separately in a MoveList.  Each move
+ * Move instructions are tracked separately in a MoveTable.  Each move
  * (src → dst) is a candidate for coalescing: if src and dst do not
- * interfere, they may be merged into a single node.
+ * interfere, they may be merged into a single node.  Moves are numbered so
+ * that the register allocator can keep their state in flat arrays.
  *
  * ─────────────────────────────────────────────────────────────────────────
  * Key types
@@ -51,7 +75,8 @@
  *   IGraph     – alias for graph::IGraph (the interference graph class)
  *   IGraphPtr  – pointer to IGraph
  *   MoveList   – a list of (src, dst) move pairs
- *   LiveGraph  – bundles IGraph + per-node MoveList
+ *   MoveTable  – all moves of a function by id, plus per-node move ids
+ *   LiveGraph  – bundles IGraph + MoveTable
  *   LiveGraphFactory – builds the live graph from a flow graph
  *
  * Note: graph::IGraph is defined in util/graph.h and extends
@@ -68,7 +93,9 @@
 #include "tiger/codegen/assem.h"
 #include "tiger/frame/frame.h"
 #include "tiger/frame/temp.h"
+#include "tiger/liveness/dataflow.h"
 #include "tiger/liveness/flowgraph.h"
+#include "tiger/util/bitset.h"
 #include "tiger/util/graph.h"
 
 namespace live {
@@ -114,7 +141,7 @@ using NodeInstrMap = std::unordered_map<INode *, std::vector<InstrPos> *>;
  * Supports set operations (Union, Intersect, Diff) used by the coloring
  * algorithm to manage the move worklists.
  */
-class MoveList {
+class MoveList : public util::AllocTracked<MoveList> {
 public:
   MoveList() = default;
   explicit MoveList(Move m) : move_list_({m}) {}
@@ -150,23 +177,99 @@ private:
   std::list<Move> move_list_;  ///< List of move pairs (src, dst)
 };
 
+/**
+ * @brief Liveness as a backward may-problem for the dataflow framework
+ *
+ * gen[n] = use[n] and kill[n] = def[n], both expressed as dense temp
+ * indices (the keys of the interference-graph nodes).  The index lists are
+ * computed once per flow-graph node so the solver never touches TempLists.
+ */
+class LivenessProblem {
+public:
+  static constexpr df::Direction DIRECTION = df::Direction::BACKWARD;
+  static constexpr df::Meet MEET = df::Meet::UNION;
+
+  LivenessProblem(int temp_count, int node_count)
+      : temp_count_(temp_count), use_(node_count), def_(node_count) {}
+
+  /** @brief Record that flow-graph node @p n uses temp index @p i */
+  void AddUse(fg::FNode *n, int i) { use_[n->Key()].push_back(i); }
+  /** @brief Record that flow-graph node @p n defines temp index @p i */
+  void AddDef(fg::FNode *n, int i) { def_[n->Key()].push_back(i); }
+
+  [[nodiscard]] int Universe() const { return temp_count_; }
+
+  template <typename Fn> void ForEachGen(fg::FNode *n, Fn f) const {
+    for (int i : use_[n->Key()])
+      f(i);
+  }
+  template <typename Fn> void ForEachKill(fg::FNode *n, Fn f) const {
+    for (int i : def_[n->Key()])
+      f(i);
+  }
+
+private:
+  int temp_count_;                     ///< Number of temps in the function
+  std::vector<std::vector<int>> use_;  ///< FNode key → used temp indices
+  std::vector<std::vector<int>> def_;  ///< FNode key → defined temp indices
+};
+
+/**
+ * @brief The move instructions of a function, numbered 0..Count()-1
+ *
+ * Each distinct (src, dst) pair of interference-graph nodes gets one id, in
+ * the order the moves are first seen.  NodeMoves(n) lists the ids of the
+ * moves node n takes part in; the register allocator extends these lists
+ * when it coalesces nodes.
+ */
+class MoveTable {
+public:
+  /// Move ids; the arrays are charged to MoveTable in an allocation profile
+  using Ids = std::vector<int, util::TrackedAllocator<int, MoveTable>>;
+
+  /** @brief Prepare per-node move lists for @p node_count nodes */
+  void Reset(int node_count) {
+    moves_.clear();
+    ids_.clear();
+    node_moves_.assign(node_count, {});
+  }
+
+  /**
+   * @brief Record move @p src → @p dst
+   * @return The id of the move (an existing id if the pair was seen before)
+   */
+  int Add(INodePtr src, INodePtr dst);
+
+  /** @brief Number of distinct moves */
+  [[nodiscard]] int Count() const { return static_cast<int>(moves_.size()); }
+
+  /** @brief The move with id @p id */
+  [[nodiscard]] const Move &Get(int id) const { return moves_[id]; }
+
+  /** @brief Ids of the moves node @p n takes part in */
+  Ids &NodeMoves(INodePtr n) { return node_moves_[n->Key()]; }
+
+private:
+  std::vector<Move> moves_;                    ///< Id → (src, dst)
+  std::vector<Ids> node_moves_;                ///< INode key → move ids
+  std::unordered_map<uint64_t, int> ids_;      ///< (src, dst) keys → id
+};
+
 /**
  * @brief The live graph: interference graph + move information
  *
  * Bundles together:
  *   - interf_graph: the interference graph (one node per temp)
- *   - move_list:    per-node move list (moves involving each node)
+ *   - moves:        every move, with the moves involving each node
  *
- * The global worklist_moves (passed separately to Liveness()) contains all
- * moves that are candidates for coalescing.
+ * Every move in the table is a candidate for coalescing.
  */
 struct LiveGraph {
-  IGraphPtr interf_graph;                  ///< The interference graph
-  tab::Table<INode, MoveList> *move_list;  ///< Per-node move list (for coalescing)
+  IGraphPtr interf_graph;  ///< The interference graph
+  MoveTable *moves;        ///< Moves of the function (for coalescing)
 
-  LiveGraph(IGraphPtr interf_graph, MoveList *moves)
-      : interf_graph(interf_graph),
-        move_list(new tab::Table<INode, MoveList>()) {}
+  explicit LiveGraph(IGraphPtr interf_graph)
+      : interf_graph(interf_graph), moves(new MoveTable()) {}
 };
 
 /**
@@ -182,8 +285,7 @@ struct LiveGraph {
  * @code
  *   live::LiveGraphFactory factory;
  *   factory.BuildIGraph(instr_list);
- *   live::MoveList *worklist_moves = new live::MoveList();
- *   factory.Liveness(flowgraph, &worklist_moves);
+ *   factory.Liveness(flowgraph);
  *   live::LiveGraph live_graph = factory.GetLiveGraph();
  * @endcode
  */
@@ -196,6 +298,9 @@ public:
    */
   LiveGraphFactory();
 
+  /** @brief Free the live graph, the temp mapping and the instruction sites */
+  ~LiveGraphFactory();
+
   /**
    * @brief Step 1: Add all temps as nodes in the interference graph
    *
@@ -211,12 +316,27 @@ public:
    * @brief Steps 2+3: Compute liveness and build interference edges
    *
    * Calls LiveMap() to compute live-in/live-out sets, then InterfGraph()
-   * to add interference edges.
+   * to add interference edges and fill the move table.
    *
    * @param flowgraph      The control flow graph for the function
-   * @param worklist_moves Output: moves that are candidates for coalescing
    */
-  void Liveness(fg::FGraphPtr flowgraph, MoveList **worklist_moves);
+  void Liveness(fg::FGraphPtr flowgraph);
+
+  /**
+   * @brief Bring liveness and the live graph up to date after spilling
+   *
+   * The instruction list must be the one given to BuildIGraph() with spill
+   * code added: every use and def of a node in @p spilled replaced by a new
+   * temp, and loads and stores of those new temps inserted.  Neither may
+   * add control flow.
+   *
+   * @param flowgraph The control flow graph of the rewritten instructions
+   * @param spilled   The nodes whose temps were spilled
+   * @param rewritten Every inserted or rewritten instruction, in program
+   *                  order per spilled node
+   */
+  void Update(fg::FGraphPtr flowgraph, const std::vector<INode *> &spilled,
+              const std::vector<InstrPos> &rewritten);
 
   /** @brief Get the constructed live graph */
   LiveGraph GetLiveGraph() { return live_graph_; }
@@ -227,36 +347,58 @@ public:
   /** @brief Get the node-to-instruction mapping */
   std::shared_ptr<NodeInstrMap> GetNodeInstrMap() { return node_instr_map_; }
 
+  /** @brief Get the basic blocks of the flow graph (valid after Liveness()) */
+  df::BlockGraph *GetBlockGraph() { return blocks_.get(); }
+
+  /** @brief Blocks evaluated by the liveness solver, Update() included */
+  [[nodiscard]] int Iterations() const { return live_ ? live_->Iterations() : 0; }
+
 private:
   LiveGraph live_graph_;                              ///< The live graph being built
-  std::unique_ptr<graph::Table<assem::Instr, temp::TempList>> in_;  ///< Live-in sets
-  std::unique_ptr<graph::Table<assem::Instr, temp::TempList>> out_; ///< Live-out sets
+  std::unique_ptr<LivenessProblem> problem_;          ///< Per-instruction use/def
+  std::unique_ptr<df::BlockGraph> blocks_;            ///< Basic blocks of the flow graph
+  std::unique_ptr<df::Solver<LivenessProblem>> live_; ///< Block live-in/live-out sets
   tab::Table<temp::Temp, INode> *temp_node_map_;      ///< Temp → INode mapping
   std::shared_ptr<NodeInstrMap> node_instr_map_;      ///< INode → instructions mapping
+  std::vector<INode *> index_node_;                   ///< Dense temp index → INode
+
+  /** @brief Dense liveness index of temp @p t (its INode key) */
+  int TempIndex(temp::Temp *t) { return temp_node_map_->Look(t)->Key(); }
 
   /**
    * @brief Step 2: Compute live-in and live-out sets (iterative dataflow)
    *
-   * Iterates the dataflow equations until a fixed point:
+   * Solves the dataflow equations
    *   live-in[n]  = use[n] ∪ (live-out[n] − def[n])
    *   live-out[n] = ∪ { live-in[s] | s ∈ succ[n] }
+   * at basic-block granularity with the df::Solver worklist.  Only block
+   * boundary sets are kept; InterfGraph() expands them per instruction.
    *
    * @param flowgraph The control flow graph
    */
   void LiveMap(fg::FGraphPtr flowgraph);
 
+  /** @brief Convert use[n]/def[n] of every flow-graph node to index lists */
+  void BuildProblem(fg::FGraphPtr flowgraph);
+
   /**
    * @brief Step 3: Add interference edges based on liveness information
    *
    * For each instruction that defines temp d, adds an interference edge
    * between d and every temp in live-out[n].
    * Move instructions are handled specially: source and destination do not
-   * interfere (they are move-related instead).
+   * interfere (they are move-related instead) and the move is recorded in
+   * the move table.
    *
    * @param flowgraph      The control flow graph
-   * @param worklist_moves Output: moves that are candidates for coalescing
    */
-  void InterfGraph(fg::FGraphPtr flowgraph, MoveList **worklist_moves);
+  void InterfGraph(fg::FGraphPtr flowgraph);
+
+  /** @brief Refill the move table from every move instruction */
+  void CollectMoves();
+
+  /** @brief Add the interference edges of the instructions of block @p b */
+  void AddInterference(df::Block *b);
 };
 
 } // namespace live
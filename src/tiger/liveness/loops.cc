@@ -0,0 +1,114 @@
+/**
+ * @file loops.cc
+ * @brief Dominator computation and natural-loop detection on basic blocks
+ */
+
+#include "tiger/liveness/loops.h"
+
+namespace df {
+
+DomTree::DomTree(const BlockGraph *graph)
+    : idom_(graph->Blocks().size(), nullptr) {
+  const std::vector<Block *> &rpo = graph->ReversePostOrder();
+  if (rpo.empty())
+    return;
+
+  // The entry block is the first block in program order, which is also the
+  // root of the first depth-first tree and hence rpo.front().
+  Block *entry = rpo.front();
+  idom_[entry->id_] = entry;
+
+  // Walk two fingers up the partially built tree until they meet, always
+  // advancing the one further from the entry (larger RPO number).
+  auto intersect = [this](Block *a, Block *b) {
+    while (a != b) {
+      while (a->rpo_ > b->rpo_)
+        a = idom_[a->id_];
+      while (b->rpo_ > a->rpo_)
+        b = idom_[b->id_];
+    }
+    return a;
+  };
+
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (Block *b : rpo) {
+      if (b == entry)
+        continue;
+      Block *new_idom = nullptr;
+      for (Block *p : b->preds_) {
+        if (idom_[p->id_] == nullptr)
+          continue;  // not processed yet, or unreachable
+        new_idom = new_idom ? intersect(p, new_idom) : p;
+      }
+      if (new_idom != idom_[b->id_]) {
+        idom_[b->id_] = new_idom;
+        changed = true;
+      }
+    }
+  }
+}
+
+bool DomTree::Dominates(Block *a, Block *b) const {
+  if (!Reachable(a) || !Reachable(b))
+    return false;
+  // Climb from b towards the entry; the entry is its own idom
+  while (true) {
+    if (a == b)
+      return true;
+    Block *up = idom_[b->id_];
+    if (up == b)
+      return false;
+    b = up;
+  }
+}
+
+LoopNest::LoopNest(const BlockGraph *graph, const DomTree *dom)
+    : graph_(graph), depth_(graph->Blocks().size(), 0) {
+  const std::vector<Block *> &blocks = graph->Blocks();
+  std::vector<int> loop_of_header(blocks.size(), -1);
+  std::vector<int> in_loop(blocks.size(), -1);  // last loop index marked
+  std::vector<Block *> stack;
+
+  for (Block *h : graph->ReversePostOrder()) {
+    for (Block *b : h->preds_) {
+      if (!dom->Dominates(h, b))
+        continue;  // not a back edge b → h
+
+      // Start (or extend) the loop headed by h
+      int index = loop_of_header[h->id_];
+      if (index < 0) {
+        index = static_cast<int>(loops_.size());
+        loop_of_header[h->id_] = index;
+        loops_.push_back({h, {h}});
+        in_loop[h->id_] = index;
+      }
+      Loop &loop = loops_[index];
+
+      // Everything that reaches b without passing through h is in the body
+      if (in_loop[b->id_] != index) {
+        in_loop[b->id_] = index;
+        loop.body_.push_back(b);
+        stack.push_back(b);
+      }
+      while (!stack.empty()) {
+        Block *x = stack.back();
+        stack.pop_back();
+        for (Block *p : x->preds_) {
+          if (in_loop[p->id_] != index && dom->Reachable(p)) {
+            in_loop[p->id_] = index;
+            loop.body_.push_back(p);
+            stack.push_back(p);
+          }
+        }
+      }
+    }
+  }
+
+  for (const Loop &loop : loops_)
+    for (Block *b : loop.body_)
+      ++depth_[b->id_];
+}
+
+} // namespace df
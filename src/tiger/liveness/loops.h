@@ -0,0 +1,91 @@
+/**
+ * @file loops.h
+ * @brief Dominator tree and natural-loop nesting of a flow graph
+ *
+ * Both analyses work on the basic blocks of df::BlockGraph, which is built
+ * from the instruction-level fg::FGraph.
+ *
+ * ─────────────────────────────────────────────────────────────────────────
+ * Dominators
+ * ─────────────────────────────────────────────────────────────────────────
+ * Block d dominates block b if every path from the entry to b passes
+ * through d.  DomTree computes the immediate dominator of every block with
+ * the iterative algorithm of Cooper, Harvey and Kennedy ("A Simple, Fast
+ * Dominance Algorithm"), visiting blocks in reverse post-order until no
+ * idom changes.  Blocks unreachable from the entry have no dominator.
+ *
+ * ─────────────────────────────────────────────────────────────────────────
+ * Natural loops
+ * ─────────────────────────────────────────────────────────────────────────
+ * An edge b → h is a back edge if h dominates b.  Its natural loop is h
+ * plus every block that reaches b without passing through h.  Loops with
+ * the same header are merged into one.  The loop depth of a block is the
+ * number of loops that contain it; the register allocator weighs spill
+ * costs by it (see ra::RegAllocator::ComputeSpillCosts()).
+ */
+
+#ifndef TIGER_LIVENESS_LOOPS_H_
+#define TIGER_LIVENESS_LOOPS_H_
+
+#include <vector>
+
+#include "tiger/liveness/dataflow.h"
+
+namespace df {
+
+/**
+ * @brief Immediate dominators of the blocks of a BlockGraph
+ */
+class DomTree {
+public:
+  explicit DomTree(const BlockGraph *graph);
+
+  /** @brief Immediate dominator of @p b; the entry is its own, unreachable
+   * blocks have none (nullptr) */
+  [[nodiscard]] Block *IDom(Block *b) const { return idom_[b->id_]; }
+
+  /** @brief Test whether @p b is reachable from the entry block */
+  [[nodiscard]] bool Reachable(Block *b) const {
+    return idom_[b->id_] != nullptr;
+  }
+
+  /** @brief Test whether @p a dominates @p b (every block dominates itself) */
+  [[nodiscard]] bool Dominates(Block *a, Block *b) const;
+
+private:
+  std::vector<Block *> idom_;  ///< Block id → immediate dominator
+};
+
+/** @brief A natural loop: its header and every block in its body */
+struct Loop {
+  Block *header_;               ///< The single entry of the loop
+  std::vector<Block *> body_;   ///< All blocks of the loop, header included
+};
+
+/**
+ * @brief The natural loops of a BlockGraph and the loop depth of each block
+ */
+class LoopNest {
+public:
+  LoopNest(const BlockGraph *graph, const DomTree *dom);
+
+  /** @brief All natural loops, one per header */
+  [[nodiscard]] const std::vector<Loop> &Loops() const { return loops_; }
+
+  /** @brief Number of loops containing block @p b (0 outside any loop) */
+  [[nodiscard]] int Depth(Block *b) const { return depth_[b->id_]; }
+
+  /** @brief Loop depth of the block containing flow-graph node @p n */
+  [[nodiscard]] int Depth(fg::FNode *n) const {
+    return Depth(graph_->BlockOf(n));
+  }
+
+private:
+  const BlockGraph *graph_;
+  std::vector<Loop> loops_;   ///< Natural loops, in order of their headers
+  std::vector<int> depth_;    ///< Block id → loop depth
+};
+
+} // namespace df
+
+#endif // TIGER_LIVENESS_LOOPS_H_
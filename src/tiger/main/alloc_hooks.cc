@@ -0,0 +1,65 @@
+/**
+ * @file alloc_hooks.cc
+ * @brief Replacement global operator new and delete for util::AllocProfile
+ *
+ * Linked into the executables that offer --alloc-profile, never into
+ * libtiger, whose embedders keep their own allocator.  The operators
+ * allocate with malloc() as the standard ones do, and record to the
+ * profile once it is enabled.  The aligned forms are left to the standard
+ * library; nothing in the compiler is over-aligned.
+ */
+
+#include <cstdlib>
+#include <new>
+
+#include "tiger/util/alloc_profile.h"
+
+namespace {
+
+/** @brief malloc() @p size bytes, calling the new handler until it works */
+void *Allocate(std::size_t size) {
+  if (size == 0)
+    size = 1;
+  void *p;
+  while ((p = std::malloc(size)) == nullptr) {
+    std::new_handler handler = std::get_new_handler();
+    if (!handler)
+      throw std::bad_alloc();
+    handler();
+  }
+  if (util::AllocProfile::Enabled())
+    util::AllocProfile::RecordNew(p, size);
+  return p;
+}
+
+void *AllocateNoThrow(std::size_t size) noexcept {
+  try {
+    return Allocate(size);
+  } catch (const std::bad_alloc &) {
+    return nullptr;
+  }
+}
+
+void Free(void *p) noexcept {
+  if (p && util::AllocProfile::Enabled())
+    util::AllocProfile::RecordDelete(p);
+  std::free(p);
+}
+
+} // namespace
+
+void *operator new(std::size_t size) { return Allocate(size); }
+void *operator new[](std::size_t size) { return Allocate(size); }
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+  return AllocateNoThrow(size);
+}
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+  return AllocateNoThrow(size);
+}
+
+void operator delete(void *p) noexcept { Free(p); }
+void operator delete[](void *p) noexcept { Free(p); }
+void operator delete(void *p, std::size_t) noexcept { Free(p); }
+void operator delete[](void *p, std::size_t) noexcept { Free(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { Free(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { Free(p); }
@@ -0,0 +1,490 @@
+/**
+ * @file bench_compile.cc
+ * @brief How compile time and memory scale with the shape of the program
+ *
+ * Compiles programs made by bench::GenerateProgram() and reports, for each,
+ * the wall time and peak resident size of every phase (parse, semant,
+ * escape, translate, back end) and the time of every pass of the back end
+ * (from util::PassTimer).  The phases run one after the other over the
+ * whole program, unlike in tiger-compiler, where translation and the back
+ * end are interleaved, so that each has its own time and memory.
+ *
+ * Usage:
+ *   bench_compile [--seed N] [--repeat N] [--steps N] [--threshold X]
+ *                 [--scale <knob>]... [--<knob> N]... [--dump <dir>] [--check]
+ *                 [--alloc-profile] [--no-annotate]
+ *
+ *   The knobs are those of bench::GenOptions: functions, depth, loops,
+ *   temps, records, arrays and strings; --<knob> N sets the base value of
+ *   one.  For every knob given with --scale (all of them by default), the
+ *   program is compiled at the base value and --steps - 1 doublings of it,
+ *   each --repeat times, keeping the fastest run.
+ *
+ *   Between consecutive steps, the growth of liveness (the liveness and
+ *   interference passes) is compared with that of the instructions it
+ *   analyses, and the growth of RegAllocator (coloring and spill rewrite)
+ *   with that of the instructions plus interference edges it colors (from
+ *   util::Stats).  A pass whose time grows as a power above --threshold
+ *   (1.3 by default) of its input is flagged as super-linear; with
+ *   --check, any flag makes the exit status 1.  --dump writes the programs
+ *   to <dir>, which it creates if need be; failing that, it exits 1.  --alloc-profile prints the allocations of each phase and
+ *   type over all the compilations at exit (see util/alloc_profile.h).
+ *   Translation uses the annotations of semantic analysis, which finds the
+ *   escapes as well, as in tiger-compiler; --no-annotate runs escape
+ *   analysis and has translation look up and check everything again.
+ *
+ * Peak resident size per phase is read from VmHWM after resetting it
+ * through /proc/self/clear_refs (Linux); elsewhere it is the peak since
+ * the start of the process.
+ */
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/stat.h>
+
+#include "tiger/absyn/absyn.h"
+#include "tiger/bench/generator.h"
+#include "tiger/escape/escape.h"
+#include "tiger/frame/compilation.h"
+#include "tiger/output/output.h"
+#include "tiger/parse/parser.h"
+#include "tiger/semant/semant.h"
+#include "tiger/translate/translate.h"
+#include "tiger/util/alloc_profile.h"
+#include "tiger/util/pass_timer.h"
+#include "tiger/util/stats.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/// A knob of bench::GenOptions
+struct Knob {
+  const char *name_;
+  int bench::GenOptions::*member_;
+};
+
+constexpr Knob KNOBS[] = {
+    {"functions", &bench::GenOptions::functions_},
+    {"depth", &bench::GenOptions::depth_},
+    {"loops", &bench::GenOptions::loops_},
+    {"temps", &bench::GenOptions::temps_},
+    {"records", &bench::GenOptions::records_},
+    {"arrays", &bench::GenOptions::arrays_},
+    {"strings", &bench::GenOptions::strings_},
+};
+
+/// Phases run over the whole program, in order
+constexpr const char *PHASES[] = {"parse", "semant", "escape", "translate",
+                                  "back end"};
+constexpr int PHASE_COUNT = sizeof(PHASES) / sizeof(PHASES[0]);
+
+/// Passes of the back end reported under it, in pipeline order
+constexpr const char *PASSES[] = {
+    "linearize", "basic blocks", "trace schedule", "codegen", "liveness",
+    "interference", "coloring", "spill rewrite", "emission", "back end"};
+
+/// What one compilation of a program measured
+struct Measurement {
+  double phase_ms_[PHASE_COUNT] = {};
+  long long peak_kib_[PHASE_COUNT] = {};  ///< Peak resident size during the phase
+  long long grew_kib_[PHASE_COUNT] = {};  ///< Of which added by the phase
+  std::map<std::string_view, double> pass_ms_; ///< Self time of back-end passes
+  long long instructions_ = 0;
+  long long edges_ = 0;
+  long long assembly_bytes_ = 0;
+
+  [[nodiscard]] double PassMs(std::string_view pass) const {
+    auto it = pass_ms_.find(pass);
+    return it == pass_ms_.end() ? 0 : it->second;
+  }
+  /// Liveness analysis and building the interference graph
+  [[nodiscard]] double LivenessMs() const {
+    return PassMs("liveness") + PassMs("interference");
+  }
+  /// RegAllocator proper
+  [[nodiscard]] double RegAllocMs() const {
+    return PassMs("coloring") + PassMs("spill rewrite");
+  }
+};
+
+bool peak_resettable = false;
+
+/** @brief Make the peak resident size the current one, if possible */
+void ResetPeak() {
+  if (FILE *f = fopen("/proc/self/clear_refs", "w")) {
+    peak_resettable = fputs("5", f) >= 0;
+    peak_resettable = fclose(f) == 0 && peak_resettable;
+  }
+}
+
+/** @brief Field @p key of /proc/self/status in KiB, or -1 */
+long long StatusKiB(const char *key) {
+  long long kib = -1;
+  if (FILE *f = fopen("/proc/self/status", "r")) {
+    char line[256];
+    size_t len = strlen(key);
+    while (fgets(line, sizeof(line), f))
+      if (strncmp(line, key, len) == 0 && line[len] == ':')
+        kib = atoll(line + len + 1);
+    fclose(f);
+  }
+  return kib;
+}
+
+/** @brief Peak resident size in KiB, since ResetPeak() where possible */
+long long PeakKiB() {
+  long long kib = peak_resettable ? StatusKiB("VmHWM") : -1;
+  if (kib < 0) {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    kib = usage.ru_maxrss;
+  }
+  return kib;
+}
+
+/**
+ * @brief Compile @p source phase by phase; false on compile errors
+ * @param annotate Translate from the annotations of semantic analysis
+ */
+bool Measure(const std::string &source, bool annotate, Measurement *m) {
+  frame::Compilation compilation(frame::DetectHostTarget());
+  util::PassTimer timer;
+  util::Stats stats;
+  compilation.SetPassTimer(&timer);
+  compilation.SetStats(&stats);
+  frame::Compilation::Scope scope(&compilation);
+
+  std::vector<err::Diagnostic> diagnostics;
+  auto errormsg = std::make_unique<err::ErrorMsg>("bench.tig", &diagnostics);
+  std::unique_ptr<absyn::AbsynTree> absyn_tree;
+  std::string assembly;
+
+  std::function<void()> phases[PHASE_COUNT] = {
+      [&] { absyn_tree = ParseBuffer(source, errormsg.get()); },
+      [&] {
+        sem::ProgSem prog_sem(std::move(absyn_tree), std::move(errormsg));
+        prog_sem.SemAnalyze();
+        absyn_tree = prog_sem.TransferAbsynTree();
+        errormsg = prog_sem.TransferErrormsg();
+      },
+      [&] {
+        if (annotate)
+          return; // Done by semantic analysis
+        esc::EscFinder esc_finder(std::move(absyn_tree));
+        esc_finder.FindEscape();
+        absyn_tree = esc_finder.TransferAbsynTree();
+      },
+      [&] {
+        tr::ProgTr prog_tr(std::move(absyn_tree), std::move(errormsg),
+                           annotate);
+        prog_tr.Translate();
+        errormsg = prog_tr.TransferErrormsg();
+      },
+      [&] {
+        output::AssemGen assem_gen(&assembly);
+        assem_gen.GenAssem(true);
+      },
+  };
+  for (int i = 0; i < PHASE_COUNT; ++i) {
+    ResetPeak();
+    long long before = StatusKiB("VmRSS");
+    Clock::time_point start = Clock::now();
+    {
+      // Also tells util::AllocProfile which phase allocates
+      util::PassTimer::Scope pass(PHASES[i]);
+      phases[i]();
+    }
+    m->phase_ms_[i] =
+        std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    m->peak_kib_[i] = PeakKiB();
+    m->grew_kib_[i] = before < 0 ? 0 : std::max(0LL, m->peak_kib_[i] - before);
+    if ((i == 0 && !absyn_tree) || (i == 1 && errormsg->AnyErrors()))
+      break;
+  }
+  for (const err::Diagnostic &diagnostic : diagnostics)
+    fprintf(stderr, "bench.tig:%d.%d: %s\n", diagnostic.line_,
+            diagnostic.column_, diagnostic.message_.c_str());
+  if (!diagnostics.empty())
+    return false;
+
+  for (const util::PassTimer::Event &event : timer.Events())
+    m->pass_ms_[event.pass_] += event.self_ns_ / 1e6;
+  for (const util::FunctionStats &function : stats.TakeFunctions()) {
+    m->instructions_ += function.instructions_;
+    m->edges_ += function.interference_edges_;
+  }
+  m->assembly_bytes_ = static_cast<long long>(assembly.size());
+  return true;
+}
+
+/** @brief The fastest of @p repeat compilations, with the largest peaks */
+bool MeasureBest(const std::string &source, int repeat, bool annotate,
+                 Measurement *best) {
+  for (int r = 0; r < repeat; ++r) {
+    Measurement m;
+    if (!Measure(source, annotate, &m))
+      return false;
+    if (r == 0) {
+      *best = m;
+      continue;
+    }
+    for (int i = 0; i < PHASE_COUNT; ++i) {
+      best->phase_ms_[i] = std::min(best->phase_ms_[i], m.phase_ms_[i]);
+      best->peak_kib_[i] = std::max(best->peak_kib_[i], m.peak_kib_[i]);
+      best->grew_kib_[i] = std::max(best->grew_kib_[i], m.grew_kib_[i]);
+    }
+    for (auto &[pass, ms] : best->pass_ms_)
+      ms = std::min(ms, m.PassMs(pass));
+  }
+  return true;
+}
+
+std::string Describe(const bench::GenOptions &options) {
+  std::string text;
+  for (const Knob &knob : KNOBS)
+    text += std::string(knob.name_) + "=" +
+            std::to_string(options.*knob.member_) + " ";
+  return text + "seed=" + std::to_string(options.seed_);
+}
+
+void Report(const bench::GenOptions &options, const std::string &source,
+            const Measurement &m) {
+  printf("%s\n", Describe(options).c_str());
+  printf("  %lld lines, %zu bytes of source; %lld instructions, "
+         "%lld interference edges, %lld bytes of assembly\n",
+         static_cast<long long>(std::count(source.begin(), source.end(), '\n')),
+         source.size(), m.instructions_, m.edges_, m.assembly_bytes_);
+  printf("  %-20s %10s %12s %10s\n", "phase", "wall ms", "peak MiB",
+         "+MiB");
+  for (int i = 0; i < PHASE_COUNT; ++i)
+    printf("  %-20s %10.2f %12.1f %10.1f\n", PHASES[i], m.phase_ms_[i],
+           m.peak_kib_[i] / 1024.0, m.grew_kib_[i] / 1024.0);
+  for (const char *pass : PASSES)
+    printf("    %-18s %10.2f\n",
+           std::strcmp(pass, "back end") == 0 ? "other" : pass, m.PassMs(pass));
+}
+
+/**
+ * @brief How @p ms grows with @p work between two steps, as an exponent
+ * @return NAN if the work did not grow or the times are too small to tell
+ */
+double Exponent(double ms0, double ms1, double work0, double work1) {
+  constexpr double NOISE_MS = 2.0;
+  if (work1 <= work0 * 1.05 || ms0 <= 0 || ms1 < NOISE_MS)
+    return NAN;
+  return std::log(ms1 / ms0) / std::log(work1 / work0);
+}
+
+/** @brief Report the growth of one pass over the steps; true if flagged */
+bool ReportGrowth(const char *pass, const char *work_name,
+                  const std::vector<double> &ms,
+                  const std::vector<double> &work, double threshold) {
+  bool flagged = false;
+  printf("  %-12s ms:", pass);
+  for (double t : ms)
+    printf(" %9.2f", t);
+  printf("   exponent vs %s:", work_name);
+  for (size_t i = 1; i < ms.size(); ++i) {
+    double e = Exponent(ms[i - 1], ms[i], work[i - 1], work[i]);
+    if (std::isnan(e)) {
+      printf("     -");
+    } else {
+      printf(" %5.2f", e);
+      flagged = flagged || e > threshold;
+    }
+  }
+  printf("%s\n", flagged ? "   SUPER-LINEAR" : "");
+  return flagged;
+}
+
+/** @brief Create @p dir and its parents; false if it is not a directory then */
+bool CreateDirectories(const std::string &dir) {
+  for (size_t slash = dir.find('/', 1); slash != std::string::npos;
+       slash = dir.find('/', slash + 1))
+    ::mkdir(dir.substr(0, slash).c_str(), 0777);
+  if (::mkdir(dir.c_str(), 0777) == 0)
+    return true;
+  int error = errno;
+  struct stat st;
+  if (::stat(dir.c_str(), &st) == 0 && S_ISDIR(st.st_mode))
+    return true;
+  errno = error;
+  return false;
+}
+
+bool WriteFile(const std::string &path, std::string_view text) {
+  FILE *out = fopen(path.c_str(), "w");
+  if (!out)
+    return false;
+  bool ok = fwrite(text.data(), 1, text.size(), out) == text.size();
+  return fclose(out) == 0 && ok;
+}
+
+bool ParseInt(std::string_view text, int *value) {
+  auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), *value);
+  return ec == std::errc() && end == text.data() + text.size();
+}
+
+void Usage() {
+  fprintf(stderr,
+          "usage: bench_compile [--seed N] [--repeat N] [--steps N] "
+          "[--threshold X]\n"
+          "                     [--scale knob]... [--knob N]... "
+          "[--dump dir] [--check]\n"
+          "                     [--alloc-profile] [--no-annotate]\n"
+          "knobs:");
+  for (const Knob &knob : KNOBS)
+    fprintf(stderr, " %s", knob.name_);
+  fprintf(stderr, "\n");
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  bench::GenOptions base;
+  int repeat = 3;
+  int steps = 3;
+  double threshold = 1.3;
+  bool check = false;
+  bool annotate = true;
+  std::string dump_dir;
+  std::vector<const Knob *> scaled;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg(argv[i]);
+    if (arg == "--check") {
+      check = true;
+      continue;
+    }
+    if (arg == "--no-annotate") {
+      annotate = false;
+      continue;
+    }
+    if (arg == "--alloc-profile") {
+      util::AllocProfile::Enable();
+      std::atexit([] { util::AllocProfile::Print(stdout); });
+      continue;
+    }
+    if (i + 1 >= argc) {
+      Usage();
+      return 1;
+    }
+    std::string_view value(argv[++i]);
+    int n = 0;
+    bool ok = true;
+    if (arg == "--seed") {
+      ok = ParseInt(value, &n) && n >= 0;
+      base.seed_ = static_cast<unsigned>(n);
+    } else if (arg == "--repeat") {
+      ok = ParseInt(value, &repeat) && repeat > 0;
+    } else if (arg == "--steps") {
+      ok = ParseInt(value, &steps) && steps > 0;
+    } else if (arg == "--threshold") {
+      threshold = atof(argv[i]);
+      ok = threshold > 0;
+    } else if (arg == "--dump") {
+      dump_dir = value;
+    } else if (arg == "--scale") {
+      auto knob = std::find_if(std::begin(KNOBS), std::end(KNOBS),
+                               [value](const Knob &k) { return value == k.name_; });
+      ok = knob != std::end(KNOBS);
+      if (ok)
+        scaled.push_back(knob);
+    } else {
+      auto knob = std::find_if(
+          std::begin(KNOBS), std::end(KNOBS),
+          [arg](const Knob &k) { return arg == "--" + std::string(k.name_); });
+      ok = knob != std::end(KNOBS) && ParseInt(value, &n) && n >= 0;
+      if (ok)
+        base.*knob->member_ = n;
+    }
+    if (!ok) {
+      fprintf(stderr, "bad value for %.*s: %.*s\n", static_cast<int>(arg.size()),
+              arg.data(), static_cast<int>(value.size()), value.data());
+      Usage();
+      return 1;
+    }
+  }
+  if (scaled.empty())
+    for (const Knob &knob : KNOBS)
+      scaled.push_back(&knob);
+  if (!dump_dir.empty() && !CreateDirectories(dump_dir)) {
+    fprintf(stderr, "cannot create %s: %s\n", dump_dir.c_str(),
+            strerror(errno));
+    return 1;
+  }
+
+#ifndef NDEBUG
+  fprintf(stderr, "warning: built without NDEBUG, so every phase logs to "
+                  "stdout; configure with -DCMAKE_BUILD_TYPE=Release\n");
+#endif
+
+  int flagged = 0;
+  for (const Knob *knob : scaled) {
+    printf("== scaling %s\n", knob->name_);
+    std::vector<int> values;
+    std::vector<double> liveness_ms, regalloc_ms, instructions, colored;
+    for (int step = 0; step < steps; ++step) {
+      bench::GenOptions options = base;
+      int value = std::max(base.*knob->member_, 1) << step;
+      options.*knob->member_ = value;
+      std::string source = bench::GenerateProgram(options);
+      if (!dump_dir.empty()) {
+        std::string path = dump_dir + "/" + knob->name_ + "-" +
+                           std::to_string(value) + ".tig";
+        if (!WriteFile(path, source)) {
+          fprintf(stderr, "cannot write %s: %s\n", path.c_str(),
+                  strerror(errno));
+          return 1;
+        }
+      }
+
+      Measurement m;
+      if (!MeasureBest(source, repeat, annotate, &m)) {
+        fprintf(stderr, "the generated program for %s does not compile\n",
+                Describe(options).c_str());
+        return 1;
+      }
+      Report(options, source, m);
+      values.push_back(value);
+      liveness_ms.push_back(m.LivenessMs());
+      regalloc_ms.push_back(m.RegAllocMs());
+      instructions.push_back(static_cast<double>(m.instructions_));
+      colored.push_back(static_cast<double>(m.instructions_ + m.edges_));
+    }
+
+    if (steps > 1) {
+      printf("growth with %s:", knob->name_);
+      for (int value : values)
+        printf(" %d", value);
+      printf("\n");
+      flagged += ReportGrowth("liveness", "instructions", liveness_ms,
+                              instructions, threshold);
+      flagged += ReportGrowth("RegAllocator", "instructions+edges",
+                              regalloc_ms, colored, threshold);
+    }
+    printf("\n");
+  }
+
+  if (!peak_resettable)
+    printf("(peak resident sizes are since the start of the process)\n");
+  if (flagged)
+    printf("%d pass%s scaled super-linearly (exponent above %.2f)\n", flagged,
+           flagged == 1 ? "" : "es", threshold);
+  return check && flagged ? 1 : 0;
+}
@@ -0,0 +1,586 @@
+/**
+ * @file bench_runtime.cc
+ * @brief How fast the code the compiler generates runs
+ *
+ * Compiles a set of Tiger programs, the test cases queens, qsort, merge,
+ * bsearch and prime and the compute kernels of src/tiger/bench/kernels
+ * (matrix multiplication, a sieve, string building and a linked list
+ * walk), links each with the runtime, runs it a number of times and
+ * reports the median wall time, the median number of instructions retired
+ * (where perf_event can count them) and the peak resident size.  The
+ * equivalent C program of each, compiled with -O0 and -O2, is run the same
+ * way as a reference point, and its output must match that of the Tiger
+ * program.
+ *
+ * The programs are started by a launcher process, forked before the
+ * harness allocates anything: a child's peak resident size starts from
+ * that of the process it was forked from, which would otherwise be the
+ * harness with its compiler and sources.
+ *
+ * Most programs take a size N: the harness rewrites the number in the
+ * first "var N := " of the Tiger program and "#define N " of the C one,
+ * and merge reads two lists of N numbers from its input.
+ *
+ * Usage (from the top of the repository, like tiger-compiler):
+ *   bench_runtime [--kernel <name>]... [--repeat N] [--cc <compiler>]
+ *                 [--quick] [--no-c]
+ *
+ *   --kernel runs only the named programs, --repeat sets the number of
+ *   runs (5 by default), --cc the C compiler used for linking and for the
+ *   C programs ($CC, or clang), --quick runs only the smallest size of
+ *   each and --no-c skips the C programs.
+ */
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+#include "tiger/driver/driver.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr const char *RUNTIME = "src/tiger/runtime/runtime.c";
+constexpr const char *TESTCASES = "testdata/lab5or6/testcases/";
+constexpr const char *KERNELS = "src/tiger/bench/kernels/";
+
+/// A program to measure
+struct Kernel {
+  const char *name_;
+  std::string tiger_;                   ///< Tiger source
+  std::string c_;                       ///< Equivalent C source
+  std::vector<int> sizes_;              ///< Values of N; none to run as written
+  std::string (*input_)(int n) = nullptr; ///< Input of size @p n, if any
+};
+
+/// Two sorted lists of @p n numbers each, as merge.tig reads them
+std::string MergeInput(int n) {
+  std::string input;
+  for (int list = 0; list < 2; ++list) {
+    for (int i = 0; i < n; ++i)
+      input += std::to_string(2 * i + list) + " ";
+    input += list == 0 ? "a\n" : "b\n";
+  }
+  return input;
+}
+
+std::vector<Kernel> Kernels() {
+  auto testcase = [](const char *name, std::vector<int> sizes,
+                     std::string (*input)(int) = nullptr) {
+    return Kernel{name, std::string(TESTCASES) + name + ".tig",
+                  std::string(KERNELS) + name + ".c", std::move(sizes), input};
+  };
+  auto kernel = [](const char *name, std::vector<int> sizes) {
+    return Kernel{name, std::string(KERNELS) + name + ".tig",
+                  std::string(KERNELS) + name + ".c", std::move(sizes)};
+  };
+  // queens.tig only works for N = 8, and prime.tig has no size
+  return {
+      testcase("queens", {}),
+      testcase("qsort", {1000, 4000}),
+      testcase("merge", {1000, 10000}, MergeInput),
+      testcase("bsearch", {16, 100000, 1000000}),
+      testcase("prime", {}),
+      kernel("matmul", {32, 64, 128}),
+      kernel("sieve", {100000, 1000000, 4000000}),
+      kernel("strbuild", {1000, 4000, 8000}),
+      kernel("list", {10000, 100000}),
+  };
+}
+
+bool ReadFile(const std::string &path, std::string *text) {
+  FILE *in = fopen(path.c_str(), "rb");
+  if (!in)
+    return false;
+  char buffer[1 << 16];
+  size_t n;
+  while ((n = fread(buffer, 1, sizeof(buffer), in)) > 0)
+    text->append(buffer, n);
+  fclose(in);
+  return true;
+}
+
+bool WriteFile(const std::string &path, std::string_view text) {
+  FILE *out = fopen(path.c_str(), "wb");
+  if (!out)
+    return false;
+  bool ok = fwrite(text.data(), 1, text.size(), out) == text.size();
+  return fclose(out) == 0 && ok;
+}
+
+/** @brief Replace the number after the first @p marker in @p source by @p n */
+std::string Resize(std::string source, std::string_view marker, int n) {
+  size_t at = source.find(marker);
+  if (at == std::string::npos)
+    return source;
+  size_t begin = at + marker.size();
+  size_t end = begin;
+  while (end < source.size() && source[end] >= '0' && source[end] <= '9')
+    ++end;
+  return source.replace(begin, end - begin, std::to_string(n));
+}
+
+/**
+ * @brief Open a counter of the instructions @p pid retires once it execs
+ * @return Its file descriptor, or -1 if it cannot be counted
+ */
+int CountInstructions(pid_t pid) {
+#ifdef __linux__
+  perf_event_attr attr = {};
+  attr.size = sizeof(attr);
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+  attr.disabled = 1;
+  attr.enable_on_exec = 1;
+  attr.inherit = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  return static_cast<int>(::syscall(SYS_perf_event_open, &attr, pid, -1, -1, 0));
+#else
+  (void)pid;
+  return -1;
+#endif
+}
+
+/// What one run of a program measured
+struct Run {
+  double ms_ = 0;
+  long long instructions_ = -1;         ///< -1 if not counted
+  long long peak_kib_ = 0;
+};
+
+/// How a run ended, as the launcher reports it
+struct Exit {
+  int status_ = 0;                      ///< As from wait4
+  double ms_ = 0;
+  long long peak_kib_ = 0;
+};
+
+bool ReadAll(int fd, void *data, size_t size) {
+  char *at = static_cast<char *>(data);
+  while (size > 0) {
+    ssize_t n = ::read(fd, at, size);
+    if (n <= 0)
+      return false;
+    at += n;
+    size -= n;
+  }
+  return true;
+}
+
+bool WriteAll(int fd, const void *data, size_t size) {
+  const char *at = static_cast<const char *>(data);
+  while (size > 0) {
+    ssize_t n = ::write(fd, at, size);
+    if (n <= 0)
+      return false;
+    at += n;
+    size -= n;
+  }
+  return true;
+}
+
+/**
+ * @brief Serve the runs the harness asks for on @p fd until it closes it
+ *
+ * A request is the size of the rest and then the binary, the input path
+ * and the output path, each ending in '\0'.  The launcher forks the
+ * child, sends its pid (-1 if it could not), waits for one byte, which
+ * tells it that the instruction counter is open, lets the child exec and
+ * sends back an Exit when it has ended.  Nothing here allocates.
+ */
+[[noreturn]] void Launch(int fd) {
+  static char request[1 << 14];
+  for (;;) {
+    uint32_t size;
+    if (!ReadAll(fd, &size, sizeof(size)) || size == 0 ||
+        size > sizeof(request) || !ReadAll(fd, request, size) ||
+        request[size - 1] != '\0')
+      ::_exit(0);
+    const char *binary = request;
+    const char *input_path = binary + strlen(binary) + 1;
+    const char *output_path = input_path + strlen(input_path) + 1;
+    if (output_path >= request + size)
+      ::_exit(0);
+
+    // The child waits for the counter to be opened before it execs
+    int go[2];
+    pid_t pid = ::pipe(go) == 0 ? ::fork() : -1;
+    if (pid == 0) {
+      ::close(fd);
+      ::close(go[1]);
+      int in = ::open(input_path, O_RDONLY);
+      int out = ::open(output_path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+      char c;
+      if (in < 0 || out < 0 || ::dup2(in, 0) < 0 || ::dup2(out, 1) < 0 ||
+          ::read(go[0], &c, 1) != 1)
+        ::_exit(127);
+      ::execl(binary, binary, static_cast<char *>(nullptr));
+      ::_exit(127);
+    }
+    if (!WriteAll(fd, &pid, sizeof(pid)))
+      ::_exit(0);
+    if (pid < 0)
+      continue;
+
+    ::close(go[0]);
+    char c;
+    if (!ReadAll(fd, &c, 1))
+      ::_exit(0);
+    Clock::time_point start = Clock::now();
+    bool released = ::write(go[1], "x", 1) == 1;
+    ::close(go[1]);
+    Exit exit;
+    rusage usage = {};
+    ::wait4(pid, &exit.status_, 0, &usage);
+    exit.ms_ =
+        std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+#ifdef __APPLE__
+    exit.peak_kib_ = usage.ru_maxrss / 1024; // In bytes there
+#else
+    exit.peak_kib_ = usage.ru_maxrss;
+#endif
+    if (!released)
+      exit.status_ = -1;
+    if (!WriteAll(fd, &exit, sizeof(exit)))
+      ::_exit(0);
+  }
+}
+
+/// The launcher process, as seen from the harness
+struct Launcher {
+  pid_t pid_ = -1;
+  int fd_ = -1;
+};
+
+/** @brief Fork the launcher; call before anything big is allocated */
+bool StartLauncher(Launcher *launcher) {
+  int fds[2];
+  if (::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+    return false;
+  pid_t pid = ::fork();
+  if (pid < 0)
+    return false;
+  if (pid == 0) {
+    ::close(fds[0]);
+    Launch(fds[1]);
+  }
+  ::close(fds[1]);
+  launcher->pid_ = pid;
+  launcher->fd_ = fds[0];
+  return true;
+}
+
+void StopLauncher(Launcher *launcher) {
+  ::close(launcher->fd_);
+  ::waitpid(launcher->pid_, nullptr, 0);
+}
+
+/**
+ * @brief Have @p launcher run @p binary with @p input_path as stdin and
+ *        @p output_path as stdout
+ * @return Whether it exited with status 0
+ */
+bool RunOnce(const Launcher &launcher, const std::string &binary,
+             const std::string &input_path, const std::string &output_path,
+             Run *run) {
+  std::string request = binary + '\0' + input_path + '\0' + output_path + '\0';
+  uint32_t size = request.size();
+  pid_t pid;
+  if (!WriteAll(launcher.fd_, &size, sizeof(size)) ||
+      !WriteAll(launcher.fd_, request.data(), size) ||
+      !ReadAll(launcher.fd_, &pid, sizeof(pid)) || pid < 0)
+    return false;
+
+  int counter = CountInstructions(pid);
+  Exit exit;
+  if (!WriteAll(launcher.fd_, "x", 1) ||
+      !ReadAll(launcher.fd_, &exit, sizeof(exit)))
+    return false;
+  run->ms_ = exit.ms_;
+  run->peak_kib_ = exit.peak_kib_;
+  if (counter >= 0) {
+    long long count;
+    if (::read(counter, &count, sizeof(count)) == sizeof(count))
+      run->instructions_ = count;
+    ::close(counter);
+  }
+  return exit.status_ != -1 && WIFEXITED(exit.status_) &&
+         WEXITSTATUS(exit.status_) == 0;
+}
+
+template <typename T> T Median(std::vector<T> values) {
+  std::sort(values.begin(), values.end());
+  size_t middle = values.size() / 2;
+  return values.size() % 2 ? values[middle]
+                           : (values[middle - 1] + values[middle]) / 2;
+}
+
+/// Median measurements of one binary
+struct Result {
+  std::string variant_;
+  bool ok_ = false;
+  std::string output_;
+  double ms_ = 0;
+  long long instructions_ = -1;
+  long long peak_kib_ = 0;
+};
+
+/** @brief Run @p binary @p repeat times; fails on the first failed run */
+Result Measure(const Launcher &launcher, const std::string &variant,
+               const std::string &binary, const std::string &input_path,
+               const std::string &work, int repeat) {
+  Result result;
+  result.variant_ = variant;
+  std::string output_path = work + "/output";
+  std::vector<double> times;
+  std::vector<long long> instructions;
+  for (int r = 0; r < repeat; ++r) {
+    Run run;
+    if (!RunOnce(launcher, binary, input_path, output_path, &run)) {
+      fprintf(stderr, "%s exited with an error\n", binary.c_str());
+      return result;
+    }
+    times.push_back(run.ms_);
+    if (run.instructions_ >= 0)
+      instructions.push_back(run.instructions_);
+    result.peak_kib_ = std::max(result.peak_kib_, run.peak_kib_);
+  }
+  result.ms_ = Median(times);
+  if (instructions.size() == times.size())
+    result.instructions_ = Median(instructions);
+  result.ok_ = ReadFile(output_path, &result.output_);
+  std::remove(output_path.c_str());
+  return result;
+}
+
+/// How the binaries are built
+struct Toolchain {
+  std::string cc_;
+  std::string link_flags_;              ///< For Tiger programs
+  std::string work_;                    ///< Directory for the files made
+};
+
+bool RunCommand(const std::string &command) {
+  if (std::system(command.c_str()) == 0)
+    return true;
+  fprintf(stderr, "command failed: %s\n", command.c_str());
+  return false;
+}
+
+/** @brief Compile Tiger @p source and link it into @p binary */
+bool BuildTiger(const Toolchain &toolchain, const std::string &name,
+                const std::string &source, const std::string &binary) {
+  driver::Compiler compiler{driver::Options()};
+  std::string assembly;
+  driver::Result result = compiler.Compile(source, &assembly, name);
+  for (const err::Diagnostic &diagnostic : result.diagnostics_)
+    fprintf(stderr, "%s\n", driver::Format(name, diagnostic).c_str());
+  std::string asm_path = binary + ".s";
+  if (!result.ok_ || !WriteFile(asm_path, assembly))
+    return false;
+  bool ok = RunCommand(toolchain.cc_ + " " + toolchain.link_flags_ + asm_path + " " +
+                RUNTIME + " -o " + binary);
+  std::remove(asm_path.c_str());
+  return ok;
+}
+
+/** @brief Compile C @p source with @p flags into @p binary */
+bool BuildC(const Toolchain &toolchain, const std::string &source,
+            const char *flags, const std::string &binary) {
+  std::string c_path = binary + ".c";
+  if (!WriteFile(c_path, source))
+    return false;
+  bool ok = RunCommand(toolchain.cc_ + " " + flags + " " + c_path + " -o " + binary);
+  std::remove(c_path.c_str());
+  return ok;
+}
+
+void Report(const std::vector<Result> &results) {
+  const Result *reference = nullptr; // The fastest C
+  for (const Result &result : results)
+    if (result.ok_ && result.variant_ != "tiger" &&
+        (!reference || result.ms_ < reference->ms_))
+      reference = &result;
+
+  printf("  %-14s %12s %16s %10s %10s\n", "variant", "median ms",
+         "instructions", "peak MiB", reference ? "vs best C" : "");
+  for (const Result &result : results) {
+    if (!result.ok_) {
+      printf("  %-14s %12s\n", result.variant_.c_str(), "failed");
+      continue;
+    }
+    char instructions[32] = "-";
+    if (result.instructions_ >= 0)
+      snprintf(instructions, sizeof(instructions), "%lld",
+               result.instructions_);
+    char ratio[32] = "";
+    if (reference && reference->ms_ > 0)
+      snprintf(ratio, sizeof(ratio), "%.2fx", result.ms_ / reference->ms_);
+    printf("  %-14s %12.2f %16s %10.1f %10s\n", result.variant_.c_str(),
+           result.ms_, instructions, result.peak_kib_ / 1024.0, ratio);
+  }
+}
+
+bool ParseInt(std::string_view text, int *value) {
+  auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), *value);
+  return ec == std::errc() && end == text.data() + text.size();
+}
+
+void Usage() {
+  fprintf(stderr, "usage: bench_runtime [--kernel name]... [--repeat N] "
+                  "[--cc compiler] [--quick] [--no-c]\n"
+                  "kernels:");
+  for (const Kernel &kernel : Kernels())
+    fprintf(stderr, " %s", kernel.name_);
+  fprintf(stderr, "\n");
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  Launcher launcher;
+  if (!StartLauncher(&launcher)) {
+    perror("bench_runtime: launcher");
+    return 1;
+  }
+  std::vector<Kernel> kernels = Kernels();
+  std::vector<std::string> selected;
+  int repeat = 5;
+  bool quick = false;
+  bool with_c = true;
+  Toolchain toolchain;
+  const char *cc = getenv("CC");
+  toolchain.cc_ = cc && *cc ? cc : "clang";
+
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg(argv[i]);
+    if (arg == "--quick") {
+      quick = true;
+    } else if (arg == "--no-c") {
+      with_c = false;
+    } else if (arg == "--kernel" && i + 1 < argc) {
+      selected.emplace_back(argv[++i]);
+      if (std::none_of(kernels.begin(), kernels.end(), [&](const Kernel &k) {
+            return selected.back() == k.name_;
+          })) {
+        fprintf(stderr, "unknown kernel: %s\n", argv[i]);
+        Usage();
+        return 1;
+      }
+    } else if (arg == "--repeat" && i + 1 < argc) {
+      if (!ParseInt(argv[++i], &repeat) || repeat <= 0) {
+        Usage();
+        return 1;
+      }
+    } else if (arg == "--cc" && i + 1 < argc) {
+      toolchain.cc_ = argv[++i];
+    } else {
+      Usage();
+      return 1;
+    }
+  }
+  // The runtime's getchar returns a Tiger string, as in scripts/grade.sh
+  if (driver::Options().target_ == frame::TargetArch::Arm64Apple)
+    toolchain.link_flags_ = "-arch arm64 ";
+  else
+    toolchain.link_flags_ = "-Wl,--wrap,getchar ";
+
+  char work[] = "/tmp/bench_runtime.XXXXXX";
+  if (!::mkdtemp(work)) {
+    perror("mkdtemp");
+    return 1;
+  }
+  toolchain.work_ = work;
+  std::string binary = toolchain.work_ + "/program";
+  std::string input_path = toolchain.work_ + "/input";
+
+  int failures = 0;
+  for (const Kernel &kernel : kernels) {
+    if (!selected.empty() &&
+        std::find(selected.begin(), selected.end(), kernel.name_) ==
+            selected.end())
+      continue;
+    std::string tiger, c;
+    if (!ReadFile(kernel.tiger_, &tiger) || !ReadFile(kernel.c_, &c)) {
+      fprintf(stderr, "cannot read %s or %s; run from the top of the "
+                      "repository\n",
+              kernel.tiger_.c_str(), kernel.c_.c_str());
+      ++failures;
+      continue;
+    }
+
+    std::vector<int> sizes = kernel.sizes_;
+    if (sizes.empty())
+      sizes.push_back(-1);
+    if (quick)
+      sizes.resize(1);
+    for (int n : sizes) {
+      if (n < 0)
+        printf("%s\n", kernel.name_);
+      else
+        printf("%s (N = %d)\n", kernel.name_, n);
+      if (!WriteFile(input_path, kernel.input_ && n >= 0 ? kernel.input_(n)
+                                                         : std::string())) {
+        perror(input_path.c_str());
+        return 1;
+      }
+
+      std::vector<Result> results;
+      std::string tiger_source = n < 0 ? tiger : Resize(tiger, "var N := ", n);
+      if (BuildTiger(toolchain, kernel.tiger_, tiger_source, binary))
+        results.push_back(
+            Measure(launcher, "tiger", binary, input_path, toolchain.work_,
+                    repeat));
+      else
+        results.push_back({"tiger"});
+      if (with_c) {
+        std::string c_source = n < 0 ? c : Resize(c, "#define N ", n);
+        for (const char *flags : {"-O0", "-O2"}) {
+          std::string variant =
+              toolchain.cc_.substr(toolchain.cc_.rfind('/') + 1) + " " + flags;
+          if (BuildC(toolchain, c_source, flags, binary))
+            results.push_back(
+                Measure(launcher, variant, binary, input_path,
+                        toolchain.work_, repeat));
+          else
+            results.push_back({variant});
+        }
+      }
+      std::remove(binary.c_str());
+
+      Report(results);
+      for (const Result &result : results)
+        failures += !result.ok_;
+      if (with_c && results[0].ok_ && results[1].ok_ &&
+          results[0].output_ != results[1].output_) {
+        printf("  the output of the Tiger program differs from that of C\n");
+        ++failures;
+      }
+    }
+  }
+
+  std::remove(input_path.c_str());
+  ::rmdir(work);
+  StopLauncher(&launcher);
+  return failures ? 1 : 0;
+}
@@ -2,54 +2,467 @@
  * @file main.cc
  * @brief Tiger compiler driver
  *
- * This is the top-level entry point for the Tiger compiler.  It drives
- * the complete compilation pipeline from source file to target assembly:
- *
- *   1. Parse          – lex + parse the .tig source file into an AST
- *   2. Semantic analysis – type-check and scope-check the AST
- *   3. Escape analysis  – determine which variables must live in the frame
- *   4. IR translation   – translate the AST to IR tree fragments
- *   5. Assembly output  – canonicalize, select instructions, allocate
- *                         registers, and write the .tig.s output file
- *
- * Global state:
- *   reg_manager – the active target register manager (singleton)
- *   frags       – the global list of compiled fragments (ProcFrag/StringFrag)
+ * This is the top-level entry point for the Tiger compiler.  It compiles
+ * each source file with a driver::Compiler (see driver.h, which describes
+ * the pipeline) and writes the assembly to <file.tig>.s.  Every file is
+ * compiled in a frame::Compilation of its own, so several files can be
+ * compiled at the same time in one process.
  *
  * Usage:
- *   tiger-compiler [--target <target>] [--emit-binary] [-o output] <file.tig>
+ *   tiger-compiler [--target <target>] [--emit-binary] [-o output] [-j N]
+ *                  [--cache <dir>] [--cache-stats] [--time-passes[=hw]]
+ *                  [--time-trace <file.json>] [--stats]
+ *                  [--stats-json <file.json>] [--alloc-profile]
+ *                  [--max-regalloc-rounds N] <file.tig>...
+ *
+ *   -j N compiles up to N files at the same time, or, given a single file,
+ *   up to N of its functions at the same time in the back end; the output
+ *   is the same for every N.  -o names the binary and needs a single file.
+ *   --cache reuses the assembly of functions compiled before from <dir>,
+ *   and adds that of the others (see output/cache.h); the output is the
+ *   same as without.  --cache-stats prints how many functions were found
+ *   there.  --time-passes prints the time spent in each pass over all files
+ *   (see util/pass_timer.h); with =hw also the CPU cycles and instructions,
+ *   or the CPU time where the hardware counters cannot be read.
+ *   --time-trace writes each pass of each function as a Chrome trace event.
+ *   --stats prints what the passes did to each function (see
+ *   util/stats.h), and --stats-json writes it as JSON.  --alloc-profile
+ *   prints, when the compiler exits, the allocations made in each phase and
+ *   the types with the most bytes (see util/alloc_profile.h).
+ *   --max-regalloc-rounds makes a function that still spills after N
+ *   rounds of register allocation an internal error; it is for testing
+ *   that error.
  *
  * Output:
  *   <file.tig>.s  – target assembly
  *   <file.tig>.bin – optional linked binary when --emit-binary is used
+ *
+ * Server mode:
+ *   tiger-compiler [--target <target>] [-j N] [--cache <dir>]
+ *                  [--request-timeout <seconds>] --serve <socket>
+ *
+ *   Listens on a Unix socket and compiles each program sent to it, up to N
+ *   at a time, sending back the assembly or the diagnostics and how long
+ *   each phase took (see ServeRequest()).  Each of the N worker processes
+ *   sets up one compilation and its register manager and resets it between
+ *   requests, so a request compiles exactly as the same program would from
+ *   a file.  A worker that crashes or grows too large is replaced, and so
+ *   is one that spends longer than --request-timeout (30 seconds by
+ *   default) on a request, after answering it with an error.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <set>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "tiger/driver/driver.h"
+#include "tiger/util/alloc_profile.h"
+#include "tiger/util/parallel.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/// Functions found in the cache and not, over all files
+std::atomic<long long> cache_hits(0);
+std::atomic<long long> cache_misses(0);
+
+/// Read all of @p fname into @p text; false if it cannot be read
+bool ReadFile(const std::string &fname, std::string *text) {
+  FILE *in = fopen(fname.c_str(), "rb");
+  if (!in)
+    return false;
+  char buf[64 * 1024];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), in)) > 0)
+    text->append(buf, n);
+  bool ok = !ferror(in);
+  fclose(in);
+  return ok;
+}
+
+/**
+ * @brief Compile @p fname to <fname>.s, and link it if @p emit_binary
+ * @param output_path Binary to link, or empty for <fname>.bin
+ * @param functions   Receives the counters of its functions, with
+ *                    Options::stats_
+ * @return Whether the file compiled (and linked) without errors
+ */
+bool CompileFile(const std::string &fname, const driver::Options &options,
+                 bool emit_binary, const std::string &output_path,
+                 std::vector<util::FunctionStats> *functions) {
+  std::string source;
+  if (!ReadFile(fname, &source)) {
+    fprintf(stderr, "%s: cannot open file\n", fname.c_str());
+    return false;
+  }
+
+  // The assembly file is created when the first of the assembly arrives
+  std::string asm_path = fname + ".s";
+  std::unique_ptr<util::Writer> out;
+  driver::Compiler compiler(options);
+  driver::Result result = compiler.Compile(
+      source,
+      [&out, &asm_path](std::string_view piece) {
+        if (!out)
+          out = std::make_unique<util::Writer>(asm_path);
+        *out << piece;
+      },
+      fname);
+  cache_hits += result.cache_.hits_;
+  cache_misses += result.cache_.misses_;
+  *functions = std::move(result.functions_);
+  bool written = out != nullptr;
+  if (out) {
+    out->Flush();
+    if (!out->Ok()) {
+      result.ok_ = false;
+      result.diagnostics_.push_back({0, 0, "cannot write " + asm_path});
+    }
+    out.reset();
+  }
+
+  for (const err::Diagnostic &diagnostic : result.diagnostics_)
+    fprintf(stderr, "%s\n", driver::Format(fname, diagnostic).c_str());
+  if (!result.ok_) {
+    // Don't leave a partial assembly file behind
+    if (written)
+      std::remove(asm_path.c_str());
+    return false; // Don't continue if error occurrs
+  }
+
+  if (emit_binary) {
+    std::string binary = output_path.empty() ? fname + ".bin" : output_path;
+    std::string command = "clang ";
+    if (options.target_ == frame::TargetArch::Arm64Apple)
+      command += "-arch arm64 ";
+    command += fname + ".s src/tiger/runtime/runtime.c -o " + binary;
+    if (std::system(command.c_str()) != 0) {
+      fprintf(stderr, "failed to link binary with command: %s\n",
+              command.c_str());
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/// Largest program the server accepts
+constexpr size_t MAX_REQUEST_SIZE = 16 << 20;
+
+/// Write all of @p data to @p fd; false if the peer went away
+bool WriteAll(int fd, std::string_view data) {
+  while (!data.empty()) {
+    ssize_t n = ::write(fd, data.data(), data.size());
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    data.remove_prefix(static_cast<size_t>(n));
+  }
+  return true;
+}
+
+/// The header of a reply, as described at ServeRequest()
+std::string ReplyHeader(bool ok, const driver::PhaseTimes &times,
+                        long long total,
+                        const output::FunctionCache::Stats &cache,
+                        size_t diagnostics, size_t assembly) {
+  std::string header;
+  header += ok ? "status ok\n" : "status error\n";
+  header += "time parse=" + std::to_string(times.parse_) +
+            " semant=" + std::to_string(times.semant_) +
+            " escape=" + std::to_string(times.escape_) +
+            " translate=" + std::to_string(times.translate_) +
+            " total=" + std::to_string(total) + "\n";
+  header += "cache hits=" + std::to_string(cache.hits_) +
+            " misses=" + std::to_string(cache.misses_) + "\n";
+  header += "diagnostics " + std::to_string(diagnostics) + "\n";
+  header += "assembly " + std::to_string(assembly) + "\n\n";
+  return header;
+}
+
+/**
+ * @brief Answer one request on @p conn, compiling it with @p compiler
+ *
+ * The request is the program text, ended by the client shutting down its
+ * side of the connection.  The reply is a header of "key value" lines,
+ * ended by an empty line, followed by the diagnostics and the assembly:
+ *
+ *   status ok|error
+ *   time parse=<us> semant=<us> escape=<us> translate=<us> total=<us>
+ *   cache hits=<functions> misses=<functions>
+ *   diagnostics <bytes>
+ *   assembly <bytes>
+ *
+ * The assembly is empty unless the status is ok.
+ */
+void ServeRequest(int conn, driver::Compiler *compiler) {
+  Clock::time_point start = Clock::now();
+  std::string source;
+  std::string diagnostics;
+  std::string assembly;
+  driver::PhaseTimes times;
+  output::FunctionCache::Stats cache;
+  bool ok = false;
+
+  char buf[64 * 1024];
+  for (;;) {
+    ssize_t n = ::read(conn, buf, sizeof(buf));
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n < 0)
+      return;
+    if (n == 0)
+      break;
+    source.append(buf, static_cast<size_t>(n));
+    if (source.size() > MAX_REQUEST_SIZE)
+      break;
+  }
+
+  if (source.size() > MAX_REQUEST_SIZE) {
+    diagnostics = "request larger than " + std::to_string(MAX_REQUEST_SIZE) +
+                  " bytes\n";
+  } else {
+    driver::Result result = compiler->Compile(source, &assembly);
+    ok = result.ok_;
+    times = result.times_;
+    cache = result.cache_;
+    for (const err::Diagnostic &diagnostic : result.diagnostics_)
+      diagnostics += driver::Format("input.tig", diagnostic) + "\n";
+  }
+
+  long long total = std::chrono::duration_cast<std::chrono::microseconds>(
+                       Clock::now() - start).count();
+  std::string header = ReplyHeader(ok, times, total, cache, diagnostics.size(),
+                                   assembly.size());
+  WriteAll(conn, header) && WriteAll(conn, diagnostics) &&
+      WriteAll(conn, assembly);
+}
+
+/// Seconds a server worker may spend on one request by default
+constexpr unsigned REQUEST_SECONDS = 30;
+
+/// Connection of the request being answered, or -1, for RequestTimedOut()
+volatile sig_atomic_t request_conn = -1;
+/// The reply to a request that timed out; made in advance, since a signal
+/// handler cannot allocate
+const std::string *timeout_reply = nullptr;
+
+/**
+ * @brief SIGALRM handler of a server worker: answer the request it has
+ *        spent too long on with an error, and exit to be replaced
+ *
+ * The compiler may be anywhere, holding any lock, so nothing but the
+ * reply is attempted; a client that is not reading does not get it.
+ */
+void RequestTimedOut(int) {
+  if (request_conn >= 0 && timeout_reply)
+    ::send(request_conn, timeout_reply->data(), timeout_reply->size(),
+           MSG_DONTWAIT | MSG_NOSIGNAL);
+  static const char message[] = "server worker timed out on a request\n";
+  ::write(STDERR_FILENO, message, sizeof(message) - 1);
+  _exit(0);
+}
+
+/// Peak resident size, in KiB, after which a server worker is replaced
+constexpr long WORKER_MAX_RSS = 256 << 10;
+
+/**
+ * @brief Accept and answer requests on @p listener until the worker has
+ *        grown too large, giving each up to @p request_seconds from being
+ *        accepted to being answered
+ * @return Whether it stopped because accepting failed
  */
+bool ServeWorker(int listener, const driver::Options &options,
+                 unsigned request_seconds) {
+  // The register manager is made once per worker, not once per request
+  driver::Compiler compiler(options);
+
+  std::string diagnostics = "input.tig:0.0: request took longer than " +
+                            std::to_string(request_seconds) + " seconds\n";
+  std::string timeout =
+      ReplyHeader(false, {}, request_seconds * 1000000LL, {},
+                  diagnostics.size(), 0) + diagnostics;
+  timeout_reply = &timeout;
+  signal(SIGALRM, RequestTimedOut);
+
+  for (;;) {
+    int conn = ::accept(listener, nullptr, nullptr);
+    if (conn < 0) {
+      if (errno == EINTR || errno == ECONNABORTED)
+        continue;
+      perror("accept");
+      return true;
+    }
+    request_conn = conn;
+    alarm(request_seconds);
+    ServeRequest(conn, &compiler);
+    alarm(0);
+    request_conn = -1;
+    ::close(conn);
+
+    rusage usage;
+    if (::getrusage(RUSAGE_SELF, &usage) == 0 &&
+        usage.ru_maxrss > WORKER_MAX_RSS)
+      return false;
+  }
+}
 
-#include "tiger/absyn/absyn.h"
-#include "tiger/escape/escape.h"
-#include "tiger/frame/target.h"
-#include "tiger/output/logger.h"
-#include "tiger/output/output.h"
-#include "tiger/parse/parser.h"
-#include "tiger/translate/translate.h"
-#include "tiger/semant/semant.h"
+/// Set by SIGINT and SIGTERM to stop the server
+volatile sig_atomic_t stop_serving = 0;
+
+void StopServing(int) { stop_serving = 1; }
+
+/// Fork a process that runs ServeWorker(); its pid, or -1
+pid_t StartWorker(int listener, const driver::Options &options,
+                  unsigned request_seconds) {
+  pid_t pid = ::fork();
+  if (pid == 0) {
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+    _exit(ServeWorker(listener, options, request_seconds) ? 1 : 0);
+  }
+  if (pid < 0)
+    perror("fork");
+  return pid;
+}
+
+/**
+ * @brief Compile programs sent to the Unix socket at @p path, answering
+ *        up to @p jobs requests at the same time, until SIGINT or SIGTERM
+ *
+ * Requests are served by @p jobs worker processes sharing the socket,
+ * each compiling one function at a time with @p options.
+ * The compiler frees little of what a program allocates, so a worker that
+ * has grown past WORKER_MAX_RSS exits and is replaced by a fresh one, as
+ * is one that crashed on its request or spent longer than
+ * @p request_seconds on it.
+ */
+int Serve(const std::string &path, const driver::Options &options, int jobs,
+          unsigned request_seconds) {
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(addr.sun_path)) {
+    fprintf(stderr, "socket path too long: %s\n", path.c_str());
+    return 1;
+  }
+  std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
 
-/** @brief Global target register manager (initialised in main) */
-frame::RegManager *reg_manager;
-/** @brief Global list of compiled fragments (ProcFrag and StringFrag) */
-frame::Frags *frags;
+  // Replace the socket of an earlier server, but nothing else
+  struct stat st;
+  if (::lstat(path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode))
+    ::unlink(path.c_str());
+
+  int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listener < 0 ||
+      ::bind(listener, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0 ||
+      ::listen(listener, SOMAXCONN) < 0) {
+    perror(path.c_str());
+    return 1;
+  }
+  // A client that hangs up early must not kill a worker
+  signal(SIGPIPE, SIG_IGN);
+  // Interrupt waitpid() below rather than restart it
+  struct sigaction stop = {};
+  stop.sa_handler = StopServing;
+  sigaction(SIGINT, &stop, nullptr);
+  sigaction(SIGTERM, &stop, nullptr);
+
+  int workers = std::max(jobs, 1);
+#ifndef NDEBUG
+  // The phase logs go to stdout and must not interleave
+  workers = 1;
+#endif
+  std::set<pid_t> running;
+  for (int w = 0; w < workers; ++w)
+    if (pid_t pid = StartWorker(listener, options, request_seconds); pid > 0)
+      running.insert(pid);
+
+  bool failed = static_cast<int>(running.size()) < workers;
+  bool stopping = false;
+  while (!running.empty()) {
+    if (stop_serving && !stopping) {
+      stopping = true;
+      for (pid_t pid : running)
+        ::kill(pid, SIGTERM);
+    }
+    int status;
+    pid_t pid = ::waitpid(-1, &status, 0);
+    if (pid < 0) {
+      if (errno == EINTR)
+        continue;
+      perror("waitpid");
+      failed = true;
+      break;
+    }
+    running.erase(pid);
+    if (stopping || failed)
+      continue;
+    if (WIFSIGNALED(status)) {
+      fprintf(stderr, "server worker killed by signal %d\n", WTERMSIG(status));
+    } else if (WEXITSTATUS(status) != 0) {
+      failed = true; // The socket itself has failed
+      continue;
+    }
+    if (pid_t worker = StartWorker(listener, options, request_seconds); worker > 0)
+      running.insert(worker);
+  }
+  ::close(listener);
+  ::unlink(path.c_str());
+  return failed ? 1 : 0;
+}
+
+} // namespace
 
 int main(int argc, char **argv) {
-  std::string_view fname;
-  std::unique_ptr<absyn::AbsynTree> absyn_tree;
-  frags = new frame::Frags();
+  std::vector<std::string> fnames;
   frame::TargetArch target = frame::DetectHostTarget();
   bool emit_binary = false;
   std::string output_path;
+  std::string socket_path;
+  std::string cache_dir;
+  bool cache_stats = false;
+  bool time_passes = false;
+  bool time_hardware = false;
+  std::string trace_path;
+  bool print_stats = false;
+  std::string stats_path;
+  bool alloc_profile = false;
+  int max_regalloc_rounds = 0;
+  unsigned request_seconds = REQUEST_SECONDS;
+  int jobs = 1;
 
   if (argc < 2) {
     fprintf(stderr,
             "usage: tiger-compiler [--target <target>] [--emit-binary] "
-            "[-o output] file.tig\n");
+            "[-o output] [-j N]\n"
+            "                      [--cache dir] [--cache-stats] "
+            "[--time-passes[=hw]]\n"
+            "                      [--time-trace file.json] [--stats] "
+            "[--stats-json file.json]\n"
+            "                      [--alloc-profile] [--max-regalloc-rounds N] "
+            "file.tig...\n"
+            "       tiger-compiler [--target <target>] [-j N] [--cache dir] "
+            "[--request-timeout seconds]\n"
+            "                      --serve socket\n");
     exit(1);
   }
 
@@ -69,6 +482,77 @@ int main(int argc, char **argv) {
       ++i;
       continue;
     }
+    if (arg == "--serve") {
+      if (i + 1 >= argc) {
+        fprintf(stderr, "--serve requires a socket path\n");
+        return 1;
+      }
+      socket_path = argv[++i];
+      continue;
+    }
+    if (arg == "--request-timeout") {
+      std::string_view count = i + 1 < argc ? argv[++i] : "";
+      auto [end, ec] = std::from_chars(count.data(), count.data() + count.size(),
+                                       request_seconds);
+      if (count.empty() || ec != std::errc() || end != count.data() + count.size() ||
+          request_seconds < 1) {
+        fprintf(stderr, "--request-timeout requires a positive number\n");
+        return 1;
+      }
+      continue;
+    }
+    if (arg == "--cache") {
+      if (i + 1 >= argc) {
+        fprintf(stderr, "--cache requires a directory\n");
+        return 1;
+      }
+      cache_dir = argv[++i];
+      continue;
+    }
+    if (arg == "--cache-stats") {
+      cache_stats = true;
+      continue;
+    }
+    if (arg == "--time-passes" || arg == "--time-passes=hw") {
+      time_passes = true;
+      time_hardware = arg == "--time-passes=hw";
+      continue;
+    }
+    if (arg == "--time-trace") {
+      if (i + 1 >= argc) {
+        fprintf(stderr, "--time-trace requires an output path\n");
+        return 1;
+      }
+      trace_path = argv[++i];
+      continue;
+    }
+    if (arg == "--stats") {
+      print_stats = true;
+      continue;
+    }
+    if (arg == "--alloc-profile") {
+      alloc_profile = true;
+      continue;
+    }
+    if (arg == "--stats-json") {
+      if (i + 1 >= argc) {
+        fprintf(stderr, "--stats-json requires an output path\n");
+        return 1;
+      }
+      stats_path = argv[++i];
+      continue;
+    }
+    if (arg == "--max-regalloc-rounds") {
+      std::string_view count = i + 1 < argc ? argv[++i] : "";
+      auto [end, ec] = std::from_chars(count.data(), count.data() + count.size(),
+                                       max_regalloc_rounds);
+      if (count.empty() || ec != std::errc() || end != count.data() + count.size() ||
+          max_regalloc_rounds < 1) {
+        fprintf(stderr, "--max-regalloc-rounds requires a positive number\n");
+        return 1;
+      }
+      continue;
+    }
     if (arg == "-o") {
       if (i + 1 >= argc) {
         fprintf(stderr, "-o requires an output path\n");
@@ -77,75 +561,109 @@ int main(int argc, char **argv) {
       output_path = argv[++i];
       continue;
     }
-    fname = arg;
+    if (arg.substr(0, 2) == "-j") {
+      std::string_view count = arg.substr(2);
+      if (count.empty() && i + 1 < argc)
+        count = argv[++i];
+      auto [end, ec] = std::from_chars(count.data(), count.data() + count.size(), jobs);
+      if (count.empty() || ec != std::errc() || end != count.data() + count.size() ||
+          jobs < 1) {
+        fprintf(stderr, "-j requires a positive number of jobs\n");
+        return 1;
+      }
+      continue;
+    }
+    fnames.emplace_back(arg);
+  }
+
+  if (!socket_path.empty()) {
+    if (!fnames.empty() || emit_binary || !output_path.empty()) {
+      fprintf(stderr, "--serve takes no source files, -o or --emit-binary\n");
+      return 1;
+    }
+    if (time_passes || !trace_path.empty() || print_stats ||
+        !stats_path.empty() || alloc_profile) {
+      fprintf(stderr, "--serve reports phase times with each reply; "
+                      "--time-passes, --time-trace, --stats, --stats-json "
+                      "and --alloc-profile cannot be used\n");
+      return 1;
+    }
+    driver::Options options{target, 1, cache_dir};
+    options.max_regalloc_rounds_ = max_regalloc_rounds;
+    return Serve(socket_path, options, jobs, request_seconds);
   }
 
-  if (fname.empty()) {
+  if (fnames.empty()) {
     fprintf(stderr, "missing Tiger source file\n");
     return 1;
   }
+  if (fnames.size() > 1 && !output_path.empty()) {
+    fprintf(stderr, "-o cannot be used with more than one source file\n");
+    return 1;
+  }
 
-  frame::SetCurrentTarget(target);
-  reg_manager = frame::NewRegManagerForTarget(target);
-
-  {
-    std::unique_ptr<err::ErrorMsg> errormsg;
-
-    {
-      // Lab 3: parsing
-      // TigerLog("-------====Parse=====-----\n");
-      absyn_tree = Parse(std::string(fname));
-      errormsg = std::unique_ptr<err::ErrorMsg>(GetErrorMsg());
-    }
-
-    {
-      // Lab 4: semantic analysis
-      TigerLog("-------====Semantic analysis=====-----\n");
-      sem::ProgSem prog_sem(std::move(absyn_tree), std::move(errormsg));
-      prog_sem.SemAnalyze();
-      absyn_tree = prog_sem.TransferAbsynTree();
-      errormsg = prog_sem.TransferErrormsg();
-    }
+  // Allocations are charged to the pass timed when they are made
+  if (alloc_profile) {
+    util::AllocProfile::Enable();
+    std::atexit([] { util::AllocProfile::Print(stderr); });
+  }
 
-    {
-      // Lab 5: escape analysis
-      TigerLog("-------====Escape analysis=====-----\n");
-      esc::EscFinder esc_finder(std::move(absyn_tree));
-      esc_finder.FindEscape();
-      absyn_tree = esc_finder.TransferAbsynTree();
-    }
+  // One timer for all files
+  std::unique_ptr<util::PassTimer> pass_timer;
+  if (time_passes || !trace_path.empty() || alloc_profile)
+    pass_timer = std::make_unique<util::PassTimer>(time_hardware);
 
-    {
-      // Lab 5: translate IR tree
-      TigerLog("-------====Translate=====-----\n");
-      tr::ProgTr prog_tr(std::move(absyn_tree), std::move(errormsg));
-      prog_tr.Translate();
-      errormsg = prog_tr.TransferErrormsg();
-    }
+  bool stats = print_stats || !stats_path.empty();
+  std::vector<std::vector<util::FunctionStats>> functions(fnames.size());
 
-    if (errormsg->AnyErrors())
-      return 1; // Don't continue if error occurrs
-  }
+  driver::Options options{target, jobs, cache_dir, pass_timer.get(), stats};
+  options.max_regalloc_rounds_ = max_regalloc_rounds;
 
-  {
-    // Output assembly
-    output::AssemGen assem_gen(fname);
-    assem_gen.GenAssem(true);
+  bool ok;
+  if (fnames.size() == 1) {
+    ok = CompileFile(fnames.front(), options, emit_binary, output_path,
+                     &functions.front());
+  } else {
+    // Compile whole files side by side, each with a serial back end
+    int threads = util::UsableThreads(jobs);
+#ifndef NDEBUG
+    // The phase logs go to stdout and must not interleave
+    threads = 1;
+#endif
+    std::atomic<bool> failed(false);
+    util::OrderedPool pool(threads, threads);
+    options.jobs_ = 1;
+    for (size_t i = 0; i < fnames.size(); ++i)
+      pool.Submit(
+          [&, i] {
+            if (!CompileFile(fnames[i], options, emit_binary, output_path,
+                             &functions[i]))
+              failed = true;
+          },
+          [] {});
+    pool.Finish();
+    ok = !failed;
   }
 
-  if (emit_binary) {
-    std::string source = std::string(fname);
-    std::string binary = output_path.empty() ? source + ".bin" : output_path;
-    std::string command = "clang ";
-    if (target == frame::TargetArch::Arm64Apple)
-      command += "-arch arm64 ";
-    command += source + ".s src/tiger/runtime/runtime.c -o " + binary;
-    if (std::system(command.c_str()) != 0) {
-      fprintf(stderr, "failed to link binary with command: %s\n",
-              command.c_str());
-      return 1;
+  if (cache_stats)
+    fprintf(stderr, "cache: %lld hits, %lld misses\n", cache_hits.load(),
+            cache_misses.load());
+  if (time_passes)
+    driver::PrintPassTimes(stderr, *pass_timer);
+  if (stats) {
+    std::vector<util::FunctionStats> all;
+    for (std::vector<util::FunctionStats> &file : functions)
+      std::move(file.begin(), file.end(), std::back_inserter(all));
+    if (print_stats)
+      driver::PrintStats(stderr, all);
+    if (!stats_path.empty() && !driver::WriteStats(stats_path, all)) {
+      fprintf(stderr, "cannot write %s\n", stats_path.c_str());
+      ok = false;
     }
   }
-
-  return 0;
+  if (!trace_path.empty() && !driver::WritePassTrace(trace_path, *pass_timer)) {
+    fprintf(stderr, "cannot write %s\n", trace_path.c_str());
+    ok = false;
+  }
+  return ok ? 0 : 1;
 }
@@ -1,21 +1,17 @@
 #include "tiger/absyn/absyn.h"
 #include "tiger/escape/escape.h"
-#include "tiger/frame/target.h"
+#include "tiger/frame/compilation.h"
 #include "tiger/output/logger.h"
 #include "tiger/output/output.h"
 #include "tiger/parse/parser.h"
 #include "tiger/translate/translate.h"
 #include "tiger/semant/semant.h"
 
-frame::RegManager *reg_manager;
-frame::Frags *frags;
-
 int main(int argc, char **argv) {
   std::string_view fname;
   std::unique_ptr<absyn::AbsynTree> absyn_tree;
-  frame::SetCurrentTarget(frame::DetectHostTarget());
-  reg_manager = frame::NewRegManagerForTarget(frame::GetCurrentTarget());
-  frags = new frame::Frags();
+  frame::Compilation compilation(frame::DetectHostTarget());
+  frame::Compilation::Scope scope(&compilation);
 
   if (argc < 2) {
     fprintf(stderr, "usage: tiger-compiler file.tig\n");
@@ -30,8 +26,8 @@ int main(int argc, char **argv) {
     {
       // Lab 3: parsing
       // TigerLog("-------====Parse=====-----\n");
-      absyn_tree = Parse(std::string(fname));
-      errormsg = std::unique_ptr<err::ErrorMsg>(GetErrorMsg());
+      errormsg = std::make_unique<err::ErrorMsg>(fname);
+      absyn_tree = Parse(std::string(fname), errormsg.get());
     }
 
     {
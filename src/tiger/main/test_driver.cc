@@ -0,0 +1,72 @@
+/**
+ * @file test_driver.cc
+ * @brief Checks of libtiger through driver::Compiler
+ *
+ * Compiles programs held in memory with one Compiler and checks what
+ * comes back.  Prints the checks that fail and exits non-zero if any did.
+ */
+
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+#include "tiger/driver/driver.h"
+
+namespace {
+
+int failures = 0;
+
+void Check(bool ok, std::string_view what, const driver::Result &result) {
+  if (ok)
+    return;
+  ++failures;
+  fprintf(stderr, "FAIL %.*s: ok_ %d, %zu diagnostics\n",
+          static_cast<int>(what.size()), what.data(), result.ok_,
+          result.diagnostics_.size());
+  for (const err::Diagnostic &diagnostic : result.diagnostics_)
+    fprintf(stderr, "  %s\n", driver::Format("input.tig", diagnostic).c_str());
+}
+
+/** @brief @p source has one error, whose message is @p message */
+void CheckOneError(driver::Compiler *compiler, std::string_view what,
+                   std::string_view source, std::string_view message) {
+  std::string assembly;
+  driver::Result result = compiler->Compile(source, &assembly);
+  Check(!result.ok_ && result.diagnostics_.size() == 1 &&
+            result.diagnostics_[0].message_ == message && assembly.empty(),
+        what, result);
+}
+
+} // namespace
+
+int main() {
+  driver::Compiler compiler;
+
+  CheckOneError(&compiler, "unterminated string",
+                "let var s := \"abc in s end\n", "unterminated string");
+  CheckOneError(&compiler, "unterminated comment",
+                "let var s := 1 /* never closed\n in s end\n",
+                "unterminated comment");
+
+  // One error for each undefined variable, more of them than are kept
+  std::string undefined = "(";
+  for (size_t i = 0; i < 2 * err::ErrorMsg::MAX_DIAGNOSTICS; ++i)
+    undefined += "x" + std::to_string(i) + ";";
+  undefined += "0)\n";
+  std::string assembly;
+  driver::Result result = compiler.Compile(undefined, &assembly);
+  Check(!result.ok_ &&
+            result.diagnostics_.size() == err::ErrorMsg::MAX_DIAGNOSTICS + 1 &&
+            result.diagnostics_.back().message_ == "too many errors",
+        "too many errors", result);
+
+  // The same Compiler goes on to compile a correct program
+  result = compiler.Compile("let function f(n: int): int = n + 1 in f(41) end\n",
+                            &assembly);
+  Check(result.ok_ && result.diagnostics_.empty() && !assembly.empty(),
+        "program after errors", result);
+
+  if (failures == 0)
+    printf("driver: all checks passed\n");
+  return failures == 0 ? 0 : 1;
+}
@@ -6,14 +6,6 @@
 #include "parse.tab.hh"
 #include "tiger/errormsg/errormsg.h"
 #include "tiger/symbol/symbol.h"
-#include "tiger/frame/frame.h"
-
-// Define here to pass compilation, but no use here
-frame::RegManager *reg_manager;
-frame::Frags frags;
-
-extern YYSTYPE yylcval;
-extern FILE *yyin;
 
 int main(int argc, char **argv) {
   std::map<int, std::string_view> tokname = {{ID, "ID"},
@@ -65,20 +57,24 @@ int main(int argc, char **argv) {
     exit(1);
   }
 
-  yyin = fopen(argv[1], "r");
-  if (!yyin) {
+  FILE *in = fopen(argv[1], "r");
+  if (!in) {
     fprintf(stderr, "Could not open file %s\n", argv[1]);
     exit(1);
   }
 
   auto errormsg = std::make_unique<err::ErrorMsg>(std::string(argv[1]));
-  InitLexer(errormsg.get());
+  LexState lex_state(errormsg.get());
+  yyscan_t scanner;
+  yylex_init_extra(&lex_state, &scanner);
+  yyset_in(in, scanner);
 
-  while (int tok = yylex()) {
+  YYSTYPE yylval;
+  while (int tok = yylex(&yylval, scanner)) {
     switch (tok) {
     case ID:
       printf("%10s %4d %s\n", tokname[tok].data(), errormsg->GetTokPos(),
-             yylval.sym ? yylval.sym->Name().c_str() : "(null)");
+             yylval.sym ? yylval.sym->Name().data() : "(null)");
       break;
     case STRING:
       printf("%10s %4d %s\n", tokname[tok].data(), errormsg->GetTokPos(),
@@ -93,7 +89,8 @@ int main(int argc, char **argv) {
     }
   }
   
-  fclose(yyin);
+  yylex_destroy(scanner);
+  fclose(in);
   
   // Return non-zero exit code if there were any errors
   return errormsg->AnyErrors() ? 1 : 0;
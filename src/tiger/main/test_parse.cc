@@ -2,12 +2,8 @@
 #include <fstream>
 
 #include "tiger/absyn/absyn.h"
+#include "tiger/errormsg/errormsg.h"
 #include "tiger/parse/parser.h"
-#include "tiger/frame/frame.h"
-
-// define here to parse compilation
-frame::RegManager *reg_manager;
-frame::Frags frags;
 
 int main(int argc, char **argv) {
   std::unique_ptr<absyn::AbsynTree> absyn_tree;
@@ -17,13 +13,13 @@ int main(int argc, char **argv) {
     exit(1);
   }
 
-  absyn_tree = Parse(std::string(argv[1]));
+  auto errormsg = std::make_unique<err::ErrorMsg>(argv[1]);
+  absyn_tree = Parse(std::string(argv[1]), errormsg.get());
   if (absyn_tree) {
     absyn_tree->Print(stderr);
     fprintf(stderr, "\n");
   }
   
   // Check for parsing errors and return appropriate exit code
-  auto errormsg = GetErrorMsg();
-  return (errormsg && errormsg->AnyErrors()) ? 1 : 0;
+  return errormsg->AnyErrors() ? 1 : 0;
 }
@@ -6,15 +6,10 @@
 #include "tiger/errormsg/errormsg.h"
 #include "tiger/parse/parser.h"
 #include "tiger/semant/semant.h"
-#include "tiger/frame/frame.h"
-
-// define here to pass compilation
-frame::RegManager *reg_manager;
-frame::Frags *frags;
 
 int main(int argc, char **argv) {
   std::unique_ptr<absyn::AbsynTree> absyn_tree;
-  err::ErrorMsg *errormsg;
+  std::unique_ptr<err::ErrorMsg> errormsg;
 
   if (argc < 2) {
     fprintf(stderr, "usage: a.out filename\n");
@@ -22,15 +17,16 @@ int main(int argc, char **argv) {
   }
 
   {
-    absyn_tree = Parse(std::string(argv[1]));
-    errormsg = GetErrorMsg();
+    errormsg = std::make_unique<err::ErrorMsg>(argv[1]);
+    absyn_tree = Parse(std::string(argv[1]), errormsg.get());
   }
 
-  if (absyn_tree && errormsg) {
-    sem::ProgSem program_Semanalyzer(std::move(absyn_tree), std::unique_ptr<err::ErrorMsg>(errormsg));
+  if (absyn_tree) {
+    sem::ProgSem program_Semanalyzer(std::move(absyn_tree), std::move(errormsg));
     program_Semanalyzer.SemAnalyze();
+    errormsg = program_Semanalyzer.TransferErrormsg();
   }
   
   // Check for parsing/semantic errors and return appropriate exit code
-  return (errormsg && errormsg->AnyErrors()) ? 1 : 0;
+  return errormsg->AnyErrors() ? 1 : 0;
 }
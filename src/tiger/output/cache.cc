@@ -0,0 +1,295 @@
+#include "tiger/output/cache.h"
+
+#include <cctype>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "tiger/frame/compilation.h"
+#include "tiger/translate/tree.h"
+
+namespace {
+
+/// Bumped whenever the format of keys or entries changes
+constexpr int CACHE_VERSION = 1;
+
+/// Characters of a label name as it appears in assembly
+bool IsWordChar(char c) {
+  return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '.' ||
+         c == '$';
+}
+
+/**
+ * @brief Copy @p text to @p out, replacing every word found in @p names
+ * @return false if some word that is not in @p names looks like the name
+ *         of an anonymous label ("L" and a digit), when @p strict
+ */
+template <typename Names>
+bool ReplaceWords(std::string_view text, const Names &names, std::string *out,
+                  bool strict) {
+  out->reserve(out->size() + text.size());
+  size_t i = 0;
+  while (i < text.size()) {
+    if (!IsWordChar(text[i])) {
+      size_t start = i;
+      while (i < text.size() && !IsWordChar(text[i]))
+        ++i;
+      out->append(text.substr(start, i - start));
+      continue;
+    }
+    size_t start = i;
+    while (i < text.size() && IsWordChar(text[i]))
+      ++i;
+    std::string_view word = text.substr(start, i - start);
+    auto it = names.find(word);
+    if (it != names.end()) {
+      out->append(it->second);
+    } else {
+      if (strict && word.size() > 1 && word[0] == 'L' &&
+          std::isdigit(static_cast<unsigned char>(word[1])))
+        return false;
+      out->append(word);
+    }
+  }
+  return true;
+}
+
+/// 64-bit FNV-1a hash of @p a followed by @p b
+unsigned long long Hash(std::string_view a, std::string_view b) {
+  unsigned long long h = 14695981039346656037ULL;
+  for (std::string_view s : {a, b})
+    for (char c : s) {
+      h ^= static_cast<unsigned char>(c);
+      h *= 1099511628211ULL;
+    }
+  return h;
+}
+
+/// The cache format and the size and time of the running executable
+std::string BuildStamp() {
+  std::string stamp = "tiger-cache " + std::to_string(CACHE_VERSION);
+  struct stat st;
+  if (::stat("/proc/self/exe", &st) == 0)
+    stamp += " " + std::to_string(st.st_size) + " " +
+             std::to_string(st.st_mtime);
+  return stamp + "\n";
+}
+
+/// Create @p dir and its parents, as far as they do not exist
+void CreateDirectories(const std::string &dir) {
+  for (size_t slash = dir.find('/', 1); slash != std::string::npos;
+       slash = dir.find('/', slash + 1))
+    ::mkdir(dir.substr(0, slash).c_str(), 0777);
+  ::mkdir(dir.c_str(), 0777);
+}
+
+} // namespace
+
+namespace output {
+
+IrEncoder::IrEncoder(frame::Frame *frame) : frame_(frame) {
+  Put(frame::TargetName(frame::GetCurrentTarget()));
+  Put(frame->local_count_);
+  Put(frame->max_outgoing_args_);
+  // The function's own label comes first, so it is L0 if anonymous; its
+  // frame-size label is named after it
+  Put(frame->name_);
+  if (frame->name_->Fresh()) {
+    std::string &name = renamed_[frame->frame_size_->Name()];
+    name = std::string(NameOf(frame->name_)) + "_framesize";
+    restored_[name] = frame->frame_size_->Name();
+    frame_size_ = name;
+  } else {
+    frame_size_ = frame->frame_size_->Name();
+  }
+}
+
+void IrEncoder::Put(std::string_view word) {
+  key_ += word;
+  key_ += ' ';
+}
+
+void IrEncoder::Put(int n) {
+  char digits[16];
+  char *end = std::to_chars(digits, digits + sizeof(digits), n).ptr;
+  Put(std::string_view(digits, end - digits));
+}
+
+void IrEncoder::Put(temp::Temp *t) {
+  if (std::string *reg = reg_manager->temp_map_->Look(t)) {
+    Put(*reg);
+    return;
+  }
+  auto [it, inserted] = temps_.emplace(t, static_cast<int>(temps_.size()));
+  key_ += 't';
+  Put(it->second);
+}
+
+void IrEncoder::Put(temp::Label *label) {
+  if (label == frame_->frame_size_)
+    Put(frame_size_);
+  else
+    Put(NameOf(label));
+}
+
+std::string_view IrEncoder::NameOf(temp::Label *label) {
+  if (!label->Fresh())
+    return label->Name();
+  auto [it, inserted] = labels_.emplace(label, static_cast<int>(labels_.size()));
+  std::string &name = renamed_[label->Name()];
+  if (inserted) {
+    name = "L" + std::to_string(it->second);
+    restored_[name] = label->Name();
+  }
+  return name;
+}
+
+bool IrEncoder::Rename(std::string_view assembly, std::string *renamed) const {
+  return ReplaceWords(assembly, renamed_, renamed, true);
+}
+
+void IrEncoder::Restore(std::string_view renamed, std::string *assembly) const {
+  ReplaceWords(renamed, restored_, assembly, false);
+}
+
+FunctionCache::FunctionCache(std::string dir)
+    : dir_(std::move(dir)), stamp_(BuildStamp()) {
+  CreateDirectories(dir_);
+}
+
+std::string FunctionCache::PathOf(const std::string &key) const {
+  char name[17];
+  snprintf(name, sizeof(name), "%016llx", Hash(stamp_, key));
+  return dir_ + "/" + name;
+}
+
+bool FunctionCache::Lookup(const std::string &key, std::string *assembly) {
+  // An entry is the stamp and the key, then the assembly
+  std::string entry;
+  if (FILE *in = fopen(PathOf(key).c_str(), "rb")) {
+    char buf[64 * 1024];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), in)) > 0)
+      entry.append(buf, n);
+    if (ferror(in))
+      entry.clear();
+    fclose(in);
+  }
+
+  std::string_view rest(entry);
+  if (rest.substr(0, stamp_.size()) == stamp_ &&
+      rest.substr(stamp_.size(), key.size()) == key &&
+      rest.substr(stamp_.size() + key.size(), 1) == "\n") {
+    assembly->assign(rest.substr(stamp_.size() + key.size() + 1));
+    ++hits_;
+    return true;
+  }
+  ++misses_;
+  return false;
+}
+
+void FunctionCache::Store(const std::string &key, std::string_view assembly) {
+  std::string path = PathOf(key);
+  std::string temp_path = path + "." + std::to_string(::getpid()) + "." +
+                          std::to_string(temp_id_++) + ".tmp";
+  FILE *out = fopen(temp_path.c_str(), "wb");
+  if (!out)
+    return;
+  fwrite(stamp_.data(), 1, stamp_.size(), out);
+  fwrite(key.data(), 1, key.size(), out);
+  fputc('\n', out);
+  fwrite(assembly.data(), 1, assembly.size(), out);
+  bool ok = !ferror(out);
+  if (fclose(out) != 0 || !ok || std::rename(temp_path.c_str(), path.c_str()) != 0)
+    std::remove(temp_path.c_str());
+}
+
+} // namespace output
+
+namespace tree {
+
+void SeqStm::Encode(output::IrEncoder &encoder) const {
+  encoder.Put("SEQ");
+  left_->Encode(encoder);
+  right_->Encode(encoder);
+}
+
+void LabelStm::Encode(output::IrEncoder &encoder) const {
+  encoder.Put("LABEL");
+  encoder.Put(label_);
+}
+
+void JumpStm::Encode(output::IrEncoder &encoder) const {
+  encoder.Put("JUMP");
+  exp_->Encode(encoder);
+  encoder.Put(static_cast<int>(jumps_->size()));
+  for (temp::Label *label : *jumps_)
+    encoder.Put(label);
+}
+
+void CjumpStm::Encode(output::IrEncoder &encoder) const {
+  encoder.Put("CJUMP");
+  encoder.Put(op_);
+  left_->Encode(encoder);
+  right_->Encode(encoder);
+  encoder.Put(true_label_);
+  encoder.Put(false_label_);
+}
+
+void MoveStm::Encode(output::IrEncoder &encoder) const {
+  encoder.Put("MOVE");
+  dst_->Encode(encoder);
+  src_->Encode(encoder);
+}
+
+void ExpStm::Encode(output::IrEncoder &encoder) const {
+  encoder.Put("EXP");
+  exp_->Encode(encoder);
+}
+
+void BinopExp::Encode(output::IrEncoder &encoder) const {
+  encoder.Put("BINOP");
+  encoder.Put(op_);
+  left_->Encode(encoder);
+  right_->Encode(encoder);
+}
+
+void MemExp::Encode(output::IrEncoder &encoder) const {
+  encoder.Put("MEM");
+  exp_->Encode(encoder);
+}
+
+void TempExp::Encode(output::IrEncoder &encoder) const {
+  encoder.Put("TEMP");
+  encoder.Put(temp_);
+}
+
+void EseqExp::Encode(output::IrEncoder &encoder) const {
+  encoder.Put("ESEQ");
+  stm_->Encode(encoder);
+  exp_->Encode(encoder);
+}
+
+void NameExp::Encode(output::IrEncoder &encoder) const {
+  encoder.Put("NAME");
+  encoder.Put(name_);
+}
+
+void ConstExp::Encode(output::IrEncoder &encoder) const {
+  encoder.Put("CONST");
+  encoder.Put(consti_);
+}
+
+void CallExp::Encode(output::IrEncoder &encoder) const {
+  encoder.Put("CALL");
+  fun_->Encode(encoder);
+  const std::list<Exp *> &args = args_->GetList();
+  encoder.Put(static_cast<int>(args.size()));
+  for (Exp *arg : args)
+    arg->Encode(encoder);
+}
+
+} // namespace tree
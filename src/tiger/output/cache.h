@@ -0,0 +1,135 @@
+/**
+ * @file cache.h
+ * @brief On-disk cache of the assembly of single functions
+ *
+ * A rebuild after a small edit changes few functions, yet the back end
+ * would compile every one of them again.  With a FunctionCache,
+ * ProcFrag::OutputAssem() first looks up the function's assembly and
+ * only runs code generation and register allocation if it is not there.
+ *
+ * A function is looked up by its key: the text of its canonical trees,
+ * written by IrEncoder, together with what else its assembly depends on
+ * (the target, the frame's slots and whether registers are allocated).
+ * The key does not name temps and anonymous labels by number, since
+ * those numbers change whenever an earlier function of the program does:
+ * temps are numbered in order of first appearance in the function,
+ * machine registers are named, and anonymous labels (including the
+ * function's own) are renamed L0, L1, … in order of appearance.  The back
+ * end only compares temps and labels for identity, so two functions with
+ * the same key compile to the same assembly but for the names of those
+ * labels.  The cache holds the assembly with the renamed labels; the
+ * IrEncoder of the function at hand renames them back.
+ *
+ * Entries are files named by a 64-bit hash of the key, holding the key
+ * itself so that a hash collision is a miss.  They are written to a
+ * temporary file and renamed into place, so any number of threads and
+ * processes can share one cache directory.  The key also holds the size
+ * and time of the compiler executable, so a rebuilt compiler does not
+ * reuse the assembly of its predecessor.
+ *
+ * Only allocated functions are cached: without register allocation the
+ * assembly names temps by number.
+ */
+
+#ifndef TIGER_OUTPUT_CACHE_H_
+#define TIGER_OUTPUT_CACHE_H_
+
+#include <atomic>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "tiger/frame/frame.h"
+#include "tiger/frame/temp.h"
+
+namespace output {
+
+/**
+ * @brief Writes the key of one function and renames its labels
+ *
+ * The tree nodes write themselves with tree::Stm::Encode() and
+ * tree::Exp::Encode(); the words they write are separated by spaces.
+ */
+class IrEncoder {
+public:
+  /** @brief Start the key of the function of @p frame */
+  explicit IrEncoder(frame::Frame *frame);
+  IrEncoder(const IrEncoder &) = delete;
+  IrEncoder &operator=(const IrEncoder &) = delete;
+
+  /** @brief Write @p word, which must not contain spaces */
+  void Put(std::string_view word);
+  void Put(int n);
+  void Put(temp::Temp *t);
+  void Put(temp::Label *label);
+
+  /** @brief The key written so far */
+  [[nodiscard]] const std::string &Key() const { return key_; }
+
+  /**
+   * @brief Copy @p assembly of this function to @p renamed, with its
+   *        anonymous labels renamed as in the key
+   * @return false if the assembly names an anonymous label that does not
+   *         occur in the key, so that it cannot be cached
+   */
+  bool Rename(std::string_view assembly, std::string *renamed) const;
+
+  /** @brief Undo Rename() on the assembly of a function with this key */
+  void Restore(std::string_view renamed, std::string *assembly) const;
+
+private:
+  std::string key_;
+  frame::Frame *frame_;
+  std::unordered_map<temp::Temp *, int> temps_;   ///< Temp → order of appearance
+  std::unordered_map<temp::Label *, int> labels_; ///< Anonymous label → order of appearance
+  std::unordered_map<std::string_view, std::string> renamed_;       ///< Label name → name in key
+  std::unordered_map<std::string_view, std::string_view> restored_; ///< Name in key → label name
+  std::string_view frame_size_;         ///< Name of the frame-size label in the key
+
+  /** @brief Name of @p label in the key */
+  std::string_view NameOf(temp::Label *label);
+};
+
+/**
+ * @brief A directory of function assembly, shared by compilations
+ *
+ * Lookup() and Store() may be called from any number of threads.
+ */
+class FunctionCache {
+public:
+  /// Hits and misses since the cache was opened
+  struct Stats {
+    long long hits_ = 0;
+    long long misses_ = 0;
+  };
+
+  /** @brief Use the directory @p dir, creating it if need be */
+  explicit FunctionCache(std::string dir);
+  FunctionCache(const FunctionCache &) = delete;
+  FunctionCache &operator=(const FunctionCache &) = delete;
+
+  /**
+   * @brief Find the assembly stored under @p key
+   * @return Whether it was found; counted as a hit or a miss
+   */
+  bool Lookup(const std::string &key, std::string *assembly);
+
+  /** @brief Store @p assembly under @p key; failures are ignored */
+  void Store(const std::string &key, std::string_view assembly);
+
+  [[nodiscard]] Stats GetStats() const { return {hits_, misses_}; }
+
+private:
+  std::string dir_;
+  std::string stamp_;                   ///< Identifies the compiler build
+  std::atomic<long long> hits_{0};
+  std::atomic<long long> misses_{0};
+  std::atomic<unsigned> temp_id_{0};    ///< Names temporary files
+
+  /** @brief Path of the entry for @p key */
+  [[nodiscard]] std::string PathOf(const std::string &key) const;
+};
+
+} // namespace output
+
+#endif // TIGER_OUTPUT_CACHE_H_
@@ -26,7 +26,8 @@ public:
       stm_list->Print(out_);
   }
   inline void Log(cg::AssemInstr *instr_list, temp::Map *map) const {
-    instr_list->Print(out_, map);
+    util::Writer out(out_);
+    instr_list->Print(out, map);
   }
 
 private:
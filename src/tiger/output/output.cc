@@ -11,6 +11,10 @@
  *   4. Generate prologue/epilogue via ProcEntryExit3
  *   5. Write the complete function assembly to the output file
  *
+ * If the current compilation has a function cache (see cache.h), steps 2-4
+ * are skipped for a function whose assembly is found there, and the
+ * assembly of any other allocated function is added to it.
+ *
  * For StringFrag (string literals):
  *   - Write label + length word + string content to .rodata section
  *
@@ -21,47 +25,100 @@
  * String layout in memory:
  *   [4-byte length][character data...]
  * This allows O(1) string length queries by the runtime library.
+ *
+ * With more than one job, steps 2-5 of different functions run on a pool
+ * of threads.  Each function is canonicalized when it is emitted, on the
+ * emitting thread, because that is where the back end makes new labels and
+ * their numbers must not depend on scheduling.  Its assembly is then
+ * written to a string of its own and the strings are appended to the
+ * output file in emission order, so the file is the same whatever the
+ * number of jobs.  The workers enter the emitting thread's compilation, so
+ * that they see its register manager.
  */
 
 #include "tiger/output/output.h"
 
 #include <cstdio>
+#include <optional>
 
+#include "tiger/frame/compilation.h"
+#include "tiger/output/cache.h"
 #include "tiger/output/logger.h"
 
-extern frame::RegManager *reg_manager;
-extern frame::Frags *frags;
-
 namespace output {
 
-void AssemGen::GenAssem(bool need_ra) {
-  frame::Frag::OutputPhase phase;
-
+void AssemGen::GenAssem(bool need_ra, int jobs) {
   // Emit all procedure (function body) fragments into the .text section
-  phase = frame::Frag::Proc;
-  fprintf(out_, "%s\n", frame::TextSectionDirective().c_str());
+  Begin(need_ra, jobs);
   for (auto &&frag : frags->GetList())
-    frag->OutputAssem(out_, phase, need_ra);
+    if (auto *proc = dynamic_cast<frame::ProcFrag *>(frag))
+      Write(proc, nullptr); // The frags list keeps it
+  End();
+}
+
+void AssemGen::Begin(bool need_ra, int jobs) {
+  need_ra_ = need_ra;
+  out_ << frame::TextSectionDirective() << '\n';
+
+#ifndef NDEBUG
+  // The phase logs go to stdout and must not interleave
+  jobs = 1;
+#endif
+  int threads = util::UsableThreads(jobs);
+  if (threads > 1)
+    pool_ = std::make_unique<util::OrderedPool>(threads,
+                                                threads * PENDING_PER_THREAD);
+}
+
+void AssemGen::Emit(std::unique_ptr<frame::ProcFrag> frag) {
+  frame::ProcFrag *proc = frag.get();
+  Write(proc, std::shared_ptr<frame::ProcFrag>(std::move(frag)));
+}
+
+void AssemGen::Write(frame::ProcFrag *frag,
+                     std::shared_ptr<frame::ProcFrag> owner) {
+  // The back end's tree nodes do not count as the translated function's
+  util::FunctionStats::Scope not_translating(nullptr);
+
+  if (!pool_) {
+    frag->OutputAssem(out_, frame::Frag::Proc, need_ra_);
+    return;
+  }
+
+  frag->Canonicalize();
+  auto text = std::make_shared<std::string>();
+  bool need_ra = need_ra_;
+  frame::Compilation *compilation = frame::Compilation::Current();
+  // Both steps hold the owner, so the function is freed once it has been
+  // committed, or dropped by the pool after an earlier piece failed
+  pool_->Submit(
+      [frag, owner, text, need_ra, compilation] {
+        frame::Compilation::Scope scope(compilation);
+        util::Writer out(text.get());
+        frag->OutputAssem(out, frame::Frag::Proc, need_ra);
+      },
+      [this, owner, text] { out_ << *text; });
+}
+
+void AssemGen::End() {
+  if (pool_) {
+    pool_->Finish();
+    pool_.reset();
+  }
 
   // Emit all string literal fragments into the .rodata section
-  phase = frame::Frag::String;
-  fprintf(out_, "%s\n", frame::RodataSectionDirective().c_str());
+  out_ << frame::RodataSectionDirective() << '\n';
   for (auto &&frag : frags->GetList())
-    frag->OutputAssem(out_, phase, need_ra);
+    frag->OutputAssem(out_, frame::Frag::String, need_ra_);
 }
 
 } // namespace output
 
 namespace frame {
 
-void ProcFrag::OutputAssem(FILE *out, OutputPhase phase, bool need_ra) const {
-  std::unique_ptr<canon::Traces> traces;
-  std::unique_ptr<cg::AssemInstr> assem_instr;
-  std::unique_ptr<ra::Result> allocation;
-
-  // When generating proc fragment, do not output string assembly
-  if (phase != Proc)
-    return;
+void ProcFrag::Canonicalize() {
+  // Everything the back end builds for this function goes into its arena
+  util::Arena::Scope scope(arena_.get());
 
   TigerLog("-------====IR tree=====-----\n");
   TigerLog(body_);
@@ -70,33 +127,102 @@ void ProcFrag::OutputAssem(FILE *out, OutputPhase phase, bool need_ra) const {
     // Canonicalize
     TigerLog("-------====Canonicalize=====-----\n");
     canon::Canon canon(body_);
+    std::string_view name = frame_->name_->Name();
 
     // Linearize to generate canonical trees
     TigerLog("-------====Linearlize=====-----\n");
-    tree::StmList *stm_linearized = canon.Linearize();
+    tree::StmList *stm_linearized;
+    {
+      util::PassTimer::Scope pass("linearize", name);
+      stm_linearized = canon.Linearize();
+    }
     TigerLog(stm_linearized);
+    if (frame_->stats_)
+      frame_->stats_->statements_ = stm_linearized->GetList().size();
 
     // Group list into basic blocks
     TigerLog("------====Basic block_=====-------\n");
-    canon::StmListList *stm_lists = canon.BasicBlocks();
+    canon::StmListList *stm_lists;
+    {
+      util::PassTimer::Scope pass("basic blocks", name);
+      stm_lists = canon.BasicBlocks();
+    }
     TigerLog(stm_lists);
+    if (frame_->stats_)
+      frame_->stats_->blocks_ = stm_lists->GetList().size();
 
     // Order basic blocks into traces_
     TigerLog("-------====Trace=====-----\n");
-    tree::StmList *stm_traces = canon.TraceSchedule();
+    tree::StmList *stm_traces;
+    {
+      util::PassTimer::Scope pass("trace schedule", name);
+      stm_traces = canon.TraceSchedule();
+    }
     TigerLog(stm_traces);
+    if (frame_->stats_)
+      frame_->stats_->traces_ = canon.TraceCount();
 
-    traces = canon.TransferTraces();
+    traces_ = canon.TransferTraces();
   }
+  first_temp_ = temp::TempFactory::Peek();
+}
+
+void ProcFrag::OutputAssem(util::Writer &out, OutputPhase phase,
+                           bool need_ra) {
+  std::unique_ptr<cg::AssemInstr> assem_instr;
+  std::unique_ptr<ra::Result> allocation;
+
+  // When generating proc fragment, do not output string assembly
+  if (phase != Proc)
+    return;
+
+  // Whatever the passes below do not account for
+  util::PassTimer::Scope back_end("back end", frame_->name_->Name());
+
+  if (!traces_)
+    Canonicalize();
+
+  util::Arena::Scope scope(arena_.get());
+
+  // Reuse the assembly of an identical function compiled before
+  output::FunctionCache *cache = nullptr;
+  if (need_ra && Compilation::Current())
+    cache = Compilation::Current()->GetFunctionCache();
+  std::unique_ptr<output::IrEncoder> encoder;
+  if (cache) {
+    util::PassTimer::Scope pass("cache lookup");
+    encoder = std::make_unique<output::IrEncoder>(frame_);
+    for (tree::Stm *stm : traces_->GetStmList()->GetList())
+      stm->Encode(*encoder);
+    std::string cached;
+    if (cache->Lookup(encoder->Key(), &cached)) {
+      if (frame_->stats_)
+        frame_->stats_->cached_ = 1;
+      std::string assembly;
+      encoder->Restore(cached, &assembly);
+      out << assembly;
+      traces_.reset();
+      arena_->Release();
+      return;
+    }
+  }
+
+  // Temps made from here on belong to this function alone; numbering them
+  // privately keeps the output independent of which thread compiles it
+  temp::TempFactory::Scope temps(first_temp_);
 
   temp::Map *color = temp::Map::LayerMap(reg_manager->temp_map_, temp::Map::Name());
   {
     // Lab 5: code generation
     TigerLog("-------====Code generate=====-----\n");
-    cg::CodeGen code_gen(frame_, std::move(traces));
+    util::PassTimer::Scope pass("codegen");
+    cg::CodeGen code_gen(frame_, std::move(traces_));
     code_gen.Codegen();
     assem_instr = code_gen.TransferAssemInstr();
     TigerLog(assem_instr.get(), color);
+    if (frame_->stats_)
+      frame_->stats_->instructions_ =
+          assem_instr->GetInstrList()->GetList().size();
   }
 
   assem::InstrList *il = assem_instr.get()->GetInstrList();
@@ -113,52 +239,76 @@ void ProcFrag::OutputAssem(FILE *out, OutputPhase phase, bool need_ra) const {
 
   TigerLog("-------====Output assembly for %s=====-----\n",
            frame_->name_->Name().data());
+  util::PassTimer::Scope emission("emission");
            
   assem::Proc *proc = frame::ProcEntryExit3(frame_, il);
   
   std::string proc_name = frame_->GetLabel();
 
+  // A function that goes into the cache is written to a string first
+  std::string text;
+  std::optional<util::Writer> text_out;
+  if (encoder)
+    text_out.emplace(&text);
+  util::Writer &fn_out = text_out ? *text_out : out;
+
   bool export_proc = true;
   if (frame::IsArm64AppleTarget() && !proc_name.empty() && proc_name[0] == 'L')
     export_proc = false;
   if (export_proc)
-    fprintf(out, ".globl %s\n", proc_name.data());
+    fn_out << ".globl " << proc_name << '\n';
   if (frame::EmitsElfFunctionMetadata())
-    fprintf(out, ".type %s, @function\n", proc_name.data());
+    fn_out << ".type " << proc_name << ", @function\n";
   // prologue
-  fprintf(out, "%s", proc->prolog_.data());
+  fn_out << proc->prolog_;
   // body
-  proc->body_->Print(out, color);
+  proc->body_->Print(fn_out, color);
   // epilog_
-  fprintf(out, "%s", proc->epilog_.data());
+  fn_out << proc->epilog_;
   if (frame::EmitsElfFunctionMetadata())
-    fprintf(out, ".size %s, .-%s\n", proc_name.data(), proc_name.data());
+    fn_out << ".size " << proc_name << ", .-" << proc_name << '\n';
+
+  if (encoder) {
+    text_out->Flush();
+    std::string renamed;
+    if (encoder->Rename(text, &renamed))
+      cache->Store(encoder->Key(), renamed);
+    out << text;
+  }
+
+  // The function is done: drop its IR, instructions and temp lists at once
+  arena_->Release();
 }
 
-void StringFrag::OutputAssem(FILE *out, OutputPhase phase, bool need_ra) const {
+void StringFrag::OutputAssem(util::Writer &out, OutputPhase phase,
+                             bool need_ra) {
   // When generating string fragment, do not output proc assembly
   if (phase != String)
     return;
 
   if (frame::IsArm64AppleTarget())
-    fprintf(out, ".p2align 2\n");
-  fprintf(out, "%s:\n", label_->Name().data());
+    out << ".p2align 2\n";
+  out << label_->Name() << ":\n";
   int length = static_cast<int>(str_.size());
-  // It may contain zeros in the middle of string. To keep this work, we need
-  // to print all the charactors instead of using fprintf(str)
-  fprintf(out, ".long %d\n", length);
-  fprintf(out, ".string \"");
-  for (int i = 0; i < length; i++) {
-    if (str_[i] == '\n') {
-      fprintf(out, "\\n");
-    } else if (str_[i] == '\t') {
-      fprintf(out, "\\t");
-    } else if (str_[i] == '\"') {
-      fprintf(out, "\\\"");
-    } else {
-      fprintf(out, "%c", str_[i]);
-    }
+  // It may contain zeros in the middle of string, so write it by length
+  // rather than as a C string; escape only the characters that need it
+  out << ".long " << length << '\n';
+  out << ".string \"";
+  std::string_view str(str_);
+  size_t run = 0;
+  for (size_t i = 0; i < str.size(); i++) {
+    const char *escaped;
+    if (str[i] == '\n')
+      escaped = "\\n";
+    else if (str[i] == '\t')
+      escaped = "\\t";
+    else if (str[i] == '\"')
+      escaped = "\\\"";
+    else
+      continue;
+    out << str.substr(run, i - run) << escaped;
+    run = i + 1;
   }
-  fprintf(out, "\"\n");
+  out << str.substr(run) << "\"\n";
 }
 } // namespace frame
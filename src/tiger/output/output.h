@@ -22,6 +22,8 @@
 #include "tiger/codegen/codegen.h"
 #include "tiger/frame/frame.h"
 #include "tiger/regalloc/regalloc.h"
+#include "tiger/util/parallel.h"
+#include "tiger/util/writer.h"
 
 namespace output {
 
@@ -30,31 +32,66 @@ namespace output {
  * 
  * Coordinates the final phases of compilation and writes assembly output.
  * Can optionally perform register allocation or output unallocated code.
+ *
+ * Functions can be compiled all at once after translation (GenAssem()), or
+ * streamed: between Begin() and End(), each ProcFrag passed to Emit() is
+ * compiled and written out, and then deleted with its frame and arena,
+ * while the rest of the program is still being translated.  String
+ * literals are written to .rodata by End(), from the current compilation's
+ * frags list.
  */
 class AssemGen {
 public:
   AssemGen() = delete;
-  explicit AssemGen(std::string_view infile) {
-    std::string outfile = static_cast<std::string>(infile) + ".s";
-    out_ = fopen(outfile.data(), "w");
-  }
+  explicit AssemGen(std::string_view infile)
+      : out_(static_cast<std::string>(infile) + ".s") {}
+  /** @brief Append the assembly to @p sink instead of writing a file */
+  explicit AssemGen(std::string *sink) : out_(sink) {}
+  /** @brief Hand the assembly to @p sink in pieces instead of writing a file */
+  explicit AssemGen(util::Writer::Sink sink) : out_(std::move(sink)) {}
   AssemGen(const AssemGen &assem_generator) = delete;
   AssemGen(AssemGen &&assem_generator) = delete;
   AssemGen &operator=(const AssemGen &assem_generator) = delete;
   AssemGen &operator=(AssemGen &&assem_generator) = delete;
-  ~AssemGen() { fclose(out_); }
+  ~AssemGen() = default;
 
   /**
    * @brief Generate assembly code
    * @param need_ra Whether to perform register allocation
+   * @param jobs    Number of functions to compile at the same time
    * 
    * Performs canonicalization, code generation, and optionally register
-   * allocation, then writes the assembly code to the output file.
+   * allocation, then writes the assembly code to the output file.  The
+   * output does not depend on @p jobs.
    */
-  void GenAssem(bool need_ra);
+  void GenAssem(bool need_ra, int jobs = 1);
+
+  /** @brief Start the .text section; parameters as for GenAssem() */
+  void Begin(bool need_ra, int jobs = 1);
+
+  /**
+   * @brief Compile @p frag and write it after every function emitted before
+   *
+   * With more than one job this canonicalizes @p frag and queues the rest;
+   * otherwise the function has been written when Emit() returns.  Either
+   * way @p frag is deleted once its assembly has been written, or once it
+   * is known that it never will be.
+   */
+  void Emit(std::unique_ptr<frame::ProcFrag> frag);
+
+  /** @brief Wait for every emitted function, then write the string literals */
+  void End();
 
 private:
-  FILE *out_; // Instream of source file
+  /// Most functions queued or compiled but not yet written, per thread
+  static constexpr size_t PENDING_PER_THREAD = 4;
+
+  util::Writer out_;                  ///< Buffered writer for the output
+  bool need_ra_ = true;               ///< Whether to allocate registers
+  std::unique_ptr<util::OrderedPool> pool_;  ///< Back-end threads, if jobs > 1
+
+  /** @brief Emit() for @p frag, which @p owner frees if set */
+  void Write(frame::ProcFrag *frag, std::shared_ptr<frame::ProcFrag> owner);
 };
 
 } // namespace output
@@ -55,7 +55,7 @@
 #define YYSKELETON_NAME "yacc.c"
 
 /* Pure parsers.  */
-#define YYPURE 0
+#define YYPURE 2
 
 /* Push parsers.  */
 #define YYPUSH 0
@@ -79,43 +79,7 @@
 #include "tiger/errormsg/errormsg.h"
 #include "tiger/symbol/symbol.h"
 
-/**
- * @brief External lexer function declaration
- */
-extern int yylex();
-
-/**
- * @brief Error reporting function called by the parser on syntax errors
- * @param s Error message string
- */
-void yyerror(const char *s);
-
-/**
- * @brief Initialize the lexical analyzer with error handler
- * @param errormsg Error message handler for position tracking
- */
-void InitLexer(err::ErrorMsg *errormsg);
-
-/**
- * @brief Global AST tree being constructed by the parser
- */
-static std::unique_ptr<absyn::AbsynTree> absyn_tree_;
-
-/**
- * @brief Global error message handler for position tracking
- */
-static err::ErrorMsg *errormsg_;
-
-/**
- * @brief Get current token position for AST node construction
- * @return Current token position from error handler
- */
-int GetTokPos() {
-    return errormsg_->GetTokPos();
-}
-
-
-#line 119 "parse.tab.cc"
+#line 83 "parse.tab.cc"
 
 # ifndef YY_CAST
 #  ifdef __cplusplus
@@ -220,6 +184,19 @@ typedef enum yysymbol_kind_t yysymbol_kind_t;
 
 
 
+/* Unqualified %code blocks.  */
+#line 39 "tiger.y"
+
+#include "tiger/lex/scanner.h"
+
+/**
+ * @brief Error reporting function called by the parser on syntax errors
+ * @param s Error message string
+ */
+void yyerror(yyscan_t scanner, err::ErrorMsg *errormsg,
+             std::unique_ptr<absyn::AbsynTree> &absyn_tree, const char *s);
+
+#line 200 "parse.tab.cc"
 
 #ifdef short
 # undef short
@@ -605,14 +582,14 @@ static const yytype_int8 yytranslate[] =
 /* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
 static const yytype_int16 yyrline[] =
 {
-       0,   173,   173,   194,   195,   196,   197,   198,   200,   201,
-     202,   203,   204,   205,   206,   207,   208,   209,   210,   211,
-     212,   216,   217,   218,   219,   220,   221,   222,   223,   224,
-     225,   226,   227,   228,   235,   236,   237,   243,   244,   249,
-     250,   254,   255,   269,   271,   276,   277,   279,   283,   285,
-     302,   303,   307,   311,   312,   313,   317,   318,   322,   323,
-     327,   342,   343,   347,   348,   362,   363,   367,   368,   372,
-     386,   387,   401,   402,   406,   407,   411,   412,   413
+       0,   163,   163,   184,   185,   186,   187,   188,   190,   191,
+     192,   193,   194,   195,   196,   197,   198,   199,   200,   201,
+     202,   206,   207,   208,   209,   210,   211,   212,   213,   214,
+     215,   216,   217,   218,   225,   226,   227,   233,   234,   239,
+     240,   244,   245,   259,   261,   266,   267,   269,   273,   275,
+     292,   293,   297,   301,   302,   303,   307,   308,   312,   313,
+     317,   332,   333,   337,   338,   352,   353,   357,   358,   362,
+     376,   377,   391,   392,   396,   397,   401,   402,   403
 };
 #endif
 
@@ -872,7 +849,7 @@ enum { YYENOMEM = -2 };
       }                                                           \
     else                                                          \
       {                                                           \
-        yyerror (YY_("syntax error: cannot back up")); \
+        yyerror (scanner, errormsg, absyn_tree, YY_("syntax error: cannot back up")); \
         YYERROR;                                                  \
       }                                                           \
   while (0)
@@ -905,7 +882,7 @@ do {                                                                      \
     {                                                                     \
       YYFPRINTF (stderr, "%s ", Title);                                   \
       yy_symbol_print (stderr,                                            \
-                  Kind, Value); \
+                  Kind, Value, scanner, errormsg, absyn_tree); \
       YYFPRINTF (stderr, "\n");                                           \
     }                                                                     \
 } while (0)
@@ -917,10 +894,13 @@ do {                                                                      \
 
 static void
 yy_symbol_value_print (FILE *yyo,
-                       yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep)
+                       yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep, yyscan_t scanner, err::ErrorMsg *errormsg, std::unique_ptr<absyn::AbsynTree> &absyn_tree)
 {
   FILE *yyoutput = yyo;
   YY_USE (yyoutput);
+  YY_USE (scanner);
+  YY_USE (errormsg);
+  YY_USE (absyn_tree);
   if (!yyvaluep)
     return;
   YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
@@ -935,12 +915,12 @@ yy_symbol_value_print (FILE *yyo,
 
 static void
 yy_symbol_print (FILE *yyo,
-                 yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep)
+                 yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep, yyscan_t scanner, err::ErrorMsg *errormsg, std::unique_ptr<absyn::AbsynTree> &absyn_tree)
 {
   YYFPRINTF (yyo, "%s %s (",
              yykind < YYNTOKENS ? "token" : "nterm", yysymbol_name (yykind));
 
-  yy_symbol_value_print (yyo, yykind, yyvaluep);
+  yy_symbol_value_print (yyo, yykind, yyvaluep, scanner, errormsg, absyn_tree);
   YYFPRINTF (yyo, ")");
 }
 
@@ -974,7 +954,7 @@ do {                                                            \
 
 static void
 yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp,
-                 int yyrule)
+                 int yyrule, yyscan_t scanner, err::ErrorMsg *errormsg, std::unique_ptr<absyn::AbsynTree> &absyn_tree)
 {
   int yylno = yyrline[yyrule];
   int yynrhs = yyr2[yyrule];
@@ -987,7 +967,7 @@ yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp,
       YYFPRINTF (stderr, "   $%d = ", yyi + 1);
       yy_symbol_print (stderr,
                        YY_ACCESSING_SYMBOL (+yyssp[yyi + 1 - yynrhs]),
-                       &yyvsp[(yyi + 1) - (yynrhs)]);
+                       &yyvsp[(yyi + 1) - (yynrhs)], scanner, errormsg, absyn_tree);
       YYFPRINTF (stderr, "\n");
     }
 }
@@ -995,7 +975,7 @@ yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp,
 # define YY_REDUCE_PRINT(Rule)          \
 do {                                    \
   if (yydebug)                          \
-    yy_reduce_print (yyssp, yyvsp, Rule); \
+    yy_reduce_print (yyssp, yyvsp, Rule, scanner, errormsg, absyn_tree); \
 } while (0)
 
 /* Nonzero means print parse trace.  It is left uninitialized so that
@@ -1036,9 +1016,12 @@ int yydebug;
 
 static void
 yydestruct (const char *yymsg,
-            yysymbol_kind_t yykind, YYSTYPE *yyvaluep)
+            yysymbol_kind_t yykind, YYSTYPE *yyvaluep, yyscan_t scanner, err::ErrorMsg *errormsg, std::unique_ptr<absyn::AbsynTree> &absyn_tree)
 {
   YY_USE (yyvaluep);
+  YY_USE (scanner);
+  YY_USE (errormsg);
+  YY_USE (absyn_tree);
   if (!yymsg)
     yymsg = "Deleting";
   YY_SYMBOL_PRINT (yymsg, yykind, yyvaluep, yylocationp);
@@ -1049,13 +1032,6 @@ yydestruct (const char *yymsg,
 }
 
 
-/* Lookahead token kind.  */
-int yychar;
-
-/* The semantic value of the lookahead symbol.  */
-YYSTYPE yylval;
-/* Number of syntax errors so far.  */
-int yynerrs;
 
 
 
@@ -1065,8 +1041,21 @@ int yynerrs;
 `----------*/
 
 int
-yyparse (void)
+yyparse (yyscan_t scanner, err::ErrorMsg *errormsg, std::unique_ptr<absyn::AbsynTree> &absyn_tree)
 {
+/* Lookahead token kind.  */
+int yychar;
+
+
+/* The semantic value of the lookahead symbol.  */
+/* Default value used for initialization, for pacifying older GCCs
+   or non-GCC compilers.  */
+YY_INITIAL_VALUE (static YYSTYPE yyval_default;)
+YYSTYPE yylval YY_INITIAL_VALUE (= yyval_default);
+
+    /* Number of syntax errors so far.  */
+    int yynerrs = 0;
+
     yy_state_fast_t yystate = 0;
     /* Number of tokens to shift before error messages enabled.  */
     int yyerrstatus = 0;
@@ -1219,7 +1208,7 @@ yybackup:
   if (yychar == YYEMPTY)
     {
       YYDPRINTF ((stderr, "Reading a token\n"));
-      yychar = yylex ();
+      yychar = yylex (&yylval, scanner);
     }
 
   if (yychar <= YYEOF)
@@ -1307,476 +1296,476 @@ yyreduce:
   switch (yyn)
     {
   case 2: /* program: exp  */
-#line 173 "tiger.y"
-               { absyn_tree_ = std::make_unique<absyn::AbsynTree>((yyvsp[0].exp)); }
-#line 1313 "parse.tab.cc"
+#line 163 "tiger.y"
+               { absyn_tree = std::make_unique<absyn::AbsynTree>((yyvsp[0].exp)); }
+#line 1302 "parse.tab.cc"
     break;
 
   case 3: /* exp: INT  */
-#line 194 "tiger.y"
-        { (yyval.exp) = new absyn::IntExp(GetTokPos(), (yyvsp[0].ival)); }
-#line 1319 "parse.tab.cc"
+#line 184 "tiger.y"
+        { (yyval.exp) = new absyn::IntExp(errormsg->GetTokPos(), (yyvsp[0].ival)); }
+#line 1308 "parse.tab.cc"
     break;
 
   case 4: /* exp: STRING  */
-#line 195 "tiger.y"
-           { (yyval.exp) = new absyn::StringExp(GetTokPos(), (yyvsp[0].sval)); }
-#line 1325 "parse.tab.cc"
+#line 185 "tiger.y"
+           { (yyval.exp) = new absyn::StringExp(errormsg->GetTokPos(), (yyvsp[0].sval)); }
+#line 1314 "parse.tab.cc"
     break;
 
   case 5: /* exp: NIL  */
-#line 196 "tiger.y"
-        { (yyval.exp) = new absyn::NilExp(GetTokPos()); }
-#line 1331 "parse.tab.cc"
+#line 186 "tiger.y"
+        { (yyval.exp) = new absyn::NilExp(errormsg->GetTokPos()); }
+#line 1320 "parse.tab.cc"
     break;
 
   case 6: /* exp: lvalue  */
-#line 197 "tiger.y"
-           { (yyval.exp) = new absyn::VarExp(GetTokPos(), (yyvsp[0].var)); }
-#line 1337 "parse.tab.cc"
+#line 187 "tiger.y"
+           { (yyval.exp) = new absyn::VarExp(errormsg->GetTokPos(), (yyvsp[0].var)); }
+#line 1326 "parse.tab.cc"
     break;
 
   case 7: /* exp: ID LPAREN actuals RPAREN  */
-#line 198 "tiger.y"
+#line 188 "tiger.y"
                              {
-     (yyval.exp) = new absyn::CallExp(GetTokPos(), (yyvsp[-3].sym), (yyvsp[-1].explist)); }
-#line 1344 "parse.tab.cc"
+     (yyval.exp) = new absyn::CallExp(errormsg->GetTokPos(), (yyvsp[-3].sym), (yyvsp[-1].explist)); }
+#line 1333 "parse.tab.cc"
     break;
 
   case 8: /* exp: expop  */
-#line 200 "tiger.y"
+#line 190 "tiger.y"
           { (yyval.exp) = (yyvsp[0].exp); }
-#line 1350 "parse.tab.cc"
+#line 1339 "parse.tab.cc"
     break;
 
   case 9: /* exp: ID LBRACE rec RBRACE  */
-#line 201 "tiger.y"
-                         { (yyval.exp) = new absyn::RecordExp(GetTokPos(), (yyvsp[-3].sym), (yyvsp[-1].efieldlist)); }
-#line 1356 "parse.tab.cc"
+#line 191 "tiger.y"
+                         { (yyval.exp) = new absyn::RecordExp(errormsg->GetTokPos(), (yyvsp[-3].sym), (yyvsp[-1].efieldlist)); }
+#line 1345 "parse.tab.cc"
     break;
 
   case 10: /* exp: LPAREN sequencing_exps RPAREN  */
-#line 202 "tiger.y"
-                                  { (yyval.exp) = new absyn::SeqExp(GetTokPos(), (yyvsp[-1].explist)); }
-#line 1362 "parse.tab.cc"
+#line 192 "tiger.y"
+                                  { (yyval.exp) = new absyn::SeqExp(errormsg->GetTokPos(), (yyvsp[-1].explist)); }
+#line 1351 "parse.tab.cc"
     break;
 
   case 11: /* exp: lvalue ASSIGN exp  */
-#line 203 "tiger.y"
-                      { (yyval.exp) = new absyn::AssignExp(GetTokPos(), (yyvsp[-2].var), (yyvsp[0].exp)); }
-#line 1368 "parse.tab.cc"
+#line 193 "tiger.y"
+                      { (yyval.exp) = new absyn::AssignExp(errormsg->GetTokPos(), (yyvsp[-2].var), (yyvsp[0].exp)); }
+#line 1357 "parse.tab.cc"
     break;
 
   case 12: /* exp: IF exp THEN exp  */
-#line 204 "tiger.y"
-                    { (yyval.exp) = new absyn::IfExp(GetTokPos(), (yyvsp[-2].exp), (yyvsp[0].exp), NULL); }
-#line 1374 "parse.tab.cc"
+#line 194 "tiger.y"
+                    { (yyval.exp) = new absyn::IfExp(errormsg->GetTokPos(), (yyvsp[-2].exp), (yyvsp[0].exp), NULL); }
+#line 1363 "parse.tab.cc"
     break;
 
   case 13: /* exp: IF exp THEN exp ELSE exp  */
-#line 205 "tiger.y"
-                             { (yyval.exp) = new absyn::IfExp(GetTokPos(), (yyvsp[-4].exp), (yyvsp[-2].exp), (yyvsp[0].exp)); }
-#line 1380 "parse.tab.cc"
+#line 195 "tiger.y"
+                             { (yyval.exp) = new absyn::IfExp(errormsg->GetTokPos(), (yyvsp[-4].exp), (yyvsp[-2].exp), (yyvsp[0].exp)); }
+#line 1369 "parse.tab.cc"
     break;
 
   case 14: /* exp: WHILE exp DO exp  */
-#line 206 "tiger.y"
-                     { (yyval.exp) = new absyn::WhileExp(GetTokPos(), (yyvsp[-2].exp), (yyvsp[0].exp)); }
-#line 1386 "parse.tab.cc"
+#line 196 "tiger.y"
+                     { (yyval.exp) = new absyn::WhileExp(errormsg->GetTokPos(), (yyvsp[-2].exp), (yyvsp[0].exp)); }
+#line 1375 "parse.tab.cc"
     break;
 
   case 15: /* exp: FOR ID ASSIGN exp TO exp DO exp  */
-#line 207 "tiger.y"
-                                    { (yyval.exp) = new absyn::ForExp(GetTokPos(), (yyvsp[-6].sym), (yyvsp[-4].exp), (yyvsp[-2].exp), (yyvsp[0].exp)); }
-#line 1392 "parse.tab.cc"
+#line 197 "tiger.y"
+                                    { (yyval.exp) = new absyn::ForExp(errormsg->GetTokPos(), (yyvsp[-6].sym), (yyvsp[-4].exp), (yyvsp[-2].exp), (yyvsp[0].exp)); }
+#line 1381 "parse.tab.cc"
     break;
 
   case 16: /* exp: BREAK  */
-#line 208 "tiger.y"
-          { (yyval.exp) = new absyn::BreakExp(GetTokPos()); }
-#line 1398 "parse.tab.cc"
+#line 198 "tiger.y"
+          { (yyval.exp) = new absyn::BreakExp(errormsg->GetTokPos()); }
+#line 1387 "parse.tab.cc"
     break;
 
   case 17: /* exp: LET decs IN expseq END  */
-#line 209 "tiger.y"
-                           { (yyval.exp) = new absyn::LetExp(GetTokPos(), (yyvsp[-3].declist), (yyvsp[-1].exp)); }
-#line 1404 "parse.tab.cc"
+#line 199 "tiger.y"
+                           { (yyval.exp) = new absyn::LetExp(errormsg->GetTokPos(), (yyvsp[-3].declist), (yyvsp[-1].exp)); }
+#line 1393 "parse.tab.cc"
     break;
 
   case 18: /* exp: ID LBRACK exp RBRACK OF exp  */
-#line 210 "tiger.y"
-                                { (yyval.exp) = new absyn::ArrayExp(GetTokPos(), (yyvsp[-5].sym), (yyvsp[-3].exp), (yyvsp[0].exp)); }
-#line 1410 "parse.tab.cc"
+#line 200 "tiger.y"
+                                { (yyval.exp) = new absyn::ArrayExp(errormsg->GetTokPos(), (yyvsp[-5].sym), (yyvsp[-3].exp), (yyvsp[0].exp)); }
+#line 1399 "parse.tab.cc"
     break;
 
   case 19: /* exp: LPAREN RPAREN  */
-#line 211 "tiger.y"
-                  { (yyval.exp) = new absyn::VoidExp(GetTokPos()); }
-#line 1416 "parse.tab.cc"
+#line 201 "tiger.y"
+                  { (yyval.exp) = new absyn::VoidExp(errormsg->GetTokPos()); }
+#line 1405 "parse.tab.cc"
     break;
 
   case 20: /* exp: LPAREN exp RPAREN  */
-#line 212 "tiger.y"
+#line 202 "tiger.y"
                       { (yyval.exp) = (yyvsp[-1].exp); }
-#line 1422 "parse.tab.cc"
+#line 1411 "parse.tab.cc"
     break;
 
   case 21: /* expop: exp PLUS exp  */
-#line 216 "tiger.y"
-                 { (yyval.exp) = new absyn::OpExp(GetTokPos(), absyn::PLUS_OP, (yyvsp[-2].exp), (yyvsp[0].exp)); }
-#line 1428 "parse.tab.cc"
+#line 206 "tiger.y"
+                 { (yyval.exp) = new absyn::OpExp(errormsg->GetTokPos(), absyn::PLUS_OP, (yyvsp[-2].exp), (yyvsp[0].exp)); }
+#line 1417 "parse.tab.cc"
     break;
 
   case 22: /* expop: exp MINUS exp  */
-#line 217 "tiger.y"
-                  { (yyval.exp) = new absyn::OpExp(GetTokPos(), absyn::MINUS_OP, (yyvsp[-2].exp), (yyvsp[0].exp)); }
-#line 1434 "parse.tab.cc"
+#line 207 "tiger.y"
+                  { (yyval.exp) = new absyn::OpExp(errormsg->GetTokPos(), absyn::MINUS_OP, (yyvsp[-2].exp), (yyvsp[0].exp)); }
+#line 1423 "parse.tab.cc"
     break;
 
   case 23: /* expop: exp TIMES exp  */
-#line 218 "tiger.y"
-                  { (yyval.exp) = new absyn::OpExp(GetTokPos(), absyn::TIMES_OP, (yyvsp[-2].exp), (yyvsp[0].exp)); }
-#line 1440 "parse.tab.cc"
+#line 208 "tiger.y"
+                  { (yyval.exp) = new absyn::OpExp(errormsg->GetTokPos(), absyn::TIMES_OP, (yyvsp[-2].exp), (yyvsp[0].exp)); }
+#line 1429 "parse.tab.cc"
     break;
 
   case 24: /* expop: exp DIVIDE exp  */
-#line 219 "tiger.y"
-                   { (yyval.exp) = new absyn::OpExp(GetTokPos(), absyn::DIVIDE_OP, (yyvsp[-2].exp), (yyvsp[0].exp)); }
-#line 1446 "parse.tab.cc"
+#line 209 "tiger.y"
+                   { (yyval.exp) = new absyn::OpExp(errormsg->GetTokPos(), absyn::DIVIDE_OP, (yyvsp[-2].exp), (yyvsp[0].exp)); }
+#line 1435 "parse.tab.cc"
     break;
 
   case 25: /* expop: exp EQ exp  */
-#line 220 "tiger.y"
-               { (yyval.exp) = new absyn::OpExp(GetTokPos(), absyn::EQ_OP, (yyvsp[-2].exp), (yyvsp[0].exp)); }
-#line 1452 "parse.tab.cc"
+#line 210 "tiger.y"
+               { (yyval.exp) = new absyn::OpExp(errormsg->GetTokPos(), absyn::EQ_OP, (yyvsp[-2].exp), (yyvsp[0].exp)); }
+#line 1441 "parse.tab.cc"
     break;
 
   case 26: /* expop: exp NEQ exp  */
-#line 221 "tiger.y"
-                { (yyval.exp) = new absyn::OpExp(GetTokPos(), absyn::NEQ_OP, (yyvsp[-2].exp), (yyvsp[0].exp)); }
-#line 1458 "parse.tab.cc"
+#line 211 "tiger.y"
+                { (yyval.exp) = new absyn::OpExp(errormsg->GetTokPos(), absyn::NEQ_OP, (yyvsp[-2].exp), (yyvsp[0].exp)); }
+#line 1447 "parse.tab.cc"
     break;
 
   case 27: /* expop: exp LT exp  */
-#line 222 "tiger.y"
-               { (yyval.exp) = new absyn::OpExp(GetTokPos(), absyn::LT_OP, (yyvsp[-2].exp), (yyvsp[0].exp)); }
-#line 1464 "parse.tab.cc"
+#line 212 "tiger.y"
+               { (yyval.exp) = new absyn::OpExp(errormsg->GetTokPos(), absyn::LT_OP, (yyvsp[-2].exp), (yyvsp[0].exp)); }
+#line 1453 "parse.tab.cc"
     break;
 
   case 28: /* expop: exp LE exp  */
-#line 223 "tiger.y"
-               { (yyval.exp) = new absyn::OpExp(GetTokPos(), absyn::LE_OP, (yyvsp[-2].exp), (yyvsp[0].exp)); }
-#line 1470 "parse.tab.cc"
+#line 213 "tiger.y"
+               { (yyval.exp) = new absyn::OpExp(errormsg->GetTokPos(), absyn::LE_OP, (yyvsp[-2].exp), (yyvsp[0].exp)); }
+#line 1459 "parse.tab.cc"
     break;
 
   case 29: /* expop: exp GT exp  */
-#line 224 "tiger.y"
-               { (yyval.exp) = new absyn::OpExp(GetTokPos(), absyn::GT_OP, (yyvsp[-2].exp), (yyvsp[0].exp)); }
-#line 1476 "parse.tab.cc"
+#line 214 "tiger.y"
+               { (yyval.exp) = new absyn::OpExp(errormsg->GetTokPos(), absyn::GT_OP, (yyvsp[-2].exp), (yyvsp[0].exp)); }
+#line 1465 "parse.tab.cc"
     break;
 
   case 30: /* expop: exp GE exp  */
-#line 225 "tiger.y"
-               { (yyval.exp) = new absyn::OpExp(GetTokPos(), absyn::GE_OP, (yyvsp[-2].exp), (yyvsp[0].exp)); }
-#line 1482 "parse.tab.cc"
+#line 215 "tiger.y"
+               { (yyval.exp) = new absyn::OpExp(errormsg->GetTokPos(), absyn::GE_OP, (yyvsp[-2].exp), (yyvsp[0].exp)); }
+#line 1471 "parse.tab.cc"
     break;
 
   case 31: /* expop: exp AND exp  */
-#line 226 "tiger.y"
-                { (yyval.exp) = new absyn::IfExp(GetTokPos(), (yyvsp[-2].exp), (yyvsp[0].exp), new absyn::IntExp(GetTokPos(), 0)); }
-#line 1488 "parse.tab.cc"
+#line 216 "tiger.y"
+                { (yyval.exp) = new absyn::IfExp(errormsg->GetTokPos(), (yyvsp[-2].exp), (yyvsp[0].exp), new absyn::IntExp(errormsg->GetTokPos(), 0)); }
+#line 1477 "parse.tab.cc"
     break;
 
   case 32: /* expop: exp OR exp  */
-#line 227 "tiger.y"
-               { (yyval.exp) = new absyn::IfExp(GetTokPos(), (yyvsp[-2].exp), new absyn::IntExp(GetTokPos(), 1), (yyvsp[0].exp)); }
-#line 1494 "parse.tab.cc"
+#line 217 "tiger.y"
+               { (yyval.exp) = new absyn::IfExp(errormsg->GetTokPos(), (yyvsp[-2].exp), new absyn::IntExp(errormsg->GetTokPos(), 1), (yyvsp[0].exp)); }
+#line 1483 "parse.tab.cc"
     break;
 
   case 33: /* expop: MINUS exp  */
-#line 228 "tiger.y"
+#line 218 "tiger.y"
               {
-     (yyval.exp) = new absyn::OpExp(GetTokPos(), absyn::MINUS_OP, new absyn::IntExp(GetTokPos(), 0), (yyvsp[0].exp)); }
-#line 1501 "parse.tab.cc"
+     (yyval.exp) = new absyn::OpExp(errormsg->GetTokPos(), absyn::MINUS_OP, new absyn::IntExp(errormsg->GetTokPos(), 0), (yyvsp[0].exp)); }
+#line 1490 "parse.tab.cc"
     break;
 
   case 34: /* expseq: sequencing_exps  */
-#line 235 "tiger.y"
-                    { (yyval.exp) = new absyn::SeqExp(GetTokPos(), (yyvsp[0].explist)); }
-#line 1507 "parse.tab.cc"
+#line 225 "tiger.y"
+                    { (yyval.exp) = new absyn::SeqExp(errormsg->GetTokPos(), (yyvsp[0].explist)); }
+#line 1496 "parse.tab.cc"
     break;
 
   case 35: /* expseq: exp  */
-#line 236 "tiger.y"
-        { (yyval.exp) = new absyn::SeqExp(GetTokPos(), new absyn::ExpList((yyvsp[0].exp))); }
-#line 1513 "parse.tab.cc"
+#line 226 "tiger.y"
+        { (yyval.exp) = new absyn::SeqExp(errormsg->GetTokPos(), new absyn::ExpList((yyvsp[0].exp))); }
+#line 1502 "parse.tab.cc"
     break;
 
   case 36: /* expseq: %empty  */
-#line 237 "tiger.y"
-   { (yyval.exp) = new absyn::VoidExp(GetTokPos()); }
-#line 1519 "parse.tab.cc"
+#line 227 "tiger.y"
+   { (yyval.exp) = new absyn::VoidExp(errormsg->GetTokPos()); }
+#line 1508 "parse.tab.cc"
     break;
 
   case 37: /* sequencing_exps: exp SEMICOLON exp  */
-#line 243 "tiger.y"
+#line 233 "tiger.y"
                       { (yyval.explist) = new absyn::ExpList((yyvsp[0].exp)); (yyval.explist)->Prepend((yyvsp[-2].exp)); }
-#line 1525 "parse.tab.cc"
+#line 1514 "parse.tab.cc"
     break;
 
   case 38: /* sequencing_exps: exp SEMICOLON sequencing_exps  */
-#line 244 "tiger.y"
+#line 234 "tiger.y"
                                   { (yyval.explist) = (yyvsp[0].explist)->Prepend((yyvsp[-2].exp)); }
-#line 1531 "parse.tab.cc"
+#line 1520 "parse.tab.cc"
     break;
 
   case 39: /* actuals: nonemptyactuals  */
-#line 249 "tiger.y"
+#line 239 "tiger.y"
                     { (yyval.explist) = (yyvsp[0].explist); }
-#line 1537 "parse.tab.cc"
+#line 1526 "parse.tab.cc"
     break;
 
   case 40: /* actuals: %empty  */
-#line 250 "tiger.y"
+#line 240 "tiger.y"
    { (yyval.explist) = new absyn::ExpList(); }
-#line 1543 "parse.tab.cc"
+#line 1532 "parse.tab.cc"
     break;
 
   case 41: /* nonemptyactuals: exp COMMA nonemptyactuals  */
-#line 254 "tiger.y"
+#line 244 "tiger.y"
                               { (yyval.explist) = (yyvsp[0].explist)->Prepend((yyvsp[-2].exp)); }
-#line 1549 "parse.tab.cc"
+#line 1538 "parse.tab.cc"
     break;
 
   case 42: /* nonemptyactuals: exp  */
-#line 255 "tiger.y"
+#line 245 "tiger.y"
         { (yyval.explist) = new absyn::ExpList((yyvsp[0].exp)); }
-#line 1555 "parse.tab.cc"
+#line 1544 "parse.tab.cc"
     break;
 
   case 43: /* lvalue: ID  */
-#line 269 "tiger.y"
+#line 259 "tiger.y"
        {
-     (yyval.var) = new absyn::SimpleVar(GetTokPos(), (yyvsp[0].sym)); }
-#line 1562 "parse.tab.cc"
+     (yyval.var) = new absyn::SimpleVar(errormsg->GetTokPos(), (yyvsp[0].sym)); }
+#line 1551 "parse.tab.cc"
     break;
 
   case 44: /* lvalue: oneormore  */
-#line 271 "tiger.y"
+#line 261 "tiger.y"
               {
      (yyval.var) = (yyvsp[0].var); }
-#line 1569 "parse.tab.cc"
+#line 1558 "parse.tab.cc"
     break;
 
   case 45: /* oneormore: oneormore LBRACK exp RBRACK  */
-#line 276 "tiger.y"
-                                { (yyval.var) = new absyn::SubscriptVar(GetTokPos(), (yyvsp[-3].var), (yyvsp[-1].exp)); }
-#line 1575 "parse.tab.cc"
+#line 266 "tiger.y"
+                                { (yyval.var) = new absyn::SubscriptVar(errormsg->GetTokPos(), (yyvsp[-3].var), (yyvsp[-1].exp)); }
+#line 1564 "parse.tab.cc"
     break;
 
   case 46: /* oneormore: oneormore DOT ID  */
-#line 277 "tiger.y"
+#line 267 "tiger.y"
                      {
-     (yyval.var) = new absyn::FieldVar(GetTokPos(), (yyvsp[-2].var), (yyvsp[0].sym)); }
-#line 1582 "parse.tab.cc"
+     (yyval.var) = new absyn::FieldVar(errormsg->GetTokPos(), (yyvsp[-2].var), (yyvsp[0].sym)); }
+#line 1571 "parse.tab.cc"
     break;
 
   case 47: /* oneormore: one  */
-#line 279 "tiger.y"
+#line 269 "tiger.y"
         { (yyval.var) = (yyvsp[0].var); }
-#line 1588 "parse.tab.cc"
+#line 1577 "parse.tab.cc"
     break;
 
   case 48: /* one: ID LBRACK exp RBRACK  */
-#line 283 "tiger.y"
+#line 273 "tiger.y"
                          {
-     (yyval.var) = new absyn::SubscriptVar(GetTokPos(), new absyn::SimpleVar(GetTokPos(), (yyvsp[-3].sym)), (yyvsp[-1].exp)); }
-#line 1595 "parse.tab.cc"
+     (yyval.var) = new absyn::SubscriptVar(errormsg->GetTokPos(), new absyn::SimpleVar(errormsg->GetTokPos(), (yyvsp[-3].sym)), (yyvsp[-1].exp)); }
+#line 1584 "parse.tab.cc"
     break;
 
   case 49: /* one: ID DOT ID  */
-#line 285 "tiger.y"
+#line 275 "tiger.y"
               {
-     (yyval.var) = new absyn::FieldVar(GetTokPos(), new absyn::SimpleVar(GetTokPos(), (yyvsp[-2].sym)), (yyvsp[0].sym)); }
-#line 1602 "parse.tab.cc"
+     (yyval.var) = new absyn::FieldVar(errormsg->GetTokPos(), new absyn::SimpleVar(errormsg->GetTokPos(), (yyvsp[-2].sym)), (yyvsp[0].sym)); }
+#line 1591 "parse.tab.cc"
     break;
 
   case 50: /* tydec: tydec_one tydec  */
-#line 302 "tiger.y"
+#line 292 "tiger.y"
                     { (yyval.tydeclist) = (yyvsp[0].tydeclist)->Prepend((yyvsp[-1].tydec)); }
-#line 1608 "parse.tab.cc"
+#line 1597 "parse.tab.cc"
     break;
 
   case 51: /* tydec: tydec_one  */
-#line 303 "tiger.y"
+#line 293 "tiger.y"
               { (yyval.tydeclist) = new absyn::NameAndTyList((yyvsp[0].tydec)); }
-#line 1614 "parse.tab.cc"
+#line 1603 "parse.tab.cc"
     break;
 
   case 52: /* tydec_one: TYPE ID EQ ty  */
-#line 307 "tiger.y"
+#line 297 "tiger.y"
                   { (yyval.tydec) = new absyn::NameAndTy((yyvsp[-2].sym), (yyvsp[0].ty)); }
-#line 1620 "parse.tab.cc"
+#line 1609 "parse.tab.cc"
     break;
 
   case 53: /* ty: ID  */
-#line 311 "tiger.y"
-       { (yyval.ty) = new absyn::NameTy(GetTokPos(), (yyvsp[0].sym)); }
-#line 1626 "parse.tab.cc"
+#line 301 "tiger.y"
+       { (yyval.ty) = new absyn::NameTy(errormsg->GetTokPos(), (yyvsp[0].sym)); }
+#line 1615 "parse.tab.cc"
     break;
 
   case 54: /* ty: LBRACE tyfields RBRACE  */
-#line 312 "tiger.y"
-                           { (yyval.ty) = new absyn::RecordTy(GetTokPos(), (yyvsp[-1].fieldlist)); }
-#line 1632 "parse.tab.cc"
+#line 302 "tiger.y"
+                           { (yyval.ty) = new absyn::RecordTy(errormsg->GetTokPos(), (yyvsp[-1].fieldlist)); }
+#line 1621 "parse.tab.cc"
     break;
 
   case 55: /* ty: ARRAY OF ID  */
-#line 313 "tiger.y"
-                { (yyval.ty) = new absyn::ArrayTy(GetTokPos(), (yyvsp[0].sym)); }
-#line 1638 "parse.tab.cc"
+#line 303 "tiger.y"
+                { (yyval.ty) = new absyn::ArrayTy(errormsg->GetTokPos(), (yyvsp[0].sym)); }
+#line 1627 "parse.tab.cc"
     break;
 
   case 56: /* tyfields: tyfields_nonempty  */
-#line 317 "tiger.y"
+#line 307 "tiger.y"
                       { (yyval.fieldlist) = (yyvsp[0].fieldlist); }
-#line 1644 "parse.tab.cc"
+#line 1633 "parse.tab.cc"
     break;
 
   case 57: /* tyfields: %empty  */
-#line 318 "tiger.y"
+#line 308 "tiger.y"
    { (yyval.fieldlist) = new absyn::FieldList(); }
-#line 1650 "parse.tab.cc"
+#line 1639 "parse.tab.cc"
     break;
 
   case 58: /* tyfields_nonempty: tyfield COMMA tyfields_nonempty  */
-#line 322 "tiger.y"
+#line 312 "tiger.y"
                                     { (yyval.fieldlist) = (yyvsp[0].fieldlist)->Prepend((yyvsp[-2].field)); }
-#line 1656 "parse.tab.cc"
+#line 1645 "parse.tab.cc"
     break;
 
   case 59: /* tyfields_nonempty: tyfield  */
-#line 323 "tiger.y"
+#line 313 "tiger.y"
             { (yyval.fieldlist) = new absyn::FieldList((yyvsp[0].field)); }
-#line 1662 "parse.tab.cc"
+#line 1651 "parse.tab.cc"
     break;
 
   case 60: /* tyfield: ID COLON ID  */
-#line 327 "tiger.y"
-                { (yyval.field) = new absyn::Field(GetTokPos(), (yyvsp[-2].sym), (yyvsp[0].sym)); }
-#line 1668 "parse.tab.cc"
+#line 317 "tiger.y"
+                { (yyval.field) = new absyn::Field(errormsg->GetTokPos(), (yyvsp[-2].sym), (yyvsp[0].sym)); }
+#line 1657 "parse.tab.cc"
     break;
 
   case 61: /* fundec: fundec_one fundec  */
-#line 342 "tiger.y"
+#line 332 "tiger.y"
                       { (yyval.fundeclist) = (yyvsp[0].fundeclist)->Prepend((yyvsp[-1].fundec)); }
-#line 1674 "parse.tab.cc"
+#line 1663 "parse.tab.cc"
     break;
 
   case 62: /* fundec: fundec_one  */
-#line 343 "tiger.y"
+#line 333 "tiger.y"
                { (yyval.fundeclist) = new absyn::FunDecList((yyvsp[0].fundec)); }
-#line 1680 "parse.tab.cc"
+#line 1669 "parse.tab.cc"
     break;
 
   case 63: /* fundec_one: FUNCTION ID LPAREN tyfields RPAREN EQ exp  */
-#line 347 "tiger.y"
-                                              { (yyval.fundec) = new absyn::FunDec(GetTokPos(), (yyvsp[-5].sym), (yyvsp[-3].fieldlist), NULL, (yyvsp[0].exp)); }
-#line 1686 "parse.tab.cc"
+#line 337 "tiger.y"
+                                              { (yyval.fundec) = new absyn::FunDec(errormsg->GetTokPos(), (yyvsp[-5].sym), (yyvsp[-3].fieldlist), NULL, (yyvsp[0].exp)); }
+#line 1675 "parse.tab.cc"
     break;
 
   case 64: /* fundec_one: FUNCTION ID LPAREN tyfields RPAREN COLON ID EQ exp  */
-#line 348 "tiger.y"
-                                                       { (yyval.fundec) = new absyn::FunDec(GetTokPos(), (yyvsp[-7].sym), (yyvsp[-5].fieldlist), (yyvsp[-2].sym), (yyvsp[0].exp)); }
-#line 1692 "parse.tab.cc"
+#line 338 "tiger.y"
+                                                       { (yyval.fundec) = new absyn::FunDec(errormsg->GetTokPos(), (yyvsp[-7].sym), (yyvsp[-5].fieldlist), (yyvsp[-2].sym), (yyvsp[0].exp)); }
+#line 1681 "parse.tab.cc"
     break;
 
   case 65: /* rec: rec_nonempty  */
-#line 362 "tiger.y"
+#line 352 "tiger.y"
                  { (yyval.efieldlist) = (yyvsp[0].efieldlist); }
-#line 1698 "parse.tab.cc"
+#line 1687 "parse.tab.cc"
     break;
 
   case 66: /* rec: %empty  */
-#line 363 "tiger.y"
+#line 353 "tiger.y"
    { (yyval.efieldlist) = new absyn::EFieldList(); }
-#line 1704 "parse.tab.cc"
+#line 1693 "parse.tab.cc"
     break;
 
   case 67: /* rec_nonempty: rec_one COMMA rec_nonempty  */
-#line 367 "tiger.y"
+#line 357 "tiger.y"
                                { (yyval.efieldlist) = (yyvsp[0].efieldlist)->Prepend((yyvsp[-2].efield)); }
-#line 1710 "parse.tab.cc"
+#line 1699 "parse.tab.cc"
     break;
 
   case 68: /* rec_nonempty: rec_one  */
-#line 368 "tiger.y"
+#line 358 "tiger.y"
             { (yyval.efieldlist) = new absyn::EFieldList((yyvsp[0].efield)); }
-#line 1716 "parse.tab.cc"
+#line 1705 "parse.tab.cc"
     break;
 
   case 69: /* rec_one: ID EQ exp  */
-#line 372 "tiger.y"
+#line 362 "tiger.y"
               { (yyval.efield) = new absyn::EField((yyvsp[-2].sym), (yyvsp[0].exp)); }
-#line 1722 "parse.tab.cc"
+#line 1711 "parse.tab.cc"
     break;
 
   case 70: /* vardec: VAR ID ASSIGN exp  */
-#line 386 "tiger.y"
-                      { (yyval.dec) = new absyn::VarDec(GetTokPos(), (yyvsp[-2].sym), NULL, (yyvsp[0].exp)); }
-#line 1728 "parse.tab.cc"
+#line 376 "tiger.y"
+                      { (yyval.dec) = new absyn::VarDec(errormsg->GetTokPos(), (yyvsp[-2].sym), NULL, (yyvsp[0].exp)); }
+#line 1717 "parse.tab.cc"
     break;
 
   case 71: /* vardec: VAR ID COLON ID ASSIGN exp  */
-#line 387 "tiger.y"
-                               { (yyval.dec) = new absyn::VarDec(GetTokPos(), (yyvsp[-4].sym), (yyvsp[-2].sym), (yyvsp[0].exp)); }
-#line 1734 "parse.tab.cc"
+#line 377 "tiger.y"
+                               { (yyval.dec) = new absyn::VarDec(errormsg->GetTokPos(), (yyvsp[-4].sym), (yyvsp[-2].sym), (yyvsp[0].exp)); }
+#line 1723 "parse.tab.cc"
     break;
 
   case 72: /* decs: decs_nonempty  */
-#line 401 "tiger.y"
+#line 391 "tiger.y"
                   { (yyval.declist) = (yyvsp[0].declist); }
-#line 1740 "parse.tab.cc"
+#line 1729 "parse.tab.cc"
     break;
 
   case 73: /* decs: %empty  */
-#line 402 "tiger.y"
+#line 392 "tiger.y"
    { (yyval.declist) = new absyn::DecList(); }
-#line 1746 "parse.tab.cc"
+#line 1735 "parse.tab.cc"
     break;
 
   case 74: /* decs_nonempty: decs_nonempty_s decs_nonempty  */
-#line 406 "tiger.y"
+#line 396 "tiger.y"
                                   { (yyval.declist) = (yyvsp[0].declist)->Prepend((yyvsp[-1].dec)); }
-#line 1752 "parse.tab.cc"
+#line 1741 "parse.tab.cc"
     break;
 
   case 75: /* decs_nonempty: decs_nonempty_s  */
-#line 407 "tiger.y"
+#line 397 "tiger.y"
                     { (yyval.declist) = new absyn::DecList((yyvsp[0].dec)); }
-#line 1758 "parse.tab.cc"
+#line 1747 "parse.tab.cc"
     break;
 
   case 76: /* decs_nonempty_s: tydec  */
-#line 411 "tiger.y"
-          { (yyval.dec) = new absyn::TypeDec(GetTokPos(), (yyvsp[0].tydeclist)); }
-#line 1764 "parse.tab.cc"
+#line 401 "tiger.y"
+          { (yyval.dec) = new absyn::TypeDec(errormsg->GetTokPos(), (yyvsp[0].tydeclist)); }
+#line 1753 "parse.tab.cc"
     break;
 
   case 77: /* decs_nonempty_s: vardec  */
-#line 412 "tiger.y"
+#line 402 "tiger.y"
            { (yyval.dec) = (yyvsp[0].dec); }
-#line 1770 "parse.tab.cc"
+#line 1759 "parse.tab.cc"
     break;
 
   case 78: /* decs_nonempty_s: fundec  */
-#line 413 "tiger.y"
-           { (yyval.dec) = new absyn::FunctionDec(GetTokPos(), (yyvsp[0].fundeclist)); }
-#line 1776 "parse.tab.cc"
+#line 403 "tiger.y"
+           { (yyval.dec) = new absyn::FunctionDec(errormsg->GetTokPos(), (yyvsp[0].fundeclist)); }
+#line 1765 "parse.tab.cc"
     break;
 
 
-#line 1780 "parse.tab.cc"
+#line 1769 "parse.tab.cc"
 
       default: break;
     }
@@ -1823,7 +1812,7 @@ yyerrlab:
   if (!yyerrstatus)
     {
       ++yynerrs;
-      yyerror (YY_("syntax error"));
+      yyerror (scanner, errormsg, absyn_tree, YY_("syntax error"));
     }
 
   if (yyerrstatus == 3)
@@ -1840,7 +1829,7 @@ yyerrlab:
       else
         {
           yydestruct ("Error: discarding",
-                      yytoken, &yylval);
+                      yytoken, &yylval, scanner, errormsg, absyn_tree);
           yychar = YYEMPTY;
         }
     }
@@ -1896,7 +1885,7 @@ yyerrlab1:
 
 
       yydestruct ("Error: popping",
-                  YY_ACCESSING_SYMBOL (yystate), yyvsp);
+                  YY_ACCESSING_SYMBOL (yystate), yyvsp, scanner, errormsg, absyn_tree);
       YYPOPSTACK (1);
       yystate = *yyssp;
       YY_STACK_PRINT (yyss, yyssp);
@@ -1934,7 +1923,7 @@ yyabortlab:
 | yyexhaustedlab -- YYNOMEM (memory exhaustion) comes here.  |
 `-----------------------------------------------------------*/
 yyexhaustedlab:
-  yyerror (YY_("memory exhausted"));
+  yyerror (scanner, errormsg, absyn_tree, YY_("memory exhausted"));
   yyresult = 2;
   goto yyreturnlab;
 
@@ -1949,7 +1938,7 @@ yyreturnlab:
          user semantic actions for why this is necessary.  */
       yytoken = YYTRANSLATE (yychar);
       yydestruct ("Cleanup: discarding lookahead",
-                  yytoken, &yylval);
+                  yytoken, &yylval, scanner, errormsg, absyn_tree);
     }
   /* Do not reclaim the symbols of the rule whose action triggered
      this YYABORT or YYACCEPT.  */
@@ -1958,7 +1947,7 @@ yyreturnlab:
   while (yyssp != yyss)
     {
       yydestruct ("Cleanup: popping",
-                  YY_ACCESSING_SYMBOL (+*yyssp), yyvsp);
+                  YY_ACCESSING_SYMBOL (+*yyssp), yyvsp, scanner, errormsg, absyn_tree);
       YYPOPSTACK (1);
     }
 #ifndef yyoverflow
@@ -1969,53 +1958,95 @@ yyreturnlab:
   return yyresult;
 }
 
-#line 416 "tiger.y"
+#line 406 "tiger.y"
 
 
 /**
  * @brief Error reporting function called by the parser on syntax errors
+ *
+ * A program that ends in a string or comment has had that reported by the
+ * scanner; the syntax error it then causes at the end is not reported.
+ *
  * @param s Error message string
  */
-void yyerror(const char *s) {
-    errormsg_->Error(GetTokPos(), "%s", s);
+void yyerror(yyscan_t scanner, err::ErrorMsg *errormsg,
+             std::unique_ptr<absyn::AbsynTree> &absyn_tree, const char *s) {
+    if (yyget_extra(scanner)->unterminated)
+        return;
+    errormsg->Error(errormsg->GetTokPos(), "%s", s);
+}
+
+/**
+ * @brief Parse what @p scanner reads, then free the scanner
+ *
+ * All lexer and parser state lives in this call, so programs can be
+ * parsed on several threads at the same time.
+ */
+static std::unique_ptr<absyn::AbsynTree> ParseAndDestroy(yyscan_t scanner,
+                                                         err::ErrorMsg *errormsg) {
+    std::unique_ptr<absyn::AbsynTree> absyn_tree;
+    int result = yyparse(scanner, errormsg, absyn_tree);
+    yylex_destroy(scanner);
+
+    // If parsing failed or there were errors, don't return the tree
+    if (result != 0 || errormsg->AnyErrors()) {
+        return nullptr;
+    }
+
+    return absyn_tree;
+}
+
+/**
+ * @brief Parse a Tiger program read from an open stream
+ *
+ * @param in Stream the program is read from; left open
+ * @param errormsg Error message handler for the program
+ * @return Unique pointer to the parsed AST, or nullptr if parsing failed
+ */
+std::unique_ptr<absyn::AbsynTree> Parse(FILE *in, err::ErrorMsg *errormsg) {
+    LexState lex_state(errormsg);
+    yyscan_t scanner;
+    yylex_init_extra(&lex_state, &scanner);
+    yyset_in(in, scanner);
+    return ParseAndDestroy(scanner, errormsg);
+}
+
+/**
+ * @brief Parse a Tiger program held in memory
+ *
+ * @param source Text of the program
+ * @param errormsg Error message handler for the program
+ * @return Unique pointer to the parsed AST, or nullptr if parsing failed
+ */
+std::unique_ptr<absyn::AbsynTree> ParseBuffer(std::string_view source,
+                                              err::ErrorMsg *errormsg) {
+    LexState lex_state(errormsg);
+    yyscan_t scanner;
+    yylex_init_extra(&lex_state, &scanner);
+    // The scanner reads a copy, which yylex_destroy() frees
+    yy_scan_bytes(source.data(), source.size(), scanner);
+    return ParseAndDestroy(scanner, errormsg);
 }
 
 /**
  * @brief Main parsing function for Tiger source files
  *
- * This function orchestrates the complete parsing process:
- * 1. Initializes error handling and lexer state
- * 2. Opens the source file for lexing
- * 3. Invokes the parser (yyparse)
- * 4. Returns the constructed AST if parsing succeeds
- * 5. Handles file I/O and error conditions
+ * Opens the source file and parses it with Parse(FILE *, err::ErrorMsg *).
  *
  * @param fname Path to the Tiger source file to parse
+ * @param errormsg Error message handler for the file
  * @return Unique pointer to the parsed AST, or nullptr if parsing failed
  */
-std::unique_ptr<absyn::AbsynTree> Parse(const std::string &fname) {
-    errormsg_ = new err::ErrorMsg(fname);
-    InitLexer(errormsg_);
-    
+std::unique_ptr<absyn::AbsynTree> Parse(const std::string &fname,
+                                        err::ErrorMsg *errormsg) {
     // Open the input file for the lexer
-    extern FILE *yyin;
-    yyin = fopen(fname.c_str(), "r");
-    if (!yyin) {
-        errormsg_->Error(0, "Cannot open file %s", fname.c_str());
+    FILE *in = fopen(fname.c_str(), "r");
+    if (!in) {
+        errormsg->Error(0, "Cannot open file %s", fname.c_str());
         return nullptr;
     }
-    
-    int result = yyparse();
-    fclose(yyin);
-    
-    // If parsing failed or there were errors, don't return the tree
-    if (result != 0 || errormsg_->AnyErrors()) {
-        return nullptr;
-    }
-    
-    return std::move(absyn_tree_);
-}
 
-err::ErrorMsg *GetErrorMsg() {
-    return errormsg_;
+    std::unique_ptr<absyn::AbsynTree> absyn_tree = Parse(in, errormsg);
+    fclose(in);
+    return absyn_tree;
 }
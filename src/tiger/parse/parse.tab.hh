@@ -45,12 +45,17 @@
 extern int yydebug;
 #endif
 /* "%code requires" blocks.  */
-#line 65 "tiger.y"
+#line 29 "tiger.y"
 
 #include "tiger/absyn/absyn.h"
 #include "tiger/symbol/symbol.h"
 
-#line 54 "parse.tab.hh"
+#ifndef YY_TYPEDEF_YY_SCANNER_T
+#define YY_TYPEDEF_YY_SCANNER_T
+typedef void *yyscan_t;
+#endif
+
+#line 59 "parse.tab.hh"
 
 /* Token kinds.  */
 #ifndef YYTOKENTYPE
@@ -112,7 +117,7 @@ extern int yydebug;
 #if ! defined YYSTYPE && ! defined YYSTYPE_IS_DECLARED
 union YYSTYPE
 {
-#line 76 "tiger.y"
+#line 66 "tiger.y"
 
   int ival;                          /**< Integer literal values */
   std::string* sval;                 /**< String literal values */
@@ -136,7 +141,7 @@ union YYSTYPE
   absyn::FunDec *fundec;             /**< Function declaration nodes */
   absyn::Ty *ty;                     /**< Type nodes */
 
-#line 140 "parse.tab.hh"
+#line 145 "parse.tab.hh"
 
 };
 typedef union YYSTYPE YYSTYPE;
@@ -145,10 +150,9 @@ typedef union YYSTYPE YYSTYPE;
 #endif
 
 
-extern YYSTYPE yylval;
 
 
-int yyparse (void);
+int yyparse (yyscan_t scanner, err::ErrorMsg *errormsg, std::unique_ptr<absyn::AbsynTree> &absyn_tree);
 
 
 #endif /* !YY_YY_PARSE_TAB_HH_INCLUDED  */
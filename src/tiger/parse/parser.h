@@ -10,8 +10,10 @@
 #ifndef TIGER_PARSE_PARSER_H_
 #define TIGER_PARSE_PARSER_H_
 
+#include <cstdio>
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <memory>
 
 // Forward declarations
@@ -23,31 +25,38 @@ namespace err {
     class ErrorMsg;   /**< Forward declaration for error message handler */
 }
 
-/**
- * @brief Forward declaration of bison generated functions
- */
-extern int yyparse();              /**< Main parsing function */
-extern void yyerror(const char *s); /**< Error reporting function */
-
 /**
  * @brief Main parsing function for Tiger source files
  *
  * Parses a Tiger source file and constructs an abstract syntax tree.
- * Handles file I/O, lexer initialization, and error reporting.
+ * Handles file I/O, lexer initialization, and error reporting.  The lexer
+ * and parser keep no state between calls, so several files can be parsed
+ * at the same time on different threads.
  *
  * @param fname Path to the Tiger source file to parse
+ * @param errormsg Error message handler that syntax errors are reported to
  * @return Unique pointer to the parsed AST, or nullptr if parsing failed
  */
-std::unique_ptr<absyn::AbsynTree> Parse(const std::string &fname);
+std::unique_ptr<absyn::AbsynTree> Parse(const std::string &fname,
+                                        err::ErrorMsg *errormsg);
 
 /**
- * @brief Get the current error message handler
+ * @brief Parse a Tiger program read from @p in, such as a memory stream
  *
- * Returns the error message handler used during parsing for
- * accessing error information and position tracking.
+ * @param in Stream the program is read from; left open
+ * @param errormsg Error message handler that syntax errors are reported to
+ * @return Unique pointer to the parsed AST, or nullptr if parsing failed
+ */
+std::unique_ptr<absyn::AbsynTree> Parse(FILE *in, err::ErrorMsg *errormsg);
+
+/**
+ * @brief Parse a Tiger program held in memory
  *
- * @return Pointer to the current error message handler
+ * @param source Text of the program; need not outlive the call
+ * @param errormsg Error message handler that syntax errors are reported to
+ * @return Unique pointer to the parsed AST, or nullptr if parsing failed
  */
-err::ErrorMsg *GetErrorMsg();
+std::unique_ptr<absyn::AbsynTree> ParseBuffer(std::string_view source,
+                                              err::ErrorMsg *errormsg);
 
 #endif // TIGER_PARSE_PARSER_H_
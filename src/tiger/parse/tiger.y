@@ -24,48 +24,38 @@
 #include "tiger/absyn/absyn.h"
 #include "tiger/errormsg/errormsg.h"
 #include "tiger/symbol/symbol.h"
+%}
 
-/**
- * @brief External lexer function declaration
- */
-extern int yylex();
-
-/**
- * @brief Error reporting function called by the parser on syntax errors
- * @param s Error message string
- */
-void yyerror(const char *s);
+%code requires {
+#include "tiger/absyn/absyn.h"
+#include "tiger/symbol/symbol.h"
 
-/**
- * @brief Initialize the lexical analyzer with error handler
- * @param errormsg Error message handler for position tracking
- */
-void InitLexer(err::ErrorMsg *errormsg);
+#ifndef YY_TYPEDEF_YY_SCANNER_T
+#define YY_TYPEDEF_YY_SCANNER_T
+typedef void *yyscan_t;
+#endif
+}
 
-/**
- * @brief Global AST tree being constructed by the parser
- */
-static std::unique_ptr<absyn::AbsynTree> absyn_tree_;
+%code {
+#include "tiger/lex/scanner.h"
 
 /**
- * @brief Global error message handler for position tracking
+ * @brief Error reporting function called by the parser on syntax errors
+ * @param s Error message string
  */
-static err::ErrorMsg *errormsg_;
+void yyerror(yyscan_t scanner, err::ErrorMsg *errormsg,
+             std::unique_ptr<absyn::AbsynTree> &absyn_tree, const char *s);
+}
 
 /**
- * @brief Get current token position for AST node construction
- * @return Current token position from error handler
+ * @brief The parser is reentrant: the scanner, the error handler and the
+ * tree being built are passed in rather than kept in globals
  */
-int GetTokPos() {
-    return errormsg_->GetTokPos();
-}
-
-%}
-
-%code requires {
-#include "tiger/absyn/absyn.h"
-#include "tiger/symbol/symbol.h"
-}
+%define api.pure full
+%lex-param {yyscan_t scanner}
+%parse-param {yyscan_t scanner}
+%parse-param {err::ErrorMsg *errormsg}
+%parse-param {std::unique_ptr<absyn::AbsynTree> &absyn_tree}
 
 /**
  * @brief Semantic value union for parser attributes
@@ -170,7 +160,7 @@ int GetTokPos() {
  * Each rule constructs appropriate AST nodes with position information
  * for error reporting and semantic analysis.
  */
-program:  exp  { absyn_tree_ = std::make_unique<absyn::AbsynTree>($1); }
+program:  exp  { absyn_tree = std::make_unique<absyn::AbsynTree>($1); }
   ;
 
 /**
@@ -191,50 +181,50 @@ program:  exp  { absyn_tree_ = std::make_unique<absyn::AbsynTree>($1); }
  */
 
 exp:
-   INT  { $$ = new absyn::IntExp(GetTokPos(), $1); }
-|  STRING  { $$ = new absyn::StringExp(GetTokPos(), $1); }
-|  NIL  { $$ = new absyn::NilExp(GetTokPos()); }
-|  lvalue  { $$ = new absyn::VarExp(GetTokPos(), $1); }
+   INT  { $$ = new absyn::IntExp(errormsg->GetTokPos(), $1); }
+|  STRING  { $$ = new absyn::StringExp(errormsg->GetTokPos(), $1); }
+|  NIL  { $$ = new absyn::NilExp(errormsg->GetTokPos()); }
+|  lvalue  { $$ = new absyn::VarExp(errormsg->GetTokPos(), $1); }
 |  ID LPAREN actuals RPAREN  {
-     $$ = new absyn::CallExp(GetTokPos(), $1, $3); }
+     $$ = new absyn::CallExp(errormsg->GetTokPos(), $1, $3); }
 |  expop  { $$ = $1; }
-|  ID LBRACE rec RBRACE  { $$ = new absyn::RecordExp(GetTokPos(), $1, $3); }
-|  LPAREN sequencing_exps RPAREN  { $$ = new absyn::SeqExp(GetTokPos(), $2); }
-|  lvalue ASSIGN exp  { $$ = new absyn::AssignExp(GetTokPos(), $1, $3); }
-|  IF exp THEN exp  { $$ = new absyn::IfExp(GetTokPos(), $2, $4, NULL); }
-|  IF exp THEN exp ELSE exp  { $$ = new absyn::IfExp(GetTokPos(), $2, $4, $6); }
-|  WHILE exp DO exp  { $$ = new absyn::WhileExp(GetTokPos(), $2, $4); }
-|  FOR ID ASSIGN exp TO exp DO exp  { $$ = new absyn::ForExp(GetTokPos(), $2, $4, $6, $8); }
-|  BREAK  { $$ = new absyn::BreakExp(GetTokPos()); }
-|  LET decs IN expseq END  { $$ = new absyn::LetExp(GetTokPos(), $2, $4); }
-|  ID LBRACK exp RBRACK OF exp  { $$ = new absyn::ArrayExp(GetTokPos(), $1, $3, $6); }
-|  LPAREN RPAREN  { $$ = new absyn::VoidExp(GetTokPos()); }
+|  ID LBRACE rec RBRACE  { $$ = new absyn::RecordExp(errormsg->GetTokPos(), $1, $3); }
+|  LPAREN sequencing_exps RPAREN  { $$ = new absyn::SeqExp(errormsg->GetTokPos(), $2); }
+|  lvalue ASSIGN exp  { $$ = new absyn::AssignExp(errormsg->GetTokPos(), $1, $3); }
+|  IF exp THEN exp  { $$ = new absyn::IfExp(errormsg->GetTokPos(), $2, $4, NULL); }
+|  IF exp THEN exp ELSE exp  { $$ = new absyn::IfExp(errormsg->GetTokPos(), $2, $4, $6); }
+|  WHILE exp DO exp  { $$ = new absyn::WhileExp(errormsg->GetTokPos(), $2, $4); }
+|  FOR ID ASSIGN exp TO exp DO exp  { $$ = new absyn::ForExp(errormsg->GetTokPos(), $2, $4, $6, $8); }
+|  BREAK  { $$ = new absyn::BreakExp(errormsg->GetTokPos()); }
+|  LET decs IN expseq END  { $$ = new absyn::LetExp(errormsg->GetTokPos(), $2, $4); }
+|  ID LBRACK exp RBRACK OF exp  { $$ = new absyn::ArrayExp(errormsg->GetTokPos(), $1, $3, $6); }
+|  LPAREN RPAREN  { $$ = new absyn::VoidExp(errormsg->GetTokPos()); }
 |  LPAREN exp RPAREN  { $$ = $2; }
 ;
 
 expop:
-   exp PLUS exp  { $$ = new absyn::OpExp(GetTokPos(), absyn::PLUS_OP, $1, $3); }
-|  exp MINUS exp  { $$ = new absyn::OpExp(GetTokPos(), absyn::MINUS_OP, $1, $3); }
-|  exp TIMES exp  { $$ = new absyn::OpExp(GetTokPos(), absyn::TIMES_OP, $1, $3); }
-|  exp DIVIDE exp  { $$ = new absyn::OpExp(GetTokPos(), absyn::DIVIDE_OP, $1, $3); }
-|  exp EQ exp  { $$ = new absyn::OpExp(GetTokPos(), absyn::EQ_OP, $1, $3); }
-|  exp NEQ exp  { $$ = new absyn::OpExp(GetTokPos(), absyn::NEQ_OP, $1, $3); }
-|  exp LT exp  { $$ = new absyn::OpExp(GetTokPos(), absyn::LT_OP, $1, $3); }
-|  exp LE exp  { $$ = new absyn::OpExp(GetTokPos(), absyn::LE_OP, $1, $3); }
-|  exp GT exp  { $$ = new absyn::OpExp(GetTokPos(), absyn::GT_OP, $1, $3); }
-|  exp GE exp  { $$ = new absyn::OpExp(GetTokPos(), absyn::GE_OP, $1, $3); }
-|  exp AND exp  { $$ = new absyn::IfExp(GetTokPos(), $1, $3, new absyn::IntExp(GetTokPos(), 0)); }
-|  exp OR exp  { $$ = new absyn::IfExp(GetTokPos(), $1, new absyn::IntExp(GetTokPos(), 1), $3); }
+   exp PLUS exp  { $$ = new absyn::OpExp(errormsg->GetTokPos(), absyn::PLUS_OP, $1, $3); }
+|  exp MINUS exp  { $$ = new absyn::OpExp(errormsg->GetTokPos(), absyn::MINUS_OP, $1, $3); }
+|  exp TIMES exp  { $$ = new absyn::OpExp(errormsg->GetTokPos(), absyn::TIMES_OP, $1, $3); }
+|  exp DIVIDE exp  { $$ = new absyn::OpExp(errormsg->GetTokPos(), absyn::DIVIDE_OP, $1, $3); }
+|  exp EQ exp  { $$ = new absyn::OpExp(errormsg->GetTokPos(), absyn::EQ_OP, $1, $3); }
+|  exp NEQ exp  { $$ = new absyn::OpExp(errormsg->GetTokPos(), absyn::NEQ_OP, $1, $3); }
+|  exp LT exp  { $$ = new absyn::OpExp(errormsg->GetTokPos(), absyn::LT_OP, $1, $3); }
+|  exp LE exp  { $$ = new absyn::OpExp(errormsg->GetTokPos(), absyn::LE_OP, $1, $3); }
+|  exp GT exp  { $$ = new absyn::OpExp(errormsg->GetTokPos(), absyn::GT_OP, $1, $3); }
+|  exp GE exp  { $$ = new absyn::OpExp(errormsg->GetTokPos(), absyn::GE_OP, $1, $3); }
+|  exp AND exp  { $$ = new absyn::IfExp(errormsg->GetTokPos(), $1, $3, new absyn::IntExp(errormsg->GetTokPos(), 0)); }
+|  exp OR exp  { $$ = new absyn::IfExp(errormsg->GetTokPos(), $1, new absyn::IntExp(errormsg->GetTokPos(), 1), $3); }
 |  MINUS exp  {
-     $$ = new absyn::OpExp(GetTokPos(), absyn::MINUS_OP, new absyn::IntExp(GetTokPos(), 0), $2); }
+     $$ = new absyn::OpExp(errormsg->GetTokPos(), absyn::MINUS_OP, new absyn::IntExp(errormsg->GetTokPos(), 0), $2); }
 ;
 
 // exp1; exp2; ... (0 or more exps)
 // Only valid in LET. Returns an Exp.
 expseq:
-   sequencing_exps  { $$ = new absyn::SeqExp(GetTokPos(), $1); }
-|  exp  { $$ = new absyn::SeqExp(GetTokPos(), new absyn::ExpList($1)); }
-|  { $$ = new absyn::VoidExp(GetTokPos()); }  // Empty LET body.
+   sequencing_exps  { $$ = new absyn::SeqExp(errormsg->GetTokPos(), $1); }
+|  exp  { $$ = new absyn::SeqExp(errormsg->GetTokPos(), new absyn::ExpList($1)); }
+|  { $$ = new absyn::VoidExp(errormsg->GetTokPos()); }  // Empty LET body.
 ;
 
 // exp1; exp2; ... (2 or more exps)
@@ -267,23 +257,23 @@ nonemptyactuals:
 
 lvalue:
    ID  {
-     $$ = new absyn::SimpleVar(GetTokPos(), $1); }
+     $$ = new absyn::SimpleVar(errormsg->GetTokPos(), $1); }
 |  oneormore  {
      $$ = $1; }
 ;
 
 oneormore:
-   oneormore LBRACK exp RBRACK  { $$ = new absyn::SubscriptVar(GetTokPos(), $1, $3); }
+   oneormore LBRACK exp RBRACK  { $$ = new absyn::SubscriptVar(errormsg->GetTokPos(), $1, $3); }
 |  oneormore DOT ID  {
-     $$ = new absyn::FieldVar(GetTokPos(), $1, $3); }
+     $$ = new absyn::FieldVar(errormsg->GetTokPos(), $1, $3); }
 |  one  { $$ = $1; }
 ;
 
 one:
    ID LBRACK exp RBRACK  {
-     $$ = new absyn::SubscriptVar(GetTokPos(), new absyn::SimpleVar(GetTokPos(), $1), $3); }
+     $$ = new absyn::SubscriptVar(errormsg->GetTokPos(), new absyn::SimpleVar(errormsg->GetTokPos(), $1), $3); }
 |  ID DOT ID  {
-     $$ = new absyn::FieldVar(GetTokPos(), new absyn::SimpleVar(GetTokPos(), $1), $3); }
+     $$ = new absyn::FieldVar(errormsg->GetTokPos(), new absyn::SimpleVar(errormsg->GetTokPos(), $1), $3); }
 ;
 
 
@@ -308,9 +298,9 @@ tydec_one:
 ;
 
 ty:
-   ID  { $$ = new absyn::NameTy(GetTokPos(), $1); }
-|  LBRACE tyfields RBRACE  { $$ = new absyn::RecordTy(GetTokPos(), $2); }
-|  ARRAY OF ID  { $$ = new absyn::ArrayTy(GetTokPos(), $3); }
+   ID  { $$ = new absyn::NameTy(errormsg->GetTokPos(), $1); }
+|  LBRACE tyfields RBRACE  { $$ = new absyn::RecordTy(errormsg->GetTokPos(), $2); }
+|  ARRAY OF ID  { $$ = new absyn::ArrayTy(errormsg->GetTokPos(), $3); }
 ;
 
 tyfields:
@@ -324,7 +314,7 @@ tyfields_nonempty:
 ;
 
 tyfield:
-   ID COLON ID  { $$ = new absyn::Field(GetTokPos(), $1, $3); }
+   ID COLON ID  { $$ = new absyn::Field(errormsg->GetTokPos(), $1, $3); }
 ;
 
 
@@ -344,8 +334,8 @@ fundec:
 ;
 
 fundec_one:
-   FUNCTION ID LPAREN tyfields RPAREN EQ exp  { $$ = new absyn::FunDec(GetTokPos(), $2, $4, NULL, $7); }
-|  FUNCTION ID LPAREN tyfields RPAREN COLON ID EQ exp  { $$ = new absyn::FunDec(GetTokPos(), $2, $4, $7, $9); }
+   FUNCTION ID LPAREN tyfields RPAREN EQ exp  { $$ = new absyn::FunDec(errormsg->GetTokPos(), $2, $4, NULL, $7); }
+|  FUNCTION ID LPAREN tyfields RPAREN COLON ID EQ exp  { $$ = new absyn::FunDec(errormsg->GetTokPos(), $2, $4, $7, $9); }
 ;
 
 
@@ -383,8 +373,8 @@ rec_one:
  */
 
 vardec:
-   VAR ID ASSIGN exp  { $$ = new absyn::VarDec(GetTokPos(), $2, NULL, $4); }
-|  VAR ID COLON ID ASSIGN exp  { $$ = new absyn::VarDec(GetTokPos(), $2, $4, $6); }
+   VAR ID ASSIGN exp  { $$ = new absyn::VarDec(errormsg->GetTokPos(), $2, NULL, $4); }
+|  VAR ID COLON ID ASSIGN exp  { $$ = new absyn::VarDec(errormsg->GetTokPos(), $2, $4, $6); }
 ;
 
 
@@ -408,57 +398,99 @@ decs_nonempty:
 ;
 
 decs_nonempty_s:
-   tydec  { $$ = new absyn::TypeDec(GetTokPos(), $1); }
+   tydec  { $$ = new absyn::TypeDec(errormsg->GetTokPos(), $1); }
 |  vardec  { $$ = $1; }
-|  fundec  { $$ = new absyn::FunctionDec(GetTokPos(), $1); }
+|  fundec  { $$ = new absyn::FunctionDec(errormsg->GetTokPos(), $1); }
 ;
 
 %%
 
 /**
  * @brief Error reporting function called by the parser on syntax errors
+ *
+ * A program that ends in a string or comment has had that reported by the
+ * scanner; the syntax error it then causes at the end is not reported.
+ *
  * @param s Error message string
  */
-void yyerror(const char *s) {
-    errormsg_->Error(GetTokPos(), "%s", s);
+void yyerror(yyscan_t scanner, err::ErrorMsg *errormsg,
+             std::unique_ptr<absyn::AbsynTree> &absyn_tree, const char *s) {
+    if (yyget_extra(scanner)->unterminated)
+        return;
+    errormsg->Error(errormsg->GetTokPos(), "%s", s);
+}
+
+/**
+ * @brief Parse what @p scanner reads, then free the scanner
+ *
+ * All lexer and parser state lives in this call, so programs can be
+ * parsed on several threads at the same time.
+ */
+static std::unique_ptr<absyn::AbsynTree> ParseAndDestroy(yyscan_t scanner,
+                                                         err::ErrorMsg *errormsg) {
+    std::unique_ptr<absyn::AbsynTree> absyn_tree;
+    int result = yyparse(scanner, errormsg, absyn_tree);
+    yylex_destroy(scanner);
+
+    // If parsing failed or there were errors, don't return the tree
+    if (result != 0 || errormsg->AnyErrors()) {
+        return nullptr;
+    }
+
+    return absyn_tree;
+}
+
+/**
+ * @brief Parse a Tiger program read from an open stream
+ *
+ * @param in Stream the program is read from; left open
+ * @param errormsg Error message handler for the program
+ * @return Unique pointer to the parsed AST, or nullptr if parsing failed
+ */
+std::unique_ptr<absyn::AbsynTree> Parse(FILE *in, err::ErrorMsg *errormsg) {
+    LexState lex_state(errormsg);
+    yyscan_t scanner;
+    yylex_init_extra(&lex_state, &scanner);
+    yyset_in(in, scanner);
+    return ParseAndDestroy(scanner, errormsg);
+}
+
+/**
+ * @brief Parse a Tiger program held in memory
+ *
+ * @param source Text of the program
+ * @param errormsg Error message handler for the program
+ * @return Unique pointer to the parsed AST, or nullptr if parsing failed
+ */
+std::unique_ptr<absyn::AbsynTree> ParseBuffer(std::string_view source,
+                                              err::ErrorMsg *errormsg) {
+    LexState lex_state(errormsg);
+    yyscan_t scanner;
+    yylex_init_extra(&lex_state, &scanner);
+    // The scanner reads a copy, which yylex_destroy() frees
+    yy_scan_bytes(source.data(), source.size(), scanner);
+    return ParseAndDestroy(scanner, errormsg);
 }
 
 /**
  * @brief Main parsing function for Tiger source files
  *
- * This function orchestrates the complete parsing process:
- * 1. Initializes error handling and lexer state
- * 2. Opens the source file for lexing
- * 3. Invokes the parser (yyparse)
- * 4. Returns the constructed AST if parsing succeeds
- * 5. Handles file I/O and error conditions
+ * Opens the source file and parses it with Parse(FILE *, err::ErrorMsg *).
  *
  * @param fname Path to the Tiger source file to parse
+ * @param errormsg Error message handler for the file
  * @return Unique pointer to the parsed AST, or nullptr if parsing failed
  */
-std::unique_ptr<absyn::AbsynTree> Parse(const std::string &fname) {
-    errormsg_ = new err::ErrorMsg(fname);
-    InitLexer(errormsg_);
-    
+std::unique_ptr<absyn::AbsynTree> Parse(const std::string &fname,
+                                        err::ErrorMsg *errormsg) {
     // Open the input file for the lexer
-    extern FILE *yyin;
-    yyin = fopen(fname.c_str(), "r");
-    if (!yyin) {
-        errormsg_->Error(0, "Cannot open file %s", fname.c_str());
-        return nullptr;
-    }
-    
-    int result = yyparse();
-    fclose(yyin);
-    
-    // If parsing failed or there were errors, don't return the tree
-    if (result != 0 || errormsg_->AnyErrors()) {
+    FILE *in = fopen(fname.c_str(), "r");
+    if (!in) {
+        errormsg->Error(0, "Cannot open file %s", fname.c_str());
         return nullptr;
     }
-    
-    return std::move(absyn_tree_);
-}
 
-err::ErrorMsg *GetErrorMsg() {
-    return errormsg_;
+    std::unique_ptr<absyn::AbsynTree> absyn_tree = Parse(in, errormsg);
+    fclose(in);
+    return absyn_tree;
 }
@@ -1,6 +1,6 @@
 #include "tiger/regalloc/color.h"
 
-extern frame::RegManager *reg_manager;
+#include "tiger/frame/compilation.h"
 
 namespace col {
 } // namespace col
@@ -29,31 +29,39 @@
  *   AssignColors – assign colors to nodes popped from the select stack
  *
  *   If spills occurred:
- *     RewriteProgram – insert load/store code, restart from Build
+ *     RewriteProgram – insert load/store code, update the graph, repeat
  *
  * ═══════════════════════════════════════════════════════════════════════════
  * NODE WORKLISTS (mutually exclusive partitions of all nodes)
  * ═══════════════════════════════════════════════════════════════════════════
  *
- *   precolored_        – machine registers (fixed colors, never simplified)
- *   initial_           – all other nodes before classification
- *   simplify_worklist_ – low-degree (< K), non-move-related
- *   freeze_worklist_   – low-degree (< K), move-related
- *   spill_worklist_    – high-degree (≥ K), spill candidates
- *   spilled_nodes_     – nodes selected for actual spilling
- *   coalesced_nodes_   – nodes merged into another node
- *   colored_nodes_     – nodes that received a color
- *   select_stack_      – nodes removed during simplification (LIFO)
+ *   PRECOLORED – machine registers (fixed colors, never simplified)
+ *   INITIAL    – all other nodes before classification
+ *   SIMPLIFY   – low-degree (< K), non-move-related
+ *   FREEZE     – low-degree (< K), move-related
+ *   SPILL      – high-degree (≥ K), spill candidates
+ *   SPILLED    – nodes selected for actual spilling
+ *   COALESCED  – nodes merged into another node
+ *   COLORED    – nodes that received a color
+ *   SELECT     – nodes removed during simplification (the select stack)
+ *
+ * The sets are kept in nodes_ (see worklist.h): each node carries the
+ * NodeState of its set and sits on an intrusive linked list, so membership
+ * tests and transitions between sets are O(1).
  *
  * ═══════════════════════════════════════════════════════════════════════════
  * MOVE WORKLISTS (mutually exclusive partitions of all moves)
  * ═══════════════════════════════════════════════════════════════════════════
  *
- *   worklist_moves_    – moves that are candidates for coalescing
- *   active_moves_      – moves not yet ready for coalescing
- *   coalesced_moves_   – moves that have been coalesced (eliminated)
- *   constrained_moves_ – moves whose endpoints interfere (cannot coalesce)
- *   frozen_moves_      – moves that will no longer be coalesced
+ *   WORKLIST    – moves that are candidates for coalescing
+ *   ACTIVE      – moves not yet ready for coalescing
+ *   COALESCED   – moves that have been coalesced (eliminated)
+ *   CONSTRAINED – moves whose endpoints interfere (cannot coalesce)
+ *   FROZEN      – moves that will no longer be coalesced
+ *
+ * Moves are identified by their live::MoveTable id and kept in moves_, the
+ * move counterpart of nodes_.  Each node's moves are a vector of ids, so
+ * NodeMoves() and MoveRelated() only look at the node's own moves.
  *
  * ═══════════════════════════════════════════════════════════════════════════
  * COALESCING SAFETY TESTS
@@ -85,19 +93,29 @@
  *   3. For each DEF of the spilled temp t at instruction i:
  *        Insert after i:   movq t_new, slot(%rsp)
  *        Replace t with t_new in i's def list
- *   4. Restarts the entire allocation with the rewritten program
+ *   4. Updates liveness and the interference graph for the new temporaries
+ *      (LiveGraphFactory::Update()) and runs the next round
  *
  * Each new temporary t_new has a very short live range (just one instruction),
- * so it is unlikely to be spilled again.
+ * so it is unlikely to be spilled again, but it can be: its spill cost is
+ * infinite, and an infinite cost only loses to a finite one.
+ *
+ * The rounds are an iterative loop in RegAlloc(), bounded by MAX_ROUNDS.
+ * A function that still spills after the last round is an internal error,
+ * not silently wrong code.
  */
 
 #include "tiger/regalloc/regalloc.h"
 
+#include "tiger/frame/compilation.h"
+#include "tiger/liveness/loops.h"
 #include "tiger/output/logger.h"
+#include "tiger/util/pass_timer.h"
 
+#include <cmath>
+#include <limits>
 #include <sstream>
-
-extern frame::RegManager *reg_manager;
+#include <stdexcept>
 
 namespace ra {
 
@@ -108,13 +126,13 @@ bool IsArm64Target() { return frame::IsArm64AppleTarget(); }
 temp::TempList *SpillBaseUseList(temp::Temp *extra = nullptr) {
   if (IsArm64Target()) {
     if (extra)
-      return new temp::TempList({extra, reg_manager->FramePointer()});
-    return new temp::TempList(reg_manager->FramePointer());
+      return util::New<temp::TempList>({extra, reg_manager->FramePointer()});
+    return util::New<temp::TempList>(reg_manager->FramePointer());
   }
 
   if (extra)
-    return new temp::TempList({extra, reg_manager->StackPointer()});
-  return new temp::TempList(reg_manager->StackPointer());
+    return util::New<temp::TempList>({extra, reg_manager->StackPointer()});
+  return util::New<temp::TempList>(reg_manager->StackPointer());
 }
 
 } // namespace
@@ -124,31 +142,17 @@ temp::TempList *SpillBaseUseList(temp::Temp *extra = nullptr) {
 // ─────────────────────────────────────────────────────────────────────────────
 
 RegAllocator::RegAllocator(frame::Frame *frame, std::unique_ptr<cg::AssemInstr> assem_instr)
-  : frame_(frame), assem_instr_(std::move(assem_instr)) {
+  : frame_(frame), assem_instr_(std::move(assem_instr)),
+    live_graph_factory_(nullptr), flow_graph_factory_(nullptr), move_stamp_(0) {
 
   // Build a global temp→name map for debug printing.
   // LayerMap(A, B) looks up in A first, then falls back to B.
   global_map_ = temp::Map::LayerMap(reg_manager->temp_map_, temp::Map::Name());
+}
 
-  // ── Node worklists (all start empty; populated by MakeWorkList) ──────────
-  precolored_ = new live::INodeList();
-
-  simplify_worklist_ = new live::INodeList();
-  freeze_worklist_ = new live::INodeList();
-  spill_worklist_ = new live::INodeList();
-
-  spilled_nodes_ = new live::INodeList();
-  coalesced_nodes_ = new live::INodeList();
-  colored_nodes_ = new live::INodeList();
-
-  select_stack_ = new live::INodeList();
-
-  // ── Move worklists (all start empty; populated by liveness analysis) ─────
-  coalesced_moves_ = new live::MoveList();
-  constrained_moves_ = new live::MoveList();
-  frozen_moves_ = new live::MoveList();
-  worklist_moves_ = new live::MoveList();
-  active_moves_ = new live::MoveList();
+RegAllocator::~RegAllocator() {
+  delete live_graph_factory_;
+  delete flow_graph_factory_;
 }
 
 // ─────────────────────────────────────────────────────────────────────────────
@@ -158,16 +162,17 @@ RegAllocator::RegAllocator(frame::Frame *frame, std::unique_ptr<cg::AssemInstr>
 /**
  * Top-level register allocation driver.
  *
- * This function implements the outer loop of the IRC algorithm.  It may be
- * called recursively if actual spills are discovered (after RewriteProgram).
+ * This function implements the outer loop of the IRC algorithm.  Each
+ * iteration of the loop is one allocation round; a round that discovers
+ * actual spills rewrites the program and starts the next one.
  *
  * Steps:
  *   1. Build the interference graph (BuildIGraph + AssemFlowGraph + Liveness)
  *   2. Initialize precolored nodes and alias map
  *   3. Classify all nodes into worklists (MakeWorkList)
  *   4. Iterate: Simplify → Coalesce → Freeze → SelectSpill until done
- *   5. AssignColors: pop nodes from select_stack_ and assign registers
- *   6a. If spills: RewriteProgram + recursive RegAlloc
+ *   5. AssignColors: pop nodes from the select stack and assign registers
+ *   6a. If spills: RewriteProgram (which updates the graph), back to step 2
  *   6b. If no spills: remove now-redundant move instructions (src == dst)
  */
 void RegAllocator::RegAlloc() {
@@ -180,77 +185,112 @@ void RegAllocator::RegAlloc() {
   live_graph_factory_->BuildIGraph(assem_instr_.get()->GetInstrList());
 
   // Build the control flow graph (nodes = instructions, edges = control flow).
-  flow_graph_factory_->AssemFlowGraph(assem_instr_.get()->GetInstrList());
+  {
+    util::PassTimer::Scope pass("liveness");
+    flow_graph_factory_->AssemFlowGraph(assem_instr_.get()->GetInstrList());
+  }
 
   // Run liveness analysis: compute live-in/live-out sets and build interference
-  // edges.  Also populates worklist_moves_ with move candidates for coalescing.
-  live_graph_factory_->Liveness(flow_graph_factory_->GetFlowGraph(), &worklist_moves_);
-
-  // ── Step 2: Initialize auxiliary maps ────────────────────────────────────
-  // Assign colors 0..K-1 to precolored nodes (machine registers).
-  InitColor();
-  // Initialize alias map: each node is its own alias (no coalescing yet).
-  InitAlias();
-  // initial_ = all nodes except precolored (these need to be colored).
-  initial_ = live_graph_factory_->GetLiveGraph().interf_graph->Nodes()->Diff(precolored_);
-
-  // ── Step 3: Classify nodes into worklists ─────────────────────────────────
-  MakeWorkList();
-
-  // ── Step 4: Main loop ─────────────────────────────────────────────────────
-  // Priority order: Simplify > Coalesce > Freeze > SelectSpill.
-  // This ensures we always make the most conservative progress first.
-  do {
-    if (!simplify_worklist_->GetList().empty())
-      // Remove a low-degree, non-move-related node (safe to color later).
-      Simplify();
-    else if (!worklist_moves_->GetList().empty())
-      // Try to merge a move-related pair (eliminates a move instruction).
-      Coalesce();
-    else if (!freeze_worklist_->GetList().empty())
-      // Give up coalescing a low-degree move-related node.
-      Freeze();
-    else if (!spill_worklist_->GetList().empty())
-      // Optimistically push a high-degree node (may become an actual spill).
-      SelectSpill();
-  } while (!(simplify_worklist_->GetList().empty()
-           && worklist_moves_->GetList().empty()
-           && freeze_worklist_->GetList().empty()
-           && spill_worklist_->GetList().empty()));
-
-  // ── Step 5: Assign colors ─────────────────────────────────────────────────
-  // Pop nodes from select_stack_ and assign the lowest available color.
-  // Nodes that cannot be colored are added to spilled_nodes_.
-  AssignColors();
-
-  // ── Step 6: Handle spills or finalize ────────────────────────────────────
-  if (!spilled_nodes_->GetList().empty()) {
-    // Actual spills: insert load/store code and restart allocation.
+  // edges.  Also fills the move table.
+  live_graph_factory_->Liveness(flow_graph_factory_->GetFlowGraph());
+  if (util::FunctionStats *stats = frame_->stats_) {
+    live::IGraph *graph = live_graph_factory_->GetLiveGraph().interf_graph;
+    stats->temps_ = graph->TempCount();
+    stats->interference_edges_ = graph->EdgeCount();
+  }
+
+  int max_rounds = MAX_ROUNDS;
+  if (frame::Compilation *compilation = frame::Compilation::Current())
+    if (compilation->MaxAllocRounds() > 0)
+      max_rounds = compilation->MaxAllocRounds();
+
+  for (int round = 1;; ++round) {
+    // Rewriting the spills is timed on its own, nested in this
+    util::PassTimer::Scope pass("coloring");
+
+    // Every move starts in WORKLIST
+    move_table_ = live_graph_factory_->GetLiveGraph().moves;
+    moves_.Reset(move_table_->Count(), MoveState::WORKLIST);
+    move_marks_.assign(move_table_->Count(), 0);
+    ComputeSpillCosts();
+
+    // ── Step 2: Initialize auxiliary maps ──────────────────────────────────
+    // Every node starts in INITIAL; InitColor() then moves the machine
+    // registers to PRECOLORED and assigns them colors 0..K-1.
+    nodes_.Reset(live_graph_factory_->GetLiveGraph().interf_graph);
+    InitColor();
+    // Initialize alias map: each node is its own alias (no coalescing yet).
+    InitAlias();
+
+    // ── Step 3: Classify nodes into worklists ───────────────────────────────
+    MakeWorkList();
+
+    // ── Step 4: Main loop ───────────────────────────────────────────────────
+    // Priority order: Simplify > Coalesce > Freeze > SelectSpill.
+    // This ensures we always make the most conservative progress first.
+    do {
+      if (!nodes_.Empty(NodeState::SIMPLIFY))
+        // Remove a low-degree, non-move-related node (safe to color later).
+        Simplify();
+      else if (!moves_.Empty(MoveState::WORKLIST))
+        // Try to merge a move-related pair (eliminates a move instruction).
+        Coalesce();
+      else if (!nodes_.Empty(NodeState::FREEZE))
+        // Give up coalescing a low-degree move-related node.
+        Freeze();
+      else if (!nodes_.Empty(NodeState::SPILL))
+        // Optimistically push a high-degree node (may become an actual spill).
+        SelectSpill();
+    } while (!(nodes_.Empty(NodeState::SIMPLIFY)
+             && moves_.Empty(MoveState::WORKLIST)
+             && nodes_.Empty(NodeState::FREEZE)
+             && nodes_.Empty(NodeState::SPILL)));
+
+    // ── Step 5: Assign colors ───────────────────────────────────────────────
+    // Pop nodes from the select stack and assign the lowest available color.
+    // Nodes that cannot be colored become SPILLED.
+    AssignColors();
+
+    if (nodes_.Empty(NodeState::SPILLED))
+      break;
+
+    // ── Step 6a: Actual spills: insert load/store code and go again ─────────
+    if (round == max_rounds)
+      throw std::runtime_error("register allocation of " + frame_->GetLabel() +
+                               " did not converge");
     RewriteProgram();
-    RegAlloc();  // Recursive restart with rewritten program
+  }
 
-  } else {
-    // No spills: remove move instructions whose source and destination
-    // received the same physical register (they are now no-ops).
-    assem::InstrList *instr_list = assem_instr_.get()->GetInstrList();
-    std::vector<live::InstrPos> delete_moves;
-    for (auto instr_it = instr_list->GetList().begin();
-         instr_it != instr_list->GetList().end(); instr_it++) {
-      assem::Instr *instr = *instr_it;
-      if (typeid(*instr) == typeid(assem::MoveInstr)) {
-        assem::MoveInstr *move_instr = static_cast<assem::MoveInstr*>(*instr_it);
-        temp::Temp *src_reg = move_instr->src_->GetList().front();
-        temp::Temp *dst_reg = move_instr->dst_->GetList().front();
-        live::INode *src_n = live_graph_factory_->GetTempNodeMap()->Look(src_reg);
-        live::INode *dst_n = live_graph_factory_->GetTempNodeMap()->Look(dst_reg);
-        // If both ends got the same color, the move is a no-op → delete it.
-        if (color_.at(src_n) == color_.at(dst_n))
-          delete_moves.push_back(instr_it);
-      }
+  // ── Step 6b: No spills: remove move instructions whose source and
+  // destination received the same physical register (they are now no-ops).
+  assem::InstrList *instr_list = assem_instr_.get()->GetInstrList();
+  std::vector<live::InstrPos> delete_moves;
+  for (auto instr_it = instr_list->GetList().begin();
+       instr_it != instr_list->GetList().end(); instr_it++) {
+    assem::Instr *instr = *instr_it;
+    if (typeid(*instr) == typeid(assem::MoveInstr)) {
+      assem::MoveInstr *move_instr = static_cast<assem::MoveInstr*>(*instr_it);
+      temp::Temp *src_reg = move_instr->src_->GetList().front();
+      temp::Temp *dst_reg = move_instr->dst_->GetList().front();
+      live::INode *src_n = GetAlias(live_graph_factory_->GetTempNodeMap()->Look(src_reg));
+      live::INode *dst_n = GetAlias(live_graph_factory_->GetTempNodeMap()->Look(dst_reg));
+      // If both ends were coalesced or got the same color, the move is a
+      // no-op → delete it.
+      if (src_n == dst_n || color_[src_n->Key()] == color_[dst_n->Key()])
+        delete_moves.push_back(instr_it);
     }
+  }
+
+  for (auto it : delete_moves)
+    instr_list->Erase(it);
 
-    for (auto it : delete_moves)
-      instr_list->Erase(it);
+  if (util::FunctionStats *stats = frame_->stats_) {
+    stats->liveness_iterations_ = live_graph_factory_->Iterations();
+    moves_.ForEach(MoveState::COALESCED,
+                   [stats](int) { ++stats->coalesced_moves_; });
+    moves_.ForEach(MoveState::CONSTRAINED,
+                   [stats](int) { ++stats->constrained_moves_; });
+    moves_.ForEach(MoveState::FROZEN, [stats](int) { ++stats->frozen_moves_; });
   }
 }
 
@@ -261,9 +301,10 @@ void RegAllocator::RegAlloc() {
 /**
  * Build the final coloring map and transfer ownership to the caller.
  *
- * Iterates over color_ (node → color index) and builds a temp::Map that maps
- * each virtual register (temp::Temp*) to the name string of the physical
- * register it was assigned (e.g., "%rax").
+ * Iterates over the nodes of the interference graph and builds a temp::Map
+ * that maps each virtual register (temp::Temp*) to the name string of the
+ * physical register it was assigned (e.g., "%rax").  Coalesced nodes take
+ * the color of their alias.
  *
  * The name string is looked up via:
  *   global_map_->Look(reg_manager->Registers()->NthTemp(c))
@@ -271,9 +312,9 @@ void RegAllocator::RegAlloc() {
  */
 std::unique_ptr<Result> RegAllocator::TransferResult() {
   temp::Map *coloring = temp::Map::Empty();
-  for (auto node_color : color_) {
-    temp::Temp *reg = node_color.first->NodeInfo();  // virtual register
-    int c = node_color.second;                        // assigned color index
+  for (live::INode *n : live_graph_factory_->GetLiveGraph().interf_graph->Nodes()->GetList()) {
+    temp::Temp *reg = n->NodeInfo();    // virtual register
+    int c = color_[GetAlias(n)->Key()];     // assigned color index
     // Look up the physical register name for color c
     std::string *str = global_map_->Look(reg_manager->Registers()->NthTemp(c));
     coloring->Enter(reg, str);
@@ -289,28 +330,27 @@ std::unique_ptr<Result> RegAllocator::TransferResult() {
 /**
  * Classify all non-precolored nodes into one of three worklists:
  *
- *   spill_worklist_    if degree(n) ≥ K  (high-degree, hard to color)
- *   freeze_worklist_   if degree(n) < K  AND  n is move-related
- *   simplify_worklist_ if degree(n) < K  AND  n is NOT move-related
+ *   SPILL    if degree(n) ≥ K  (high-degree, hard to color)
+ *   FREEZE   if degree(n) < K  AND  n is move-related
+ *   SIMPLIFY if degree(n) < K  AND  n is NOT move-related
  *
  * K = reg_manager->RegCount() = number of allocatable registers.
  *
  * Move-related means the node is the source or destination of a move that
- * is still a candidate for coalescing (in worklist_moves_ or active_moves_).
+ * is still a candidate for coalescing (in WORKLIST or ACTIVE).
  */
 void RegAllocator::MakeWorkList() {
-  for (live::INode *n : initial_->GetList()) {
-    live::INodeList *single_n = new live::INodeList(n);
+  nodes_.ForEach(NodeState::INITIAL, [this](live::INode *n) {
     if (n->IDegree() >= reg_manager->RegCount())
       // High-degree: may need to spill
-      spill_worklist_ = spill_worklist_->Union(single_n);
+      nodes_.MoveTo(n, NodeState::SPILL);
     else if (MoveRelated(n))
       // Low-degree but involved in a move: defer simplification to allow coalescing
-      freeze_worklist_ = freeze_worklist_->Union(single_n);
+      nodes_.MoveTo(n, NodeState::FREEZE);
     else
       // Low-degree, not move-related: safe to simplify immediately
-      simplify_worklist_ = simplify_worklist_->Union(single_n);
-  }
+      nodes_.MoveTo(n, NodeState::SIMPLIFY);
+  });
 }
 
 // ─────────────────────────────────────────────────────────────────────────────
@@ -321,37 +361,55 @@ void RegAllocator::MakeWorkList() {
  * Return the current neighbors of n in the interference graph.
  *
  * Excludes nodes that have already been removed from the graph:
- *   - select_stack_:    nodes removed during Simplify
- *   - coalesced_nodes_: nodes merged into another node
+ *   - SELECT:    nodes removed during Simplify
+ *   - COALESCED: nodes merged into another node
  *
  * This gives the "effective" adjacency list used by the coloring algorithm.
  */
 live::INodeList *RegAllocator::Adjacent(live::INode *n) {
-  return n->AdjList()->Diff(select_stack_->Union(coalesced_nodes_));
+  live::INodeList *res = util::New<live::INodeList>();
+  for (live::INode *m : live_graph_factory_->GetLiveGraph().interf_graph->Neighbors(n)) {
+    NodeState state = nodes_.State(m);
+    if (state != NodeState::SELECT && state != NodeState::COALESCED)
+      res->Append(m);
+  }
+  return res;
+}
+
+/** @brief Return true if move @p id is in ACTIVE or WORKLIST */
+bool RegAllocator::IsLiveMove(int id) {
+  MoveState state = moves_.Of(id);
+  return state == MoveState::ACTIVE || state == MoveState::WORKLIST;
 }
 
 /**
- * Return the moves associated with node n that are still active.
+ * Visit the moves associated with node n that are still active.
  *
- * A move is "active" for n if it is in active_moves_ or worklist_moves_
- * (i.e., it has not yet been coalesced, constrained, or frozen).
+ * A move is "active" for n if it is in ACTIVE or WORKLIST (i.e., it has not
+ * yet been coalesced, constrained, or frozen).  The state is checked as each
+ * move is reached, so @p f may retire the moves it is given.
  *
  * Used to determine whether n is move-related and to find coalescing candidates.
  */
-live::MoveList *RegAllocator::NodeMoves(live::INode *n) {
-  live::MoveList *node_moves = live_graph_factory_->GetLiveGraph().move_list->Look(n);
-  // Intersect with (active_moves_ ∪ worklist_moves_) to get only live moves
-  return node_moves->Intersect(active_moves_->Union(worklist_moves_));
+template <typename Fn> void RegAllocator::NodeMoves(live::INode *n, Fn f) {
+  for (int id : move_table_->NodeMoves(n)) {
+    if (IsLiveMove(id))
+      f(id);
+  }
 }
 
 /**
  * Return true if node n is involved in any active or worklist move.
  *
- * Move-related nodes are kept in freeze_worklist_ rather than
- * simplify_worklist_ to give coalescing a chance to eliminate the move.
+ * Move-related nodes are kept in FREEZE rather than SIMPLIFY to give
+ * coalescing a chance to eliminate the move.
  */
 bool RegAllocator::MoveRelated(live::INode *n) {
-  return !NodeMoves(n)->GetList().empty();
+  for (int id : move_table_->NodeMoves(n)) {
+    if (IsLiveMove(id))
+      return true;
+  }
+  return false;
 }
 
 // ─────────────────────────────────────────────────────────────────────────────
@@ -361,18 +419,16 @@ bool RegAllocator::MoveRelated(live::INode *n) {
 /**
  * Remove a low-degree, non-move-related node from the interference graph.
  *
- * The node is pushed onto select_stack_ (LIFO).  When AssignColors() later
+ * The node is pushed onto the select stack (LIFO).  When AssignColors() later
  * pops it, the node's neighbors will have been colored, so there will be a
  * free color available (since degree < K).
  *
  * Removing the node effectively decrements the degree of all its neighbors,
- * which may enable them to move from spill_worklist_ to simplify_worklist_
- * or freeze_worklist_.
+ * which may enable them to move from SPILL to SIMPLIFY or FREEZE.
  */
 void RegAllocator::Simplify() {
-  live::INode *n = simplify_worklist_->GetList().front();
-  simplify_worklist_->DeleteNode(n);
-  select_stack_->Prepend(n);  // push onto stack (LIFO order for AssignColors)
+  live::INode *n = nodes_.Front(NodeState::SIMPLIFY);
+  nodes_.MoveTo(n, NodeState::SELECT);  // push onto stack (LIFO order for AssignColors)
   live::INodeList *adj_nodes = Adjacent(n);
   for (live::INode *m : adj_nodes->GetList())
     DecrementDegree(m);  // removing n reduces the effective degree of each neighbor
@@ -384,48 +440,41 @@ void RegAllocator::Simplify() {
  * If m's degree drops from K to K-1 (the "threshold"), m transitions from
  * a high-degree node to a low-degree node.  This may enable:
  *   - Moves involving m or its neighbors to be reconsidered for coalescing
- *   - m itself to move from spill_worklist_ to freeze_worklist_ or
- *     simplify_worklist_
+ *   - m itself to move from SPILL to FREEZE or SIMPLIFY
  *
  * Precolored nodes are never decremented (their degree is conceptually ∞).
  */
 void RegAllocator::DecrementDegree(live::INode *m) {
-  if (precolored_->Contain(m))
+  if (IsPrecolored(m))
     return;  // precolored nodes have infinite degree; never decrement
   int d = m->IDegree();
   m->MinusOneIDegree();
   if (d == reg_manager->RegCount()) {
     // m just crossed the threshold from high-degree to low-degree.
     // Enable moves for m and its neighbors (they may now be coalesceable).
-    live::INodeList *single_m = new live::INodeList(m);
-    EnableMoves(single_m->Union(Adjacent(m)));
-    // Move m from spill_worklist_ to the appropriate low-degree worklist.
-    spill_worklist_ = spill_worklist_->Diff(single_m);
+    EnableMoves(m);
+    for (live::INode *t : Adjacent(m)->GetList())
+      EnableMoves(t);
+    // Move m from SPILL to the appropriate low-degree worklist.
     if (MoveRelated(m))
-      freeze_worklist_ = freeze_worklist_->Union(single_m);
+      nodes_.MoveTo(m, NodeState::FREEZE);
     else
-      simplify_worklist_ = simplify_worklist_->Union(single_m);
+      nodes_.MoveTo(m, NodeState::SIMPLIFY);
   }
 }
 
 /**
- * Move moves from active_moves_ to worklist_moves_ for the given nodes.
+ * Move the ACTIVE moves of node n to WORKLIST.
  *
  * When a node's degree drops below K, moves that were previously blocked
- * (in active_moves_) may now be eligible for coalescing.  This function
- * re-enables them by moving them back to worklist_moves_.
+ * (ACTIVE) may now be eligible for coalescing.  This function re-enables
+ * them by moving them back to WORKLIST.
  */
-void RegAllocator::EnableMoves(live::INodeList *nodes) {
-  for (live::INode *n : nodes->GetList()) {
-    live::MoveList *moves = NodeMoves(n);
-    for (live::Move m : moves->GetList()) {
-      if (active_moves_->Contain(m.first, m.second)) {
-        live::MoveList *single_move = new live::MoveList(m);
-        active_moves_ = active_moves_->Diff(single_move);
-        worklist_moves_ = worklist_moves_->Union(single_move);
-      }
-    }
-  }
+void RegAllocator::EnableMoves(live::INode *n) {
+  NodeMoves(n, [this](int id) {
+    if (moves_.Of(id) == MoveState::ACTIVE)
+      moves_.MoveTo(id, MoveState::WORKLIST);
+  });
 }
 
 // ─────────────────────────────────────────────────────────────────────────────
@@ -433,30 +482,29 @@ void RegAllocator::EnableMoves(live::INodeList *nodes) {
 // ─────────────────────────────────────────────────────────────────────────────
 
 /**
- * Try to coalesce the source and destination of a move from worklist_moves_.
+ * Try to coalesce the source and destination of a move from WORKLIST.
  *
  * Coalescing eliminates a move instruction by merging its source and
  * destination into a single node.  This is safe only if the merged node
  * can still be colored (checked by George's or Briggs' test).
  *
  * Algorithm:
- *   1. Pick a move (x, y) from worklist_moves_
+ *   1. Pick a move (x, y) from WORKLIST
  *   2. Resolve aliases: x = GetAlias(x), y = GetAlias(y)
  *   3. Orient so that u is precolored if possible (u = precolored, v = other)
- *   4. Remove the move from worklist_moves_
- *   5. Classify the move:
+ *   4. Move it out of WORKLIST according to its classification:
  *      a. u == v (same node after alias resolution):
- *           → coalesced_moves_; try to simplify u
+ *           → COALESCED; try to simplify u
  *      b. v is precolored OR u and v already interfere:
- *           → constrained_moves_; cannot coalesce
+ *           → CONSTRAINED; cannot coalesce
  *      c. George(u,v) passes (u is precolored) OR Briggs(u,v) passes:
- *           → coalesced_moves_; Combine(u, v) merges v into u
+ *           → COALESCED; Combine(u, v) merges v into u
  *      d. None of the above:
- *           → active_moves_; try again later
+ *           → ACTIVE; try again later
  */
 void RegAllocator::Coalesce() {
-  live::Move m = worklist_moves_->GetList().front();
-  live::MoveList *single_move = new live::MoveList(m);
+  int id = moves_.Front(MoveState::WORKLIST);
+  const live::Move &m = move_table_->Get(id);
   // Resolve aliases: follow the coalescing chain to find the canonical node
   live::INode *x = GetAlias(m.first);
   live::INode *y = GetAlias(m.second);
@@ -472,45 +520,41 @@ void RegAllocator::Coalesce() {
     v = y;
   }
 
-  worklist_moves_ = worklist_moves_->Diff(single_move);
-
   if (u == v) {
     // Case (a): both ends are the same node (already coalesced or trivial)
-    coalesced_moves_ = coalesced_moves_->Union(single_move);
+    moves_.MoveTo(id, MoveState::COALESCED);
     AddWorkList(u);  // u may now be non-move-related → move to simplify
 
   } else if (IsPrecolored(v) || AreAdj(u, v)) {
     // Case (b): both ends are precolored (can't merge two machine regs),
     //           OR the two nodes already interfere (coalescing would be wrong)
-    constrained_moves_ = constrained_moves_->Union(single_move);
+    moves_.MoveTo(id, MoveState::CONSTRAINED);
     AddWorkList(u);
     AddWorkList(v);
 
   } else if (George(u, v) || Briggs(u, v)) {
     // Case (c): coalescing is safe by George's or Briggs' test
-    coalesced_moves_ = coalesced_moves_->Union(single_move);
+    moves_.MoveTo(id, MoveState::COALESCED);
     Combine(u, v);   // merge v into u
     AddWorkList(u);  // u may now be non-move-related → move to simplify
 
   } else {
-    // Case (d): cannot coalesce yet; put back in active_moves_ for later
-    active_moves_ = active_moves_->Union(single_move);
+    // Case (d): cannot coalesce yet; park it in ACTIVE for later
+    moves_.MoveTo(id, MoveState::ACTIVE);
   }
 }
 
 /**
- * After coalescing, check if u can now be moved to simplify_worklist_.
+ * After coalescing, check if u can now be moved to SIMPLIFY.
  *
  * If u is not precolored, not move-related, and has low degree (< K),
- * it no longer needs to stay in freeze_worklist_ and can be simplified.
+ * it no longer needs to stay in FREEZE and can be simplified.
  * This is called after a move involving u is resolved (coalesced or constrained).
  */
 void RegAllocator::AddWorkList(live::INode *u) {
-  if (!IsPrecolored(u) && !MoveRelated(u) && u->IDegree() < reg_manager->RegCount()) {
-    live::INodeList *single_u = new live::INodeList(u);
-    freeze_worklist_ = freeze_worklist_->Diff(single_u);
-    simplify_worklist_ = simplify_worklist_->Union(single_u);
-  }
+  if (nodes_.State(u) == NodeState::FREEZE && !MoveRelated(u) &&
+      u->IDegree() < reg_manager->RegCount())
+    nodes_.MoveTo(u, NodeState::SIMPLIFY);
 }
 
 /**
@@ -553,18 +597,15 @@ bool RegAllocator::Conservative(live::INodeList *nodes) {
 /**
  * Return the canonical representative of node n after coalescing.
  *
- * When node v is coalesced into u, alias_[v] = u.  GetAlias() follows
- * the alias chain recursively until it reaches a node that is not in
- * coalesced_nodes_ (i.e., the root of the coalescing chain).
+ * When node v is coalesced into u, the alias sets of u and v are merged
+ * and named by u.  GetAlias() is a union-find lookup: path compression
+ * keeps it near O(1) even after long chains of coalescing.
  *
  * This is used throughout the algorithm to work with canonical nodes
  * rather than stale coalesced nodes.
  */
 live::INode *RegAllocator::GetAlias(live::INode *n) {
-  if (coalesced_nodes_->Contain(n))
-    return GetAlias(alias_.at(n));  // follow the alias chain
-  else
-    return n;  // n is the canonical representative
+  return nodes_.Node(alias_.Find(n->Key()));
 }
 
 // ─────────────────────────────────────────────────────────────────────────────
@@ -575,32 +616,30 @@ live::INode *RegAllocator::GetAlias(live::INode *n) {
  * Merge node v into node u (coalescing step).
  *
  * After this call:
- *   - v is in coalesced_nodes_ (removed from the graph)
- *   - alias_[v] = u (GetAlias(v) will return u)
+ *   - v is COALESCED (removed from the graph)
+ *   - v's alias set is merged into u's (GetAlias(v) will return u)
  *   - u inherits all of v's moves (for future coalescing)
  *   - All neighbors of v now have an interference edge to u
  *   - Degrees of v's neighbors are decremented (v is removed)
- *   - If u's degree crosses K, u moves from freeze_worklist_ to spill_worklist_
+ *   - If u's degree crosses K, u moves from FREEZE to SPILL
  */
 void RegAllocator::Combine(live::INode *u, live::INode *v) {
-  live::INodeList *single_v = new live::INodeList(v);
-
-  // Remove v from whichever worklist it is currently in
-  if (freeze_worklist_->Contain(v))
-    freeze_worklist_ = freeze_worklist_->Diff(single_v);
-  else
-    spill_worklist_ = spill_worklist_->Diff(single_v);
-
-  // Mark v as coalesced and set its alias to u
-  coalesced_nodes_ = coalesced_nodes_->Union(single_v);
-  alias_[v] = u;
-
-  // Merge v's move list into u's move list (u inherits all of v's moves)
-  live::MoveList *u_moves = live_graph_factory_->GetLiveGraph().move_list->Look(u);
-  live::MoveList *v_moves = live_graph_factory_->GetLiveGraph().move_list->Look(v);
-  live_graph_factory_->GetLiveGraph().move_list->Enter(u, u_moves->Union(v_moves));
+  // Take v off whichever worklist it is in, mark it coalesced and alias it to u
+  nodes_.MoveTo(v, NodeState::COALESCED);
+  alias_.Union(u->Key(), v->Key());
+
+  // Merge v's move list into u's move list (u inherits all of v's moves).
+  // Marking u's moves first keeps the merged list free of duplicates.
+  live::MoveTable::Ids &u_moves = move_table_->NodeMoves(u);
+  ++move_stamp_;
+  for (int id : u_moves)
+    move_marks_[id] = move_stamp_;
+  for (int id : move_table_->NodeMoves(v)) {
+    if (move_marks_[id] != move_stamp_)
+      u_moves.push_back(id);
+  }
   // Re-enable moves of v (they may now be coalesceable via u)
-  EnableMoves(single_v);
+  EnableMoves(v);
 
   // For each neighbor t of v: add edge (t, u) and decrement t's degree
   // (because v is being removed from the graph)
@@ -611,12 +650,9 @@ void RegAllocator::Combine(live::INode *u, live::INode *v) {
   }
 
   // If u's degree just became ≥ K (due to inheriting v's neighbors),
-  // move u from freeze_worklist_ to spill_worklist_
-  if (u->IDegree() >= reg_manager->RegCount() && freeze_worklist_->Contain(u)) {
-    live::INodeList *single_u = new live::INodeList(u);
-    freeze_worklist_ = freeze_worklist_->Diff(single_u);
-    spill_worklist_ = spill_worklist_->Union(single_u);
-  }
+  // move u from FREEZE to SPILL
+  if (u->IDegree() >= reg_manager->RegCount() && nodes_.State(u) == NodeState::FREEZE)
+    nodes_.MoveTo(u, NodeState::SPILL);
 }
 
 // ─────────────────────────────────────────────────────────────────────────────
@@ -666,7 +702,7 @@ bool RegAllocator::Briggs(live::INode *u, live::INode *v) {
 
 /** @brief Return true if n is a precolored (machine register) node */
 bool RegAllocator::IsPrecolored(live::INode *n) {
-  return precolored_->Contain(n);
+  return nodes_.State(n) == NodeState::PRECOLORED;
 }
 
 /** @brief Return true if nodes u and v have an interference edge */
@@ -682,19 +718,17 @@ bool RegAllocator::AreAdj(live::INode *u, live::INode *v) {
  * Give up coalescing a low-degree move-related node.
  *
  * When no simplification or coalescing is possible, we pick a node from
- * freeze_worklist_ and "freeze" it: we give up trying to coalesce its moves
- * and move it to simplify_worklist_ so it can be simplified.
+ * FREEZE and "freeze" it: we give up trying to coalesce its moves and move
+ * it to SIMPLIFY so it can be simplified.
  *
  * FreezeMoves() marks all moves involving u as frozen (no longer candidates
  * for coalescing), which may enable the other endpoints of those moves to
  * also be simplified.
  */
 void RegAllocator::Freeze() {
-  live::INode *u = freeze_worklist_->GetList().front();
-  live::INodeList *single_u = new live::INodeList(u);
-  // Move u from freeze_worklist_ to simplify_worklist_
-  freeze_worklist_ = freeze_worklist_->Diff(single_u);
-  simplify_worklist_ = simplify_worklist_->Union(single_u);
+  live::INode *u = nodes_.Front(NodeState::FREEZE);
+  // Move u from FREEZE to SIMPLIFY
+  nodes_.MoveTo(u, NodeState::SIMPLIFY);
   // Freeze all moves involving u
   FreezeMoves(u);
 }
@@ -703,36 +737,32 @@ void RegAllocator::Freeze() {
  * Freeze all moves associated with node u.
  *
  * For each move (u, v) or (v, u) that is still active:
- *   1. Move it from active_moves_ to frozen_moves_
+ *   1. Move it from ACTIVE or WORKLIST to FROZEN
  *   2. If v is now non-move-related and low-degree, move v from
- *      freeze_worklist_ to simplify_worklist_
+ *      FREEZE to SIMPLIFY
  *
  * This is called both from Freeze() and from SelectSpill() (to freeze moves
  * of the selected spill candidate before pushing it onto the select stack).
  */
 void RegAllocator::FreezeMoves(live::INode *u) {
-  live::MoveList *u_moves = NodeMoves(u);
-  live::INode *v;
+  NodeMoves(u, [this, u](int id) {
+    const live::Move &m = move_table_->Get(id);
+    live::INode *v;
 
-  for (live::Move m : u_moves->GetList()) {
     // Find the other endpoint of the move (not u)
     if (GetAlias(m.second) == GetAlias(u))
       v = GetAlias(m.first);
     else
       v = GetAlias(m.second);
 
-    // Move this move from active_moves_ to frozen_moves_
-    live::MoveList *single_m = new live::MoveList(m);
-    active_moves_ = active_moves_->Diff(single_m);
-    frozen_moves_ = frozen_moves_->Union(single_m);
+    // Retire the move: it will no longer be considered for coalescing
+    moves_.MoveTo(id, MoveState::FROZEN);
 
     // If v is now non-move-related and low-degree, it can be simplified
-    if (NodeMoves(v)->GetList().empty() && v->IDegree() < reg_manager->RegCount()) {
-      live::INodeList *single_v = new live::INodeList(v);
-      freeze_worklist_ = freeze_worklist_->Diff(single_v);
-      simplify_worklist_ = simplify_worklist_->Union(single_v);
-    }
-  }
+    if (nodes_.State(v) == NodeState::FREEZE && !MoveRelated(v) &&
+        v->IDegree() < reg_manager->RegCount())
+      nodes_.MoveTo(v, NodeState::SIMPLIFY);
+  });
 }
 
 // ─────────────────────────────────────────────────────────────────────────────
@@ -740,10 +770,10 @@ void RegAllocator::FreezeMoves(live::INode *u) {
 // ─────────────────────────────────────────────────────────────────────────────
 
 /**
- * Select a node from spill_worklist_ as a potential spill candidate.
+ * Select a node from SPILL as a potential spill candidate.
  *
- * This is "optimistic" spilling: the selected node is moved to
- * simplify_worklist_ (not immediately spilled).  It may still receive a
+ * This is "optimistic" spilling: the selected node is moved to SIMPLIFY
+ * (not immediately spilled).  It may still receive a
  * color during AssignColors() if enough colors are available.  Only if
  * AssignColors() cannot color it does it become an actual spill.
  *
@@ -751,61 +781,77 @@ void RegAllocator::FreezeMoves(live::INode *u) {
  * coalescing it.
  */
 void RegAllocator::SelectSpill() {
-  assert(!spill_worklist_->GetList().empty());
+  assert(!nodes_.Empty(NodeState::SPILL));
   live::INode *m = HeuristicSelect();  // choose the best candidate to spill
 
-  live::INodeList *single_m = new live::INodeList(m);
-  // Move from spill_worklist_ to simplify_worklist_ (optimistic)
-  spill_worklist_ = spill_worklist_->Diff(single_m);
-  simplify_worklist_ = simplify_worklist_->Union(single_m);
+  // Move from SPILL to SIMPLIFY (optimistic)
+  nodes_.MoveTo(m, NodeState::SIMPLIFY);
   FreezeMoves(m);  // give up coalescing moves of the spill candidate
 }
 
 /**
- * Heuristic for choosing which node to spill.
+ * Compute the spill cost of every node once per allocation round.
+ *
+ * Follows Chaitin: every use or def of a temp costs one load or store if the
+ * temp is spilled, and an instruction nested d loops deep runs roughly 10^d
+ * times as often as straight-line code.  Loop depths come from the natural
+ * loops of the flow graph (dominator tree → back edges → loop bodies).
  *
- * Uses a "furthest next use" heuristic: prefer to spill the temporary whose
- * next use is furthest away from its last definition.  This minimizes the
- * number of load/store instructions inserted by RewriteProgram().
+ * Temps created by RewriteProgram() live across a single instruction;
+ * spilling them again would only add more code, so they cost ∞.  That makes
+ * them the last choice, not an impossible one: HeuristicSelect() picks one
+ * when every candidate costs ∞.
+ */
+void RegAllocator::ComputeSpillCosts() {
+  // Cap the exponent so deeply nested loops don't overflow the weights
+  constexpr int MAX_DEPTH = 8;
+
+  live::IGraph *interf_graph = live_graph_factory_->GetLiveGraph().interf_graph;
+  auto tn_map = live_graph_factory_->GetTempNodeMap();
+  df::BlockGraph *blocks = live_graph_factory_->GetBlockGraph();
+  df::DomTree dom(blocks);
+  df::LoopNest loops(blocks, &dom);
+
+  spill_cost_.assign(interf_graph->nodecount_, 0.0);
+  for (fg::FNode *fnode : flow_graph_factory_->GetFlowGraph()->Nodes()->GetList()) {
+    double weight = std::pow(10.0, std::min(loops.Depth(fnode), MAX_DEPTH));
+    assem::Instr *instr = fnode->NodeInfo();
+    for (temp::Temp *t : instr->Use()->GetList())
+      spill_cost_[tn_map->Look(t)->Key()] += weight;
+    for (temp::Temp *t : instr->Def()->GetList())
+      spill_cost_[tn_map->Look(t)->Key()] += weight;
+  }
+
+  for (temp::Temp *t : spill_temps_) {
+    live::INode *n = tn_map->Look(t);
+    if (n)
+      spill_cost_[n->Key()] = std::numeric_limits<double>::infinity();
+  }
+}
+
+/**
+ * Heuristic for choosing which node to spill.
  *
- * Special case: if a temporary is defined but never used, spill it immediately
- * (it is dead code and the spill cost is zero).
+ * Picks the spill candidate with the lowest spill_cost_ / degree: a temp
+ * that is rarely used (especially inside loops) but interferes with many
+ * others frees the most room for the least spill code.
  *
- * Note: A more sophisticated heuristic would weight by loop nesting depth
- * (temporaries used inside loops are more expensive to spill).
+ * The costs were computed once per round by ComputeSpillCosts(), so each
+ * selection is a single pass over SPILL.
  *
  * @return The node selected for potential spilling
  */
 live::INode *RegAllocator::HeuristicSelect() {
   live::INode *res = nullptr;
-  int max_distance = 0;
-  assem::InstrList *instr_list = (*assem_instr_).GetInstrList();
-
-  for (live::INode *n : spill_worklist_->GetList()) {
-    int pos = 0;
-    int start = 0;
-    int distance = -1;
-    for (assem::Instr *instr : instr_list->GetList()) {
-      // Track the most recent definition and measure how far away the next use
-      // occurs. Larger gaps make spilling cheaper because a single reload can
-      // often cover a long dead region.
-      if (instr->Def()->Contain(n->NodeInfo())) {
-        start = pos;  // record position of last definition
-      }
-      if (instr->Use()->Contain(n->NodeInfo())) {
-        distance = pos - start;  // distance from def to use
-        if (distance > max_distance) {
-          max_distance = distance;
-          res = n;  // prefer the node with the largest def-to-use distance
-        }
-      }
-      pos++;
-    }
+  double min_cost = 0;
 
-    // Defined but never used: spill cost is zero, spill immediately
-    if (distance == -1)
-      return n;
-  }
+  nodes_.ForEach(NodeState::SPILL, [&](live::INode *n) {
+    double cost = spill_cost_[n->Key()] / n->IDegree();
+    if (res == nullptr || cost < min_cost) {
+      min_cost = cost;
+      res = n;
+    }
+  });
 
   return res;
 }
@@ -815,58 +861,54 @@ live::INode *RegAllocator::HeuristicSelect() {
 // ─────────────────────────────────────────────────────────────────────────────
 
 /**
- * Assign colors (physical registers) to nodes popped from select_stack_.
+ * Assign colors (physical registers) to nodes popped from the select stack.
  *
- * Nodes were pushed onto select_stack_ in simplification order (LIFO).
+ * Nodes were pushed onto the select stack in simplification order (LIFO).
  * We pop them in reverse order (the last simplified node is colored first).
  * For each node n:
  *   1. Start with all K colors available
  *   2. For each neighbor w of n (in the original graph):
  *        If GetAlias(w) is already colored, remove its color from available
- *   3. If no colors remain: n is an actual spill → add to spilled_nodes_
+ *   3. If no colors remain: n is an actual spill → mark it SPILLED
  *   4. Otherwise: assign the lowest available color to n
  *
- * After coloring all stack nodes, propagate colors to coalesced nodes:
- *   color[v] = color[GetAlias(v)]  for all v in coalesced_nodes_
+ * Coalesced nodes get no color of their own; they share the color of their
+ * alias, which TransferResult() and the final move cleanup look up.
  *
- * Note: We use the full AdjList (not Adjacent()) here because we need to
+ * Note: We use all graph neighbours (not Adjacent()) here because we need to
  * consider all original interference edges, including those to nodes that
  * were removed during simplification.
  */
 void RegAllocator::AssignColors() {
-  while (!select_stack_->GetList().empty()) {
-    live::INode *n = select_stack_->GetList().front();
-    select_stack_->DeleteNode(n);
+  while (!nodes_.Empty(NodeState::SELECT)) {
+    live::INode *n = nodes_.Back(NodeState::SELECT);
 
     // Start with all colors available
-    std::set<int> ok_colors;
+    std::set<int, std::less<int>, util::TrackedAllocator<int, RegAllocator>>
+        ok_colors;
     for (int c = 0; c < reg_manager->RegCount(); ++c)
       ok_colors.emplace(c);
 
     // Remove colors used by already-colored neighbors
-    live::INodeList *adj_list = n->AdjList();
-    for (live::INode *w : adj_list->GetList()) {
+    for (live::INode *w : live_graph_factory_->GetLiveGraph().interf_graph->Neighbors(n)) {
       live::INode *alias = GetAlias(w);
       // Only consider neighbors that have already been colored
-      if (colored_nodes_->Union(precolored_)->Contain(alias))
-        ok_colors.erase(color_.at(alias));  // this color is taken
+      NodeState state = nodes_.State(alias);
+      if (state == NodeState::COLORED || state == NodeState::PRECOLORED)
+        ok_colors.erase(color_[alias->Key()]);  // this color is taken
     }
 
-    live::INodeList *single_n = new live::INodeList(n);
     if (ok_colors.empty()) {
       // No color available: actual spill
-      spilled_nodes_ = spilled_nodes_->Union(single_n);
+      nodes_.MoveTo(n, NodeState::SPILLED);
     } else {
       // Assign the lowest available color
-      colored_nodes_ = colored_nodes_->Union(single_n);
+      nodes_.MoveTo(n, NodeState::COLORED);
       int c = *(ok_colors.begin());
-      color_[n] = c;
+      color_[n->Key()] = c;
     }
   }
 
-  // Propagate colors to coalesced nodes (they share the color of their alias)
-  for (live::INode *n : coalesced_nodes_->GetList())
-    color_[n] = color_[GetAlias(n)];
 }
 
 // ─────────────────────────────────────────────────────────────────────────────
@@ -876,7 +918,7 @@ void RegAllocator::AssignColors() {
 /**
  * Insert load/store code for actual spills and reset state for re-allocation.
  *
- * For each node v in spilled_nodes_:
+ * For each SPILLED node v:
  *   1. Allocate a new frame slot: acc = frame_->AllocLocal(true)
  *      The slot address is mem_pos = "offset(%rsp)" or similar.
  *   2. For each instruction that USES v:
@@ -893,13 +935,23 @@ void RegAllocator::AssignColors() {
  * Each t_new has a very short live range (just one instruction), so it is
  * unlikely to be spilled again in the next iteration.
  *
- * After rewriting, all worklists and maps are cleared so RegAlloc() can
- * restart from scratch with the rewritten instruction list.
+ * Every inserted or rewritten instruction is recorded so that, after the
+ * flow graph is rebuilt, LiveGraphFactory::Update() only has to redo
+ * liveness and interference around them.  Worklists are rebuilt by the next
+ * round of RegAlloc().
  */
 void RegAllocator::RewriteProgram() {
-  live::NodeInstrMap *node_instr_map = live_graph_factory_->GetNodeInstrMap().get();
+  util::PassTimer::Scope pass("spill rewrite");
 
-  for (live::INode *v : spilled_nodes_->GetList()) {
+  live::NodeInstrMap *node_instr_map = live_graph_factory_->GetNodeInstrMap().get();
+  std::vector<live::INode *> spilled;
+  std::vector<live::InstrPos> rewritten;
+  int loads = 0, stores = 0;
+
+  nodes_.ForEach(NodeState::SPILLED, [this, node_instr_map, &spilled,
+                                      &rewritten, &loads,
+                                      &stores](live::INode *v) {
+    spilled.push_back(v);
     // Allocate a new frame slot for the spilled temporary
     frame::Access *acc = frame_->AllocLocal(true);
     std::string mem_pos = acc->MunchAccess(frame_);  // e.g., "-8(%rsp)"
@@ -917,6 +969,7 @@ void RegAllocator::RewriteProgram() {
       // Create a fresh temporary for this use/def site
       // (each site gets its own t_new to keep live ranges short)
       temp::Temp *new_reg = temp::TempFactory::NewTemp();
+      spill_temps_.push_back(new_reg);
 
       // ── Handle USE of the spilled temporary ──────────────────────────────
       if (instr->Use()->Contain(v->NodeInfo())) {
@@ -935,14 +988,17 @@ void RegAllocator::RewriteProgram() {
           instr_ss << "ldur `d0, " << mem_pos;
         else
           instr_ss << "movq " << mem_pos << ", `d0";
-        assem::Instr *fetch_instr = new assem::OperInstr(
+        assem::Instr *fetch_instr = util::New<assem::OperInstr>(
             instr_ss.str(),
-            new temp::TempList(new_reg),                    // def: new_reg
+            util::New<temp::TempList>(new_reg),              // def: new_reg
             SpillBaseUseList(),                              // use: frame base
             nullptr);
-        assem_instr_.get()->GetInstrList()->Insert(instr_pos, fetch_instr);
+        rewritten.push_back(
+            assem_instr_.get()->GetInstrList()->Insert(instr_pos, fetch_instr));
+        ++loads;
         instr_ss.str("");
       }
+      rewritten.push_back(instr_pos);
 
       // ── Handle DEF of the spilled temporary ──────────────────────────────
       if (instr->Def()->Contain(v->NodeInfo())) {
@@ -958,33 +1014,37 @@ void RegAllocator::RewriteProgram() {
         // Insert a store instruction AFTER the current instruction:
         //   movq new_reg, mem_pos
         instr_ss << (IsArm64Target() ? "stur `s0, " : "movq `s0, ") << mem_pos;
-        assem::Instr *store_instr = new assem::OperInstr(
+        assem::Instr *store_instr = util::New<assem::OperInstr>(
             instr_ss.str(),
             nullptr,                                                    // no def
             SpillBaseUseList(new_reg),                                  // use: new_reg, frame base
             nullptr);
-        assem_instr_.get()->GetInstrList()->Insert(++instr_pos, store_instr);
+        rewritten.push_back(
+            assem_instr_.get()->GetInstrList()->Insert(++instr_pos, store_instr));
+        ++stores;
       }
     }
+  });
+
+  if (util::FunctionStats *stats = frame_->stats_) {
+    ++stats->spill_rounds_;
+    stats->spilled_temps_ += spilled.size();
+    stats->loads_ += loads;
+    stats->stores_ += stores;
   }
 
   // ── Reset all worklists and maps for the next allocation pass ─────────────
-  spilled_nodes_->Clear();
-  colored_nodes_->Clear();
-  coalesced_nodes_->Clear();
-
-  coalesced_moves_->Clear();
-  constrained_moves_->Clear();
-  frozen_moves_->Clear();
-  worklist_moves_->Clear();
-  active_moves_->Clear();
-
+  // (node and move sets are rebuilt from the new graph by RegAlloc())
   color_.clear();
-  alias_.clear();
 
-  // Destroy the old flow graph and liveness analysis (will be rebuilt)
-  delete flow_graph_factory_;
-  delete live_graph_factory_;
+  // The flow graph is cheap to rebuild (one pass, no fixed point); liveness
+  // and the interference graph are only patched.
+  fg::FlowGraphFactory *old_flow_graph_factory = flow_graph_factory_;
+  flow_graph_factory_ = new fg::FlowGraphFactory();
+  flow_graph_factory_->AssemFlowGraph(assem_instr_.get()->GetInstrList());
+  live_graph_factory_->Update(flow_graph_factory_->GetFlowGraph(), spilled,
+                              rewritten);
+  delete old_flow_graph_factory;
 }
 
 // ─────────────────────────────────────────────────────────────────────────────
@@ -995,106 +1055,71 @@ void RegAllocator::RewriteProgram() {
  * Initialize the color map for precolored (machine register) nodes.
  *
  * Assigns colors 0, 1, ..., K-1 to the K machine registers in the order
- * returned by reg_manager->Registers().  Also populates precolored_ with
- * the corresponding interference graph nodes.
+ * returned by reg_manager->Registers().  Also marks the corresponding
+ * interference graph nodes PRECOLORED.
  *
  * Precolored nodes have infinite degree (set by BuildIGraph) so they are
  * never simplified or spilled.
  */
 void RegAllocator::InitColor() {
   auto tn_map = live_graph_factory_->GetTempNodeMap();
+  color_.assign(live_graph_factory_->GetLiveGraph().interf_graph->nodecount_, -1);
   int c = 0;
   for (temp::Temp *reg : reg_manager->Registers()->GetList()) {
     live::INode *node = tn_map->Look(reg);
-    precolored_->Append(node);   // add to precolored set
-    color_[node] = c++;          // assign color index
+    nodes_.MoveTo(node, NodeState::PRECOLORED);
+    color_[node->Key()] = c++;   // assign color index
   }
 }
 
 /**
- * Initialize the alias map so each node is its own alias.
+ * Initialize the alias sets so each node is its own alias.
  *
- * Before any coalescing, every node n satisfies alias_[n] = n.
- * As coalescing proceeds, alias_[v] = u when v is merged into u.
- * GetAlias() follows the chain to find the canonical representative.
+ * Before any coalescing, every node is a singleton set named by itself.
+ * As coalescing proceeds, Combine() merges v's set into u's.
  */
 void RegAllocator::InitAlias() {
-  live::INodeList *all_nodes = live_graph_factory_->GetLiveGraph().interf_graph->Nodes();
-  for (live::INode *n : all_nodes->GetList())
-    alias_[n] = n;  // each node is initially its own alias
+  alias_.Reset(live_graph_factory_->GetLiveGraph().interf_graph->nodecount_);
 }
 
 void RegAllocator::PrintMoveList() {
-
-  std::cout << "worklist_moves_: ";
-  for (live::Move m : worklist_moves_->GetList()) {
-    std::cout <<  *global_map_->Look(m.first->NodeInfo()) << "->" 
-              << *global_map_->Look(m.second->NodeInfo()) << " ";
-  }
-  std::cout << std::endl;
-
-  std::cout << "coalesced_moves_: ";
-  for (live::Move m : coalesced_moves_->GetList()) {
-    std::cout <<  *global_map_->Look(m.first->NodeInfo()) << "->" 
-              << *global_map_->Look(m.second->NodeInfo()) << " ";
-  }
-  std::cout << std::endl;
-
-  std::cout << "constrained_moves_: ";
-  for (live::Move m : constrained_moves_->GetList()) {
-    std::cout <<  *global_map_->Look(m.first->NodeInfo()) << "->" 
-              << *global_map_->Look(m.second->NodeInfo()) << " ";
-  }
-  std::cout << std::endl;
-
-  std::cout << "frozen_moves_: ";
-  for (live::Move m : frozen_moves_->GetList()) {
-    std::cout <<  *global_map_->Look(m.first->NodeInfo()) << "->" 
-              << *global_map_->Look(m.second->NodeInfo()) << " ";
-  }
-  std::cout << std::endl;
-
-  std::cout << "active_moves_: ";
-  for (live::Move m : active_moves_->GetList()) {
-    std::cout <<  *global_map_->Look(m.first->NodeInfo()) << "->" 
-              << *global_map_->Look(m.second->NodeInfo()) << " ";
-  }
-  std::cout << std::endl;
+  auto print = [this](const char *name, MoveState state) {
+    std::cout << name << ": ";
+    moves_.ForEach(state, [this](int id) {
+      const live::Move &m = move_table_->Get(id);
+      std::cout << global_map_->NameOf(m.first->NodeInfo()) << "->"
+                << global_map_->NameOf(m.second->NodeInfo()) << " ";
+    });
+    std::cout << std::endl;
+  };
+  print("worklist_moves", MoveState::WORKLIST);
+  print("coalesced_moves", MoveState::COALESCED);
+  print("constrained_moves", MoveState::CONSTRAINED);
+  print("frozen_moves", MoveState::FROZEN);
+  print("active_moves", MoveState::ACTIVE);
 }
 
 void RegAllocator::PrintAlias() {
   std::cout << "PrintAlias: ";
   auto all_nodes = live_graph_factory_->GetLiveGraph().interf_graph->Nodes();
   for (auto n : all_nodes->GetList())
-    std::cout << *global_map_->Look(n->NodeInfo()) << '-'
-              << *global_map_->Look(alias_[n]->NodeInfo()) << ' ';
+    std::cout << global_map_->NameOf(n->NodeInfo()) << '-'
+              << global_map_->NameOf(GetAlias(n)->NodeInfo()) << ' ';
   std::cout << std::endl;
 }
 
 void RegAllocator::PrintNodeList() {
-  std::cout << "spilled_nodes_: ";
-  for (auto n : spilled_nodes_->GetList()) {
-    std::cout << *global_map_->Look(n->NodeInfo()) << ' ';
-  }
-  std::cout << std::endl;
-
-  std::cout << "coalesced_nodes_: ";
-  for (auto n : coalesced_nodes_->GetList()) {
-    std::cout << *global_map_->Look(n->NodeInfo()) << ' ';
-  }
-  std::cout << std::endl;
-
-  std::cout << "colored_nodes_: ";
-  for (auto n : colored_nodes_->GetList()) {
-    std::cout << *global_map_->Look(n->NodeInfo()) << ' ';
-  }
-  std::cout << std::endl;
-
-  std::cout << "select_stack_: ";
-  for (auto n : select_stack_->GetList()) {
-    std::cout << *global_map_->Look(n->NodeInfo()) << ' ';
-  }
-  std::cout << std::endl;
+  auto print = [this](const char *name, NodeState state) {
+    std::cout << name << ": ";
+    nodes_.ForEach(state, [this](live::INode *n) {
+      std::cout << global_map_->NameOf(n->NodeInfo()) << ' ';
+    });
+    std::cout << std::endl;
+  };
+  print("spilled", NodeState::SPILLED);
+  print("coalesced", NodeState::COALESCED);
+  print("colored", NodeState::COLORED);
+  print("select_stack", NodeState::SELECT);
 }
 
 
@@ -20,28 +20,30 @@
  *   5. Freeze       – give up coalescing a low-degree move-related node
  *   6. SelectSpill  – choose a high-degree node to potentially spill
  *   7. AssignColors – assign colors (registers) to nodes on the select stack
- *   8. RewriteProgram – if spills occurred, insert load/store code and restart
+ *   8. RewriteProgram – if spills occurred, insert load/store code, update
+ *                      the interference graph and go back to step 2
  *
  * ─────────────────────────────────────────────────────────────────────────
  * Worklists
  * ─────────────────────────────────────────────────────────────────────────
- * Nodes are classified into mutually exclusive worklists:
- *   precolored_        – machine registers (pre-assigned colors)
- *   initial_           – all other nodes (not yet classified)
- *   simplify_worklist_ – low-degree, non-move-related nodes (ready to simplify)
- *   freeze_worklist_   – low-degree, move-related nodes
- *   spill_worklist_    – high-degree nodes (candidates for spilling)
- *   spilled_nodes_     – nodes selected for spilling
- *   coalesced_nodes_   – nodes that have been coalesced into another
- *   colored_nodes_     – nodes that have been successfully colored
- *   select_stack_      – nodes removed from the graph (in simplification order)
+ * Nodes are classified into mutually exclusive worklists, one per NodeState
+ * (see worklist.h):
+ *   PRECOLORED – machine registers (pre-assigned colors)
+ *   INITIAL    – all other nodes (not yet classified)
+ *   SIMPLIFY   – low-degree, non-move-related nodes (ready to simplify)
+ *   FREEZE     – low-degree, move-related nodes
+ *   SPILL      – high-degree nodes (candidates for spilling)
+ *   SPILLED    – nodes selected for spilling
+ *   COALESCED  – nodes that have been coalesced into another
+ *   COLORED    – nodes that have been successfully colored
+ *   SELECT     – nodes removed from the graph (the select stack)
  *
- * Move worklists:
- *   worklist_moves_    – moves that are candidates for coalescing
- *   active_moves_      – moves not yet ready for coalescing
- *   coalesced_moves_   – moves that have been coalesced
- *   constrained_moves_ – moves whose endpoints interfere (cannot coalesce)
- *   frozen_moves_      – moves that will no longer be coalesced
+ * Move worklists, one per MoveState:
+ *   WORKLIST    – moves that are candidates for coalescing
+ *   ACTIVE      – moves not yet ready for coalescing
+ *   COALESCED   – moves that have been coalesced
+ *   CONSTRAINED – moves whose endpoints interfere (cannot coalesce)
+ *   FROZEN      – moves that will no longer be coalesced
  *
  * ─────────────────────────────────────────────────────────────────────────
  * Coalescing safety tests
@@ -62,13 +64,15 @@
  * load/store instructions:
  *   - Before each use:  movq slot(%rsp), t_new
  *   - After each def:   movq t_new, slot(%rsp)
- * The allocator then restarts from scratch with the rewritten program.
+ * LiveGraphFactory::Update() then patches liveness and the interference
+ * graph around the new temps instead of rebuilding them, and the next round
+ * starts.  At most MAX_ROUNDS rounds are run.
  */
 
 #ifndef TIGER_REGALLOC_REGALLOC_H_
 #define TIGER_REGALLOC_REGALLOC_H_
 
-#include <unordered_map>
+#include <vector>
 
 #include "tiger/codegen/assem.h"
 #include "tiger/codegen/codegen.h"
@@ -76,7 +80,9 @@
 #include "tiger/frame/temp.h"
 #include "tiger/liveness/liveness.h"
 #include "tiger/regalloc/color.h"
+#include "tiger/regalloc/worklist.h"
 #include "tiger/util/graph.h"
+#include "tiger/util/union_find.h"
 
 namespace ra {
 
@@ -113,7 +119,7 @@ public:
  *   1. Build the interference graph (via liveness analysis)
  *   2. Iteratively simplify, coalesce, freeze, and spill
  *   3. Assign colors (physical registers) to virtual registers
- *   4. Rewrite the program if spills occurred, then restart
+ *   4. Rewrite the program if spills occurred, update the graph and repeat
  *
  * Typical usage:
  * @code
@@ -133,11 +139,23 @@ public:
    */
   RegAllocator(frame::Frame *frame, std::unique_ptr<cg::AssemInstr> assem_instr);
 
+  /** @brief Free the flow graph and live graph of the last round */
+  ~RegAllocator();
+
+  /// Upper bound on allocation rounds, unless the current compilation sets
+  /// another.  Spill temps cost infinitely much, but when every candidate
+  /// does, HeuristicSelect() still picks one of them; this bound is what
+  /// stops the rounds in that case.  Real programs need only a few.
+  static constexpr int MAX_ROUNDS = 32;
+
   /**
    * @brief Perform register allocation
    *
    * Runs the iterated register coalescing algorithm until no spills remain.
    * After this call, TransferResult() returns the final colored instruction list.
+   *
+   * @throw std::runtime_error if spills remain after MAX_ROUNDS rounds, or
+   *        after frame::Compilation::MaxAllocRounds() if it is set
    */
   void RegAlloc();
 
@@ -148,32 +166,29 @@ public:
   std::unique_ptr<Result> TransferResult();
 
 private:
+  /// The arrays are charged to RegAllocator in an allocation profile
+  template <typename T>
+  using Vector = std::vector<T, util::TrackedAllocator<T, RegAllocator>>;
+
   frame::Frame *frame_;                          ///< Activation record for the function
   std::unique_ptr<cg::AssemInstr> assem_instr_;  ///< Abstract assembly (input)
   live::LiveGraphFactory *live_graph_factory_;   ///< Liveness analysis factory
   fg::FlowGraphFactory *flow_graph_factory_;     ///< Control flow graph factory
 
   // ── Node worklists ──────────────────────────────────────────────────────
-  live::INodeList *precolored_;         ///< Machine register nodes (pre-colored)
-  live::INodeList *initial_;            ///< Unclassified nodes (not yet in any worklist)
-  live::INodeList *select_stack_;       ///< Nodes removed during simplification (LIFO)
-  live::INodeList *simplify_worklist_;  ///< Low-degree, non-move-related nodes
-  live::INodeList *freeze_worklist_;    ///< Low-degree, move-related nodes
-  live::INodeList *spill_worklist_;     ///< High-degree nodes (spill candidates)
-  live::INodeList *spilled_nodes_;      ///< Nodes selected for actual spilling
-  live::INodeList *coalesced_nodes_;    ///< Nodes merged into another node
-  live::INodeList *colored_nodes_;      ///< Nodes that have been assigned a color
+  NodeWorklists nodes_;  ///< State tag and worklist membership of every node
 
   // ── Move worklists ───────────────────────────────────────────────────────
-  live::MoveList *coalesced_moves_;     ///< Moves that have been coalesced
-  live::MoveList *constrained_moves_;   ///< Moves whose endpoints interfere
-  live::MoveList *frozen_moves_;        ///< Moves that will no longer be coalesced
-  live::MoveList *worklist_moves_;      ///< Moves that are candidates for coalescing
-  live::MoveList *active_moves_;        ///< Moves not yet ready for coalescing
+  live::MoveTable *move_table_;    ///< All moves of this round, by id
+  MoveWorklists moves_;            ///< State tag and worklist membership of every move
+  Vector<int> move_marks_;         ///< Scratch marks for merging move lists
+  int move_stamp_;                 ///< Current mark value in move_marks_
 
   // ── Auxiliary maps ───────────────────────────────────────────────────────
-  std::unordered_map<live::INode*, live::INode*> alias_; ///< Coalescing alias map
-  std::unordered_map<live::INode*, int> color_;          ///< Node → color (register index)
+  util::UnionFind alias_;                                ///< Coalescing alias sets (by node key)
+  Vector<int> color_;                                    ///< Node key → color (register index)
+  Vector<double> spill_cost_;                            ///< Node key → spill cost
+  Vector<temp::Temp *> spill_temps_;                     ///< Temps introduced by spilling, in order
 
   std::unique_ptr<Result> result_;  ///< The allocation result (built by AssignColors)
 
@@ -182,7 +197,7 @@ private:
   // ── Initialization ───────────────────────────────────────────────────────
   /** @brief Initialize the color map from precolored registers */
   void InitColor();
-  /** @brief Initialize the alias map (each node is its own alias initially) */
+  /** @brief Initialize the alias sets (each node is its own alias initially) */
   void InitAlias();
 
   // ── Main algorithm steps ─────────────────────────────────────────────────
@@ -190,9 +205,9 @@ private:
    * @brief Classify all nodes into simplify/freeze/spill worklists
    *
    * A node goes to:
-   *   simplify_worklist_ if degree < K and not move-related
-   *   freeze_worklist_   if degree < K and move-related
-   *   spill_worklist_    if degree >= K
+   *   SIMPLIFY if degree < K and not move-related
+   *   FREEZE   if degree < K and move-related
+   *   SPILL    if degree >= K
    */
   void MakeWorkList();
 
@@ -202,11 +217,15 @@ private:
    */
   live::INodeList *Adjacent(live::INode *n);
 
+  /** @brief Test whether move @p id is ACTIVE or in WORKLIST */
+  bool IsLiveMove(int id);
+
   /**
-   * @brief Compute the moves associated with node n that are active or in worklist
-   * @return Intersection of moves(n) with (active_moves_ ∪ worklist_moves_)
+   * @brief Call @p f(move id) for the moves of n that are active or in worklist
+   *
+   * Visits moves(n) ∩ (ACTIVE ∪ WORKLIST) without allocating.
    */
-  live::MoveList *NodeMoves(live::INode *n);
+  template <typename Fn> void NodeMoves(live::INode *n, Fn f);
 
   /**
    * @brief Test whether node n is involved in any active or worklist move
@@ -217,7 +236,7 @@ private:
   /**
    * @brief Remove a low-degree, non-move-related node from the graph
    *
-   * Pushes the node onto select_stack_ and decrements the degree of its
+   * Pushes the node onto the select stack and decrements the degree of its
    * neighbors (potentially enabling them for simplification or coalescing).
    */
   void Simplify();
@@ -225,20 +244,20 @@ private:
   /**
    * @brief Decrement the degree of node n by 1
    *
-   * If n's degree drops below K, it may be moved from spill_worklist_ to
-   * simplify_worklist_ or freeze_worklist_.
+   * If n's degree drops below K, it may be moved from SPILL to SIMPLIFY or
+   * FREEZE.
    */
   void DecrementDegree(live::INode *n);
 
   /**
-   * @brief Enable moves associated with the given nodes for coalescing
+   * @brief Enable moves associated with node @p n for coalescing
    *
-   * Moves active_moves that involve any node in @p nodes to worklist_moves_.
+   * Moves the ACTIVE moves of @p n to WORKLIST.
    */
-  void EnableMoves(live::INodeList *nodes);
+  void EnableMoves(live::INode *n);
 
   /**
-   * @brief Attempt to coalesce a move from worklist_moves_
+   * @brief Attempt to coalesce a move from WORKLIST
    *
    * Tries to merge the source and destination of a move using George's or
    * Briggs' safety test.  If coalescing is safe, merges the two nodes.
@@ -246,7 +265,7 @@ private:
   void Coalesce();
 
   /**
-   * @brief Move node u from freeze_worklist_ to simplify_worklist_ if safe
+   * @brief Move node u from FREEZE to SIMPLIFY if safe
    *
    * Called after coalescing to check if u is now non-move-related.
    */
@@ -276,8 +295,8 @@ private:
   /**
    * @brief Get the canonical representative of node n (following alias chain)
    *
-   * After coalescing, coalesced nodes point to their representative via alias_.
-   * GetAlias() follows the chain to find the root.
+   * After coalescing, coalesced nodes share an alias set with their
+   * representative; GetAlias() finds it in near-constant time.
    */
   live::INode *GetAlias(live::INode *n);
 
@@ -300,7 +319,7 @@ private:
   /**
    * @brief Give up coalescing a low-degree move-related node
    *
-   * Moves a node from freeze_worklist_ to simplify_worklist_ and freezes
+   * Moves a node from FREEZE to SIMPLIFY and freezes
    * all moves associated with it.
    */
   void Freeze();
@@ -308,48 +327,55 @@ private:
   /**
    * @brief Freeze all moves associated with node u
    *
-   * Moves the moves from active_moves_/worklist_moves_ to frozen_moves_.
+   * Moves the moves from ACTIVE/WORKLIST to FROZEN.
    * May enable the other endpoint of each move for simplification.
    */
   void FreezeMoves(live::INode *u);
 
   /**
-   * @brief Select a node from spill_worklist_ as a potential spill
+   * @brief Select a node from SPILL as a potential spill
    *
    * Uses a heuristic (HeuristicSelect) to choose the best candidate.
-   * Moves the selected node to simplify_worklist_ (optimistic coloring).
+   * Moves the selected node to SIMPLIFY (optimistic coloring).
    */
   void SelectSpill();
 
   /**
    * @brief Heuristic for choosing which node to spill
    *
-   * Selects the node whose observed def-to-next-use distance is largest,
-   * with an immediate preference for temps that are defined but never used.
-   * This is a simple approximation of spill cost rather than a pure
-   * degree-based policy.
+   * Selects the node of SPILL with the smallest spill_cost_ / degree, so
+   * cheap temps that block many neighbours go first (Chaitin).
    *
    * @return The node selected for potential spilling
    */
   live::INode *HeuristicSelect();
 
+  /**
+   * @brief Compute the spill cost of every node for this round
+   *
+   * cost(n) = Σ over uses and defs of n of 10^depth, where depth is the
+   * loop-nesting depth of the instruction (df::LoopNest).  Temps created by
+   * RewriteProgram() get an infinite cost: spilling them again cannot help.
+   */
+  void ComputeSpillCosts();
+
   /**
    * @brief Assign colors (physical registers) to nodes on the select stack
    *
-   * Pops nodes from select_stack_ and assigns the lowest available color
-   * not used by any neighbor.  Nodes that cannot be colored are added to
-   * spilled_nodes_.
+   * Pops nodes from the select stack and assigns the lowest available color
+   * not used by any neighbor.  Nodes that cannot be colored become SPILLED.
    */
   void AssignColors();
 
   /**
    * @brief Rewrite the program to handle actual spills
    *
-   * For each node in spilled_nodes_:
+   * For each SPILLED node:
    *   1. Allocate a new frame slot
    *   2. Replace each use with: movq slot(%rsp), t_new  (before the instruction)
    *   3. Replace each def with:  movq t_new, slot(%rsp) (after the instruction)
-   * Then restarts the allocation from scratch with the rewritten program.
+   * Then rebuilds the flow graph and updates liveness and the interference
+   * graph for the next round.
    */
   void RewriteProgram();
 
@@ -0,0 +1,233 @@
+/**
+ * @file worklist.h
+ * @brief Node and move worklists of the register allocator with O(1)
+ * transitions
+ *
+ * The node sets of iterated register coalescing (precolored, initial,
+ * simplifyWorklist, freezeWorklist, spillWorklist, spilledNodes,
+ * coalescedNodes, coloredNodes, selectStack) partition the nodes of the
+ * interference graph: every node is in exactly one of them at any time.
+ * Likewise the move sets (coalescedMoves, constrainedMoves, frozenMoves,
+ * worklistMoves, activeMoves) partition the moves.
+ *
+ * As suggested by Appel & George, each element therefore carries a state
+ * tag naming its set, and each set is an intrusive doubly-linked list
+ * threaded through per-element prev/next links.  Membership tests read the
+ * tag and moving an element between sets unlinks it from one list and
+ * links it into another, so every transition is O(1) and allocates nothing.
+ *
+ * Elements are dense integer ids: INode::Key() for nodes (see
+ * live::LiveGraphFactory::BuildIGraph()) and move ids for moves (see
+ * live::MoveTable).
+ */
+
+#ifndef TIGER_REGALLOC_WORKLIST_H_
+#define TIGER_REGALLOC_WORKLIST_H_
+
+#include <cassert>
+#include <vector>
+
+#include "tiger/liveness/liveness.h"
+
+namespace ra {
+
+/** @brief The node set (worklist) an interference-graph node belongs to */
+enum class NodeState {
+  PRECOLORED,  ///< Machine register
+  INITIAL,     ///< Not yet classified
+  SIMPLIFY,    ///< Low-degree, non-move-related
+  FREEZE,      ///< Low-degree, move-related
+  SPILL,       ///< High-degree
+  SPILLED,     ///< Marked for actual spilling
+  COALESCED,   ///< Merged into another node
+  COLORED,     ///< Successfully colored
+  SELECT,      ///< Removed from the graph, on the select stack
+  COUNT
+};
+
+/** @brief The move set (worklist) a move belongs to */
+enum class MoveState {
+  COALESCED,    ///< Source and destination were merged
+  CONSTRAINED,  ///< Source and destination interfere
+  FROZEN,       ///< No longer considered for coalescing
+  WORKLIST,     ///< Candidate for coalescing
+  ACTIVE,       ///< Not yet ready for coalescing
+  COUNT
+};
+
+/**
+ * @brief Intrusive doubly-linked lists partitioning the ids [0, count) by
+ * state
+ * @tparam State An enum class whose last enumerator is COUNT
+ *
+ * Ids are appended at the tail, so Front() yields the oldest member and
+ * Back() the newest one.
+ */
+template <typename State> class StateLists {
+public:
+  StateLists() { ClearHeads(); }
+
+  /** @brief Put every id in [0, @p count) into the list of @p initial */
+  void Reset(int count, State initial) {
+    state_.assign(count, initial);
+    prev_.assign(count, NONE);
+    next_.assign(count, NONE);
+    ClearHeads();
+    for (int id = 0; id < count; ++id)
+      Link(id, initial);
+  }
+
+  /** @brief The set @p id currently belongs to */
+  [[nodiscard]] State Of(int id) const { return state_[id]; }
+
+  /** @brief Test whether the list of state @p s is empty */
+  [[nodiscard]] bool Empty(State s) const { return head_[Index(s)] == NONE; }
+
+  /** @brief Oldest id in the list of state @p s */
+  [[nodiscard]] int Front(State s) const {
+    assert(!Empty(s));
+    return head_[Index(s)];
+  }
+
+  /** @brief Newest id in the list of state @p s */
+  [[nodiscard]] int Back(State s) const {
+    assert(!Empty(s));
+    return tail_[Index(s)];
+  }
+
+  /**
+   * @brief Move @p id to the tail of the list of state @p s
+   *
+   * An id already in state @p s keeps its position, matching the set
+   * semantics of the lists this replaces.
+   */
+  void MoveTo(int id, State s) {
+    if (state_[id] == s)
+      return;
+    Unlink(id);
+    Link(id, s);
+  }
+
+  /**
+   * @brief Call @p f(id) for every id in state @p s, oldest first
+   *
+   * @p f may move the id it is given to another list.
+   */
+  template <typename Fn> void ForEach(State s, Fn f) const {
+    for (int id = head_[Index(s)]; id != NONE;) {
+      int next = next_[id];
+      f(id);
+      id = next;
+    }
+  }
+
+private:
+  static constexpr int NONE = -1;
+  static constexpr int STATE_COUNT = static_cast<int>(State::COUNT);
+
+  /// The arrays are charged to StateLists in an allocation profile
+  template <typename T>
+  using Vector = std::vector<T, util::TrackedAllocator<T, StateLists>>;
+
+  Vector<State> state_;  ///< Id → current set
+  Vector<int> prev_;     ///< Id → previous id in its list
+  Vector<int> next_;     ///< Id → next id in its list
+  int head_[STATE_COUNT];     ///< First id of each list
+  int tail_[STATE_COUNT];     ///< Last id of each list
+
+  static int Index(State s) { return static_cast<int>(s); }
+
+  void ClearHeads() {
+    for (int i = 0; i < STATE_COUNT; ++i)
+      head_[i] = tail_[i] = NONE;
+  }
+
+  void Link(int id, State s) {
+    int i = Index(s);
+    state_[id] = s;
+    prev_[id] = tail_[i];
+    next_[id] = NONE;
+    if (tail_[i] == NONE)
+      head_[i] = id;
+    else
+      next_[tail_[i]] = id;
+    tail_[i] = id;
+  }
+
+  void Unlink(int id) {
+    int i = Index(state_[id]);
+    if (prev_[id] == NONE)
+      head_[i] = next_[id];
+    else
+      next_[prev_[id]] = next_[id];
+    if (next_[id] == NONE)
+      tail_[i] = prev_[id];
+    else
+      prev_[next_[id]] = prev_[id];
+  }
+};
+
+/** @brief The move worklists, indexed by live::MoveTable move id */
+using MoveWorklists = StateLists<MoveState>;
+
+/**
+ * @brief The node worklists, StateLists over INode keys that hand out the
+ * nodes themselves
+ *
+ * The select stack pushes and pops at the back of the SELECT list.
+ */
+class NodeWorklists {
+public:
+  /**
+   * @brief Put every node of @p graph into the INITIAL list, in node order
+   */
+  void Reset(live::IGraph *graph) {
+    node_.assign(graph->nodecount_, nullptr);
+    for (live::INode *node : graph->Nodes()->GetList())
+      node_[node->Key()] = node;
+    lists_.Reset(graph->nodecount_, NodeState::INITIAL);
+  }
+
+  /** @brief The node with key @p key */
+  [[nodiscard]] live::INode *Node(int key) const { return node_[key]; }
+
+  /** @brief The set node @p n currently belongs to */
+  [[nodiscard]] NodeState State(live::INode *n) const {
+    return lists_.Of(n->Key());
+  }
+
+  /** @brief Test whether the list of state @p s is empty */
+  [[nodiscard]] bool Empty(NodeState s) const { return lists_.Empty(s); }
+
+  /** @brief Oldest node in the list of state @p s */
+  [[nodiscard]] live::INode *Front(NodeState s) const {
+    return node_[lists_.Front(s)];
+  }
+
+  /** @brief Newest node in the list of state @p s */
+  [[nodiscard]] live::INode *Back(NodeState s) const {
+    return node_[lists_.Back(s)];
+  }
+
+  /** @brief Move node @p n to the tail of the list of state @p s */
+  void MoveTo(live::INode *n, NodeState s) { lists_.MoveTo(n->Key(), s); }
+
+  /**
+   * @brief Call @p f(node) for every node in state @p s, oldest first
+   *
+   * @p f may move the node it is given to another list.
+   */
+  template <typename Fn> void ForEach(NodeState s, Fn f) const {
+    lists_.ForEach(s, [this, &f](int key) { f(node_[key]); });
+  }
+
+private:
+  /// Key → node; charged to NodeWorklists in an allocation profile
+  std::vector<live::INode *, util::TrackedAllocator<live::INode *, NodeWorklists>>
+      node_;
+  StateLists<NodeState> lists_;      ///< Per-state lists of node keys
+};
+
+} // namespace ra
+
+#endif // TIGER_REGALLOC_WORKLIST_H_
@@ -12,6 +12,7 @@
  * - Detection of semantic errors (type mismatches, undefined variables, etc.)
  * - Construction of type information for the AST
  * - Support for mutually recursive type and function declarations
+ * - Annotation of the AST for translation, escape flags included
  */
 
 #include "tiger/absyn/absyn.h"
@@ -20,13 +21,27 @@
 #include <unordered_map>
 
 using namespace std;
+
+namespace {
+
+/** @brief Enter @p entry, declared at @p depth, for @p escape */
+env::VarEntry *Declare(env::VarEntry *entry, int depth, bool *escape) {
+  *escape = false;
+  entry->escape_ = escape;
+  entry->depth_ = depth;
+  return entry;
+}
+
+} // namespace
+
 namespace absyn {
 
 /**
  * @brief Performs semantic analysis on the abstract syntax tree
  *
  * This method initiates semantic analysis by calling SemAnalyze on the root
- * expression node with initial environments and a label count of 0.
+ * expression node with initial environments, a label count of 0 and a
+ * depth of 0.
  *
  * @param venv Variable environment containing variable and function definitions
  * @param tenv Type environment containing type definitions
@@ -34,7 +49,7 @@ namespace absyn {
  */
 void AbsynTree::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
                            err::ErrorMsg *errormsg) const {
-  root_->SemAnalyze(venv, tenv, 0, errormsg);
+  root_->SemAnalyze(venv, tenv, 0, 0, errormsg);
 }
 
 /**
@@ -42,21 +57,27 @@ void AbsynTree::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
  *
  * Looks up the variable in the variable environment and returns its type.
  * Reports an error if the variable is not found or is not a variable (e.g., a function).
+ * The variable escapes if it is declared in a function this one is nested in.
  *
  * @param venv Variable environment for symbol lookup
  * @param tenv Type environment (unused for variables)
  * @param labelcount Current label count for break statements (unused)
+ * @param depth Number of functions the node is nested in
  * @param errormsg Error handler for reporting semantic errors
  * @return Type of the variable, or IntTy if undefined
  */
 type::Ty *SimpleVar::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
-                                int labelcount, err::ErrorMsg *errormsg) const {
+                                int labelcount, int depth,
+                                err::ErrorMsg *errormsg) const {
   env::EnvEntry* entry = venv->Look(sym_);
   if (!entry || typeid(*entry) != typeid(env::VarEntry)) {
     errormsg->Error(pos_, "undefined variable %s", sym_->Name().data());
     return type::IntTy::Instance();
   }
-  return (static_cast<env::VarEntry*>(entry))->ty_->ActualTy();
+  entry_ = static_cast<env::VarEntry*>(entry);
+  if (entry_->escape_ && entry_->depth_ < depth)
+    *entry_->escape_ = true;
+  return entry_->ty_->ActualTy();
 }
 
 /**
@@ -68,14 +89,16 @@ type::Ty *SimpleVar::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
  * @param venv Variable environment for symbol lookup
  * @param tenv Type environment (unused for field access)
  * @param labelcount Current label count for break statements (unused)
+ * @param depth Number of functions the node is nested in
  * @param errormsg Error handler for reporting semantic errors
  * @return Type of the field, or IntTy if there's an error
  */
 type::Ty *FieldVar::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
-                               int labelcount, err::ErrorMsg *errormsg) const {
+                               int labelcount, int depth,
+                               err::ErrorMsg *errormsg) const {
   type::Ty* varTy;
 
-  varTy = var_->SemAnalyze(venv, tenv, labelcount, errormsg)->ActualTy();
+  varTy = var_->SemAnalyze(venv, tenv, labelcount, depth, errormsg)->ActualTy();
   if (typeid(*varTy) != typeid(type::RecordTy)) {
     errormsg->Error(var_->pos_, "not a record type");
     return type::IntTy::Instance();
@@ -102,21 +125,22 @@ type::Ty *FieldVar::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
  * @param venv Variable environment for symbol lookup
  * @param tenv Type environment (unused for subscript access)
  * @param labelcount Current label count for break statements (unused)
+ * @param depth Number of functions the node is nested in
  * @param errormsg Error handler for reporting semantic errors
  * @return Element type of the array, or IntTy if there's an error
  */
 type::Ty *SubscriptVar::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
-                                   int labelcount,
+                                   int labelcount, int depth,
                                    err::ErrorMsg *errormsg) const {
   type::Ty* varTy, * subscriptTy;
 
-  varTy = var_->SemAnalyze(venv, tenv, labelcount, errormsg)->ActualTy();
+  varTy = var_->SemAnalyze(venv, tenv, labelcount, depth, errormsg)->ActualTy();
   if (typeid(*varTy) != typeid(type::ArrayTy)) {
     errormsg->Error(var_->pos_, "array type required");
     return type::IntTy::Instance();
   }
 
-  subscriptTy = subscript_->SemAnalyze(venv, tenv, labelcount, errormsg)->ActualTy();
+  subscriptTy = subscript_->SemAnalyze(venv, tenv, labelcount, depth, errormsg)->ActualTy();
   if (typeid(*subscriptTy) != typeid(type::IntTy)) {
     errormsg->Error(subscript_->pos_, "ARRAY can only be subscripted by INT.");
     return type::IntTy::Instance();
@@ -134,12 +158,14 @@ type::Ty *SubscriptVar::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
  * @param venv Variable environment for symbol lookup
  * @param tenv Type environment (unused)
  * @param labelcount Current label count for break statements (unused)
+ * @param depth Number of functions the node is nested in
  * @param errormsg Error handler (unused for variable expressions)
  * @return Type of the referenced variable
  */
 type::Ty *VarExp::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
-                             int labelcount, err::ErrorMsg *errormsg) const {
-  return var_->SemAnalyze(venv, tenv, labelcount, errormsg)->ActualTy();
+                             int labelcount, int depth,
+                             err::ErrorMsg *errormsg) const {
+  return var_->SemAnalyze(venv, tenv, labelcount, depth, errormsg)->ActualTy();
 }
 
 /**
@@ -151,26 +177,31 @@ type::Ty *VarExp::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
  * @param venv Variable environment (unused)
  * @param tenv Type environment (unused)
  * @param labelcount Current label count (unused)
+ * @param depth Number of functions the node is nested in (unused)
  * @param errormsg Error handler (unused)
  * @return NilTy singleton instance
  */
 type::Ty *NilExp::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
-                             int labelcount, err::ErrorMsg *errormsg) const {
+                             int labelcount, int depth,
+                             err::ErrorMsg *errormsg) const {
   return type::NilTy::Instance();
 }
 
 type::Ty *IntExp::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
-                             int labelcount, err::ErrorMsg *errormsg) const {
+                             int labelcount, int depth,
+                             err::ErrorMsg *errormsg) const {
   return type::IntTy::Instance();
 }
 
 type::Ty *StringExp::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
-                                int labelcount, err::ErrorMsg *errormsg) const {
+                                int labelcount, int depth,
+                                err::ErrorMsg *errormsg) const {
   return type::StringTy::Instance();
 }
 
 type::Ty *CallExp::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
-                              int labelcount, err::ErrorMsg *errormsg) const {
+                              int labelcount, int depth,
+                              err::ErrorMsg *errormsg) const {
   env::EnvEntry* entry;
   env::FunEntry* funcEnt;
   type::TyList* formalList;
@@ -182,6 +213,7 @@ type::Ty *CallExp::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
   }
   
   funcEnt = static_cast<env::FunEntry*>(entry);
+  entry_ = funcEnt;
   formalList = funcEnt->formals_;
 
   auto argIt = args_->GetList().begin();
@@ -189,7 +221,7 @@ type::Ty *CallExp::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
   while (argIt != args_->GetList().end() && formalIt != formalList->GetList().end()) {
     type::Ty* argTy, * formalTy;
     formalTy = (*formalIt)->ActualTy();
-    argTy = (*argIt)->SemAnalyze(venv, tenv, labelcount, errormsg)->ActualTy();
+    argTy = (*argIt)->SemAnalyze(venv, tenv, labelcount, depth, errormsg)->ActualTy();
     if (!argTy->IsSameType(formalTy)) {
       errormsg->Error((*argIt)->pos_, "para type mismatch");
       return type::VoidTy::Instance();
@@ -211,9 +243,10 @@ type::Ty *CallExp::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
 }
 
 type::Ty *OpExp::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
-                            int labelcount, err::ErrorMsg *errormsg) const {
-  type::Ty *leftTy = left_->SemAnalyze(venv, tenv, labelcount, errormsg)->ActualTy();
-  type::Ty *rightTy = right_->SemAnalyze(venv, tenv, labelcount, errormsg)->ActualTy();
+                            int labelcount, int depth,
+                            err::ErrorMsg *errormsg) const {
+  type::Ty *leftTy = left_->SemAnalyze(venv, tenv, labelcount, depth, errormsg)->ActualTy();
+  type::Ty *rightTy = right_->SemAnalyze(venv, tenv, labelcount, depth, errormsg)->ActualTy();
 
   if (oper_ == absyn::PLUS_OP || oper_ == absyn::MINUS_OP 
     || oper_ == absyn::TIMES_OP || oper_==absyn::DIVIDE_OP) {
@@ -232,27 +265,34 @@ type::Ty *OpExp::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
 }
 
 type::Ty *RecordExp::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
-                                int labelcount, err::ErrorMsg *errormsg) const {
+                                int labelcount, int depth,
+                                err::ErrorMsg *errormsg) const {
   type::Ty* ty = tenv->Look(typ_);
   if (!ty) {
     errormsg->Error(pos_, "undefined type %s", typ_->Name().data());
     return type::VoidTy::Instance();
   }
+  // The fields are checked against the type in translation
+  for (EField *field : fields_->GetList())
+    field->exp_->SemAnalyze(venv, tenv, labelcount, depth, errormsg);
+  ty_ = ty;
   return ty;
 }
 
 type::Ty *SeqExp::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
-                             int labelcount, err::ErrorMsg *errormsg) const {
+                             int labelcount, int depth,
+                             err::ErrorMsg *errormsg) const {
   type::Ty* ty;
   for (Exp* exp : seq_->GetList())
-    ty = exp->SemAnalyze(venv, tenv, labelcount, errormsg);
+    ty = exp->SemAnalyze(venv, tenv, labelcount, depth, errormsg);
   return ty;
 }
 
 type::Ty *AssignExp::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
-                                int labelcount, err::ErrorMsg *errormsg) const {
-  type::Ty* varTy = var_->SemAnalyze(venv, tenv, labelcount, errormsg)->ActualTy();
-  type::Ty* expTy = exp_->SemAnalyze(venv, tenv, labelcount, errormsg)->ActualTy();
+                                int labelcount, int depth,
+                                err::ErrorMsg *errormsg) const {
+  type::Ty* varTy = var_->SemAnalyze(venv, tenv, labelcount, depth, errormsg)->ActualTy();
+  type::Ty* expTy = exp_->SemAnalyze(venv, tenv, labelcount, depth, errormsg)->ActualTy();
 
   if (!varTy->IsSameType(expTy)) {
     errormsg->Error(exp_->pos_, "unmatched assign exp");
@@ -272,16 +312,17 @@ type::Ty *AssignExp::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
 }
 
 type::Ty *IfExp::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
-                            int labelcount, err::ErrorMsg *errormsg) const {
+                            int labelcount, int depth,
+                            err::ErrorMsg *errormsg) const {
   type::Ty* testTy, * thenTy, * elseTy;
 
-  testTy = test_->SemAnalyze(venv, tenv, labelcount, errormsg)->ActualTy();
+  testTy = test_->SemAnalyze(venv, tenv, labelcount, depth, errormsg)->ActualTy();
   if (typeid(*testTy) != typeid(type::IntTy)) {
     errormsg->Error(test_->pos_, "integer required for if test condition");
     return type::VoidTy::Instance();
   }
 
-  thenTy = then_->SemAnalyze(venv, tenv, labelcount, errormsg)->ActualTy();
+  thenTy = then_->SemAnalyze(venv, tenv, labelcount, depth, errormsg)->ActualTy();
 
   if (!elsee_ && typeid(*thenTy) != typeid(type::VoidTy)) {
     errormsg->Error(then_->pos_, "if-then exp's body must produce no value");
@@ -289,7 +330,7 @@ type::Ty *IfExp::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
   }
 
   if (elsee_) {
-    elseTy = elsee_->SemAnalyze(venv, tenv, labelcount, errormsg)->ActualTy();
+    elseTy = elsee_->SemAnalyze(venv, tenv, labelcount, depth, errormsg)->ActualTy();
     if (!thenTy->IsSameType(elseTy)) {
       errormsg->Error(elsee_->pos_, "then exp and else exp type mismatch");
       return thenTy;
@@ -300,19 +341,20 @@ type::Ty *IfExp::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
 }
 
 type::Ty *WhileExp::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
-                               int labelcount, err::ErrorMsg *errormsg) const {
+                               int labelcount, int depth,
+                               err::ErrorMsg *errormsg) const {
   venv->BeginScope();
   tenv->BeginScope();
 
   type::Ty* testTy, * bodyTy;
 
-  testTy = test_->SemAnalyze(venv, tenv, labelcount, errormsg)->ActualTy();
+  testTy = test_->SemAnalyze(venv, tenv, labelcount, depth, errormsg)->ActualTy();
   if (typeid(*testTy) != typeid(type::IntTy)) {
     errormsg->Error(test_->pos_, "while test condition must produce INT value.");
     return type::VoidTy::Instance();
   }
 
-  bodyTy = body_->SemAnalyze(venv, tenv, -1, errormsg)->ActualTy();
+  bodyTy = body_->SemAnalyze(venv, tenv, -1, depth, errormsg)->ActualTy();
   if (typeid(*bodyTy) != typeid(type::VoidTy)) {
     errormsg->Error(body_->pos_, "while body must produce no value");
     return type::VoidTy::Instance();
@@ -325,29 +367,33 @@ type::Ty *WhileExp::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
 }
 
 type::Ty *ForExp::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
-                             int labelcount, err::ErrorMsg *errormsg) const {
+                             int labelcount, int depth,
+                             err::ErrorMsg *errormsg) const {
   type::Ty* loTy, * hiTy, * bodyTy;
 
   venv->BeginScope();
   tenv->BeginScope();
 
-  venv->Enter(var_, new env::VarEntry(type::IntTy::Instance(), true));
-
-  loTy = lo_->SemAnalyze(venv, tenv, labelcount, errormsg)->ActualTy();
+  // The bounds are outside the scope of the loop variable
+  loTy = lo_->SemAnalyze(venv, tenv, labelcount, depth, errormsg)->ActualTy();
   if (typeid(*loTy) != typeid(type::IntTy)) {
     errormsg->Error(lo_->pos_, "for exp's range type is not integer");
     // venv->EndScope();
     // return type::VoidTy::Instance();
   }
 
-  hiTy = hi_->SemAnalyze(venv, tenv, labelcount, errormsg)->ActualTy();
+  hiTy = hi_->SemAnalyze(venv, tenv, labelcount, depth, errormsg)->ActualTy();
   if (typeid(*hiTy) != typeid(type::IntTy)) {
     errormsg->Error(hi_->pos_, "for exp's range type is not integer");
     // venv->EndScope();
     // return type::VoidTy::Instance();
   }
 
-  bodyTy = body_->SemAnalyze(venv, tenv, -1, errormsg)->ActualTy();
+  entry_ = Declare(new env::VarEntry(type::IntTy::Instance(), true), depth,
+                   &escape_);
+  venv->Enter(var_, entry_);
+
+  bodyTy = body_->SemAnalyze(venv, tenv, -1, depth, errormsg)->ActualTy();
   if (typeid(*bodyTy) != typeid(type::VoidTy)) {
     errormsg->Error(body_->pos_, "for body must produce no value.");
     venv->EndScope();
@@ -361,21 +407,23 @@ type::Ty *ForExp::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
 }
 
 type::Ty *BreakExp::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
-                               int labelcount, err::ErrorMsg *errormsg) const {
+                               int labelcount, int depth,
+                               err::ErrorMsg *errormsg) const {
   if (labelcount != -1)
     errormsg->Error(pos_, "break is not inside any loop");
   return type::VoidTy::Instance();
 }
 
 type::Ty *LetExp::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
-                             int labelcount, err::ErrorMsg *errormsg) const {
+                             int labelcount, int depth,
+                             err::ErrorMsg *errormsg) const {
   venv->BeginScope();
   tenv->BeginScope();
 
   for (Dec* dec : decs_->GetList())
-    dec->SemAnalyze(venv, tenv, labelcount, errormsg);
+    dec->SemAnalyze(venv, tenv, labelcount, depth, errormsg);
 
-  type::Ty *result = body_->SemAnalyze(venv, tenv, labelcount, errormsg)->ActualTy();
+  type::Ty *result = body_->SemAnalyze(venv, tenv, labelcount, depth, errormsg)->ActualTy();
 
   venv->EndScope();
   tenv->EndScope();
@@ -384,7 +432,8 @@ type::Ty *LetExp::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
 }
 
 type::Ty *ArrayExp::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
-                               int labelcount, err::ErrorMsg *errormsg) const {
+                               int labelcount, int depth,
+                               err::ErrorMsg *errormsg) const {
   type::Ty* arrayTy, * sizeTy, * initTy;
 
   arrayTy = tenv->Look(typ_);
@@ -393,14 +442,15 @@ type::Ty *ArrayExp::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
     errormsg->Error(pos_, "no array type %s", typ_->Name().data());
     return type::IntTy::Instance();
   }
+  ty_ = arrayTy;
 
-  sizeTy = size_->SemAnalyze(venv, tenv, labelcount, errormsg);
+  sizeTy = size_->SemAnalyze(venv, tenv, labelcount, depth, errormsg);
   if (typeid(*sizeTy) != typeid(type::IntTy)) {
     errormsg->Error(size_->pos_, "integer required for array size");
     return arrayTy;
   }
 
-  initTy = init_->SemAnalyze(venv, tenv, labelcount, errormsg);
+  initTy = init_->SemAnalyze(venv, tenv, labelcount, depth, errormsg);
   if (initTy->ActualTy() != static_cast<type::ArrayTy*>(arrayTy->ActualTy())->ty_->ActualTy()) {
     errormsg->Error(init_->pos_, "type mismatch");
     return arrayTy;
@@ -411,25 +461,28 @@ type::Ty *ArrayExp::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
 }
 
 type::Ty *VoidExp::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
-                              int labelcount, err::ErrorMsg *errormsg) const {
+                              int labelcount, int depth,
+                              err::ErrorMsg *errormsg) const {
   return type::VoidTy::Instance();
 }
 
 void FunctionDec::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
-                             int labelcount, err::ErrorMsg *errormsg) const {
+                             int labelcount, int depth,
+                             err::ErrorMsg *errormsg) const {
   type::Ty* resultTy, * bodyTy;
   type::TyList* formals;
-  unordered_map<string, int> functionRecord;
+  unordered_map<sym::Symbol *, int> functionRecord;
 
   for (FunDec* function : functions_->GetList()) {
-    if (functionRecord.count(function->name_->Name())) {
+    if (functionRecord.count(function->name_)) {
       errormsg->Error(function->pos_, "two functions have the same name");
       return;
     }
-    functionRecord[function->name_->Name()] = 1;
+    functionRecord[function->name_] = 1;
     resultTy = function->result_ ? tenv->Look(function->result_) : nullptr;
     formals = function->params_->MakeFormalTyList(tenv, errormsg);
-    venv->Enter(function->name_, new env::FunEntry(formals, resultTy));
+    function->entry_ = new env::FunEntry(formals, resultTy);
+    venv->Enter(function->name_, function->entry_);
   }
 
   for (FunDec* function : functions_->GetList()) {
@@ -441,10 +494,14 @@ void FunctionDec::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
     auto paramIt = function->params_->GetList().begin();
     auto formalIt = formals->GetList().begin();
     for (; formalIt != formals->GetList().end(); paramIt++, formalIt++) {
-      venv->Enter((*paramIt)->name_, new env::VarEntry(*formalIt));
+      Field *param = *paramIt;
+      param->entry_ = Declare(new env::VarEntry(*formalIt), depth + 1,
+                              &param->escape_);
+      venv->Enter(param->name_, param->entry_);
     }
 
-    bodyTy = function->body_->SemAnalyze(venv, tenv, labelcount, errormsg);
+    bodyTy = function->body_->SemAnalyze(venv, tenv, labelcount, depth + 1,
+                                         errormsg);
     if (!function->result_ && typeid(*bodyTy) != typeid(type::VoidTy)) {
       errormsg->Error(function->body_->pos_, "procedure returns value");
     } else if (function->result_ && !bodyTy->IsSameType(resultTy)) {
@@ -456,7 +513,7 @@ void FunctionDec::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
 }
 
 void VarDec::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
-                        err::ErrorMsg *errormsg) const {
+                        int depth, err::ErrorMsg *errormsg) const {
   type::Ty* ty, * initTy;
 
   if (typ_) {
@@ -467,7 +524,7 @@ void VarDec::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
     }
   }
 
-  initTy = init_->SemAnalyze(venv, tenv, labelcount, errormsg);
+  initTy = init_->SemAnalyze(venv, tenv, labelcount, depth, errormsg);
   type::Ty *tyActualTy = typ_ ? ty->ActualTy() : nullptr;
   if (typeid(*initTy) == typeid(type::NilTy) 
     && (!typ_ || typeid(*tyActualTy) != typeid(type::RecordTy))) {
@@ -478,21 +535,22 @@ void VarDec::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
     return;
   }
 
-  venv->Enter(var_, new env::VarEntry(initTy));
+  entry_ = Declare(new env::VarEntry(initTy), depth, &escape_);
+  venv->Enter(var_, entry_);
 }
 
 void TypeDec::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
-                         err::ErrorMsg *errormsg) const {
+                         int depth, err::ErrorMsg *errormsg) const {
   type::Ty* ty;
   type::NameTy* tenvTy;
-  unordered_map<string, int> typeRecord;
+  unordered_map<sym::Symbol *, int> typeRecord;
 
   for (NameAndTy* nameAndTy : types_->GetList()) {
-    if (typeRecord.count(nameAndTy->name_->Name())) {
+    if (typeRecord.count(nameAndTy->name_)) {
       errormsg->Error(nameAndTy->ty_->pos_, "two types have the same name");
       return;
     }
-    typeRecord[nameAndTy->name_->Name()] = 1;
+    typeRecord[nameAndTy->name_] = 1;
     tenv->Enter(nameAndTy->name_, new type::NameTy(nameAndTy->name_, NULL));
   }
 
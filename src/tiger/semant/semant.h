@@ -17,6 +17,10 @@
  * (defined in absyn.cc / semant.cc). This class sets up the initial
  * environments and invokes the traversal.
  *
+ * The traversal annotates the AST with what it resolved, and sets the
+ * escape flags, so that tr::ProgTr can translate it without going over
+ * the same ground (see absyn.h).
+ *
  * Environments:
  * - VEnv (variable environment): maps names to VarEntry / FunEntry
  * - TEnv (type environment): maps names to type::Ty objects
@@ -31,6 +31,7 @@
 #define TIGER_SEMANT_TYPES_H_
 
 #include "tiger/symbol/symbol.h"
+#include "tiger/util/alloc_profile.h"
 #include <list>
 
 namespace type {
@@ -46,7 +47,7 @@ class FieldList;
  *   - ActualTy()    – resolve type aliases (default: return this)
  *   - IsSameType()  – structural/nominal equality check
  */
-class Ty {
+class Ty : public util::AllocTracked<Ty> {
 public:
   /**
    * @brief Resolve type aliases, returning the underlying concrete type
@@ -1,50 +1,112 @@
 /**
  * @file symbol.cc
  * @brief Implementation of symbol interning
- * 
- * Implements the symbol interning hash table. Uses a simple hash table
- * with chaining to store unique symbols.
+ *
+ * Implements the symbol interning hash table: an open-addressing table of
+ * Symbol pointers with linear probing, doubled whenever it is half full.
+ * Interned symbols and the characters of their names are carved out of one
+ * arena that is never released.  A mutex guards both, since the back ends
+ * of several functions may make symbols at the same time.  Fresh symbols
+ * go into the caller's arena instead.
  */
 
 #include "tiger/symbol/symbol.h"
 
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#include "tiger/util/arena.h"
+
 namespace {
 
-constexpr unsigned int HASH_TABSIZE = 109;  ///< Hash table size (prime number)
-sym::Symbol *hashtable[HASH_TABSIZE];        ///< Hash table for symbol interning
+constexpr size_t MIN_SLOTS = 1024;  ///< Initial table size (power of two)
+
+/// The interning table and the storage behind every symbol
+struct Interner {
+  util::Arena arena_;                                        ///< Symbols and names
+  std::vector<sym::Symbol *> table_ =
+      std::vector<sym::Symbol *>(MIN_SLOTS, nullptr);        ///< Interned symbols
+  size_t count_ = 0;                                         ///< Entries in table_
+  std::mutex mutex_;                                         ///< Guards all of the above
+};
+
+/// Constructed on first use, so symbols may be made during static init
+Interner &GetInterner() {
+  static Interner interner;
+  return interner;
+}
 
 /**
  * @brief Hash function for symbol names
  * @param str String to hash
  * @return Hash value
- * 
+ *
  * Uses a simple multiplicative hash (65599 is a common choice).
  */
-unsigned int Hash(std::string_view str) {
-  unsigned int h = 0;
-  for (const char *s = str.data(); *s; s++)
-    h = h * 65599 + *s;
+size_t Hash(std::string_view str) {
+  size_t h = 0;
+  for (char c : str)
+    h = h * 65599 + static_cast<unsigned char>(c);
   return h;
 }
 
+/// Copy @p name into @p arena, NUL-terminated
+std::string_view StoreName(std::string_view name, util::Arena *arena) {
+  char *chars = static_cast<char *>(arena->Allocate(name.size() + 1, 1));
+  std::memcpy(chars, name.data(), name.size());
+  chars[name.size()] = '\0';
+  return {chars, name.size()};
+}
+
+/// Double the table, reinserting every symbol by its stored hash
+void Grow() {
+  std::vector<sym::Symbol *> &hashtable = GetInterner().table_;
+  std::vector<sym::Symbol *> old(2 * hashtable.size(), nullptr);
+  old.swap(hashtable);
+  size_t mask = hashtable.size() - 1;
+  for (sym::Symbol *s : old) {
+    if (s == nullptr)
+      continue;
+    size_t i = s->Hash() & mask;
+    while (hashtable[i] != nullptr)
+      i = (i + 1) & mask;
+    hashtable[i] = s;
+  }
+}
+
 } // namespace
 
 namespace sym {
 
 Symbol *Symbol::UniqueSymbol(std::string_view name) {
-  // Compute hash bucket index
-  unsigned int index = Hash(name) % HASH_TABSIZE;
-  Symbol *syms = hashtable[index], *sym;
-  
-  // Search for existing symbol in hash bucket
-  for (sym = syms; sym; sym = sym->next_)
-    if (sym->name_ == name)
+  Interner &interner = GetInterner();
+  size_t hash = ::Hash(name);
+  std::lock_guard<std::mutex> lock(interner.mutex_);
+  std::vector<Symbol *> &hashtable = interner.table_;
+  size_t mask = hashtable.size() - 1;
+  size_t i = hash & mask;
+
+  // Probe for an existing symbol; the stored hash rejects most mismatches
+  // without touching the name
+  for (; hashtable[i] != nullptr; i = (i + 1) & mask) {
+    Symbol *sym = hashtable[i];
+    if (sym->hash_ == hash && sym->name_ == name)
       return sym;
-  
-  // Not found: create new symbol and add to front of bucket
-  sym = new Symbol(static_cast<std::string>(name), syms);
-  hashtable[index] = sym;
+  }
+
+  // Not found: create a new symbol in the empty slot that ended the probe
+  void *mem = interner.arena_.Allocate(sizeof(Symbol), alignof(Symbol));
+  Symbol *sym = new (mem) Symbol(StoreName(name, &interner.arena_), hash);
+  hashtable[i] = sym;
+  if (2 * ++interner.count_ > hashtable.size())
+    Grow();
   return sym;
 }
 
+Symbol *Symbol::FreshSymbol(std::string_view name, util::Arena *arena) {
+  void *mem = arena->Allocate(sizeof(Symbol), alignof(Symbol));
+  return new (mem) Symbol(StoreName(name, arena), ::Hash(name), true);
+}
+
 } // namespace sym
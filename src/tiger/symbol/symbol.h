@@ -9,15 +9,30 @@
  * Symbols are interned (unique per name) to enable fast comparison by pointer.
  * The Table class provides scoped symbol lookup with BeginScope()/EndScope()
  * for managing nested scopes (e.g., function parameters, let expressions).
+ *
+ * The interner is an open-addressing table that grows with the number of
+ * names.  Symbols and their NUL-terminated names live in a util::Arena for
+ * the lifetime of the compiler, and each symbol stores the hash of its name
+ * so growing the table never rehashes strings.  Names the compiler makes
+ * up itself and never looks up by string, like the anonymous labels L0,
+ * L1, …, are created by FreshSymbol() without entering the table, in an
+ * arena supplied by the caller that is freed with the program they belong
+ * to.
  */
 
 #ifndef TIGER_SYMBOL_SYMBOL_H_
 #define TIGER_SYMBOL_SYMBOL_H_
 
+#include <cstddef>
 #include <string>
+#include <string_view>
 
 #include "tiger/util/table.h"
 
+namespace util {
+class Arena;
+} // namespace util
+
 /**
  * @brief Forward declarations
  */
@@ -50,19 +65,38 @@ public:
    * Otherwise, creates a new symbol and adds it to the hash table.
    */
   static Symbol *UniqueSymbol(std::string_view);
-  
+
+  /**
+   * @brief Create a new symbol that is not interned
+   * @param name  String name of the symbol
+   * @param arena Holds the symbol and its name, and must outlive every use
+   * @return A symbol distinct from every other, even one with the same name
+   *
+   * For compiler-generated names that are only ever compared by pointer.
+   * Unlike UniqueSymbol() this takes no lock; @p arena must not be used by
+   * other threads at the same time.
+   */
+  static Symbol *FreshSymbol(std::string_view name, util::Arena *arena);
+
   /**
    * @brief Get the string name of this symbol
-   * @return The original string name
+   * @return The original string name; data() is NUL-terminated
    */
-  [[nodiscard]] std::string Name() const { return name_; }
+  [[nodiscard]] std::string_view Name() const { return name_; }
+
+  /** @brief Hash of the name, computed once when the symbol is created */
+  [[nodiscard]] size_t Hash() const { return hash_; }
+
+  /** @brief Whether the symbol was made by FreshSymbol() */
+  [[nodiscard]] bool Fresh() const { return fresh_; }
 
 private:
-  Symbol(std::string name, Symbol *next)
-      : name_(std::move(name)), next_(next) {}
+  Symbol(std::string_view name, size_t hash, bool fresh = false)
+      : name_(name), hash_(hash), fresh_(fresh) {}
 
-  std::string name_;  ///< The interned string name
-  Symbol *next_;      ///< Next symbol in hash bucket (for collision handling)
+  std::string_view name_;  ///< The string name, stored with the symbol
+  size_t hash_;            ///< Hash of name_
+  bool fresh_;             ///< Not in the interning table
 };
 
 /**
@@ -96,7 +130,7 @@ public:
   void EndScope();
 
 private:
-  Symbol marksym_ = {"<mark>", nullptr};  ///< Scope marker symbol
+  Symbol marksym_ = {"<mark>", 0};  ///< Scope marker symbol
 };
 
 template <typename ValueType> void Table<ValueType>::BeginScope() {
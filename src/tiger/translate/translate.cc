@@ -4,6 +4,7 @@
 
 #include "tiger/env/env.h"
 #include "tiger/errormsg/errormsg.h"
+#include "tiger/frame/compilation.h"
 #include "tiger/frame/target.h"
 #include "tiger/frame/temp.h"
 #include "tiger/frame/frame.h"
@@ -11,9 +12,6 @@
 #include <iostream>
 #include <unordered_map>
 
-extern frame::Frags *frags;
-extern frame::RegManager *reg_manager;
-
 namespace tr {
 
 Access *Access::AllocLocal(Level *level, bool escape) {
@@ -57,12 +55,12 @@ public:
       return exp_;
   }
   [[nodiscard]] tree::Stm *UnNx() const override {
-      return new tree::ExpStm(exp_);
+      return util::New<tree::ExpStm>(exp_);
   }
   [[nodiscard]] Cx UnCx(err::ErrorMsg *errormsg) const override {
     temp::Label *t = temp::LabelFactory::NewLabel();
     temp::Label *f = temp::LabelFactory::NewLabel();
-    tree::CjumpStm *cjump_stm = new tree::CjumpStm(tree::NE_OP, new tree::ConstExp(0), exp_, t, f);
+    tree::CjumpStm *cjump_stm = util::New<tree::CjumpStm>(tree::NE_OP, util::New<tree::ConstExp>(0), exp_, t, f);
     return Cx(&cjump_stm->true_label_, &cjump_stm->false_label_, cjump_stm);
   }
 };
@@ -74,7 +72,7 @@ public:
   explicit NxExp(tree::Stm *stm) : stm_(stm) {}
 
   [[nodiscard]] tree::Exp *UnEx() const override {
-      return new tree::EseqExp(stm_, new tree::ConstExp(0));
+      return util::New<tree::EseqExp>(stm_, util::New<tree::ConstExp>(0));
   }
   [[nodiscard]] tree::Stm *UnNx() const override { 
       return stm_;
@@ -101,12 +99,12 @@ public:
     *cx_.trues_ = t;
     *cx_.falses_ = f;
 
-    return new tree::EseqExp(new tree::MoveStm(new tree::TempExp(reg), new tree::ConstExp(1)),
-            new tree::EseqExp(cx_.stm_,
-              new tree::EseqExp(new tree::LabelStm(f),
-                new tree::EseqExp(new tree::MoveStm(new tree::TempExp(reg), new tree::ConstExp(0)),
-                  new tree::EseqExp(new tree::LabelStm(t),
-                    new tree::TempExp(reg))))));
+    return util::New<tree::EseqExp>(util::New<tree::MoveStm>(util::New<tree::TempExp>(reg), util::New<tree::ConstExp>(1)),
+            util::New<tree::EseqExp>(cx_.stm_,
+              util::New<tree::EseqExp>(util::New<tree::LabelStm>(f),
+                util::New<tree::EseqExp>(util::New<tree::MoveStm>(util::New<tree::TempExp>(reg), util::New<tree::ConstExp>(0)),
+                  util::New<tree::EseqExp>(util::New<tree::LabelStm>(t),
+                    util::New<tree::TempExp>(reg))))));
   }
   [[nodiscard]] tree::Stm *UnNx() const override {
       return cx_.stm_;
@@ -116,24 +114,32 @@ public:
   }
 };
 
-void ProcEntryExit(Level *level, Exp *body) {
-  frame::ProcFrag *frag = new frame::ProcFrag(body->UnNx(), level->frame_);
+void ProcEntryExit(Level *level, Exp *body, std::unique_ptr<util::Arena> arena) {
+  frame::ProcFrag *frag =
+      new frame::ProcFrag(body->UnNx(), level->frame_, std::move(arena));
   frags->PushBack(frag);
 }
 
 void ProgTr::Translate() {
+  auto arena = std::make_unique<util::Arena>();
+  util::Arena::Scope scope(arena.get());
   temp::Label *main_label = frame::NamedCodeLabel("tigermain");
   frame::Frame *new_frame = frame::NewFrame(main_label, std::vector<bool>());
+  util::FunctionStats::Scope counting(new_frame->stats_);
   Level *main_level = new Level(new_frame, outermost_level_.get());
   tr::ExpAndTy *tree_expty = absyn_tree_->Translate(venv_.get(), tenv_.get(), main_level, nullptr, errormsg_.get());
   tree::Stm *main_stm = frame::ProcEntryExit1(new_frame, tree_expty->exp_->UnNx());
-  ProcEntryExit(main_level, new NxExp(main_stm));
+  ProcEntryExit(main_level, util::New<NxExp>(main_stm), std::move(arena));
 }
 
 } // namespace tr
 
 namespace absyn {
 
+// Without environments (venv and tenv null) the tree has been annotated by
+// semantic analysis: names are taken from the annotations, and what
+// semantic analysis has checked is not checked again.
+
 tr::ExpAndTy *AbsynTree::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
                                    tr::Level *level, temp::Label *label,
                                    err::ErrorMsg *errormsg) const {
@@ -143,25 +149,28 @@ tr::ExpAndTy *AbsynTree::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
 tr::ExpAndTy *SimpleVar::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
                                    tr::Level *level, temp::Label *label,
                                    err::ErrorMsg *errormsg) const {
-  env::EnvEntry *ent = venv->Look(sym_);
-  if (!ent) {
-    errormsg->Error(pos_, "variable %s not exist", sym_->Name().data());
-    return new tr::ExpAndTy(new tr::ExExp(new tree::ConstExp(0)), type::VoidTy::Instance()); 
-  }
+  env::VarEntry *var_ent = entry_;
+  if (venv) {
+    env::EnvEntry *ent = venv->Look(sym_);
+    if (!ent) {
+      errormsg->Error(pos_, "variable %s not exist", sym_->Name().data());
+      return util::New<tr::ExpAndTy>(util::New<tr::ExExp>(util::New<tree::ConstExp>(0)), type::VoidTy::Instance()); 
+    }
 
-  if (typeid(*ent) != typeid(env::VarEntry)) {
-    errormsg->Error(pos_, "%s is not a variable", sym_->Name().data());
-    return new tr::ExpAndTy(new tr::ExExp(new tree::ConstExp(0)), type::VoidTy::Instance());
+    if (typeid(*ent) != typeid(env::VarEntry)) {
+      errormsg->Error(pos_, "%s is not a variable", sym_->Name().data());
+      return util::New<tr::ExpAndTy>(util::New<tr::ExExp>(util::New<tree::ConstExp>(0)), type::VoidTy::Instance());
+    }
+    var_ent = static_cast<env::VarEntry *>(ent);
   }
 
-  env::VarEntry *var_ent = static_cast<env::VarEntry *>(ent);
   tr::Access *dec_acc = var_ent->access_;
   tr::Level *dec_level = dec_acc->level_;
   tr::Level *cur_level = level;
 
   if (cur_level == dec_level) {
     tree::Exp *var_exp = frame::AccessCurrentExp(dec_acc->access_, dec_level->frame_);
-    return new tr::ExpAndTy(new tr::ExExp(var_exp), var_ent->ty_);
+    return util::New<tr::ExpAndTy>(util::New<tr::ExExp>(var_exp), var_ent->ty_);
   }
   
   // Follow the static links
@@ -176,7 +185,7 @@ tr::ExpAndTy *SimpleVar::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
 
   // Now at declare level
   tree::Exp *var_exp = frame::AccessExp(dec_acc->access_, static_link);
-  return new tr::ExpAndTy(new tr::ExExp(var_exp), var_ent->ty_);
+  return util::New<tr::ExpAndTy>(util::New<tr::ExExp>(var_exp), var_ent->ty_);
 
 }
 
@@ -188,9 +197,9 @@ tr::ExpAndTy *FieldVar::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
   type::Ty *var_ty = var_expty->ty_;
   type::Ty *var_actual_ty = var_ty->ActualTy();
 
-  if (typeid(*var_actual_ty) != typeid(type::RecordTy)) {
+  if (venv && typeid(*var_actual_ty) != typeid(type::RecordTy)) {
     errormsg->Error(var_->pos_, "not a record type");
-    return new tr::ExpAndTy(new tr::ExExp(new tree::ConstExp(0)), type::VoidTy::Instance());
+    return util::New<tr::ExpAndTy>(util::New<tr::ExExp>(util::New<tree::ConstExp>(0)), type::VoidTy::Instance());
   }
 
   // record is bound to be in the frame
@@ -198,16 +207,16 @@ tr::ExpAndTy *FieldVar::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
   int k = 0;
   for (type::Field *field : rec->fields_->GetList()) {
     if (field->name_->Name() == sym_->Name()) {
-      tree::Exp *exp = new tree::MemExp(
-        new tree::BinopExp(tree::PLUS_OP, var_exp, 
-          new tree::ConstExp(k * level->frame_->WordSize())));
-      return new tr::ExpAndTy(new tr::ExExp(exp), field->ty_->ActualTy());
+      tree::Exp *exp = util::New<tree::MemExp>(
+        util::New<tree::BinopExp>(tree::PLUS_OP, var_exp, 
+          util::New<tree::ConstExp>(k * level->frame_->WordSize())));
+      return util::New<tr::ExpAndTy>(util::New<tr::ExExp>(exp), field->ty_->ActualTy());
     }
     k++;
   }
 
   errormsg->Error(pos_, "no field named %s", sym_->Name().data());
-  return new tr::ExpAndTy(new tr::ExExp(new tree::ConstExp(0)), type::VoidTy::Instance());
+  return util::New<tr::ExpAndTy>(util::New<tr::ExExp>(util::New<tree::ConstExp>(0)), type::VoidTy::Instance());
 
 }
 
@@ -219,27 +228,27 @@ tr::ExpAndTy *SubscriptVar::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
   type::Ty *var_ty = var_expty->ty_;
   type::Ty *var_actual_ty = var_ty->ActualTy();
 
-  if (typeid(*var_actual_ty) != typeid(type::ArrayTy)) {
+  if (venv && typeid(*var_actual_ty) != typeid(type::ArrayTy)) {
     errormsg->Error(var_->pos_, "not an array type");
-    return new tr::ExpAndTy(new tr::ExExp(new tree::ConstExp(0)), type::VoidTy::Instance());
+    return util::New<tr::ExpAndTy>(util::New<tr::ExExp>(util::New<tree::ConstExp>(0)), type::VoidTy::Instance());
   }
 
   tr::ExpAndTy *subscript_expty = subscript_->Translate(venv, tenv, level, label, errormsg);
   tree::Exp *subscript_exp = subscript_expty->exp_->UnEx();
   type::Ty *subscript_actual_ty = subscript_expty->ty_->ActualTy();
 
-  if (typeid(*subscript_actual_ty) != typeid(type::IntTy)) {
+  if (venv && typeid(*subscript_actual_ty) != typeid(type::IntTy)) {
     errormsg->Error(subscript_->pos_, "require integer array subsription");
-    return new tr::ExpAndTy(new tr::ExExp(new tree::ConstExp(0)), type::VoidTy::Instance());
+    return util::New<tr::ExpAndTy>(util::New<tr::ExExp>(util::New<tree::ConstExp>(0)), type::VoidTy::Instance());
   }
 
   // array is bound to be in the frame
   type::ArrayTy *array = static_cast<type::ArrayTy *>(var_ty->ActualTy());
-  tree::Exp *exp = new tree::MemExp(
-    new tree::BinopExp(tree::PLUS_OP, var_exp, 
-      new tree::BinopExp(tree::MUL_OP, subscript_exp, 
-        new tree::ConstExp(level->frame_->WordSize()))));
-  return new tr::ExpAndTy(new tr::ExExp(exp), array->ty_);
+  tree::Exp *exp = util::New<tree::MemExp>(
+    util::New<tree::BinopExp>(tree::PLUS_OP, var_exp, 
+      util::New<tree::BinopExp>(tree::MUL_OP, subscript_exp, 
+        util::New<tree::ConstExp>(level->frame_->WordSize()))));
+  return util::New<tr::ExpAndTy>(util::New<tr::ExExp>(exp), array->ty_);
 
 }
 
@@ -252,13 +261,13 @@ tr::ExpAndTy *VarExp::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
 tr::ExpAndTy *NilExp::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
                                 tr::Level *level, temp::Label *label,
                                 err::ErrorMsg *errormsg) const {
-  return new tr::ExpAndTy(new tr::ExExp(new tree::ConstExp(0)), type::NilTy::Instance());
+  return util::New<tr::ExpAndTy>(util::New<tr::ExExp>(util::New<tree::ConstExp>(0)), type::NilTy::Instance());
 }
 
 tr::ExpAndTy *IntExp::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
                                 tr::Level *level, temp::Label *label,
                                 err::ErrorMsg *errormsg) const {
-  return new tr::ExpAndTy(new tr::ExExp(new tree::ConstExp(val_)), type::IntTy::Instance());
+  return util::New<tr::ExpAndTy>(util::New<tr::ExExp>(util::New<tree::ConstExp>(val_)), type::IntTy::Instance());
 }
 
 tr::ExpAndTy *StringExp::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
@@ -266,20 +275,23 @@ tr::ExpAndTy *StringExp::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
                                    err::ErrorMsg *errormsg) const {
   temp::Label *str_label = temp::LabelFactory::NewLabel();
   frags->PushBack(new frame::StringFrag(str_label, str_));
-  return new tr::ExpAndTy(new tr::ExExp(new tree::NameExp(str_label)), type::StringTy::Instance());
+  return util::New<tr::ExpAndTy>(util::New<tr::ExExp>(util::New<tree::NameExp>(str_label)), type::StringTy::Instance());
 }
 
 tr::ExpAndTy *CallExp::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
                                  tr::Level *level, temp::Label *label,
                                  err::ErrorMsg *errormsg) const {
-  env::EnvEntry *ent = venv->Look(func_);
-  if (!ent || typeid(*ent) != typeid(env::FunEntry)) {
-    errormsg->Error(pos_, "undefined function %s", func_->Name().data());
-    return new tr::ExpAndTy(new tr::ExExp(new tree::ConstExp(0)), type::VoidTy::Instance());
-  }  
-
-  env::FunEntry *func_ent = static_cast<env::FunEntry *>(ent);
-  tree::ExpList *args = new tree::ExpList();
+  env::FunEntry *func_ent = entry_;
+  if (venv) {
+    env::EnvEntry *ent = venv->Look(func_);
+    if (!ent || typeid(*ent) != typeid(env::FunEntry)) {
+      errormsg->Error(pos_, "undefined function %s", func_->Name().data());
+      return util::New<tr::ExpAndTy>(util::New<tr::ExExp>(util::New<tree::ConstExp>(0)), type::VoidTy::Instance());
+    }
+    func_ent = static_cast<env::FunEntry *>(ent);
+  }
+
+  tree::ExpList *args = util::New<tree::ExpList>();
   tree::Exp *func_exp;
 
   if (func_ent->label_) {
@@ -306,15 +318,16 @@ tr::ExpAndTy *CallExp::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
 
       } else {
         // Error. No matched function is found.
+        // The callee's frame may have been freed with its ProcFrag already
         errormsg->Error(pos_, "%s cannot call %s", level->frame_->GetLabel().data(), 
-                        func_ent->level_->frame_->GetLabel().data());
-        return new tr::ExpAndTy(new tr::ExExp(new tree::ConstExp(0)), type::VoidTy::Instance());  
+                        func_ent->label_->Name().data());
+        return util::New<tr::ExpAndTy>(util::New<tr::ExExp>(util::New<tree::ConstExp>(0)), type::VoidTy::Instance());  
       }
     }
-    func_exp = new tree::NameExp(func_ent->label_);
+    func_exp = util::New<tree::NameExp>(func_ent->label_);
 
   } else {  // External call
-    func_exp = new tree::NameExp(frame::NamedCodeLabel(func_->Name()));
+    func_exp = util::New<tree::NameExp>(frame::NamedCodeLabel(func_->Name()));
   }
 
   for (Exp *arg : args_->GetList()) {
@@ -325,8 +338,10 @@ tr::ExpAndTy *CallExp::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
   level->frame_->max_outgoing_args_ = std::max(level->frame_->max_outgoing_args_, 
                                         (int) args->GetList().size() - (int) reg_manager->ArgRegs()->GetList().size());
 
-  tree::Exp *call_exp = new tree::CallExp(func_exp, args);
-  return new tr::ExpAndTy(new tr::ExExp(call_exp), func_ent->result_);
+  tree::Exp *call_exp = util::New<tree::CallExp>(func_exp, args);
+  // Semantic analysis enters procedures without a result type
+  type::Ty *result_ty = func_ent->result_ ? func_ent->result_ : type::VoidTy::Instance();
+  return util::New<tr::ExpAndTy>(util::New<tr::ExExp>(call_exp), result_ty);
 }
 
 tr::ExpAndTy *OpExp::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
@@ -336,108 +351,110 @@ tr::ExpAndTy *OpExp::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
   tr::ExpAndTy *right_expty = right_->Translate(venv, tenv, level, label, errormsg);
   tree::Exp *left_exp = left_expty->exp_->UnEx();
   tree::Exp *right_exp = right_expty->exp_->UnEx();
-  tr::Exp *exp;
+  tr::Exp *exp = nullptr;
   tree::CjumpStm *cjump;
 
-  if (left_expty->ty_->IsSameType(right_expty->ty_)) {
+  if (!venv || left_expty->ty_->IsSameType(right_expty->ty_)) {
     type::Ty *left_actual_ty = left_expty->ty_->ActualTy();
     if (typeid(*left_actual_ty) == typeid(type::StringTy)) {
-      tree::ExpList *args = new tree::ExpList({left_exp, right_exp});
+      tree::ExpList *args = util::New<tree::ExpList>({left_exp, right_exp});
       std::string string_equal = "string_equal";
 
       switch (oper_) {
       case absyn::EQ_OP:
-        exp = new tr::ExExp(frame::ExternalCall(string_equal, args));
+        exp = util::New<tr::ExExp>(frame::ExternalCall(string_equal, args));
         break;
       case absyn::NEQ_OP:
-        exp = new tr::ExExp(new tree::BinopExp(tree::MINUS_OP, new tree::ConstExp(1), 
+        exp = util::New<tr::ExExp>(util::New<tree::BinopExp>(tree::MINUS_OP, util::New<tree::ConstExp>(1), 
                 frame::ExternalCall(string_equal, args)));
         break;
       default:
         errormsg->Error(pos_, "unexpected binary token for string");
-        return new tr::ExpAndTy(new tr::ExExp(new tree::ConstExp(0)), type::VoidTy::Instance());
+        return util::New<tr::ExpAndTy>(util::New<tr::ExExp>(util::New<tree::ConstExp>(0)), type::VoidTy::Instance());
       }
 
     } else {
       switch (oper_) {
       case absyn::PLUS_OP:
-        exp = new tr::ExExp(new tree::BinopExp(tree::PLUS_OP, left_exp, right_exp));
+        exp = util::New<tr::ExExp>(util::New<tree::BinopExp>(tree::PLUS_OP, left_exp, right_exp));
         break;
       case absyn::MINUS_OP:
-        exp = new tr::ExExp(new tree::BinopExp(tree::MINUS_OP, left_exp, right_exp));
+        exp = util::New<tr::ExExp>(util::New<tree::BinopExp>(tree::MINUS_OP, left_exp, right_exp));
         break;
       case absyn::TIMES_OP:
-        exp = new tr::ExExp(new tree::BinopExp(tree::MUL_OP, left_exp, right_exp));
+        exp = util::New<tr::ExExp>(util::New<tree::BinopExp>(tree::MUL_OP, left_exp, right_exp));
         break;
       case absyn::DIVIDE_OP:
-        exp = new tr::ExExp(new tree::BinopExp(tree::DIV_OP, left_exp, right_exp));
+        exp = util::New<tr::ExExp>(util::New<tree::BinopExp>(tree::DIV_OP, left_exp, right_exp));
         break;
       case absyn::EQ_OP:
-        cjump = new tree::CjumpStm(tree::EQ_OP, left_exp, right_exp, nullptr, nullptr);
-        exp = new tr::CxExp(&cjump->true_label_, &cjump->false_label_, cjump);
+        cjump = util::New<tree::CjumpStm>(tree::EQ_OP, left_exp, right_exp, nullptr, nullptr);
+        exp = util::New<tr::CxExp>(&cjump->true_label_, &cjump->false_label_, cjump);
         break;
       case absyn::NEQ_OP:
-        cjump = new tree::CjumpStm(tree::NE_OP, left_exp, right_exp, nullptr, nullptr);
-        exp = new tr::CxExp(&cjump->true_label_, &cjump->false_label_, cjump);
+        cjump = util::New<tree::CjumpStm>(tree::NE_OP, left_exp, right_exp, nullptr, nullptr);
+        exp = util::New<tr::CxExp>(&cjump->true_label_, &cjump->false_label_, cjump);
         break;
       case absyn::GT_OP:
-        cjump = new tree::CjumpStm(tree::GT_OP, left_exp, right_exp, nullptr, nullptr);
-        exp = new tr::CxExp(&cjump->true_label_, &cjump->false_label_, cjump);
+        cjump = util::New<tree::CjumpStm>(tree::GT_OP, left_exp, right_exp, nullptr, nullptr);
+        exp = util::New<tr::CxExp>(&cjump->true_label_, &cjump->false_label_, cjump);
         break;
       case absyn::GE_OP:
-        cjump = new tree::CjumpStm(tree::GE_OP, left_exp, right_exp, nullptr, nullptr);
-        exp = new tr::CxExp(&cjump->true_label_, &cjump->false_label_, cjump);
+        cjump = util::New<tree::CjumpStm>(tree::GE_OP, left_exp, right_exp, nullptr, nullptr);
+        exp = util::New<tr::CxExp>(&cjump->true_label_, &cjump->false_label_, cjump);
         break;
       case absyn::LT_OP:
-        cjump = new tree::CjumpStm(tree::LT_OP, left_exp, right_exp, nullptr, nullptr);
-        exp = new tr::CxExp(&cjump->true_label_, &cjump->false_label_, cjump);
+        cjump = util::New<tree::CjumpStm>(tree::LT_OP, left_exp, right_exp, nullptr, nullptr);
+        exp = util::New<tr::CxExp>(&cjump->true_label_, &cjump->false_label_, cjump);
         break;
       case absyn::LE_OP:
-        cjump = new tree::CjumpStm(tree::LE_OP, left_exp, right_exp, nullptr, nullptr);
-        exp = new tr::CxExp(&cjump->true_label_, &cjump->false_label_, cjump);
+        cjump = util::New<tree::CjumpStm>(tree::LE_OP, left_exp, right_exp, nullptr, nullptr);
+        exp = util::New<tr::CxExp>(&cjump->true_label_, &cjump->false_label_, cjump);
         break;
       default:
         errormsg->Error(pos_, "unexpected binary token %d", oper_);
-        return new tr::ExpAndTy(new tr::ExExp(new tree::ConstExp(0)), type::VoidTy::Instance());
+        return util::New<tr::ExpAndTy>(util::New<tr::ExExp>(util::New<tree::ConstExp>(0)), type::VoidTy::Instance());
       }
     }
   }
 
   if (!exp) {
     errormsg->Error(pos_, "binary operation type mismatch");
-    return new tr::ExpAndTy(new tr::ExExp(new tree::ConstExp(0)), type::VoidTy::Instance());
+    return util::New<tr::ExpAndTy>(util::New<tr::ExExp>(util::New<tree::ConstExp>(0)), type::VoidTy::Instance());
   }
 
-  return new tr::ExpAndTy(exp, type::IntTy::Instance());
+  return util::New<tr::ExpAndTy>(exp, type::IntTy::Instance());
 }
 
 tr::ExpAndTy *RecordExp::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
                                    tr::Level *level, temp::Label *label,      
                                    err::ErrorMsg *errormsg) const {
-  type::Ty* ty = tenv->Look(typ_);
+  type::Ty* ty = tenv ? tenv->Look(typ_) : ty_;
   if (!ty) {
     errormsg->Error(pos_, "undefined type %s", typ_->Name().data());
-    return new tr::ExpAndTy(new tr::ExExp(new tree::ConstExp(0)), type::VoidTy::Instance());
+    return util::New<tr::ExpAndTy>(util::New<tr::ExExp>(util::New<tree::ConstExp>(0)), type::VoidTy::Instance());
   }
+  // Semantic analysis leaves the fields to be checked here
   type::Ty *ty_actual_ty = ty->ActualTy();
   if (typeid(*ty_actual_ty) != typeid(type::RecordTy)) {
     errormsg->Error(pos_, "type %s is not a record", typ_->Name().data());
-    return new tr::ExpAndTy(new tr::ExExp(new tree::ConstExp(0)), type::VoidTy::Instance());
+    return util::New<tr::ExpAndTy>(util::New<tr::ExExp>(util::New<tree::ConstExp>(0)), type::VoidTy::Instance());
   }
 
   type::RecordTy *rec_ty = static_cast<type::RecordTy *>(ty->ActualTy());
   auto fields = rec_ty->fields_->GetList();
   auto efields = fields_->GetList();
   int n = fields.size();
-  tree::Exp *reg_exp = new tree::TempExp(temp::TempFactory::NewTemp());
-  tree::ExpList *call_args = new tree::ExpList({new tree::ConstExp(n * level->frame_->WordSize())});
-  tree::Stm *malloc_stm = new tree::MoveStm(reg_exp, frame::ExternalCall("alloc_record", call_args));
+  tree::Exp *reg_exp = util::New<tree::TempExp>(temp::TempFactory::NewTemp());
+  tree::Exp *size_exp = util::New<tree::ConstExp>(n * level->frame_->WordSize());
+  tree::ExpList *call_args = util::New<tree::ExpList>({size_exp});
+  tree::Stm *malloc_stm = util::New<tree::MoveStm>(reg_exp, frame::ExternalCall("alloc_record", call_args));
 
   if (fields.empty() && efields.empty()) {  // record has no field
-    return new tr::ExpAndTy(new tr::ExExp(new tree::EseqExp(malloc_stm, reg_exp)), rec_ty);
+    return util::New<tr::ExpAndTy>(util::New<tr::ExExp>(util::New<tree::EseqExp>(malloc_stm, reg_exp)), rec_ty);
   } else if (fields.empty() || efields.empty()) {
     errormsg->Error(pos_, "field type mismatch");
-    return new tr::ExpAndTy(new tr::ExExp(new tree::ConstExp(0)), type::VoidTy::Instance());
+    return util::New<tr::ExpAndTy>(util::New<tr::ExExp>(util::New<tree::ConstExp>(0)), type::VoidTy::Instance());
   }
 
   type::Field *last_field = fields.back();
@@ -445,39 +462,39 @@ tr::ExpAndTy *RecordExp::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
   tr::ExpAndTy *last_efield_expty = last_efield->exp_->Translate(venv, tenv, level, label, errormsg);
   if (!(last_field->ty_->IsSameType(last_efield_expty->ty_))) {
     errormsg->Error(pos_, "field type mismatch");
-    return new tr::ExpAndTy(new tr::ExExp(new tree::ConstExp(0)), type::VoidTy::Instance());
+    return util::New<tr::ExpAndTy>(util::New<tr::ExExp>(util::New<tree::ConstExp>(0)), type::VoidTy::Instance());
   }
 
-  tree::Stm *stm = new tree::MoveStm(new tree::MemExp(new tree::BinopExp(tree::PLUS_OP, reg_exp, 
-                    new tree::ConstExp((--n) * level->frame_->WordSize()))), last_efield_expty->exp_->UnEx());
+  tree::Stm *stm = util::New<tree::MoveStm>(util::New<tree::MemExp>(util::New<tree::BinopExp>(tree::PLUS_OP, reg_exp, 
+                    util::New<tree::ConstExp>((--n) * level->frame_->WordSize()))), last_efield_expty->exp_->UnEx());
   auto field_it = ++fields.rbegin();
   auto efield_it = ++efields.rbegin();
   for (; field_it != fields.rend() && efield_it != efields.rend(); field_it++, efield_it++) {
     tr::ExpAndTy *efield_expty = (*efield_it)->exp_->Translate(venv, tenv, level, label, errormsg);
     if (!(efield_expty->ty_->IsSameType((*field_it)->ty_))) {
       errormsg->Error(pos_, "field type mismatch");
-      return new tr::ExpAndTy(new tr::ExExp(new tree::ConstExp(0)), type::VoidTy::Instance());
+      return util::New<tr::ExpAndTy>(util::New<tr::ExExp>(util::New<tree::ConstExp>(0)), type::VoidTy::Instance());
     }
     tree::Exp *efield_exp = efield_expty->exp_->UnEx();
-    stm = new tree::SeqStm(new tree::MoveStm(new tree::MemExp(new tree::BinopExp(tree::PLUS_OP, reg_exp,
-            new tree::ConstExp((--n) * level->frame_->WordSize()))), efield_expty->exp_->UnEx()), stm);
+    stm = util::New<tree::SeqStm>(util::New<tree::MoveStm>(util::New<tree::MemExp>(util::New<tree::BinopExp>(tree::PLUS_OP, reg_exp,
+            util::New<tree::ConstExp>((--n) * level->frame_->WordSize()))), efield_expty->exp_->UnEx()), stm);
   }
 
   if (field_it != fields.rend() || efield_it != efields.rend()) {
     errormsg->Error(pos_, "fields mismatch");
-    return new tr::ExpAndTy(new tr::ExExp(new tree::ConstExp(0)), type::VoidTy::Instance());
+    return util::New<tr::ExpAndTy>(util::New<tr::ExExp>(util::New<tree::ConstExp>(0)), type::VoidTy::Instance());
   }
 
-  stm = new tree::SeqStm(malloc_stm, stm);
-  tree::Exp *res_exp = new tree::EseqExp(stm, reg_exp);
+  stm = util::New<tree::SeqStm>(malloc_stm, stm);
+  tree::Exp *res_exp = util::New<tree::EseqExp>(stm, reg_exp);
 
-  return new tr::ExpAndTy(new tr::ExExp(res_exp), rec_ty);
+  return util::New<tr::ExpAndTy>(util::New<tr::ExExp>(res_exp), rec_ty);
 }
 
 tr::ExpAndTy *SeqExp::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
                                 tr::Level *level, temp::Label *label,
                                 err::ErrorMsg *errormsg) const {
-  tree::ExpList *seq_exps = new tree::ExpList();
+  tree::ExpList *seq_exps = util::New<tree::ExpList>();
   tr::ExpAndTy *expty;
   for (auto exp : seq_->GetList()) {
     expty = exp->Translate(venv, tenv, level, label, errormsg);
@@ -486,9 +503,9 @@ tr::ExpAndTy *SeqExp::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
   
   tree::Exp *res_exp = seq_exps->GetList().back();
   for (auto it = ++seq_exps->GetList().rbegin(); it != seq_exps->GetList().rend(); ++it)
-    res_exp = new tree::EseqExp(new tree::ExpStm(*it), res_exp);
+    res_exp = util::New<tree::EseqExp>(util::New<tree::ExpStm>(*it), res_exp);
   
-  return new tr::ExpAndTy(new tr::ExExp(res_exp), expty->ty_);
+  return util::New<tr::ExpAndTy>(util::New<tr::ExExp>(res_exp), expty->ty_);
 }
 
 tr::ExpAndTy *AssignExp::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
@@ -496,15 +513,15 @@ tr::ExpAndTy *AssignExp::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
                                    err::ErrorMsg *errormsg) const {
   tr::ExpAndTy *var_expty = var_->Translate(venv, tenv, level, label, errormsg);
   tr::ExpAndTy *exp_expty = exp_->Translate(venv, tenv, level, label, errormsg);
-  if (!(var_expty->ty_->IsSameType(exp_expty->ty_))) {
+  if (venv && !(var_expty->ty_->IsSameType(exp_expty->ty_))) {
     errormsg->Error(exp_->pos_, "unmatched assign exp");
-    return new tr::ExpAndTy(new tr::ExExp(new tree::ConstExp(0)), type::VoidTy::Instance());
+    return util::New<tr::ExpAndTy>(util::New<tr::ExExp>(util::New<tree::ConstExp>(0)), type::VoidTy::Instance());
   }
 
   tree::Exp *var_exp = var_expty->exp_->UnEx();
   tree::Exp *exp_exp = exp_expty->exp_->UnEx();
-  tree::Stm *assign_stm = new tree::MoveStm(var_exp, exp_exp);
-  return new tr::ExpAndTy(new tr::NxExp(assign_stm), type::VoidTy::Instance());
+  tree::Stm *assign_stm = util::New<tree::MoveStm>(var_exp, exp_exp);
+  return util::New<tr::ExpAndTy>(util::New<tr::NxExp>(assign_stm), type::VoidTy::Instance());
 }
 
 tr::ExpAndTy *IfExp::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
@@ -524,57 +541,57 @@ tr::ExpAndTy *IfExp::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
   }
 
   if (!elsee_) {
-    if (typeid(*then_expty->ty_) != typeid(type::VoidTy)) {
+    if (venv && typeid(*then_expty->ty_) != typeid(type::VoidTy)) {
       errormsg->Error(then_->pos_, "if with no else must return no value");
-      return new tr::ExpAndTy(new tr::ExExp(new tree::ConstExp(0)), type::VoidTy::Instance());
+      return util::New<tr::ExpAndTy>(util::New<tr::ExExp>(util::New<tree::ConstExp>(0)), type::VoidTy::Instance());
     }
 
     if (typeid(*then_expty->ty_) == typeid(type::VoidTy)) {
       // *test_cx.trues_ = true_label;
       // *test_cx.falses_ = false_label;
-      tree::Stm* stm = new tree::SeqStm(test_cx.stm_, 
-                        new tree::SeqStm(new tree::LabelStm(*test_cx.trues_), 
-                          new tree::SeqStm(then_expty->exp_->UnNx(), 
-                            new tree::LabelStm(*test_cx.falses_))));
-      return new tr::ExpAndTy(new tr::NxExp(stm), type::VoidTy::Instance());
+      tree::Stm* stm = util::New<tree::SeqStm>(test_cx.stm_, 
+                        util::New<tree::SeqStm>(util::New<tree::LabelStm>(*test_cx.trues_), 
+                          util::New<tree::SeqStm>(then_expty->exp_->UnNx(), 
+                            util::New<tree::LabelStm>(*test_cx.falses_))));
+      return util::New<tr::ExpAndTy>(util::New<tr::NxExp>(stm), type::VoidTy::Instance());
 
     } else {
       errormsg->Error(then_->pos_, "if-then exp's body must produce no value");
-      return new tr::ExpAndTy(new tr::ExExp(new tree::ConstExp(0)), type::VoidTy::Instance());
+      return util::New<tr::ExpAndTy>(util::New<tr::ExExp>(util::New<tree::ConstExp>(0)), type::VoidTy::Instance());
     }
 
   } else {
     tr::ExpAndTy *else_expty = elsee_->Translate(venv, tenv, level, label, errormsg);
 
-    if (!(then_expty->ty_->IsSameType(else_expty->ty_))) {
+    if (venv && !(then_expty->ty_->IsSameType(else_expty->ty_))) {
       errormsg->Error(elsee_->pos_, "then exp and else exp type mismatch");
-      return new tr::ExpAndTy(new tr::ExExp(new tree::ConstExp(0)), type::VoidTy::Instance());
+      return util::New<tr::ExpAndTy>(util::New<tr::ExExp>(util::New<tree::ConstExp>(0)), type::VoidTy::Instance());
     }
 
     temp::Label *converge_label = temp::LabelFactory::NewLabel();
-    std::vector<temp::Label *> *converge_jumps = new std::vector<temp::Label *>{converge_label};
+    std::vector<temp::Label *> *converge_jumps = util::New<std::vector<temp::Label *>>({converge_label});
     
     if (typeid(*then_expty->ty_) == typeid(type::VoidTy)) {
-      tree::Stm *stm = new tree::SeqStm(test_cx.stm_,
-                          new tree::SeqStm(new tree::LabelStm(*test_cx.trues_), 
-                            new tree::SeqStm(then_expty->exp_->UnNx(),
-                              new tree::SeqStm(new tree::JumpStm(new tree::NameExp(converge_label), converge_jumps), 
-                                new tree::SeqStm(new tree::LabelStm(*test_cx.falses_),
-                                  new tree::SeqStm(else_expty->exp_->UnNx(), 
-                                    new tree::LabelStm(converge_label)))))));
-      return new tr::ExpAndTy(new tr::NxExp(stm), type::VoidTy::Instance());
+      tree::Stm *stm = util::New<tree::SeqStm>(test_cx.stm_,
+                          util::New<tree::SeqStm>(util::New<tree::LabelStm>(*test_cx.trues_), 
+                            util::New<tree::SeqStm>(then_expty->exp_->UnNx(),
+                              util::New<tree::SeqStm>(util::New<tree::JumpStm>(util::New<tree::NameExp>(converge_label), converge_jumps), 
+                                util::New<tree::SeqStm>(util::New<tree::LabelStm>(*test_cx.falses_),
+                                  util::New<tree::SeqStm>(else_expty->exp_->UnNx(), 
+                                    util::New<tree::LabelStm>(converge_label)))))));
+      return util::New<tr::ExpAndTy>(util::New<tr::NxExp>(stm), type::VoidTy::Instance());
 
     } else {
       temp::Temp *reg = temp::TempFactory::NewTemp();
-      tree::Exp *reg_exp = new tree::TempExp(reg);
-      tree::Exp *exp = new tree::EseqExp(test_cx.stm_,
-                          new tree::EseqExp(new tree::LabelStm(*test_cx.trues_),
-                            new tree::EseqExp(new tree::MoveStm(reg_exp, then_expty->exp_->UnEx()),
-                              new tree::EseqExp(new tree::JumpStm(new tree::NameExp(converge_label), converge_jumps),
-                                new tree::EseqExp(new tree::LabelStm(*test_cx.falses_),
-                                  new tree::EseqExp(new tree::MoveStm(reg_exp, else_expty->exp_->UnEx()), 
-                                    new tree::EseqExp(new tree::LabelStm(converge_label), reg_exp)))))));
-      return new tr::ExpAndTy(new tr::ExExp(exp), then_expty->ty_);
+      tree::Exp *reg_exp = util::New<tree::TempExp>(reg);
+      tree::Exp *exp = util::New<tree::EseqExp>(test_cx.stm_,
+                          util::New<tree::EseqExp>(util::New<tree::LabelStm>(*test_cx.trues_),
+                            util::New<tree::EseqExp>(util::New<tree::MoveStm>(reg_exp, then_expty->exp_->UnEx()),
+                              util::New<tree::EseqExp>(util::New<tree::JumpStm>(util::New<tree::NameExp>(converge_label), converge_jumps),
+                                util::New<tree::EseqExp>(util::New<tree::LabelStm>(*test_cx.falses_),
+                                  util::New<tree::EseqExp>(util::New<tree::MoveStm>(reg_exp, else_expty->exp_->UnEx()), 
+                                    util::New<tree::EseqExp>(util::New<tree::LabelStm>(converge_label), reg_exp)))))));
+      return util::New<tr::ExpAndTy>(util::New<tr::ExExp>(exp), then_expty->ty_);
     }
   }
 }
@@ -590,23 +607,23 @@ tr::ExpAndTy *WhileExp::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
   temp::Label *done_label = temp::LabelFactory::NewLabel();
   tr::ExpAndTy *body_expty = body_->Translate(venv, tenv, level, done_label, errormsg);
   
-  if (typeid(*body_expty->ty_) != typeid(type::VoidTy)) {
+  if (venv && typeid(*body_expty->ty_) != typeid(type::VoidTy)) {
     errormsg->Error(body_->pos_, "while body must produce no value");
-    return new tr::ExpAndTy(new tr::ExExp(new tree::ConstExp(0)), type::VoidTy::Instance());
+    return util::New<tr::ExpAndTy>(util::New<tr::ExExp>(util::New<tree::ConstExp>(0)), type::VoidTy::Instance());
   }
 
   *test_cx.trues_ = body_label;
   *test_cx.falses_ = done_label;
 
-  std::vector<temp::Label *> *test_jumps = new std::vector<temp::Label *>{test_label};
-  tree::Stm *test_jump_stm = new tree::JumpStm(new tree::NameExp(test_label), test_jumps);
+  std::vector<temp::Label *> *test_jumps = util::New<std::vector<temp::Label *>>({test_label});
+  tree::Stm *test_jump_stm = util::New<tree::JumpStm>(util::New<tree::NameExp>(test_label), test_jumps);
 
-  tree::Stm *while_stm = new tree::SeqStm(new tree::LabelStm(test_label),
-                          new tree::SeqStm(test_cx.stm_,
-                            new tree::SeqStm(new tree::LabelStm(body_label),
-                              new tree::SeqStm(body_expty->exp_->UnNx(), 
-                                new tree::SeqStm(test_jump_stm, new tree::LabelStm(done_label))))));
-  return new tr::ExpAndTy(new tr::NxExp(while_stm), type::VoidTy::Instance());
+  tree::Stm *while_stm = util::New<tree::SeqStm>(util::New<tree::LabelStm>(test_label),
+                          util::New<tree::SeqStm>(test_cx.stm_,
+                            util::New<tree::SeqStm>(util::New<tree::LabelStm>(body_label),
+                              util::New<tree::SeqStm>(body_expty->exp_->UnNx(), 
+                                util::New<tree::SeqStm>(test_jump_stm, util::New<tree::LabelStm>(done_label))))));
+  return util::New<tr::ExpAndTy>(util::New<tr::NxExp>(while_stm), type::VoidTy::Instance());
 
 }
 
@@ -625,6 +642,12 @@ tr::ExpAndTy *ForExp::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
 
   SimpleVar *it_var = new SimpleVar(pos_, var_);
   SimpleVar *limit_var = new SimpleVar(pos_, limit_sym);
+  if (!venv) {
+    // The body refers to the loop variable by entry_
+    lo_dec->entry_ = it_var->entry_ = entry_;
+    hi_dec->entry_ = limit_var->entry_ =
+        new env::VarEntry(type::IntTy::Instance(), true);
+  }
   VarExp *it_exp = new VarExp(pos_, it_var);
   VarExp *limit_exp = new VarExp(pos_, limit_var);
 
@@ -644,91 +667,101 @@ tr::ExpAndTy *ForExp::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
 tr::ExpAndTy *BreakExp::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
                                   tr::Level *level, temp::Label *label,
                                   err::ErrorMsg *errormsg) const {
-  std::vector<temp::Label *> *jumps = new std::vector<temp::Label *>{label};
-  tree::Stm *jump_stm = new tree::JumpStm(new tree::NameExp(label), jumps);
-  return new tr::ExpAndTy(new tr::NxExp(jump_stm), type::VoidTy::Instance());
+  std::vector<temp::Label *> *jumps = util::New<std::vector<temp::Label *>>({label});
+  tree::Stm *jump_stm = util::New<tree::JumpStm>(util::New<tree::NameExp>(label), jumps);
+  return util::New<tr::ExpAndTy>(util::New<tr::NxExp>(jump_stm), type::VoidTy::Instance());
 }
 
 tr::ExpAndTy *LetExp::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
                                 tr::Level *level, temp::Label *label,
                                 err::ErrorMsg *errormsg) const {
-  venv->BeginScope();
-  tenv->BeginScope();
+  if (venv) {
+    venv->BeginScope();
+    tenv->BeginScope();
+  }
 
   auto dec_it = decs_->GetList().begin();
   if (dec_it == decs_->GetList().end()) {  // declist is empty
     tr::ExpAndTy *body_expty = body_->Translate(venv, tenv, level, label, errormsg);
     if (typeid(*body_expty->exp_) == typeid(tr::NxExp)) {
-      venv->EndScope();
-      tenv->EndScope();
-      return new tr::ExpAndTy(body_expty->exp_, type::VoidTy::Instance());
+      if (venv) {
+        venv->EndScope();
+        tenv->EndScope();
+      }
+      return util::New<tr::ExpAndTy>(body_expty->exp_, type::VoidTy::Instance());
     } else {
       tree::Exp *body_exp = body_expty->exp_->UnEx();
-      venv->EndScope();
-      tenv->EndScope();
-      return new tr::ExpAndTy(new tr::ExExp(body_exp), body_expty->ty_);
+      if (venv) {
+        venv->EndScope();
+        tenv->EndScope();
+      }
+      return util::New<tr::ExpAndTy>(util::New<tr::ExExp>(body_exp), body_expty->ty_);
     }
   }
 
   tree::Stm *dec_stm = (*dec_it)->Translate(venv, tenv, level, label, errormsg)->UnNx();
   dec_it++;
   for (; dec_it != decs_->GetList().end(); dec_it++)
-    dec_stm = new tree::SeqStm(dec_stm, (*dec_it)->Translate(venv, tenv, level, label, errormsg)->UnNx());
+    dec_stm = util::New<tree::SeqStm>(dec_stm, (*dec_it)->Translate(venv, tenv, level, label, errormsg)->UnNx());
   
   tr::ExpAndTy *body_expty = body_->Translate(venv, tenv, level, label, errormsg);
   if (typeid(*body_expty->exp_) == typeid(tr::NxExp)) {
     tree::Stm *body_stm = body_expty->exp_->UnNx();
-    tree::Stm *seq_stm = new tree::SeqStm(dec_stm, body_stm);
-    venv->EndScope();
-    tenv->EndScope();
-    return new tr::ExpAndTy(new tr::NxExp(seq_stm), type::VoidTy::Instance());
+    tree::Stm *seq_stm = util::New<tree::SeqStm>(dec_stm, body_stm);
+    if (venv) {
+      venv->EndScope();
+      tenv->EndScope();
+    }
+    return util::New<tr::ExpAndTy>(util::New<tr::NxExp>(seq_stm), type::VoidTy::Instance());
   } else {
     tree::Exp *body_exp = body_expty->exp_->UnEx();
-    tree::Exp *eseq_exp = new tree::EseqExp(dec_stm, body_exp);
-    venv->EndScope();
-    tenv->EndScope();
-    return new tr::ExpAndTy(new tr::ExExp(eseq_exp), body_expty->ty_);
+    tree::Exp *eseq_exp = util::New<tree::EseqExp>(dec_stm, body_exp);
+    if (venv) {
+      venv->EndScope();
+      tenv->EndScope();
+    }
+    return util::New<tr::ExpAndTy>(util::New<tr::ExExp>(eseq_exp), body_expty->ty_);
   }
 }
 
 tr::ExpAndTy *ArrayExp::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
                                   tr::Level *level, temp::Label *label,                    
                                   err::ErrorMsg *errormsg) const {
-  type::Ty* ty = tenv->Look(typ_);
+  type::Ty* ty = tenv ? tenv->Look(typ_) : ty_;
   if (!ty) {
     errormsg->Error(pos_, "undefined type %s", typ_->Name().data());
-    return new tr::ExpAndTy(new tr::ExExp(new tree::ConstExp(0)), type::VoidTy::Instance());
+    return util::New<tr::ExpAndTy>(util::New<tr::ExExp>(util::New<tree::ConstExp>(0)), type::VoidTy::Instance());
   }
   type::Ty *ty_actual_ty = ty->ActualTy();
-  if (typeid(*ty_actual_ty) != typeid(type::ArrayTy)) {
+  if (venv && typeid(*ty_actual_ty) != typeid(type::ArrayTy)) {
     errormsg->Error(pos_, "type %s is not an array", typ_->Name().data());
-    return new tr::ExpAndTy(new tr::ExExp(new tree::ConstExp(0)), type::VoidTy::Instance());
+    return util::New<tr::ExpAndTy>(util::New<tr::ExExp>(util::New<tree::ConstExp>(0)), type::VoidTy::Instance());
   }
 
   type::ArrayTy *arr_ty = static_cast<type::ArrayTy *>(ty->ActualTy());
   tr::ExpAndTy *size_expty = size_->Translate(venv, tenv, level, label, errormsg);
   type::Ty *size_actual_ty = size_expty->ty_->ActualTy();
-  if (typeid(*size_actual_ty) != typeid(type::IntTy)) {
+  if (venv && typeid(*size_actual_ty) != typeid(type::IntTy)) {
     errormsg->Error(size_->pos_, "integer required for array size");
-    return new tr::ExpAndTy(new tr::ExExp(new tree::ConstExp(0)), type::VoidTy::Instance());
+    return util::New<tr::ExpAndTy>(util::New<tr::ExExp>(util::New<tree::ConstExp>(0)), type::VoidTy::Instance());
   }
   tr::ExpAndTy *init_expty = init_->Translate(venv, tenv, level, label, errormsg);
-  if (!(init_expty->ty_->IsSameType(arr_ty->ty_))) {
+  if (venv && !(init_expty->ty_->IsSameType(arr_ty->ty_))) {
     errormsg->Error(init_->pos_, "type mismatch");
-    return new tr::ExpAndTy(new tr::ExExp(new tree::ConstExp(0)), type::VoidTy::Instance());
+    return util::New<tr::ExpAndTy>(util::New<tr::ExExp>(util::New<tree::ConstExp>(0)), type::VoidTy::Instance());
   }
 
-  tree::Exp *reg_exp = new tree::TempExp(temp::TempFactory::NewTemp());
-  tree::ExpList *call_args = new tree::ExpList({size_expty->exp_->UnEx(), init_expty->exp_->UnEx()});
-  tree::Stm *init_stm = new tree::MoveStm(reg_exp, frame::ExternalCall("init_array", call_args));
-  tree::Exp *res_exp = new tree::EseqExp(init_stm, reg_exp);
-  return new tr::ExpAndTy(new tr::ExExp(res_exp), arr_ty);
+  tree::Exp *reg_exp = util::New<tree::TempExp>(temp::TempFactory::NewTemp());
+  tree::ExpList *call_args = util::New<tree::ExpList>({size_expty->exp_->UnEx(), init_expty->exp_->UnEx()});
+  tree::Stm *init_stm = util::New<tree::MoveStm>(reg_exp, frame::ExternalCall("init_array", call_args));
+  tree::Exp *res_exp = util::New<tree::EseqExp>(init_stm, reg_exp);
+  return util::New<tr::ExpAndTy>(util::New<tr::ExExp>(res_exp), arr_ty);
 }
 
 tr::ExpAndTy *VoidExp::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
                                  tr::Level *level, temp::Label *label,
                                  err::ErrorMsg *errormsg) const {
-  return new tr::ExpAndTy(new tr::ExExp(new tree::ConstExp(0)), type::VoidTy::Instance());
+  return util::New<tr::ExpAndTy>(util::New<tr::ExExp>(util::New<tree::ConstExp>(0)), type::VoidTy::Instance());
 }
 
 tr::Exp *FunctionDec::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
@@ -740,93 +773,125 @@ tr::Exp *FunctionDec::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
   frame::Frame* new_frame;
   tr::Level *new_level;
   std::vector<frame::Access *> formal_access;
-  std::unordered_map<std::string, temp::Label *> function_record;
+  std::unordered_map<sym::Symbol *, temp::Label *> function_record;
+  // Each function gets its own arena, current while its frame and body are
+  // built, so that its IR is released with its ProcFrag
+  std::vector<std::unique_ptr<util::Arena>> arenas;
 
   for (FunDec *function : functions_->GetList()) {
-    if (function_record.count(function->name_->Name())) {
+    if (venv && function_record.count(function->name_)) {
       errormsg->Error(function->pos_, "two functions have the same name");
-      return new tr::ExExp(new tree::ConstExp(0));
+      return util::New<tr::ExExp>(util::New<tree::ConstExp>(0));
     }
 
     fun_label = temp::LabelFactory::NewLabel();
-    function_record[function->name_->Name()] = fun_label;
-    result_ty = function->result_ ? 
-                  tenv->Look(function->result_) : type::VoidTy::Instance();
-    formal_tys = function->params_->MakeFormalTyList(tenv, errormsg);
+    if (venv) {
+      function_record[function->name_] = fun_label;
+      result_ty = function->result_ ? 
+                    tenv->Look(function->result_) : type::VoidTy::Instance();
+      formal_tys = function->params_->MakeFormalTyList(tenv, errormsg);
+    }
 
     std::vector<bool> formal_escapes = std::vector<bool>{true};
     for (auto param : function->params_->GetList()) 
       formal_escapes.push_back(param->escape_);
     
-    new_frame = frame::NewFrame(fun_label, formal_escapes);
+    arenas.push_back(std::make_unique<util::Arena>());
+    {
+      util::Arena::Scope scope(arenas.back().get());
+      new_frame = frame::NewFrame(fun_label, formal_escapes);
+    }
+    if (new_frame->stats_)
+      new_frame->stats_->name_ = function->name_->Name();
     new_level = new tr::Level(new_frame, level);
     formal_access = new_frame->formal_access_;
 
-    venv->Enter(function->name_, new env::FunEntry(new_level, fun_label, formal_tys, result_ty));
+    if (venv) {
+      venv->Enter(function->name_, new env::FunEntry(new_level, fun_label, formal_tys, result_ty));
+    } else {
+      function->entry_->level_ = new_level;
+      function->entry_->label_ = fun_label;
+    }
   }
 
+  auto arena_it = arenas.begin();
   for (FunDec* function : functions_->GetList()) {
-    env::EnvEntry *ent = venv->Look(function->name_);
-    env::FunEntry *func_ent = static_cast<env::FunEntry *>(ent);
+    std::unique_ptr<util::Arena> arena = std::move(*arena_it++);
+    util::Arena::Scope scope(arena.get());
+    env::FunEntry *func_ent = function->entry_;
+    if (venv)
+      func_ent = static_cast<env::FunEntry *>(venv->Look(function->name_));
 
     new_level = func_ent->level_;
     new_frame = new_level->frame_;
+    util::FunctionStats::Scope counting(new_frame->stats_);
     formal_access = new_frame->formal_access_;
     fun_label = func_ent->label_;
-    result_ty = function->result_ ? 
-                  tenv->Look(function->result_) : type::VoidTy::Instance();
-    formal_tys = function->params_->MakeFormalTyList(tenv, errormsg);
+    auto acc_it = formal_access.cbegin() + 1;  // the first one goes to static link
+
+    if (venv) {
+      result_ty = function->result_ ? 
+                    tenv->Look(function->result_) : type::VoidTy::Instance();
+      formal_tys = function->params_->MakeFormalTyList(tenv, errormsg);
     
-    venv->BeginScope();
+      venv->BeginScope();
 
-    auto param_it = function->params_->GetList().cbegin();
-    auto formal_ty_it = formal_tys->GetList().cbegin();
-    auto acc_it = formal_access.cbegin() + 1;  // the first one goes to static link
-    for (; formal_ty_it != formal_tys->GetList().cend(); param_it++, formal_ty_it++, acc_it++)
-      venv->Enter((*param_it)->name_, new env::VarEntry(new tr::Access(new_level, *acc_it), *formal_ty_it));
+      auto param_it = function->params_->GetList().cbegin();
+      auto formal_ty_it = formal_tys->GetList().cbegin();
+      for (; formal_ty_it != formal_tys->GetList().cend(); param_it++, formal_ty_it++, acc_it++)
+        venv->Enter((*param_it)->name_, new env::VarEntry(new tr::Access(new_level, *acc_it), *formal_ty_it));
+    } else {
+      for (Field *param : function->params_->GetList())
+        param->entry_->access_ = new tr::Access(new_level, *acc_it++);
+    }
     
     tr::ExpAndTy* body_expty = function->body_->Translate(venv, tenv, new_level, label, errormsg);
-    if (!function->result_
+    if (venv && !function->result_
         && typeid(*body_expty->ty_) != typeid(type::VoidTy)) {
       errormsg->Error(function->body_->pos_, "procedure returns value");
-    } else if (function->result_ && !(body_expty->ty_->IsSameType(result_ty))) {
+    } else if (venv && function->result_ && !(body_expty->ty_->IsSameType(result_ty))) {
       errormsg->Error(function->body_->pos_, "return type of function %s mismatch", 
                         function->name_->Name().data());
     }
 
     tree::Stm *body_stm = frame::ProcEntryExit1(new_frame, 
-                            new tree::MoveStm(new tree::TempExp(reg_manager->ReturnValue()), 
+                            util::New<tree::MoveStm>(util::New<tree::TempExp>(reg_manager->ReturnValue()), 
                               body_expty->exp_->UnEx()));
-    tr::ProcEntryExit(new_level, new tr::NxExp(body_stm));
+    tr::ProcEntryExit(new_level, util::New<tr::NxExp>(body_stm),
+                      std::move(arena));
 
-    venv->EndScope();
+    if (venv)
+      venv->EndScope();
   }
 
-  return new tr::NxExp(new tree::ExpStm(new tree::ConstExp(0)));
+  // Outside the function scopes again: this belongs to the enclosing body
+  return util::New<tr::NxExp>(util::New<tree::ExpStm>(util::New<tree::ConstExp>(0)));
 }
 
 tr::Exp *VarDec::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
                            tr::Level *level, temp::Label *label,
                            err::ErrorMsg *errormsg) const {
   type::Ty* ty;
-  if (typ_) {
+  if (venv && typ_) {
     ty = tenv->Look(typ_);
     if (!ty) {
       errormsg->Error(pos_, "undefined type %s", typ_->Name().data());
-      return new tr::ExExp(new tree::ConstExp(0));
+      return util::New<tr::ExExp>(util::New<tree::ConstExp>(0));
     }
   }
 
   tr::ExpAndTy *init_expty = init_->Translate(venv, tenv, level, label, errormsg);
 
   tr::Access *var_acc = tr::Access::AllocLocal(level, escape_);
-  env::EnvEntry *ent = new env::VarEntry(var_acc, init_expty->ty_);
-  venv->Enter(var_, ent);
+  if (venv)
+    venv->Enter(var_, new env::VarEntry(var_acc, init_expty->ty_));
+  else
+    entry_->access_ = var_acc;
 
   tree::Exp *acc_exp = frame::AccessCurrentExp(var_acc->access_, level->frame_);
-  tree::Stm *dec_stm = new tree::MoveStm(acc_exp, init_expty->exp_->UnEx());
+  tree::Stm *dec_stm = util::New<tree::MoveStm>(acc_exp, init_expty->exp_->UnEx());
 
-  return new tr::NxExp(dec_stm);
+  return util::New<tr::NxExp>(dec_stm);
 }
 
 tr::Exp *TypeDec::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
@@ -834,14 +899,18 @@ tr::Exp *TypeDec::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
                             err::ErrorMsg *errormsg) const {
   type::Ty* ty;
   type::NameTy* tenv_ty;
-  std::unordered_map<std::string, int> typeRecord;
+  std::unordered_map<sym::Symbol *, int> typeRecord;
+
+  // The types built by semantic analysis are the ones annotated
+  if (!tenv)
+    return util::New<tr::NxExp>(util::New<tree::ExpStm>(util::New<tree::ConstExp>(0)));
 
   for (NameAndTy* nameAndTy : types_->GetList()) {
-    if (typeRecord.count(nameAndTy->name_->Name())) {
+    if (typeRecord.count(nameAndTy->name_)) {
       errormsg->Error(nameAndTy->ty_->pos_, "two types have the same name");
-      return new tr::ExExp(new tree::ConstExp(0));
+      return util::New<tr::ExExp>(util::New<tree::ConstExp>(0));
     }
-    typeRecord[nameAndTy->name_->Name()] = 1;
+    typeRecord[nameAndTy->name_] = 1;
     tenv->Enter(nameAndTy->name_, new type::NameTy(nameAndTy->name_, NULL));
   }
 
@@ -849,7 +918,7 @@ tr::Exp *TypeDec::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
     ty = tenv->Look(nameAndTy->name_);
     if (!ty) {
       errormsg->Error(nameAndTy->ty_->pos_, "undefined type %s", nameAndTy->name_->Name().data());
-      return new tr::ExExp(new tree::ConstExp(0));
+      return util::New<tr::ExExp>(util::New<tree::ConstExp>(0));
     }
     tenv_ty = static_cast<type::NameTy*>(ty);
     tenv_ty->ty_ = nameAndTy->ty_->Translate(tenv, errormsg);
@@ -863,13 +932,13 @@ tr::Exp *TypeDec::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
       tenv_ty = static_cast<type::NameTy*>(ty);
       if (tenv_ty->sym_->Name() == nameAndTy->name_->Name()) {
         errormsg->Error(nameAndTy->ty_->pos_, "illegal type cycle");
-        return new tr::ExExp(new tree::ConstExp(0));
+        return util::New<tr::ExExp>(util::New<tree::ConstExp>(0));
       }
       ty = tenv_ty->ty_;
     }
   }
 
-  return new tr::NxExp(new tree::ExpStm(new tree::ConstExp(0)));
+  return util::New<tr::NxExp>(util::New<tree::ExpStm>(util::New<tree::ConstExp>(0)));
 }
 
 type::Ty *NameTy::Translate(env::TEnvPtr tenv, err::ErrorMsg *errormsg) const {
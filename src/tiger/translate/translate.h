@@ -141,6 +141,11 @@ public:
  *   errormsg = prog_tr.TransferErrormsg();
  *   // frags now contains ProcFrag and StringFrag objects
  * @endcode
+ *
+ * A tree that has been through semantic analysis can be translated from
+ * its annotations (see absyn.h): there are no environments to fill, no
+ * name is looked up and nothing checked again, and escape analysis need
+ * not run, semantic analysis having set the escape flags.
  */
 class ProgTr {
 public:
@@ -148,17 +153,22 @@ public:
    * @brief Construct the translation driver
    * @param absyn_tree Parsed and semantically-checked AST (ownership in)
    * @param errormsg   Error reporter (ownership in)
+   * @param annotated  Translate from the annotations semantic analysis left
+   *                   on @p absyn_tree, which has no errors
    *
    * Initialises the outermost level, populates the base environments with
-   * Tiger built-in types and functions, and prepares for translation.
+   * Tiger built-in types and functions unless @p annotated, and prepares
+   * for translation.
    */
   ProgTr(std::unique_ptr<absyn::AbsynTree> absyn_tree,
-    std::unique_ptr<err::ErrorMsg> errormsg) {
+    std::unique_ptr<err::ErrorMsg> errormsg, bool annotated = false) {
       absyn_tree_ = std::move(absyn_tree);
       errormsg_ = std::move(errormsg);
+      outermost_level_ = std::make_unique<Level>();
+      if (annotated)
+        return;
       tenv_ = std::make_unique<env::TEnv>();
       venv_ = std::make_unique<env::VEnv>();
-      outermost_level_ = std::make_unique<Level>();
       FillBaseVEnv();
       FillBaseTEnv();
     }
@@ -184,8 +194,8 @@ private:
   std::unique_ptr<absyn::AbsynTree> absyn_tree_; ///< The program AST
   std::unique_ptr<err::ErrorMsg> errormsg_;       ///< Error reporter
   std::unique_ptr<Level> outermost_level_;        ///< Dummy outermost level
-  std::unique_ptr<env::TEnv> tenv_;               ///< Type environment
-  std::unique_ptr<env::VEnv> venv_;               ///< Variable/function environment
+  std::unique_ptr<env::TEnv> tenv_;               ///< Type environment, unless annotated
+  std::unique_ptr<env::VEnv> venv_;               ///< Variable/function environment, unless annotated
 
   /** @brief Populate venv_ with Tiger built-in functions */
   void FillBaseVEnv();
@@ -201,8 +211,9 @@ private:
  *
  * @param level The level (frame) of the completed function
  * @param body  The translated body expression (as NxExp)
+ * @param arena The arena the body was built in; the fragment takes it over
  */
-void ProcEntryExit(Level *level, Exp *body);
+void ProcEntryExit(Level *level, Exp *body, std::unique_ptr<util::Arena> arena);
 
 } // namespace tr
 
@@ -14,49 +14,31 @@ void Indent(FILE *out, int d) {
 
 namespace tree {
 
-SeqStm::~SeqStm() {
-  delete left_;
-  delete right_;
-}
+SeqStm::~SeqStm() = default;
 
 LabelStm::~LabelStm() = default;
 
-JumpStm::~JumpStm() { delete exp_; }
+JumpStm::~JumpStm() = default;
 
-CjumpStm::~CjumpStm() {
-  delete left_;
-  delete right_;
-}
+CjumpStm::~CjumpStm() = default;
 
-MoveStm::~MoveStm() {
-  delete dst_;
-  delete src_;
-}
+MoveStm::~MoveStm() = default;
 
-ExpStm::~ExpStm() { delete exp_; }
+ExpStm::~ExpStm() = default;
 
-BinopExp::~BinopExp() {
-  delete left_;
-  delete right_;
-}
+BinopExp::~BinopExp() = default;
 
-MemExp::~MemExp() { delete exp_; }
+MemExp::~MemExp() = default;
 
 TempExp::~TempExp() = default;
 
-EseqExp::~EseqExp() {
-  delete stm_;
-  delete exp_;
-}
+EseqExp::~EseqExp() = default;
 
 NameExp::~NameExp() = default;
 
 ConstExp::~ConstExp() = default;
 
-CallExp::~CallExp() {
-  delete fun_;
-  delete args_;
-}
+CallExp::~CallExp() = default;
 
 void SeqStm::Print(FILE *out, int d) const {
   Indent(out, d);
@@ -132,7 +114,7 @@ void MemExp::Print(FILE *out, int d) const {
 
 void TempExp::Print(FILE *out, int d) const {
   Indent(out, d);
-  fprintf(out, "temp %s", temp::Map::Name()->Look(temp_)->data());
+  fprintf(out, "temp %s", temp::Map::Name()->NameOf(temp_).c_str());
 }
 
 void EseqExp::Print(FILE *out, int d) const {
@@ -45,6 +45,9 @@
  *              and emits x64 assembly instructions into an InstrList.
  *              Returns the TEMP holding the result (for Exp nodes).
  *
+ *   Encode() – write the tree to an output::IrEncoder, which identifies a
+ *              function's canonical trees for the function cache.
+ *
  * ─────────────────────────────────────────────────────────────────────────
  * Operator enumerations
  * ─────────────────────────────────────────────────────────────────────────
@@ -54,6 +57,14 @@
  * Helper functions:
  *   NotRel(op)    – logical negation of a relational operator
  *   Commute(op)   – commuted form of a relational operator (swap operands)
+ *
+ * ─────────────────────────────────────────────────────────────────────────
+ * Allocation
+ * ─────────────────────────────────────────────────────────────────────────
+ * Nodes are created with util::New() inside the arena of the function being
+ * compiled (see util::Arena and frame::ProcFrag) and are released together
+ * with it.  Canonicalization shares subtrees freely, so a node never owns
+ * or deletes its children.
  */
 
 #ifndef TIGER_TRANSLATE_TREE_H_
@@ -66,6 +77,8 @@
 #include <string>
 
 #include "tiger/frame/temp.h"
+#include "tiger/util/arena.h"
+#include "tiger/util/stats.h"
 
 // Forward Declarations
 namespace canon {
@@ -81,6 +94,10 @@ namespace frame {
 class RegManager;
 } // namespace frame
 
+namespace output {
+class IrEncoder;
+} // namespace output
+
 namespace tree {
 
 class Stm;
@@ -144,6 +161,7 @@ enum RelOp {
  *   - Print()  – pretty-print for debugging
  *   - Canon()  – canonicalize (remove ESEQ, lift CALL results)
  *   - Munch()  – emit x64 assembly instructions (instruction selection)
+ *   - Encode() – write the statement to a function cache key
  *
  * Static helpers:
  *   - IsNop()     – true if this statement is a no-op (EXP(CONST(0)))
@@ -152,11 +170,16 @@ enum RelOp {
  */
 class Stm {
 public:
+  Stm() {
+    if (util::FunctionStats *stats = util::FunctionStats::Current())
+      ++stats->ir_nodes_;
+  }
   virtual ~Stm() = default;
 
   virtual void Print(FILE *out, int d) const = 0;
   virtual Stm *Canon() = 0;
   virtual void Munch(assem::InstrList &instr_list, std::string_view fs) = 0;
+  virtual void Encode(output::IrEncoder &encoder) const = 0;
 
   /**
    * @brief Test whether this statement is a no-op
@@ -201,6 +224,7 @@ public:
   void Print(FILE *out, int d) const override;
   Stm *Canon() override;
   void Munch(assem::InstrList &instr_list, std::string_view fs) override;
+  void Encode(output::IrEncoder &encoder) const override;
 };
 
 /**
@@ -219,6 +243,7 @@ public:
   void Print(FILE *out, int d) const override;
   Stm *Canon() override;
   void Munch(assem::InstrList &instr_list, std::string_view fs) override;
+  void Encode(output::IrEncoder &encoder) const override;
 };
 
 /**
@@ -240,6 +265,7 @@ public:
   void Print(FILE *out, int d) const override;
   Stm *Canon() override;
   void Munch(assem::InstrList &instr_list, std::string_view fs) override;
+  void Encode(output::IrEncoder &encoder) const override;
 };
 
 /**
@@ -265,6 +291,7 @@ public:
   void Print(FILE *out, int d) const override;
   Stm *Canon() override;
   void Munch(assem::InstrList &instr_list, std::string_view fs) override;
+  void Encode(output::IrEncoder &encoder) const override;
 };
 
 /**
@@ -288,6 +315,7 @@ public:
   void Print(FILE *out, int d) const override;
   Stm *Canon() override;
   void Munch(assem::InstrList &instr_list, std::string_view fs) override;
+  void Encode(output::IrEncoder &encoder) const override;
 };
 
 /**
@@ -306,6 +334,7 @@ public:
   void Print(FILE *out, int d) const override;
   Stm *Canon() override;
   void Munch(assem::InstrList &instr_list, std::string_view fs) override;
+  void Encode(output::IrEncoder &encoder) const override;
 };
 
 // ═══════════════════════════════════════════════════════════════════════════
@@ -320,14 +349,20 @@ public:
  *   - Print()  – pretty-print for debugging
  *   - Canon()  – canonicalize; returns a StmAndExp pair {side-effects, value}
  *   - Munch()  – emit x64 instructions and return the result TEMP
+ *   - Encode() – write the expression to a function cache key
  */
 class Exp {
 public:
+  Exp() {
+    if (util::FunctionStats *stats = util::FunctionStats::Current())
+      ++stats->ir_nodes_;
+  }
   virtual ~Exp() = default;
 
   virtual void Print(FILE *out, int d) const = 0;
   virtual canon::StmAndExp Canon() = 0;
   virtual temp::Temp *Munch(assem::InstrList &instr_list, std::string_view fs) = 0;
+  virtual void Encode(output::IrEncoder &encoder) const = 0;
 };
 
 /**
@@ -348,6 +383,7 @@ public:
   void Print(FILE *out, int d) const override;
   canon::StmAndExp Canon() override;
   temp::Temp *Munch(assem::InstrList &instr_list, std::string_view fs) override;
+  void Encode(output::IrEncoder &encoder) const override;
 };
 
 /**
@@ -367,6 +403,7 @@ public:
   void Print(FILE *out, int d) const override;
   canon::StmAndExp Canon() override;
   temp::Temp *Munch(assem::InstrList &instr_list, std::string_view fs) override;
+  void Encode(output::IrEncoder &encoder) const override;
 };
 
 /**
@@ -386,6 +423,7 @@ public:
   void Print(FILE *out, int d) const override;
   canon::StmAndExp Canon() override;
   temp::Temp *Munch(assem::InstrList &instr_list, std::string_view fs) override;
+  void Encode(output::IrEncoder &encoder) const override;
 };
 
 /**
@@ -409,6 +447,7 @@ public:
   void Print(FILE *out, int d) const override;
   canon::StmAndExp Canon() override;
   temp::Temp *Munch(assem::InstrList &instr_list, std::string_view fs) override;
+  void Encode(output::IrEncoder &encoder) const override;
 };
 
 /**
@@ -427,6 +466,7 @@ public:
   void Print(FILE *out, int d) const override;
   canon::StmAndExp Canon() override;
   temp::Temp *Munch(assem::InstrList &instr_list, std::string_view fs) override;
+  void Encode(output::IrEncoder &encoder) const override;
 };
 
 /**
@@ -445,6 +485,7 @@ public:
   void Print(FILE *out, int d) const override;
   canon::StmAndExp Canon() override;
   temp::Temp *Munch(assem::InstrList &instr_list, std::string_view fs) override;
+  void Encode(output::IrEncoder &encoder) const override;
 };
 
 /**
@@ -471,6 +512,7 @@ public:
   void Print(FILE *out, int d) const override;
   canon::StmAndExp Canon() override;
   temp::Temp *Munch(assem::InstrList &instr_list, std::string_view fs) override;
+  void Encode(output::IrEncoder &encoder) const override;
 };
 
 // ═══════════════════════════════════════════════════════════════════════════
@@ -0,0 +1,393 @@
+/**
+ * @file alloc_profile.h
+ * @brief Where the compiler's memory goes, by phase and by type
+ *
+ * An opt-in account of every allocation the compiler makes.  Heap
+ * allocations are seen by a replacement global operator new and delete
+ * (src/tiger/main/alloc_hooks.cc), which only the executables that offer
+ * --alloc-profile link; objects carved from a util::Arena are recorded by
+ * the arena itself, and its chunks as heap allocations of their own.  Until
+ * Enable() is called, nothing is recorded and each hook costs the test of
+ * a flag.
+ *
+ * Each allocation is charged to the phase of the pipeline it happens in,
+ * taken from the innermost util::PassTimer::Scope of the thread, so a
+ * timer must be current for allocations to be told apart (see
+ * frame::Compilation).  Allocations made through util::New<T>() and those
+ * of the classes deriving from AllocTracked<T>, which the code allocates
+ * with plain new, are also charged to the type T, and the storage of the
+ * containers that use TrackedAllocator<T, Owner> (list cells, set nodes,
+ * vector arrays) to their owner type.  Anything else the heap hands out
+ * is untyped.
+ *
+ * The counters are atomics in static storage, so the hooks never allocate
+ * and are safe on every thread and before main().
+ */
+
+#ifndef TIGER_UTIL_ALLOC_PROFILE_H_
+#define TIGER_UTIL_ALLOC_PROFILE_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#endif
+
+#if defined(__GNUG__)
+#include <cxxabi.h>
+#endif
+
+#include "tiger/util/pass_timer.h"
+
+namespace util {
+
+/**
+ * @brief Counts allocations by phase and type, from any number of threads
+ */
+class AllocProfile {
+public:
+  /// Phases allocations are charged to
+  enum Phase {
+    PARSE, SEMANT, ESCAPE, TRANSLATE, CANON, CODEGEN, LIVENESS, REGALLOC,
+    EMIT, BACK_END, OTHER, PHASE_COUNT
+  };
+
+  /// Types that are not C++ types
+  enum : int {
+    UNTYPED = 0,       ///< Heap allocations of no particular type
+    ARENA_CHUNKS = 1,  ///< Chunks of util::Arena
+  };
+
+  AllocProfile() = delete;
+
+  /** @brief Start recording; the executable must link the hooks */
+  static void Enable() { enabled_.store(true, std::memory_order_relaxed); }
+  static bool Enabled() { return enabled_.load(std::memory_order_relaxed); }
+
+  /** @brief The slot of the counters of type T */
+  template <typename T> static int TypeOf() {
+    static const int slot = Register(typeid(T));
+    return slot;
+  }
+
+  /**
+   * @brief Charges the next heap allocation of the thread, made while in
+   *        scope, to a type
+   *
+   * The next allocation is the object itself: operator new is called
+   * before the constructor, whose own allocations stay untyped.  Scopes
+   * may nest around one allocation; the outermost type wins.
+   */
+  class TypeScope {
+  public:
+    explicit TypeScope(int type) {
+      if (pending_ < 0)
+        pending_ = type;
+    }
+    TypeScope(const TypeScope &) = delete;
+    TypeScope &operator=(const TypeScope &) = delete;
+    ~TypeScope() { pending_ = -1; }
+  };
+
+  /** @brief Bytes the allocator really reserved for @p p, if it can tell */
+  static size_t UsableSize(void *p) {
+#if defined(__GLIBC__)
+    return malloc_usable_size(p);
+#elif defined(__APPLE__)
+    return malloc_size(p);
+#else
+    (void)p;
+    return 0;
+#endif
+  }
+
+  /** @brief Record a heap allocation of @p size bytes at @p p */
+  static void RecordNew(void *p, size_t size) {
+    int type = pending_ < 0 ? UNTYPED : pending_;
+    pending_ = -1;
+    RecordHeap(type, size, UsableSize(p));
+  }
+
+  /** @brief Record that an arena took a chunk of @p size bytes at @p p */
+  static void RecordChunk(void *p, size_t size) {
+    RecordHeap(ARENA_CHUNKS, size, UsableSize(p));
+  }
+
+  /** @brief Record the release of the heap block at @p p */
+  static void RecordDelete(void *p) {
+    frees_.fetch_add(1, std::memory_order_relaxed);
+    live_.fetch_sub(static_cast<long long>(UsableSize(p)),
+                    std::memory_order_relaxed);
+  }
+
+  /** @brief Record an object of @p size bytes carved from an arena */
+  static void RecordArena(int type, size_t size) {
+    Phase phase = CurrentPhase();
+    Add(&arena_[phase], size);
+    Add(&types_[type].arena_[phase], size);
+  }
+
+  /**
+   * @brief Stop recording and print the allocations of each phase and the
+   *        @p top types with the most bytes to @p out
+   */
+  static void Print(FILE *out, size_t top = 20) {
+    enabled_.store(false, std::memory_order_relaxed);
+
+    Counter total_heap, total_arena;
+    fprintf(out, "%-16s %12s %12s %12s %12s\n", "phase", "heap allocs",
+            "heap MiB", "arena objs", "arena MiB");
+    for (int phase = 0; phase < PHASE_COUNT; ++phase) {
+      if (heap_[phase].count_ == 0 && arena_[phase].count_ == 0)
+        continue;
+      PrintRow(out, PHASE_NAMES[phase], heap_[phase], arena_[phase]);
+      Add(&total_heap, heap_[phase]);
+      Add(&total_arena, arena_[phase]);
+    }
+    PrintRow(out, "total", total_heap, total_arena);
+    fprintf(out,
+            "heap blocks freed: %lld; peak live heap: %.1f MiB; live at "
+            "exit: %.1f MiB\n",
+            frees_.load(), Mib(peak_.load()),
+            Mib(std::max(0LL, live_.load())));
+
+    // Types by bytes, heap and arena together
+    struct Row {
+      std::string name_;
+      long long count_ = 0;
+      long long bytes_ = 0;
+      long long arena_bytes_ = 0;
+      int phase_ = OTHER;               ///< Where most of its bytes went
+    };
+    std::vector<Row> rows;
+    int types = std::min(type_count_.load(), MAX_TYPES);
+    for (int type = 0; type < types; ++type) {
+      const TypeCounters &counters = types_[type];
+      Row row;
+      long long most = -1;
+      for (int phase = 0; phase < PHASE_COUNT; ++phase) {
+        long long bytes =
+            counters.heap_[phase].bytes_ + counters.arena_[phase].bytes_;
+        row.count_ +=
+            counters.heap_[phase].count_ + counters.arena_[phase].count_;
+        row.bytes_ += bytes;
+        row.arena_bytes_ += counters.arena_[phase].bytes_;
+        if (bytes > most) {
+          most = bytes;
+          row.phase_ = phase;
+        }
+      }
+      if (row.count_ == 0)
+        continue;
+      row.name_ = TypeName(type);
+      rows.push_back(std::move(row));
+    }
+    std::sort(rows.begin(), rows.end(),
+              [](const Row &a, const Row &b) { return a.bytes_ > b.bytes_; });
+    if (rows.size() > top)
+      rows.resize(top);
+
+    fprintf(out, "\n%-40s %12s %10s %8s  %s\n", "type", "allocs", "MiB",
+            "arena", "mostly in");
+    for (const Row &row : rows)
+      fprintf(out, "%-40s %12lld %10.1f %7.0f%%  %s\n", row.name_.c_str(),
+              row.count_, Mib(row.bytes_),
+              row.bytes_ ? 100.0 * row.arena_bytes_ / row.bytes_ : 0,
+              PHASE_NAMES[row.phase_]);
+  }
+
+private:
+  static constexpr int MAX_TYPES = 256;
+  static constexpr const char *PHASE_NAMES[PHASE_COUNT] = {
+      "parse",    "semant",   "escape", "translate", "canon",         "codegen",
+      "liveness", "regalloc", "emit",   "back end",  "outside passes"};
+
+  /// Pass names of util::PassTimer::Scope and the phase of each
+  struct PassPhase {
+    const char *pass_;
+    Phase phase_;
+  };
+  static constexpr PassPhase PASS_PHASES[] = {
+      {"parse", PARSE},          {"semant", SEMANT},
+      {"escape", ESCAPE},        {"translate", TRANSLATE},
+      {"linearize", CANON},      {"basic blocks", CANON},
+      {"trace schedule", CANON}, {"codegen", CODEGEN},
+      {"liveness", LIVENESS},    {"interference", LIVENESS},
+      {"coloring", REGALLOC},    {"spill rewrite", REGALLOC},
+      {"emission", EMIT},
+  };
+
+  /// A number of allocations and their bytes
+  struct Counter {
+    std::atomic<long long> count_{0};
+    std::atomic<long long> bytes_{0};
+  };
+
+  struct TypeCounters {
+    const std::type_info *type_ = nullptr;
+    Counter heap_[PHASE_COUNT];
+    Counter arena_[PHASE_COUNT];
+  };
+
+  // Defined after the class, which the initializers of Counter need complete
+  static std::atomic<bool> enabled_;
+  static Counter heap_[PHASE_COUNT];
+  static Counter arena_[PHASE_COUNT];
+  static TypeCounters types_[MAX_TYPES];
+  static std::atomic<int> type_count_;  ///< Past UNTYPED and ARENA_CHUNKS
+  static std::mutex register_mutex_;
+  static std::atomic<long long> live_;  ///< Usable bytes
+  static std::atomic<long long> peak_;
+  static std::atomic<long long> frees_;
+  static thread_local int pending_;     ///< Type of the next allocation
+
+  static void Add(Counter *counter, size_t bytes) {
+    counter->count_.fetch_add(1, std::memory_order_relaxed);
+    counter->bytes_.fetch_add(static_cast<long long>(bytes),
+                              std::memory_order_relaxed);
+  }
+
+  static void Add(Counter *sum, const Counter &counter) {
+    sum->count_ += counter.count_.load();
+    sum->bytes_ += counter.bytes_.load();
+  }
+
+  static void RecordHeap(int type, size_t size, size_t usable) {
+    Phase phase = CurrentPhase();
+    Add(&heap_[phase], size);
+    Add(&types_[type].heap_[phase], size);
+    long long live = live_.fetch_add(static_cast<long long>(usable),
+                                     std::memory_order_relaxed) +
+                     static_cast<long long>(usable);
+    long long peak = peak_.load(std::memory_order_relaxed);
+    while (live > peak &&
+           !peak_.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+      ;
+  }
+
+  static Phase CurrentPhase() {
+    // Pass names are string literals, so the last one found is remembered
+    static thread_local const char *last_pass = nullptr;
+    static thread_local Phase last_phase = OTHER;
+    const char *pass = PassTimer::CurrentPass();
+    if (pass == last_pass)
+      return last_phase;
+    Phase phase = pass ? BACK_END : OTHER;
+    for (const PassPhase &entry : PASS_PHASES)
+      if (pass && std::strcmp(pass, entry.pass_) == 0)
+        phase = entry.phase_;
+    last_pass = pass;
+    last_phase = phase;
+    return phase;
+  }
+
+  static int Register(const std::type_info &type) {
+    std::lock_guard<std::mutex> lock(register_mutex_);
+    int count = type_count_.load();
+    for (int slot = 2; slot < count; ++slot)
+      if (*types_[slot].type_ == type)
+        return slot;
+    if (count == MAX_TYPES)
+      return UNTYPED;
+    types_[count].type_ = &type;
+    type_count_.store(count + 1);
+    return count;
+  }
+
+  static std::string TypeName(int type) {
+    if (type == UNTYPED)
+      return "(untyped)";
+    if (type == ARENA_CHUNKS)
+      return "(arena chunks)";
+    const char *name = types_[type].type_->name();
+#if defined(__GNUG__)
+    int status = 0;
+    char *demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+    if (status == 0 && demangled) {
+      std::string result(demangled);
+      std::free(demangled);
+      return result;
+    }
+#endif
+    return name;
+  }
+
+  static double Mib(long long bytes) { return bytes / (1024.0 * 1024.0); }
+
+  static void PrintRow(FILE *out, const char *name, const Counter &heap,
+                       const Counter &arena) {
+    fprintf(out, "%-16s %12lld %12.1f %12lld %12.1f\n", name,
+            heap.count_.load(), Mib(heap.bytes_), arena.count_.load(),
+            Mib(arena.bytes_));
+  }
+};
+
+inline std::atomic<bool> AllocProfile::enabled_{false};
+inline AllocProfile::Counter AllocProfile::heap_[AllocProfile::PHASE_COUNT];
+inline AllocProfile::Counter AllocProfile::arena_[AllocProfile::PHASE_COUNT];
+inline AllocProfile::TypeCounters AllocProfile::types_[AllocProfile::MAX_TYPES];
+inline std::atomic<int> AllocProfile::type_count_{2};
+inline std::mutex AllocProfile::register_mutex_;
+inline std::atomic<long long> AllocProfile::live_{0};
+inline std::atomic<long long> AllocProfile::peak_{0};
+inline std::atomic<long long> AllocProfile::frees_{0};
+inline thread_local int AllocProfile::pending_ = -1;
+
+/**
+ * @brief Base of the classes the code allocates with plain new, which
+ *        charges their allocations (and those of their subclasses) to T
+ */
+template <typename T> struct AllocTracked {
+  static void *operator new(size_t size) {
+    if (!AllocProfile::Enabled())
+      return ::operator new(size);
+    AllocProfile::TypeScope scope(AllocProfile::TypeOf<T>());
+    return ::operator new(size);
+  }
+  static void operator delete(void *p) noexcept { ::operator delete(p); }
+};
+
+/**
+ * @brief Allocator of the containers whose storage is charged to Owner,
+ *        the class that holds them or whose work they do
+ *
+ * Behaves as std::allocator<T> otherwise; all instances are equal.
+ */
+template <typename T, typename Owner> struct TrackedAllocator {
+  using value_type = T;
+
+  TrackedAllocator() = default;
+  template <typename U>
+  TrackedAllocator(const TrackedAllocator<U, Owner> &) noexcept {}
+
+  T *allocate(size_t n) {
+    if (!AllocProfile::Enabled())
+      return static_cast<T *>(::operator new(n * sizeof(T)));
+    AllocProfile::TypeScope scope(AllocProfile::TypeOf<Owner>());
+    return static_cast<T *>(::operator new(n * sizeof(T)));
+  }
+  void deallocate(T *p, size_t) noexcept { ::operator delete(p); }
+
+  template <typename U>
+  bool operator==(const TrackedAllocator<U, Owner> &) const noexcept {
+    return true;
+  }
+  template <typename U>
+  bool operator!=(const TrackedAllocator<U, Owner> &) const noexcept {
+    return false;
+  }
+};
+
+} // namespace util
+
+#endif // TIGER_UTIL_ALLOC_PROFILE_H_
@@ -0,0 +1,198 @@
+/**
+ * @file arena.h
+ * @brief Bump-pointer arena for per-function backend objects
+ *
+ * The IR trees, canonical trees and abstract assembly of a function are
+ * built once, read by the next phase and then dropped wholesale.  Instead of
+ * giving each node its own heap block, they are carved out of large chunks
+ * owned by the function's frame::ProcFrag and released together when its
+ * assembly has been written (see frame::ProcFrag::OutputAssem()).
+ *
+ * ─────────────────────────────────────────────────────────────────────────
+ * Allocation
+ * ─────────────────────────────────────────────────────────────────────────
+ * Allocate() bumps a pointer through the current chunk and starts a new
+ * CHUNK_SIZE chunk when it runs out; requests larger than a quarter chunk
+ * get a dedicated chunk so they do not waste the tail of the current one.
+ * New<T>() constructs an object in place and, unless T is trivially
+ * destructible, records its destructor so that Release() can run it (in
+ * reverse order of construction) before the chunks are freed.
+ *
+ * ─────────────────────────────────────────────────────────────────────────
+ * The current arena
+ * ─────────────────────────────────────────────────────────────────────────
+ * The phases create nodes far from the code that owns the arena, so the
+ * arena in use is carried implicitly: an Arena::Scope installs an arena as
+ * the current one for the running thread and restores the previous one on
+ * exit.  util::New<T>() allocates from the current arena, or from the heap
+ * when there is none, which keeps code outside any scope (tests, tools)
+ * working unchanged.  Objects obtained from util::New() must never be
+ * deleted individually.
+ *
+ * With util::AllocProfile enabled, both paths charge the object to T.
+ */
+
+#ifndef TIGER_UTIL_ARENA_H_
+#define TIGER_UTIL_ARENA_H_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <initializer_list>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "tiger/util/alloc_profile.h"
+
+namespace util {
+
+/**
+ * @brief A region of memory from which objects are allocated by bumping a
+ *        pointer and freed all at once
+ */
+class Arena {
+public:
+  static constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+  Arena() = default;
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+  ~Arena() { Release(); }
+
+  /** @brief Allocate @p size bytes aligned to @p align (a power of two) */
+  void *Allocate(size_t size, size_t align = alignof(std::max_align_t)) {
+    assert(align != 0 && (align & (align - 1)) == 0);
+    uintptr_t p = (reinterpret_cast<uintptr_t>(cur_) + align - 1) & ~(align - 1);
+    if (cur_ == nullptr || p + size > reinterpret_cast<uintptr_t>(end_))
+      return AllocateSlow(size, align);
+    cur_ = reinterpret_cast<char *>(p + size);
+    bytes_ += size;
+    return reinterpret_cast<void *>(p);
+  }
+
+  /** @brief Construct a T in the arena; it lives until Release() */
+  template <typename T, typename... Args> T *New(Args &&...args) {
+    void *mem = Allocate(sizeof(T), alignof(T));
+    if (AllocProfile::Enabled())
+      AllocProfile::RecordArena(AllocProfile::TypeOf<T>(), sizeof(T));
+    T *obj = ::new (mem) T(std::forward<Args>(args)...);
+    if constexpr (!std::is_trivially_destructible_v<T>)
+      dtors_.push_back({obj, [](void *p) { static_cast<T *>(p)->~T(); }});
+    return obj;
+  }
+
+  /** @brief Destroy every object and free all chunks; the arena stays usable */
+  void Release() {
+    for (auto it = dtors_.rbegin(); it != dtors_.rend(); ++it)
+      it->destroy_(it->obj_);
+    // Give back the bookkeeping too: a released arena may be kept around
+    decltype(dtors_)().swap(dtors_);
+    bool profiled = AllocProfile::Enabled();
+    for (char *chunk : chunks_) {
+      if (profiled)
+        AllocProfile::RecordDelete(chunk);
+      std::free(chunk);
+    }
+    std::vector<char *>().swap(chunks_);
+    cur_ = end_ = nullptr;
+    bytes_ = 0;
+  }
+
+  /** @brief Bytes handed out since construction or the last Release() */
+  [[nodiscard]] size_t BytesAllocated() const { return bytes_; }
+
+  /** @brief The arena installed for the running thread, if any */
+  static Arena *Current() { return current_; }
+
+  /**
+   * @brief Makes an arena current for the lifetime of the scope
+   *
+   * Scopes nest; the previously current arena is restored on exit.
+   */
+  class Scope {
+  public:
+    explicit Scope(Arena *arena) : saved_(current_) { current_ = arena; }
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+    ~Scope() { current_ = saved_; }
+
+  private:
+    Arena *saved_;
+  };
+
+private:
+  /// A constructed object whose destructor Release() has to run
+  struct Dtor {
+    void *obj_;
+    void (*destroy_)(void *);
+  };
+
+  std::vector<char *> chunks_;  ///< Every chunk, in allocation order
+  /// Non-trivial objects, in construction order
+  std::vector<Dtor, TrackedAllocator<Dtor, Arena>> dtors_;
+  char *cur_ = nullptr;         ///< Next free byte in the current chunk
+  char *end_ = nullptr;         ///< One past the end of the current chunk
+  size_t bytes_ = 0;            ///< Bytes handed out
+
+  static inline thread_local Arena *current_ = nullptr;
+
+  void *AllocateSlow(size_t size, size_t align) {
+    size_t need = size + align - 1;
+    char *chunk;
+    if (need > CHUNK_SIZE / 4) {
+      // Dedicated chunk; keep bumping through the current one afterwards
+      chunk = static_cast<char *>(std::malloc(need));
+      if (chunk == nullptr)
+        throw std::bad_alloc();
+      if (AllocProfile::Enabled())
+        AllocProfile::RecordChunk(chunk, need);
+      chunks_.push_back(chunk);
+    } else {
+      chunk = static_cast<char *>(std::malloc(CHUNK_SIZE));
+      if (chunk == nullptr)
+        throw std::bad_alloc();
+      if (AllocProfile::Enabled())
+        AllocProfile::RecordChunk(chunk, CHUNK_SIZE);
+      chunks_.push_back(chunk);
+      cur_ = chunk;
+      end_ = chunk + CHUNK_SIZE;
+    }
+    uintptr_t p = (reinterpret_cast<uintptr_t>(chunk) + align - 1) & ~(align - 1);
+    if (chunk == cur_)
+      cur_ = reinterpret_cast<char *>(p + size);
+    bytes_ += size;
+    return reinterpret_cast<void *>(p);
+  }
+};
+
+/**
+ * @brief Construct a T in the current arena, or on the heap outside any
+ *        Arena::Scope
+ */
+template <typename T, typename... Args> T *New(Args &&...args) {
+  if (Arena *arena = Arena::Current())
+    return arena->New<T>(std::forward<Args>(args)...);
+  if (AllocProfile::Enabled()) {
+    AllocProfile::TypeScope tag(AllocProfile::TypeOf<T>());
+    return new T(std::forward<Args>(args)...);
+  }
+  return new T(std::forward<Args>(args)...);
+}
+
+/** @brief util::New() for types built from a braced list, e.g. TempList */
+template <typename T, typename E> T *New(std::initializer_list<E> list) {
+  if (Arena *arena = Arena::Current())
+    return arena->New<T>(list);
+  if (AllocProfile::Enabled()) {
+    AllocProfile::TypeScope tag(AllocProfile::TypeOf<T>());
+    return new T(list);
+  }
+  return new T(list);
+}
+
+} // namespace util
+
+#endif // TIGER_UTIL_ARENA_H_
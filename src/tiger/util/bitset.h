@@ -0,0 +1,176 @@
+/**
+ * @file bitset.h
+ * @brief Packed, dynamically sized bit set for dataflow analysis
+ *
+ * Provides a dense bit set over the indices [0, size) stored as an array of
+ * 64-bit words.  All set operations (union, difference, comparison) work one
+ * machine word at a time, so a set over N elements costs N/64 word
+ * operations instead of the O(N^2) list scans done by temp::TempList.
+ *
+ * Used by liveness analysis, where every temporary of a function is given a
+ * dense index and live-in/live-out sets are stored as BitSets, and by the
+ * interference graph as the backing store of its adjacency bit matrix.
+ */
+
+#ifndef TIGER_UTIL_BITSET_H_
+#define TIGER_UTIL_BITSET_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+namespace util {
+
+/**
+ * @brief A fixed-universe set of small integers packed into 64-bit words
+ *
+ * The universe size is chosen at construction (or by Resize()) and all
+ * binary operations require both operands to share it.
+ */
+class BitSet {
+public:
+  using Word = uint64_t;
+  static constexpr int WORD_BITS = 64;
+
+  BitSet() : size_(0) {}
+  explicit BitSet(int size) : size_(size), words_(WordCount(size), 0) {}
+
+  /** @brief Number of elements in the universe (not the population count) */
+  [[nodiscard]] int Size() const { return size_; }
+
+  /** @brief Change the universe size, clearing all bits */
+  void Resize(int size) {
+    size_ = size;
+    words_.assign(WordCount(size), 0);
+  }
+
+  /** @brief Enlarge the universe to @p size, keeping the current elements */
+  void Grow(int size) {
+    assert(size >= size_);
+    size_ = size;
+    words_.resize(WordCount(size), 0);
+  }
+
+  /** @brief Remove every element */
+  void Clear() { std::fill(words_.begin(), words_.end(), 0); }
+
+  /** @brief Add every element of the universe */
+  void SetAll() {
+    std::fill(words_.begin(), words_.end(), ~Word(0));
+    if (size_ % WORD_BITS)
+      words_.back() &= (Word(1) << (size_ % WORD_BITS)) - 1;
+  }
+
+  /** @brief Add element @p i */
+  void Set(int i) {
+    assert(i >= 0 && i < size_);
+    words_[i / WORD_BITS] |= Word(1) << (i % WORD_BITS);
+  }
+
+  /** @brief Remove element @p i */
+  void Reset(int i) {
+    assert(i >= 0 && i < size_);
+    words_[i / WORD_BITS] &= ~(Word(1) << (i % WORD_BITS));
+  }
+
+  /** @brief Test whether element @p i is present */
+  [[nodiscard]] bool Test(int i) const {
+    assert(i >= 0 && i < size_);
+    return (words_[i / WORD_BITS] >> (i % WORD_BITS)) & 1;
+  }
+
+  /** @brief Test whether the set has no elements */
+  [[nodiscard]] bool Empty() const {
+    for (Word w : words_)
+      if (w)
+        return false;
+    return true;
+  }
+
+  /** @brief Number of elements in the set */
+  [[nodiscard]] int Count() const {
+    int n = 0;
+    for (Word w : words_)
+      n += __builtin_popcountll(w);
+    return n;
+  }
+
+  /**
+   * @brief this = this ∪ other
+   * @return true if any bit changed
+   */
+  bool UnionWith(const BitSet &other) {
+    assert(size_ == other.size_);
+    Word changed = 0;
+    for (std::size_t i = 0; i < words_.size(); ++i) {
+      Word w = words_[i] | other.words_[i];
+      changed |= w ^ words_[i];
+      words_[i] = w;
+    }
+    return changed != 0;
+  }
+
+  /** @brief this = this \ other */
+  void DiffWith(const BitSet &other) {
+    assert(size_ == other.size_);
+    for (std::size_t i = 0; i < words_.size(); ++i)
+      words_[i] &= ~other.words_[i];
+  }
+
+  /** @brief this = this ∩ other */
+  void IntersectWith(const BitSet &other) {
+    assert(size_ == other.size_);
+    for (std::size_t i = 0; i < words_.size(); ++i)
+      words_[i] &= other.words_[i];
+  }
+
+  /**
+   * @brief this = use ∪ (out \ def), the liveness transfer function
+   * @return true if any bit changed
+   */
+  bool AssignTransfer(const BitSet &use, const BitSet &out,
+                      const BitSet &def) {
+    assert(size_ == use.size_ && size_ == out.size_ && size_ == def.size_);
+    Word changed = 0;
+    for (std::size_t i = 0; i < words_.size(); ++i) {
+      Word w = use.words_[i] | (out.words_[i] & ~def.words_[i]);
+      changed |= w ^ words_[i];
+      words_[i] = w;
+    }
+    return changed != 0;
+  }
+
+  bool operator==(const BitSet &other) const {
+    return size_ == other.size_ && words_ == other.words_;
+  }
+  bool operator!=(const BitSet &other) const { return !(*this == other); }
+
+  /**
+   * @brief Call @p f(i) for every element i in increasing order
+   *
+   * Skips empty words entirely, so iteration costs O(size/64 + count).
+   */
+  template <typename Fn> void ForEach(Fn f) const {
+    for (std::size_t i = 0; i < words_.size(); ++i) {
+      Word w = words_[i];
+      while (w) {
+        int bit = __builtin_ctzll(w);
+        f(static_cast<int>(i) * WORD_BITS + bit);
+        w &= w - 1;
+      }
+    }
+  }
+
+private:
+  static std::size_t WordCount(int size) {
+    return (static_cast<std::size_t>(size) + WORD_BITS - 1) / WORD_BITS;
+  }
+
+  int size_;                 ///< Universe size
+  std::vector<Word> words_;  ///< Packed bits, element i in words_[i / 64]
+};
+
+} // namespace util
+
+#endif // TIGER_UTIL_BITSET_H_
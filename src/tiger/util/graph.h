@@ -11,18 +11,27 @@
  * - Adjacency queries
  * - Degree computation
  * - Specialized interference graph (IGraph) for register allocation
+ *
+ * Node lists computed on demand (Adj(), Union(), Diff(), IGraph::AdjList())
+ * are made with util::New(), so during register allocation they live in
+ * the function's arena and go away with it.
  */
 
 #ifndef TIGER_UTIL_GRAPH_H_
 #define TIGER_UTIL_GRAPH_H_
 
+#include "tiger/util/arena.h"
+#include "tiger/util/bitset.h"
 #include "tiger/util/table.h"
 #include "tiger/frame/temp.h"
 
+#include <cstdint>
 #include <set>
 #include <unordered_map>
+#include <unordered_set>
 #include <iostream>
 #include <list>
+#include <vector>
 
 namespace graph {
 
@@ -57,6 +66,11 @@ public:
   static void Show(FILE *out, NodeList<T> *p,
                    std::function<void(T *)> show_info);
 
+  // Get all the neighbours of node "n", ignoring edge direction
+  virtual NodeList<T> *AdjList(Node<T> *n) {
+    return n->succs_->Union(n->preds_);
+  }
+
   virtual void SetDegree(Node<temp::Temp> *n, int d) {}
   virtual int GetDegree(Node<T> *n) { return n->Degree(); }
   virtual void AddOneDegree(Node<T> *n) {}
@@ -78,20 +92,47 @@ protected:
  * - Edges represent interference (two temporaries can't share a register)
  * - Precolored nodes represent machine registers
  * - Degree tracking is optimized for graph coloring algorithms
+ *
+ * Following Appel, interference is kept in two forms:
+ * - An adjacency set answering IAdj() in O(1).  While the graph has at most
+ *   DENSE_LIMIT nodes it is a lower-triangular bit matrix indexed by node
+ *   key (a new node only appends a row, so nodes can still be added after
+ *   edges); beyond that it switches to a hash set of edges so memory stays
+ *   proportional to the number of edges.
+ * - Per-node adjacency vectors (Neighbors()) for non-precolored nodes only;
+ *   machine registers interfere with almost everything and their
+ *   neighbours are never enumerated.
+ *
+ * The register allocator adds edges while coalescing.  Edges added after
+ * Checkpoint() are logged and Rollback() removes them again, so the graph
+ * built by liveness can be reused for the next allocation round.
  */
 class IGraph : public Graph<temp::Temp> {
 public:
+  /// Largest node count for which the adjacency bit matrix is used
+  /// (8192 nodes ≈ 4 MB of bits)
+  static constexpr int DENSE_LIMIT = 8192;
+
   /**
    * @param precolored List of precolored temporaries (machine registers)
    */
   IGraph(temp::TempList *precolored) 
-    : Graph<temp::Temp>(), precolored_(precolored) {}
+    : Graph<temp::Temp>(), precolored_(precolored), dense_(true) {}
 
   bool IAdj(Node<temp::Temp> *n, Node<temp::Temp> *m);
 
   Node<temp::Temp> *NewNode(temp::Temp *info) override;
   void AddEdge(Node<temp::Temp> *from, Node<temp::Temp> *to) override;
 
+  /// The arrays are charged to IGraph in an allocation profile
+  template <typename E>
+  using Vector = std::vector<E, util::TrackedAllocator<E, IGraph>>;
+
+  /** @brief All interference neighbours of non-precolored node @p n */
+  const Vector<Node<temp::Temp> *> &Neighbors(Node<temp::Temp> *n);
+
+  NodeList<temp::Temp> *AdjList(Node<temp::Temp> *n) override;
+
   void SetDegree(Node<temp::Temp> *n, int d) override;
   int GetDegree(Node<temp::Temp> *n) override;
   void AddOneDegree(Node<temp::Temp> *n) override;
@@ -99,13 +140,53 @@ public:
 
   void ClearEdge();
 
+  /** @brief Start logging added edges so Rollback() can undo them */
+  void Checkpoint();
+
+  /**
+   * @brief Remove every edge added since Checkpoint() and reset the degree
+   * of each non-precolored node to its number of neighbours
+   */
+  void Rollback();
+
+  /** @brief Remove every edge of non-precolored node @p n */
+  void Isolate(Node<temp::Temp> *n);
+
+  /** @brief Number of non-precolored nodes */
+  [[nodiscard]] int TempCount() const;
+
+  /** @brief Number of edges with a non-precolored end (counted, not kept) */
+  [[nodiscard]] long long EdgeCount() const;
+
 private:
   temp::TempList *precolored_;
-  std::set<std::pair<Node<temp::Temp>*, Node<temp::Temp>*>> adj_set_;
-  std::unordered_map<Node<temp::Temp>*, int> degree_;
+  std::vector<bool> is_precolored_;                          ///< Key → precolored?
+  Vector<Vector<Node<temp::Temp> *>> adj_list_;             ///< Key → neighbours
+  Vector<int> degree_;                                       ///< Key → degree
+  bool dense_;                          ///< Adjacency set is the bit matrix
+  util::BitSet adj_bits_;               ///< Lower-triangular adjacency matrix
+  std::unordered_set<uint64_t> adj_set_; ///< Sparse adjacency set
+  bool logging_ = false;                ///< Record added edges in edge_log_
+  Vector<std::pair<Node<temp::Temp> *, Node<temp::Temp> *>> edge_log_;  ///< Edges added since Checkpoint()
+
+  /// First bit of row @p i in the triangular matrix
+  static int64_t RowStart(int64_t i) { return i * (i - 1) / 2; }
+  /// Bit of the unordered pair {i, j}, i != j
+  static int64_t BitIndex(int i, int j) {
+    return i > j ? RowStart(i) + j : RowStart(j) + i;
+  }
+  /// Hash-set key of the unordered pair {i, j}
+  static uint64_t EdgeKey(int i, int j) {
+    return i > j ? (uint64_t(i) << 32) | uint32_t(j)
+                 : (uint64_t(j) << 32) | uint32_t(i);
+  }
+  /// Move every edge from the bit matrix to the hash set
+  void MakeSparse();
+  /// Remove {i, j} from the adjacency set
+  void EraseEdge(int i, int j);
 };
 
-template <typename T> class Node {
+template <typename T> class Node : public util::AllocTracked<Node<T>> {
   template <typename NodeType> friend class Graph;
   friend class IGraph;
 
@@ -165,7 +246,8 @@ private:
         info_(nullptr) {}
 };
 
-template <typename T> class NodeList {
+template <typename T>
+class NodeList : public util::AllocTracked<NodeList<T>> {
   friend class Graph<T>;
   friend class Node<T>;
   friend class IGraph;
@@ -191,12 +273,13 @@ public:
   NodeList<T> *Union(NodeList<T> *nl);
   NodeList<T> *Diff(NodeList<T> *nl);
 
-  [[nodiscard]] const std::list<Node<T> *> &GetList() const {
-    return node_list_;
-  }
+  /// The cells are charged to NodeList in an allocation profile
+  using List = std::list<Node<T> *, util::TrackedAllocator<Node<T> *, NodeList>>;
+
+  [[nodiscard]] const List &GetList() const { return node_list_; }
 
 private:
-  std::list<Node<T> *> node_list_{};
+  List node_list_{};
 };
 
 
@@ -258,7 +341,7 @@ template <typename T> void Node<T>::AddOneIDegree() { my_graph_->AddOneDegree(th
 template <typename T> void Node<T>::MinusOneIDegree() { my_graph_->MinusOneDegree(this); }
 
 template <typename T> NodeList<T> *Node<T>::Adj() {
-  NodeList<T> *adj_list = new NodeList<T>();
+  NodeList<T> *adj_list = util::New<NodeList<T>>();
   adj_list->CatList(succs_);
   adj_list->CatList(preds_);
   return adj_list;
@@ -269,7 +352,7 @@ template <typename T> NodeList<T> *Node<T>::Succ() { return succs_; }
 template <typename T> NodeList<T> *Node<T>::Pred() { return preds_; }
 
 template <typename T> NodeList<T> *Node<T>::AdjList() { 
-  return succs_->Union(preds_); 
+  return my_graph_->AdjList(this);
 }
 
 template <typename T> T *Node<T>::NodeInfo() { return info_; }
@@ -278,6 +361,11 @@ template <typename T> int Node<T>::Key() { return my_key_; }
 
 template <typename T> NodeList<T> *Graph<T>::Nodes() { return my_nodes_; }
 
+inline const IGraph::Vector<Node<temp::Temp> *> &
+IGraph::Neighbors(Node<temp::Temp> *n) {
+  return adj_list_[n->Key()];
+}
+
 template <typename T> bool NodeList<T>::Contain(Node<T> *n) {
   for (auto node : node_list_) {
     if (node == n)
@@ -306,7 +394,7 @@ template <typename T> void NodeList<T>::CatList(NodeList<T> *nl) {
 }
 
 template <typename T> NodeList<T> *NodeList<T>::Union(NodeList<T> *nl) {
-  NodeList<T> *res = new NodeList<T>();
+  NodeList<T> *res = util::New<NodeList<T>>();
   res->CatList(this);
   for (auto temp : nl->GetList()) {
     if (!res->Contain(temp))
@@ -316,7 +404,7 @@ template <typename T> NodeList<T> *NodeList<T>::Union(NodeList<T> *nl) {
 }
 
 template <typename T> NodeList<T> *NodeList<T>::Diff(NodeList<T> *nl) {
-  NodeList<T> *res = new NodeList<T>();
+  NodeList<T> *res = util::New<NodeList<T>>();
   for (auto node : node_list_) {
     if (!nl->Contain(node))
       res->node_list_.push_back(node);
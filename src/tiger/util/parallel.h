@@ -0,0 +1,176 @@
+/**
+ * @file parallel.h
+ * @brief Running independent pieces of work on several threads
+ *
+ * The back end compiles each function on its own, but the results have to
+ * be written out in fragment order.  An OrderedPool hands submitted pieces
+ * of work to a fixed set of worker threads and runs a commit step for each
+ * finished piece in submission order.  A piece is committed as soon as it
+ * and every piece before it are done, by whichever worker completed the
+ * last of them, so finished output does not pile up behind the whole run,
+ * only behind the slowest piece still in progress.
+ *
+ * Submit() blocks while too many pieces are uncommitted.  The producer can
+ * therefore run ahead of the workers only by a bounded amount, which bounds
+ * the memory held by pieces in flight.
+ */
+
+#ifndef TIGER_UTIL_PARALLEL_H_
+#define TIGER_UTIL_PARALLEL_H_
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace util {
+
+/**
+ * @brief Number of threads worth starting for @p jobs-way parallelism
+ *
+ * More threads than cores only adds switching between them.
+ */
+inline int UsableThreads(int jobs) {
+  int threads = std::max(jobs, 1);
+  if (unsigned cores = std::thread::hardware_concurrency())
+    threads = std::min(threads, static_cast<int>(cores));
+  return threads;
+}
+
+/**
+ * @brief A pool of threads that runs work in any order and commits it in
+ *        the order it was submitted
+ */
+class OrderedPool {
+public:
+  /**
+   * @param threads     Number of worker threads to start
+   * @param max_pending Most pieces submitted but not yet committed
+   */
+  OrderedPool(int threads, size_t max_pending)
+      : max_pending_(std::max<size_t>(max_pending, 1)) {
+    for (int t = 0; t < threads; ++t)
+      workers_.emplace_back([this] { Work(); });
+  }
+
+  OrderedPool(const OrderedPool &) = delete;
+  OrderedPool &operator=(const OrderedPool &) = delete;
+
+  ~OrderedPool() {
+    if (!workers_.empty())
+      Stop();
+  }
+
+  /**
+   * @brief Queue @p work to run on some worker, then @p commit once every
+   *        earlier piece has been committed
+   *
+   * Commits run one at a time, on worker threads.  After a piece has
+   * thrown, the remaining work and commits are skipped.
+   */
+  void Submit(std::function<void()> work, std::function<void()> commit) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    space_cv_.wait(lock, [this] { return tasks_.size() < max_pending_; });
+    tasks_.push_back({std::move(work), std::move(commit), false});
+    work_cv_.notify_one();
+  }
+
+  /**
+   * @brief Wait until everything submitted has been committed and stop the
+   *        workers; rethrows the first exception thrown by a piece
+   */
+  void Finish() {
+    Stop();
+    if (error_)
+      std::rethrow_exception(error_);
+  }
+
+private:
+  struct Task {
+    std::function<void()> work_;
+    std::function<void()> commit_;
+    bool done_;
+  };
+
+  size_t max_pending_;
+  std::vector<std::thread> workers_;
+
+  std::mutex mutex_;                  ///< Guards everything below
+  std::condition_variable work_cv_;   ///< Signalled on Submit() and Stop()
+  std::condition_variable space_cv_;  ///< Signalled when tasks_ shrinks
+  std::deque<Task> tasks_;            ///< Uncommitted pieces, oldest first
+  size_t first_ = 0;                  ///< Sequence number of tasks_.front()
+  size_t next_ = 0;                   ///< Sequence number of the next piece to start
+  bool committing_ = false;           ///< A worker is running commits
+  bool stopping_ = false;             ///< No more pieces will be submitted
+  std::exception_ptr error_;          ///< First exception thrown by a piece
+
+  void Stop() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+    }
+    work_cv_.notify_all();
+    for (std::thread &worker : workers_)
+      worker.join();
+    workers_.clear();
+  }
+
+  void Work() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+      work_cv_.wait(lock, [this] {
+        return next_ < first_ + tasks_.size() || stopping_;
+      });
+      if (next_ == first_ + tasks_.size())
+        return;
+
+      size_t seq = next_++;
+      std::function<void()> work = std::move(tasks_[seq - first_].work_);
+      lock.unlock();
+      Run(work);
+      lock.lock();
+      tasks_[seq - first_].done_ = true;
+      if (committing_)
+        continue;
+
+      // Commit every finished piece at the front, in order
+      committing_ = true;
+      while (!tasks_.empty() && tasks_.front().done_) {
+        std::function<void()> commit = std::move(tasks_.front().commit_);
+        tasks_.pop_front();
+        ++first_;
+        lock.unlock();
+        Run(commit);
+        space_cv_.notify_one();
+        lock.lock();
+      }
+      committing_ = false;
+    }
+  }
+
+  /// Run @p f unless an earlier piece failed; record its exception if any
+  void Run(const std::function<void()> &f) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (error_)
+        return;
+    }
+    try {
+      f();
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!error_)
+        error_ = std::current_exception();
+    }
+  }
+};
+
+} // namespace util
+
+#endif // TIGER_UTIL_PARALLEL_H_
@@ -0,0 +1,280 @@
+/**
+ * @file pass_timer.h
+ * @brief Time spent in each pass of the compiler
+ *
+ * A PassTimer records one Event for every PassTimer::Scope that ends on a
+ * thread where it is current (see frame::Compilation, which makes the
+ * timer of a compilation current along with the rest of it).  Where no
+ * timer is current, a Scope does nothing but test a thread-local pointer,
+ * so the passes can be instrumented unconditionally.
+ *
+ * Scopes nest.  An event has the wall time of its scope, start to end, and
+ * its self time, which excludes the scopes nested in it on the same
+ * thread; the self times of all events add up to the time spent in scopes
+ * without counting any of it twice.  A scope that names no function or
+ * file takes the one of the scope it is nested in.
+ *
+ * Besides wall time a timer can count, per scope and excluding nested
+ * ones, the CPU cycles and instructions retired by the thread, read from
+ * the hardware counters through perf_event.  Where those cannot be opened
+ * (another OS, a container, perf_event_paranoid) it falls back to the CPU
+ * time of the thread from getrusage().
+ */
+
+#ifndef TIGER_UTIL_PASS_TIMER_H_
+#define TIGER_UTIL_PASS_TIMER_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+namespace util {
+
+/**
+ * @brief Collects the time spent in passes, from any number of threads
+ */
+class PassTimer {
+public:
+  /// What a timer counts besides wall time
+  enum class Counters {
+    NONE,      ///< Wall time only
+    HARDWARE,  ///< CPU cycles and instructions retired
+    RUSAGE,    ///< CPU time of the thread
+  };
+
+  /// One scope that ended
+  struct Event {
+    const char *pass_;                  ///< Name of the pass
+    std::string detail_;                ///< Function or file, if any
+    int thread_;                        ///< Threads numbered from 0 in order of appearance
+    long long start_ns_;                ///< Since the timer was made
+    long long wall_ns_;                 ///< Start to end
+    long long self_ns_;                 ///< Excluding nested scopes
+    long long cycles_ = 0;              ///< Self, with Counters::HARDWARE
+    long long instructions_ = 0;        ///< Self, with Counters::HARDWARE
+    long long cpu_ns_ = 0;              ///< Self, with Counters::RUSAGE
+  };
+
+  /**
+   * @param hardware Count cycles and instructions as well, or CPU time if
+   *                 the hardware counters are not available
+   */
+  explicit PassTimer(bool hardware = false)
+      : epoch_(std::chrono::steady_clock::now()),
+        counters_(!hardware          ? Counters::NONE
+                  : PerfCounters::Open() ? Counters::HARDWARE
+                                     : Counters::RUSAGE) {}
+  PassTimer(const PassTimer &) = delete;
+  PassTimer &operator=(const PassTimer &) = delete;
+
+  [[nodiscard]] Counters GetCounters() const { return counters_; }
+
+  /** @brief Events recorded so far, in the order they ended */
+  [[nodiscard]] std::vector<Event> Events() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return events_;
+  }
+
+  /** @brief The timer that scopes on the running thread record to */
+  static PassTimer *Current() { return current_; }
+  static void SetCurrent(PassTimer *timer) { current_ = timer; }
+
+  /** @brief Name of the innermost pass timed on the running thread, if any */
+  static const char *CurrentPass() {
+    return current_ && top_ ? top_->pass_ : nullptr;
+  }
+
+  /**
+   * @brief Times the pass @p pass, for the function or file @p detail, from
+   *        construction to destruction
+   *
+   * @p pass must be a string literal: only the pointer is kept.
+   */
+  class Scope {
+  public:
+    explicit Scope(const char *pass, std::string_view detail = {})
+        : timer_(current_) {
+      if (!timer_)
+        return;
+      pass_ = pass;
+      parent_ = top_;
+      detail_ = detail.empty() && parent_ ? parent_->detail_ : detail;
+      top_ = this;
+      start_ = timer_->Now();
+    }
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+    ~Scope() {
+      if (timer_)
+        timer_->Finish(this);
+    }
+
+  private:
+    friend class PassTimer;
+
+    /// Counters at one point of a thread
+    struct Sample {
+      long long ns_ = 0;
+      long long cycles_ = 0;
+      long long instructions_ = 0;
+      long long cpu_ns_ = 0;
+    };
+
+    PassTimer *timer_;
+    const char *pass_ = nullptr;
+    std::string_view detail_;
+    Scope *parent_ = nullptr;           ///< Enclosing scope on this thread
+    Sample start_;
+    Sample nested_;                     ///< Spent in nested scopes
+  };
+
+private:
+  /// The hardware counters of one thread, opened on first use
+  class PerfCounters {
+  public:
+    ~PerfCounters() {
+      if (leader_ >= 0)
+        ::close(leader_);
+      if (member_ >= 0)
+        ::close(member_);
+    }
+
+    /** @brief Open this thread's counters if need be; false if not possible */
+    static bool Open() {
+#ifdef __linux__
+      PerfCounters &perf = OfThread();
+      if (perf.leader_ == -2) {
+        perf.leader_ = OpenCounter(PERF_COUNT_HW_CPU_CYCLES, -1);
+        if (perf.leader_ >= 0) {
+          perf.member_ = OpenCounter(PERF_COUNT_HW_INSTRUCTIONS, perf.leader_);
+          if (perf.member_ < 0) {
+            ::close(perf.leader_);
+            perf.leader_ = -1;
+          }
+        }
+      }
+      return perf.leader_ >= 0;
+#else
+      return false;
+#endif
+    }
+
+    /** @brief Read this thread's cycles and instructions; false if not open */
+    static bool Read(long long *cycles, long long *instructions) {
+      if (!Open())
+        return false;
+      uint64_t values[3]; // Number of counters, then their values
+      if (::read(OfThread().leader_, values, sizeof(values)) != sizeof(values))
+        return false;
+      *cycles = static_cast<long long>(values[1]);
+      *instructions = static_cast<long long>(values[2]);
+      return true;
+    }
+
+  private:
+    int leader_ = -2;                   ///< Cycles; -2 until opened, -1 if failed
+    int member_ = -1;                   ///< Instructions, read with the leader
+
+#ifdef __linux__
+    static int OpenCounter(uint64_t config, int group) {
+      perf_event_attr attr = {};
+      attr.size = sizeof(attr);
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = config;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format = PERF_FORMAT_GROUP;
+      return static_cast<int>(
+          ::syscall(SYS_perf_event_open, &attr, 0, -1, group, 0));
+    }
+#endif
+
+    static PerfCounters &OfThread() {
+      static thread_local PerfCounters perf;
+      return perf;
+    }
+  };
+
+  std::chrono::steady_clock::time_point epoch_;
+  Counters counters_;
+  mutable std::mutex mutex_;
+  std::vector<Event> events_;
+  std::atomic<int> threads_{0};
+
+  static inline thread_local PassTimer *current_ = nullptr;
+  static inline thread_local Scope *top_ = nullptr;         ///< Innermost scope
+  static inline thread_local PassTimer *numbered_by_ = nullptr;
+  static inline thread_local int thread_ = 0;   ///< This thread's number for numbered_by_
+
+  Scope::Sample Now() const {
+    Scope::Sample sample;
+    sample.ns_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     std::chrono::steady_clock::now() - epoch_)
+                     .count();
+    if (counters_ == Counters::HARDWARE) {
+      PerfCounters::Read(&sample.cycles_, &sample.instructions_);
+    } else if (counters_ == Counters::RUSAGE) {
+      rusage usage;
+#ifdef RUSAGE_THREAD
+      int who = RUSAGE_THREAD;
+#else
+      int who = RUSAGE_SELF;
+#endif
+      if (::getrusage(who, &usage) == 0)
+        sample.cpu_ns_ =
+            (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000000LL +
+            (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1000LL;
+    }
+    return sample;
+  }
+
+  void Finish(Scope *scope) {
+    Scope::Sample end = Now();
+    Scope::Sample total;
+    total.ns_ = end.ns_ - scope->start_.ns_;
+    total.cycles_ = end.cycles_ - scope->start_.cycles_;
+    total.instructions_ = end.instructions_ - scope->start_.instructions_;
+    total.cpu_ns_ = end.cpu_ns_ - scope->start_.cpu_ns_;
+
+    top_ = scope->parent_;
+    if (Scope *parent = scope->parent_) {
+      parent->nested_.ns_ += total.ns_;
+      parent->nested_.cycles_ += total.cycles_;
+      parent->nested_.instructions_ += total.instructions_;
+      parent->nested_.cpu_ns_ += total.cpu_ns_;
+    }
+
+    if (numbered_by_ != this) {
+      numbered_by_ = this;
+      thread_ = threads_++;
+    }
+    Event event{scope->pass_,
+                std::string(scope->detail_),
+                thread_,
+                scope->start_.ns_,
+                total.ns_,
+                total.ns_ - scope->nested_.ns_,
+                total.cycles_ - scope->nested_.cycles_,
+                total.instructions_ - scope->nested_.instructions_,
+                total.cpu_ns_ - scope->nested_.cpu_ns_};
+    std::lock_guard<std::mutex> lock(mutex_);
+    events_.push_back(std::move(event));
+  }
+};
+
+} // namespace util
+
+#endif // TIGER_UTIL_PASS_TIMER_H_
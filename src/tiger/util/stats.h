@@ -0,0 +1,162 @@
+/**
+ * @file stats.h
+ * @brief Counters of what the compiler did to each function
+ *
+ * The counters show how much work each pass had and what came of it: how
+ * large a function's IR, canonical trees and assembly are, how hard its
+ * registers were to allocate and how large its frame ended up.  They are
+ * kept in one FunctionStats per function, made with its frame when a
+ * Stats is current (see frame::Compilation) and reached by the later
+ * passes through the function's frame::Frame::stats_.  When no Stats is
+ * current, no record is made, and every counter costs a test of a null
+ * pointer.
+ *
+ * Translation makes tree nodes far from the code that knows the function,
+ * so while a function's body is translated its record is current on the
+ * thread (FunctionStats::Scope) and the tree nodes count themselves.
+ */
+
+#ifndef TIGER_UTIL_STATS_H_
+#define TIGER_UTIL_STATS_H_
+
+#include <deque>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace util {
+
+/**
+ * @brief What the compiler did to one function
+ *
+ * The register allocation counters are those of its last round but for
+ * the spill counters, which add up all rounds.  A function taken from the
+ * function cache only has the counters of the passes before the lookup.
+ */
+struct FunctionStats {
+  std::string file_;                    ///< Program, as named to the driver
+  std::string name_;                    ///< Name in the source
+  std::string label_;                   ///< Label of its code
+  long long ir_nodes_ = 0;              ///< Tree nodes made by translation
+  long long statements_ = 0;            ///< Statements after Canon::Linearize()
+  long long blocks_ = 0;                ///< Basic blocks
+  long long traces_ = 0;                ///< Traces
+  long long instructions_ = 0;          ///< Made by CodeGen::Codegen()
+  long long temps_ = 0;                 ///< Temps to allocate, before spilling
+  long long interference_edges_ = 0;    ///< Involving a temp, before spilling
+  long long liveness_iterations_ = 0;   ///< Blocks evaluated by liveness, all rounds
+  long long coalesced_moves_ = 0;
+  long long constrained_moves_ = 0;
+  long long frozen_moves_ = 0;
+  long long spill_rounds_ = 0;          ///< Rounds that rewrote the program
+  long long spilled_temps_ = 0;
+  long long loads_ = 0;                 ///< Inserted for spilled temps
+  long long stores_ = 0;                ///< Inserted for spilled temps
+  long long frame_size_ = 0;            ///< In bytes
+  long long cached_ = 0;                ///< 1 if taken from the function cache
+
+  /** @brief The record current on the running thread, or nullptr */
+  static FunctionStats *Current() { return current_; }
+
+  /**
+   * @brief Makes a record current on the running thread while in scope
+   *
+   * A null record stops counting, e.g. for the back end, which runs on the
+   * translating thread in between.
+   */
+  class Scope {
+  public:
+    explicit Scope(FunctionStats *stats) : saved_(current_) {
+      current_ = stats;
+    }
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+    ~Scope() { current_ = saved_; }
+
+  private:
+    FunctionStats *saved_;
+  };
+
+private:
+  static inline thread_local FunctionStats *current_ = nullptr;
+};
+
+/// A counter of FunctionStats with its name in reports
+struct StatsCounter {
+  const char *key_;                     ///< In JSON
+  const char *header_;                  ///< In tables
+  long long FunctionStats::*member_;
+};
+
+/// All counters of FunctionStats, in the order they are reported
+inline constexpr StatsCounter STATS_COUNTERS[] = {
+    {"ir_nodes", "ir", &FunctionStats::ir_nodes_},
+    {"statements", "stms", &FunctionStats::statements_},
+    {"blocks", "blocks", &FunctionStats::blocks_},
+    {"traces", "traces", &FunctionStats::traces_},
+    {"instructions", "instrs", &FunctionStats::instructions_},
+    {"temps", "temps", &FunctionStats::temps_},
+    {"interference_edges", "edges", &FunctionStats::interference_edges_},
+    {"liveness_iterations", "live it", &FunctionStats::liveness_iterations_},
+    {"coalesced_moves", "coal", &FunctionStats::coalesced_moves_},
+    {"constrained_moves", "constr", &FunctionStats::constrained_moves_},
+    {"frozen_moves", "frozen", &FunctionStats::frozen_moves_},
+    {"spill_rounds", "rounds", &FunctionStats::spill_rounds_},
+    {"spilled_temps", "spilled", &FunctionStats::spilled_temps_},
+    {"loads", "loads", &FunctionStats::loads_},
+    {"stores", "stores", &FunctionStats::stores_},
+    {"frame_size", "frame", &FunctionStats::frame_size_},
+    {"cached", "cached", &FunctionStats::cached_},
+};
+
+/**
+ * @brief The FunctionStats of one compilation
+ *
+ * Records are made by the translating thread only.  Each is then written
+ * by whichever thread compiles its function, and must not be read before
+ * the compilation is over.
+ */
+class Stats {
+public:
+  Stats() = default;
+  Stats(const Stats &) = delete;
+  Stats &operator=(const Stats &) = delete;
+
+  /**
+   * @brief A new record for the function with code at @p label, in the
+   *        Stats current on the running thread, named after the label
+   *        until translation knows better
+   * @return nullptr if there is none
+   */
+  static FunctionStats *NewFunction(std::string_view label) {
+    if (!current_)
+      return nullptr;
+    FunctionStats &stats = current_->functions_.emplace_back();
+    stats.name_ = label;
+    stats.label_ = label;
+    return &stats;
+  }
+
+  /** @brief Move out the records made so far, in the order they were made */
+  std::vector<FunctionStats> TakeFunctions() {
+    std::vector<FunctionStats> functions(
+        std::make_move_iterator(functions_.begin()),
+        std::make_move_iterator(functions_.end()));
+    functions_.clear();
+    return functions;
+  }
+
+  /** @brief The Stats that records are made in on the running thread */
+  static Stats *Current() { return current_; }
+  static void SetCurrent(Stats *stats) { current_ = stats; }
+
+private:
+  std::deque<FunctionStats> functions_; ///< Records never move
+
+  static inline thread_local Stats *current_ = nullptr;
+};
+
+} // namespace util
+
+#endif // TIGER_UTIL_STATS_H_
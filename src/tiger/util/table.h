@@ -1,35 +1,45 @@
 /**
  * @file table.h
  * @brief Generic hash table implementation
- * 
+ *
  * Provides a generic hash table with the following features:
  * - Hash-based lookup using pointer keys
  * - Stack-like operations (Enter, Pop) for scoped symbol tables
  * - Efficient insertion and lookup
- * 
+ *
  * Used as the base for symbol tables (sym::Table) throughout the compiler.
+ *
+ * Every Enter() appends a binding to an undo log; the log doubles as the
+ * stack that Pop() unwinds.  A binding that shadows an earlier one for the
+ * same key remembers it, so popping it makes the earlier binding visible
+ * again.  Lookup goes through an open-addressing index (linear probing,
+ * load factor at most 1/2) that maps each key to its innermost binding.
+ * The index doubles when it fills up, so lookups stay O(1) however many
+ * keys are entered, and bindings cost no allocation of their own.
  */
 
 #ifndef TIGER_UTIL_TABLE_H_
 #define TIGER_UTIL_TABLE_H_
 
 #include <cassert>
+#include <cstdint>
 #include <functional>
+#include <vector>
 
 namespace tab {
 
 /**
  * @brief Generic hash table with stack operations
- * 
+ *
  * A hash table that supports stack-like operations for implementing
  * scoped symbol tables. Keys are pointers (typically Symbol pointers).
- * 
+ *
  * @tparam KeyType Type of keys (must be pointer type)
  * @tparam ValueType Type of values stored
  */
 template <typename KeyType, typename ValueType> class Table {
 public:
-  Table() : top_(nullptr), table_() {}
+  Table() : slots_(MIN_SLOTS, Slot{nullptr, NONE}), used_(0) {}
   void Enter(KeyType *key, ValueType *value);
   ValueType *Look(KeyType *key);
   void Set(KeyType *key, ValueType *value);
@@ -37,79 +47,126 @@ public:
   void Dump(std::function<void(KeyType *, ValueType *)> show);
 
 protected:
-  static const unsigned long TABSIZE = 127;
-  struct Binder {
-  public:
+  static constexpr size_t MIN_SLOTS = 16;  ///< Initial index size (power of two)
+  static constexpr int NONE = -1;          ///< No binding
+
+  /// One Enter(), in the order they happened
+  struct Binding {
     KeyType *key;
     ValueType *value;
-    Binder *next;
-    KeyType *prevtop;
+    int shadowed;  ///< Log index of the binding this one hides, or NONE
+  };
 
-    Binder(KeyType *key, ValueType *value, Binder *next, KeyType *prevtop)
-        : key(key), value(value), next(next), prevtop(prevtop) {}
+  /// Index entry: a key and its innermost binding (key == nullptr: empty)
+  struct Slot {
+    KeyType *key;
+    int binding;
   };
 
-  Binder *table_[TABSIZE];
-  KeyType *top_;
+  std::vector<Slot> slots_;   ///< Open-addressing index, size a power of two
+  std::vector<Binding> log_;  ///< Every live binding, oldest first
+  size_t used_;               ///< Number of occupied slots (distinct keys)
+
+  /// Preferred slot of @p key
+  size_t Home(KeyType *key) const {
+    uint64_t h = reinterpret_cast<uintptr_t>(key) * 0x9E3779B97F4A7C15ull;
+    return (h ^ (h >> 32)) & (slots_.size() - 1);
+  }
+
+  /// Slot holding @p key, or the empty slot where its probe ends
+  size_t Find(KeyType *key) const {
+    size_t mask = slots_.size() - 1;
+    size_t i = Home(key);
+    while (slots_[i].key != nullptr && slots_[i].key != key)
+      i = (i + 1) & mask;
+    return i;
+  }
+
+  void Grow();
+  void EraseSlot(size_t i);
 };
 
 template <typename KeyType, typename ValueType>
 void Table<KeyType, ValueType>::Enter(KeyType *key, ValueType *value) {
-  unsigned long index = reinterpret_cast<unsigned long>(key) % TABSIZE;
-  table_[index] = new Binder(key, value, table_[index], top_);
-  top_ = key;
+  assert(key);
+  if (2 * (used_ + 1) > slots_.size())
+    Grow();
+  size_t i = Find(key);
+  int shadowed = NONE;
+  if (slots_[i].key == nullptr) {
+    slots_[i].key = key;
+    ++used_;
+  } else {
+    shadowed = slots_[i].binding;
+  }
+  slots_[i].binding = static_cast<int>(log_.size());
+  log_.push_back({key, value, shadowed});
 }
 
 template <typename KeyType, typename ValueType>
 ValueType *Table<KeyType, ValueType>::Look(KeyType *key) {
   assert(key);
-  unsigned long index = reinterpret_cast<unsigned long>(key) % TABSIZE;
-  Binder *b;
-  for (b = table_[index]; b; b = b->next)
-    if (b->key == key)
-      return b->value;
-  return nullptr;
+  size_t i = Find(key);
+  if (slots_[i].key == nullptr)
+    return nullptr;
+  return log_[slots_[i].binding].value;
 }
 
 template <typename KeyType, typename ValueType>
 void Table<KeyType, ValueType>::Set(KeyType *key, ValueType *value) {
   assert(key);
-  unsigned long index = reinterpret_cast<unsigned long>(key) % TABSIZE;
-  Binder *b;
-  for (b = table_[index]; b; b = b->next)
-    if (b->key == key) {
-      b->value = value;
-      return;
-    }
+  size_t i = Find(key);
+  if (slots_[i].key != nullptr)
+    log_[slots_[i].binding].value = value;
 }
 
 template <typename KeyType, typename ValueType>
 KeyType *Table<KeyType, ValueType>::Pop() {
-  KeyType *k = top_;
-  assert(k);
-  unsigned long index = reinterpret_cast<unsigned long>(k) % TABSIZE;
-  Binder *b = table_[index];
-  assert(b);
-  table_[index] = b->next;
-  top_ = b->prevtop;
-  return b->key;
+  assert(!log_.empty());
+  Binding b = log_.back();
+  log_.pop_back();
+  size_t i = Find(b.key);
+  assert(slots_[i].key == b.key &&
+         slots_[i].binding == static_cast<int>(log_.size()));
+  if (b.shadowed != NONE)
+    slots_[i].binding = b.shadowed;
+  else
+    EraseSlot(i);
+  return b.key;
 }
 
 template <typename KeyType, typename ValueType>
 void Table<KeyType, ValueType>::Dump(
     std::function<void(KeyType *, ValueType *)> show) {
-  KeyType *k = top_;
-  unsigned long index = reinterpret_cast<unsigned long>(k) % TABSIZE;
-  Binder *b = table_[index];
-  if (b == nullptr)
-    return;
-  table_[index] = b->next;
-  top_ = b->prevtop;
-  show(b->key, b->value);
-  Dump(show);
-  assert(top_ == b->prevtop && table_[index] == b->next);
-  top_ = k;
-  table_[index] = b;
+  // Innermost first, shadowed bindings included
+  for (auto it = log_.rbegin(); it != log_.rend(); ++it)
+    show(it->key, it->value);
+}
+
+template <typename KeyType, typename ValueType>
+void Table<KeyType, ValueType>::Grow() {
+  std::vector<Slot> old(2 * slots_.size(), Slot{nullptr, NONE});
+  old.swap(slots_);
+  for (const Slot &s : old)
+    if (s.key != nullptr)
+      slots_[Find(s.key)] = s;
+}
+
+template <typename KeyType, typename ValueType>
+void Table<KeyType, ValueType>::EraseSlot(size_t i) {
+  // Backward-shift deletion: pull later members of the probe run into the
+  // hole unless that would move them in front of their home slot
+  size_t mask = slots_.size() - 1;
+  for (size_t j = (i + 1) & mask; slots_[j].key != nullptr; j = (j + 1) & mask) {
+    size_t home = Home(slots_[j].key);
+    bool stays = i <= j ? (i < home && home <= j) : (i < home || home <= j);
+    if (!stays) {
+      slots_[i] = slots_[j];
+      i = j;
+    }
+  }
+  slots_[i] = Slot{nullptr, NONE};
+  --used_;
 }
 
 } // namespace tab
@@ -0,0 +1,91 @@
+/**
+ * @file union_find.h
+ * @brief Disjoint-set forest over dense integer ids
+ *
+ * Used by the register allocator to resolve coalescing aliases: when node v
+ * is coalesced into node u, the sets of u and v are merged and every member
+ * of the merged set resolves to u.
+ *
+ * The forest uses union by rank and path compression, so a sequence of m
+ * operations on n elements costs O(m α(n)), effectively constant per
+ * operation.  Because union by rank may hang u's tree below v's, each root
+ * additionally records which element names its set.
+ */
+
+#ifndef TIGER_UTIL_UNION_FIND_H_
+#define TIGER_UTIL_UNION_FIND_H_
+
+#include <cassert>
+#include <utility>
+#include <vector>
+
+namespace util {
+
+/**
+ * @brief Disjoint sets of the ids [0, size) with named representatives
+ */
+class UnionFind {
+public:
+  UnionFind() = default;
+  explicit UnionFind(int size) { Reset(size); }
+
+  /** @brief Make every id in [0, size) a singleton set */
+  void Reset(int size) {
+    parent_.resize(size);
+    rank_.assign(size, 0);
+    name_.resize(size);
+    for (int i = 0; i < size; ++i)
+      parent_[i] = name_[i] = i;
+  }
+
+  /** @brief Number of ids in the universe */
+  [[nodiscard]] int Size() const { return static_cast<int>(parent_.size()); }
+
+  /** @brief The id naming the set that contains @p x */
+  int Find(int x) { return name_[Root(x)]; }
+
+  /** @brief Test whether @p x names its own set (was never merged away) */
+  bool IsRepresentative(int x) { return Find(x) == x; }
+
+  /**
+   * @brief Merge the set of @p merged into the set of @p keep
+   *
+   * Afterwards Find() of any member of either set returns Find(@p keep).
+   */
+  void Union(int keep, int merged) {
+    int name = Find(keep);
+    int a = Root(keep);
+    int b = Root(merged);
+    if (a == b)
+      return;
+    if (rank_[a] < rank_[b])
+      std::swap(a, b);
+    parent_[b] = a;
+    if (rank_[a] == rank_[b])
+      ++rank_[a];
+    name_[a] = name;
+  }
+
+private:
+  std::vector<int> parent_;  ///< Parent in the forest; roots point to themselves
+  std::vector<int> rank_;    ///< Upper bound on the height of each root's tree
+  std::vector<int> name_;    ///< Root → id that names the set
+
+  /// Find the root of @p x, compressing the path behind it
+  int Root(int x) {
+    assert(x >= 0 && x < Size());
+    int root = x;
+    while (parent_[root] != root)
+      root = parent_[root];
+    while (parent_[x] != root) {
+      int next = parent_[x];
+      parent_[x] = root;
+      x = next;
+    }
+    return root;
+  }
+};
+
+} // namespace util
+
+#endif // TIGER_UTIL_UNION_FIND_H_
@@ -0,0 +1,195 @@
+/**
+ * @file writer.h
+ * @brief Append-only buffered output to a file descriptor
+ *
+ * The assembly of a large program is written as millions of short pieces
+ * (mnemonics, register names, labels).  Writer collects them in one large
+ * buffer and hands the buffer to the kernel only when it is full, so the
+ * cost per piece is a memcpy.  A piece too large to be worth copying is
+ * sent together with the buffered bytes in a single writev().
+ *
+ * A Writer either owns a file it opened itself or borrows the descriptor
+ * of a stdio stream; in the latter case the stream is flushed first so the
+ * two kinds of output stay in order.  Write errors are remembered and can
+ * be checked with Ok() once everything has been flushed.  A Writer can
+ * also append to a std::string, so that a piece of output can be produced
+ * on one thread and written to the file later by another, or hand its
+ * output in pieces to a Sink supplied by whoever embeds the compiler.
+ */
+
+#ifndef TIGER_UTIL_WRITER_H_
+#define TIGER_UTIL_WRITER_H_
+
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "tiger/util/alloc_profile.h"
+
+namespace util {
+
+/**
+ * @brief A large output buffer in front of a file descriptor
+ */
+class Writer {
+public:
+  static constexpr size_t BUFFER_SIZE = 1 << 20;
+  static constexpr size_t STRING_BUFFER_SIZE = 1 << 14;
+
+  /// Receives the output in pieces, in order
+  using Sink = std::function<void(std::string_view)>;
+
+  /** @brief Create (or truncate) the file at @p path and write to it */
+  explicit Writer(const std::string &path)
+      : fd_(::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644)),
+        owns_fd_(true), ok_(fd_ >= 0), buffer_(NewBuffer(BUFFER_SIZE)) {}
+
+  /** @brief Write to the descriptor behind @p file, after flushing it */
+  explicit Writer(FILE *file)
+      : fd_(fileno(file)), owns_fd_(false), buffer_(NewBuffer(BUFFER_SIZE)) {
+    fflush(file);
+  }
+
+  /** @brief Append to @p sink, which must outlive the Writer */
+  explicit Writer(std::string *sink)
+      : fd_(-1), owns_fd_(false), sink_(sink), capacity_(STRING_BUFFER_SIZE),
+        buffer_(NewBuffer(STRING_BUFFER_SIZE)) {}
+
+  /** @brief Hand the output to @p sink, STRING_BUFFER_SIZE bytes at a time */
+  explicit Writer(Sink sink)
+      : fd_(-1), owns_fd_(false), consumer_(std::move(sink)),
+        capacity_(STRING_BUFFER_SIZE), buffer_(NewBuffer(STRING_BUFFER_SIZE)) {}
+
+  Writer(const Writer &) = delete;
+  Writer &operator=(const Writer &) = delete;
+
+  ~Writer() {
+    Flush();
+    if (owns_fd_ && fd_ >= 0)
+      ::close(fd_);
+  }
+
+  /** @brief Append @p s */
+  Writer &operator<<(std::string_view s) {
+    if (s.size() <= capacity_ - used_) {
+      std::memcpy(buffer_.get() + used_, s.data(), s.size());
+      used_ += s.size();
+    } else {
+      WriteLarge(s);
+    }
+    return *this;
+  }
+
+  /** @brief Append one character */
+  Writer &operator<<(char c) {
+    if (used_ == capacity_)
+      Flush();
+    buffer_[used_++] = c;
+    return *this;
+  }
+
+  /** @brief Append @p n in decimal */
+  Writer &operator<<(long long n) {
+    char digits[24];
+    char *end = std::to_chars(digits, digits + sizeof(digits), n).ptr;
+    return *this << std::string_view(digits, end - digits);
+  }
+  Writer &operator<<(int n) { return *this << static_cast<long long>(n); }
+
+  /** @brief Hand everything buffered so far to the kernel */
+  void Flush() {
+    if (used_ == 0)
+      return;
+    if (sink_)
+      sink_->append(buffer_.get(), used_);
+    else if (consumer_)
+      consumer_(std::string_view(buffer_.get(), used_));
+    else
+      WriteAll(buffer_.get(), used_);
+    used_ = 0;
+  }
+
+  /** @brief Whether the file could be opened and every write succeeded */
+  [[nodiscard]] bool Ok() const { return ok_; }
+
+private:
+  int fd_;
+  bool owns_fd_;
+  bool ok_ = true;
+  std::string *sink_ = nullptr;     ///< String appended to instead of fd_
+  Sink consumer_;                   ///< Takes the output instead of fd_, if set
+  size_t capacity_ = BUFFER_SIZE;   ///< Size of buffer_
+  std::unique_ptr<char[]> buffer_;
+  size_t used_ = 0;
+
+  /// A buffer of @p size bytes, charged to Writer in an allocation profile
+  static char *NewBuffer(size_t size) {
+    if (!AllocProfile::Enabled())
+      return new char[size];
+    AllocProfile::TypeScope scope(AllocProfile::TypeOf<Writer>());
+    return new char[size];
+  }
+
+  /// Write the buffer followed by @p s, without copying @p s
+  void WriteLarge(std::string_view s) {
+    if (sink_ || consumer_) {
+      Flush();
+      if (sink_)
+        sink_->append(s);
+      else
+        consumer_(s);
+      return;
+    }
+    if (used_ == 0 || !ok_) {
+      WriteAll(s.data(), s.size());
+      return;
+    }
+    iovec iov[2] = {{buffer_.get(), used_},
+                    {const_cast<char *>(s.data()), s.size()}};
+    ssize_t n;
+    do
+      n = ::writev(fd_, iov, 2);
+    while (n < 0 && errno == EINTR);
+    if (n < 0) {
+      ok_ = false;
+      used_ = 0;
+      return;
+    }
+    // Finish whatever a short writev left over
+    size_t written = static_cast<size_t>(n);
+    if (written < used_) {
+      WriteAll(buffer_.get() + written, used_ - written);
+      written = used_;
+    }
+    used_ = 0;
+    written -= iov[0].iov_len;
+    WriteAll(s.data() + written, s.size() - written);
+  }
+
+  void WriteAll(const char *data, size_t size) {
+    while (size > 0 && ok_) {
+      ssize_t n = ::write(fd_, data, size);
+      if (n < 0) {
+        if (errno == EINTR)
+          continue;
+        ok_ = false;
+        return;
+      }
+      data += n;
+      size -= static_cast<size_t>(n);
+    }
+  }
+};
+
+} // namespace util
+
+#endif // TIGER_UTIL_WRITER_H_